@@ -32,6 +32,7 @@
 #include "gdkresources.h"
 
 #include "gdk-private.h"
+#include "gdkprofilerprivate.h"
 
 #include "gdkconstructor.h"
 
@@ -131,6 +132,7 @@ static const GdkDebugKey gdk_debug_keys[] = {
   { "vulkan-disable",  GDK_DEBUG_VULKAN_DISABLE, "Disable Vulkan support" },
   { "vulkan-validate", GDK_DEBUG_VULKAN_VALIDATE, "Load the Vulkan validation layer" },
   { "default-settings",GDK_DEBUG_DEFAULT_SETTINGS, "Force default values for xsettings" },
+  { "shm-disable",     GDK_DEBUG_SHM_DISABLE, "Disable shared memory for Cairo rendering (X11)" },
 };
 
 
@@ -297,6 +299,9 @@ gdk_pre_parse (void)
                                           gdk_debug_keys,
                                           G_N_ELEMENTS (gdk_debug_keys));
 
+  if (g_getenv ("GDK_TRACE_FILE"))
+    gdk_profiler_start_recording (g_getenv ("GDK_TRACE_FILE"));
+
 #ifndef G_HAS_CONSTRUCTORS
   stash_desktop_startup_notification_id ();
 #endif
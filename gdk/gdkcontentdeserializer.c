@@ -670,6 +670,28 @@ string_deserializer_finish (GObject      *source,
       /* Never return NULL, we only return that on error */
       g_value_set_string (gdk_content_deserializer_get_value (deserializer), "");
     }
+  else if (G_IS_MEMORY_OUTPUT_STREAM (stream))
+    {
+      char *str;
+
+      /* UTF-8 data was read as is, so it still needs to be validated */
+      if (g_output_stream_write (stream, "", 1, NULL, &error) < 0 ||
+          !g_output_stream_close (stream, NULL, &error))
+        {
+          gdk_content_deserializer_return_error (deserializer, error);
+          return;
+        }
+
+      str = g_memory_output_stream_steal_data (G_MEMORY_OUTPUT_STREAM (stream));
+      if (!g_utf8_validate (str, -1, NULL))
+        {
+          char *valid = g_utf8_make_valid (str, -1);
+          g_free (str);
+          str = valid;
+        }
+
+      g_value_take_string (gdk_content_deserializer_get_value (deserializer), str);
+    }
   else
     {
       GOutputStream *mem_stream = g_filter_output_stream_get_base_stream (G_FILTER_OUTPUT_STREAM (stream));
@@ -691,12 +713,30 @@ string_deserializer_finish (GObject      *source,
 static void
 string_deserializer (GdkContentDeserializer *deserializer)
 {
+  const char *charset = gdk_content_deserializer_get_user_data (deserializer);
   GOutputStream *output, *filter;
   GCharsetConverter *converter;
   GError *error = NULL;
 
+  /* No need to pass UTF-8 through a converter, and then keep the
+   * converted copy around on top of the data as it was read.
+   */
+  if (g_ascii_strcasecmp (charset, "utf-8") == 0)
+    {
+      output = g_memory_output_stream_new_resizable ();
+      g_output_stream_splice_async (output,
+                                    gdk_content_deserializer_get_input_stream (deserializer),
+                                    G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE,
+                                    gdk_content_deserializer_get_priority (deserializer),
+                                    gdk_content_deserializer_get_cancellable (deserializer),
+                                    string_deserializer_finish,
+                                    deserializer);
+      g_object_unref (output);
+      return;
+    }
+
   converter = g_charset_converter_new ("utf-8",
-                                       gdk_content_deserializer_get_user_data (deserializer),
+                                       charset,
                                        &error);
   if (converter == NULL)
     {
@@ -658,6 +658,30 @@ pixbuf_serializer (GdkContentSerializer *serializer)
   g_object_unref (pixbuf);
 }
 
+/* Large strings are written in chunks, each one only after the previous
+ * one was accepted by the stream. This way neither a converter nor a
+ * slow reader on the other end makes us buffer the whole text again.
+ */
+#define STRING_CHUNK_SIZE (64 * 1024)
+
+typedef struct
+{
+  GOutputStream *stream;
+  const char *text;
+  gsize remaining;
+} StringWriter;
+
+static void
+string_writer_free (gpointer data)
+{
+  StringWriter *writer = data;
+
+  g_object_unref (writer->stream);
+  g_free (writer);
+}
+
+static void string_serializer_write_chunk (GdkContentSerializer *serializer);
+
 static void
 string_serializer_finish (GObject      *source,
                           GAsyncResult *result,
@@ -669,43 +693,87 @@ string_serializer_finish (GObject      *source,
   if (!g_output_stream_write_all_finish (stream, result, NULL, &error))
     gdk_content_serializer_return_error (serializer, error);
   else
-    gdk_content_serializer_return_success (serializer);
+    string_serializer_write_chunk (serializer);
+}
+
+static void
+string_serializer_write_chunk (GdkContentSerializer *serializer)
+{
+  StringWriter *writer = gdk_content_serializer_get_task_data (serializer);
+  gsize size;
+
+  if (writer->remaining == 0)
+    {
+      gdk_content_serializer_return_success (serializer);
+      return;
+    }
+
+  size = writer->remaining;
+  if (size > STRING_CHUNK_SIZE)
+    {
+      /* Don't split a character, the converter would have to hold on to it */
+      const char *end = g_utf8_find_prev_char (writer->text, writer->text + STRING_CHUNK_SIZE + 1);
+      if (end != NULL && end > writer->text)
+        size = end - writer->text;
+      else
+        size = STRING_CHUNK_SIZE;
+    }
+
+  g_output_stream_write_all_async (writer->stream,
+                                   writer->text,
+                                   size,
+                                   gdk_content_serializer_get_priority (serializer),
+                                   gdk_content_serializer_get_cancellable (serializer),
+                                   string_serializer_finish,
+                                   serializer);
+
+  writer->text += size;
+  writer->remaining -= size;
 }
 
 static void
 string_serializer (GdkContentSerializer *serializer)
 {
-  GOutputStream *filter;
-  GCharsetConverter *converter;
-  GError *error = NULL;
+  const char *charset = gdk_content_serializer_get_user_data (serializer);
+  StringWriter *writer;
+  GOutputStream *stream;
   const char *text;
 
-  converter = g_charset_converter_new (gdk_content_serializer_get_user_data (serializer),
-                                       "utf-8",
-                                       &error);
-  if (converter == NULL)
+  stream = gdk_content_serializer_get_output_stream (serializer);
+
+  /* Strings are UTF-8 already, so they can be written as they are */
+  if (g_ascii_strcasecmp (charset, "utf-8") == 0)
     {
-      gdk_content_serializer_return_error (serializer, error);
-      return;
+      g_object_ref (stream);
     }
-  g_charset_converter_set_use_fallback (converter, TRUE);
+  else
+    {
+      GCharsetConverter *converter;
+      GError *error = NULL;
+
+      converter = g_charset_converter_new (charset, "utf-8", &error);
+      if (converter == NULL)
+        {
+          gdk_content_serializer_return_error (serializer, error);
+          return;
+        }
+      g_charset_converter_set_use_fallback (converter, TRUE);
 
-  filter = g_converter_output_stream_new (gdk_content_serializer_get_output_stream (serializer),
-                                          G_CONVERTER (converter));
-  g_object_unref (converter);
+      stream = g_converter_output_stream_new (stream, G_CONVERTER (converter));
+      g_object_unref (converter);
+    }
 
   text = g_value_get_string (gdk_content_serializer_get_value (serializer));
   if (text == NULL)
     text = "";
 
-  g_output_stream_write_all_async (filter,
-                                   text,
-                                   strlen (text),
-                                   gdk_content_serializer_get_priority (serializer),
-                                   gdk_content_serializer_get_cancellable (serializer),
-                                   string_serializer_finish,
-                                   serializer);
-  g_object_unref (filter);
+  writer = g_new (StringWriter, 1);
+  writer->stream = stream;
+  writer->text = text;
+  writer->remaining = strlen (text);
+  gdk_content_serializer_set_task_data (serializer, writer, string_writer_free);
+
+  string_serializer_write_chunk (serializer);
 }
 
 static void
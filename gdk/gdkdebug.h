@@ -44,7 +44,8 @@ typedef enum {
   GDK_DEBUG_GL_GLX          = 1 << 18,
   GDK_DEBUG_VULKAN_DISABLE  = 1 << 19,
   GDK_DEBUG_VULKAN_VALIDATE = 1 << 20,
-  GDK_DEBUG_DEFAULT_SETTINGS= 1 << 21
+  GDK_DEBUG_DEFAULT_SETTINGS= 1 << 21,
+  GDK_DEBUG_SHM_DISABLE     = 1 << 22
 } GdkDebugFlags;
 
 extern guint _gdk_debug_flags;
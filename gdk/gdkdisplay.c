@@ -303,6 +303,7 @@ gdk_display_init (GdkDisplay *display)
                                                   (GDestroyNotify) free_pointer_info);
 
   g_queue_init (&display->queued_events);
+  display->coalesce_info = g_hash_table_new_full (NULL, NULL, NULL, g_free);
 
   display->debug_flags = _gdk_debug_flags;
 
@@ -319,6 +320,7 @@ gdk_display_dispose (GObject *object)
   _gdk_display_manager_remove_display (gdk_display_manager_get (), display);
 
   g_queue_clear (&display->queued_events);
+  g_hash_table_remove_all (display->coalesce_info);
 
   G_OBJECT_CLASS (gdk_display_parent_class)->dispose (object);
 }
@@ -334,6 +336,7 @@ gdk_display_finalize (GObject *object)
   g_hash_table_destroy (display->device_grabs);
 
   g_hash_table_destroy (display->pointers_info);
+  g_hash_table_destroy (display->coalesce_info);
 
   g_list_free_full (display->seats, g_object_unref);
 
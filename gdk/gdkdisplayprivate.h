@@ -76,6 +76,8 @@ struct _GdkDisplay
   GObject parent_instance;
 
   GQueue queued_events;
+  GHashTable *coalesce_info;     /* Per-device state for motion and scroll compression */
+  guint event_barrier;           /* Bumped by every queued event that ends coalescing */
 
   guint event_pause_count;       /* How many times events are blocked */
 
@@ -315,7 +315,6 @@ gdk_draw_context_begin_frame (GdkDrawContext       *context,
   GDK_DRAW_CONTEXT_GET_CLASS (context)->begin_frame (context, priv->frame_region);
 }
 
-#ifdef HAVE_SYSPROF
 static gint64
 region_get_pixels (cairo_region_t *region)
 {
@@ -332,7 +331,6 @@ region_get_pixels (cairo_region_t *region)
 
   return pixels;
 }
-#endif
 
 /**
  * gdk_draw_context_end_frame:
@@ -374,7 +372,8 @@ gdk_draw_context_end_frame (GdkDrawContext *context)
 
   GDK_DRAW_CONTEXT_GET_CLASS (context)->end_frame (context, priv->frame_region);
 
-  gdk_profiler_set_int_counter (pixels_counter, region_get_pixels (priv->frame_region));
+  if (GDK_PROFILER_IS_RUNNING)
+    gdk_profiler_set_int_counter (pixels_counter, region_get_pixels (priv->frame_region));
 
   g_clear_pointer (&priv->frame_region, cairo_region_destroy);
   g_clear_object (&priv->surface->paint_context);
@@ -534,6 +534,80 @@ _gdk_event_queue_find_first (GdkDisplay *display)
   return NULL;
 }
 
+/* Per-device coalescing state.
+ *
+ * For every device we remember the queue node of its most recent
+ * motion and smooth scroll event, together with the value of
+ * display->event_barrier at the time it was queued. A newly queued
+ * event can be merged into the remembered one as long as no barrier
+ * (any event other than motion or smooth scroll) and no event of a
+ * different kind from the same device was queued in between. This
+ * lets compression look at exactly one older event, no matter how
+ * many devices are interleaving their events in the queue.
+ */
+typedef struct
+{
+  GList *motion;
+  guint motion_barrier;
+
+  GList *scroll;
+  guint scroll_barrier;
+  /* Deltas and time of the scroll event before any merging */
+  double scroll_dx;
+  double scroll_dy;
+  guint32 scroll_time;
+} GdkCoalesceInfo;
+
+static gboolean
+is_smooth_scroll (GdkEvent *event)
+{
+  return event->event_type == GDK_SCROLL &&
+         ((GdkScrollEvent *) event)->direction == GDK_SCROLL_SMOOTH;
+}
+
+static GdkCoalesceInfo *
+lookup_coalesce_info (GdkDisplay *display,
+                      GdkDevice  *device,
+                      gboolean    create)
+{
+  GdkCoalesceInfo *info;
+
+  if (device == NULL)
+    return NULL;
+
+  info = g_hash_table_lookup (display->coalesce_info, device);
+  if (info == NULL && create)
+    {
+      info = g_new0 (GdkCoalesceInfo, 1);
+      g_hash_table_insert (display->coalesce_info, device, info);
+    }
+
+  return info;
+}
+
+/* Must be called before @node leaves the queue, so that no
+ * dangling node is kept around for later compression.
+ */
+static void
+forget_coalesce_node (GdkDisplay *display,
+                      GList      *node)
+{
+  GdkEvent *event = node->data;
+  GdkCoalesceInfo *info;
+
+  if (event->event_type != GDK_MOTION_NOTIFY && event->event_type != GDK_SCROLL)
+    return;
+
+  info = lookup_coalesce_info (display, event->device, FALSE);
+  if (info == NULL)
+    return;
+
+  if (info->motion == node)
+    info->motion = NULL;
+  if (info->scroll == node)
+    info->scroll = NULL;
+}
+
 /**
  * _gdk_event_queue_append:
  * @display: a `GdkDisplay`
@@ -547,6 +621,24 @@ GList *
 _gdk_event_queue_append (GdkDisplay *display,
 			 GdkEvent   *event)
 {
+  GdkCoalesceInfo *info;
+
+  if (event->event_type == GDK_MOTION_NOTIFY)
+    {
+      /* A motion in between keeps scrolls of the same device apart */
+      info = lookup_coalesce_info (display, event->device, FALSE);
+      if (info)
+        info->scroll = NULL;
+    }
+  else if (is_smooth_scroll (event))
+    {
+      info = lookup_coalesce_info (display, event->device, FALSE);
+      if (info)
+        info->motion = NULL;
+    }
+  else
+    display->event_barrier++;
+
   g_queue_push_tail (&display->queued_events, event);
 
   return g_queue_peek_tail_link (&display->queued_events);
@@ -563,6 +655,7 @@ void
 _gdk_event_queue_remove_link (GdkDisplay *display,
 			      GList      *node)
 {
+  forget_coalesce_node (display, node);
   g_queue_unlink (&display->queued_events, node);
 }
 
@@ -593,113 +686,95 @@ _gdk_event_unqueue (GdkDisplay *display)
   return event;
 }
 
+static void
+request_flush_if_alone (GdkDisplay *display,
+                        GList      *node)
+{
+  GdkEvent *event = node->data;
+
+  if (g_queue_get_length (&display->queued_events) == 1 &&
+      g_queue_peek_head_link (&display->queued_events) == node)
+    {
+      GdkFrameClock *clock = gdk_surface_get_frame_clock (event->surface);
+      if (clock) /* might be NULL if surface was destroyed */
+        gdk_frame_clock_request_phase (clock, GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS);
+    }
+}
+
 /*
- * If the last N events in the event queue are smooth scroll events
- * for the same surface and device, combine them into one.
+ * If the last event in the event queue is a smooth scroll event,
+ * merge the previous smooth scroll event of the same device into
+ * it, provided nothing else happened to that device in between
+ * and both are for the same surface.
  */
 void
 gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
 {
   GList *l;
-  GdkSurface *surface = NULL;
-  GdkDevice *device = NULL;
-  GdkEvent *last_event = NULL;
-  GList *scrolls = NULL;
-  double delta_x, delta_y;
-  GArray *history = NULL;
-  GdkTimeCoord hist;
+  GdkEvent *event;
+  GdkScrollEvent *self;
+  GdkCoalesceInfo *info;
+  double dx, dy;
 
   l = g_queue_peek_tail_link (&display->queued_events);
+  if (l == NULL)
+    return;
 
-  while (l)
-    {
-      GdkEvent *event = l->data;
-
-      if (event->flags & GDK_EVENT_PENDING)
-        break;
-
-      if (event->event_type != GDK_SCROLL ||
-          gdk_scroll_event_get_direction (event) != GDK_SCROLL_SMOOTH)
-        break;
-
-      if (surface != NULL &&
-          surface != event->surface)
-        break;
-
-      if (device != NULL &&
-          device != event->device)
-        break;
-
-      if (!last_event)
-        last_event = event;
+  event = l->data;
+  if (event->flags & GDK_EVENT_PENDING)
+    return;
 
-      surface = event->surface;
-      device = event->device;
-      scrolls = l;
+  if (!is_smooth_scroll (event))
+    return;
 
-      l = l->prev;
-    }
+  info = lookup_coalesce_info (display, event->device, TRUE);
+  if (info == NULL || info->scroll == l)
+    return;
 
-  delta_x = delta_y = 0;
+  self = (GdkScrollEvent *) event;
+  dx = self->delta_x;
+  dy = self->delta_y;
 
-  while (scrolls && scrolls->next != NULL)
+  if (info->scroll != NULL &&
+      info->scroll_barrier == display->event_barrier)
     {
-      GdkEvent *event = scrolls->data;
-      GList *next = scrolls->next;
-      double dx, dy;
-
-      if (!history)
-        history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
-
-      gdk_scroll_event_get_deltas (event, &dx, &dy);
-      delta_x += dx;
-      delta_y += dy;
-
-      memset (&hist, 0, sizeof (GdkTimeCoord));
-      hist.time = gdk_event_get_time (event);
-      hist.flags = GDK_AXIS_FLAG_DELTA_X | GDK_AXIS_FLAG_DELTA_Y;
-      hist.axes[GDK_AXIS_DELTA_X] = dx;
-      hist.axes[GDK_AXIS_DELTA_Y] = dy;
+      GdkScrollEvent *prev = info->scroll->data;
+      GdkTimeCoord hist;
 
-      g_array_append_val (history, hist);
-
-      gdk_event_unref (event);
-      g_queue_delete_link (&display->queued_events, scrolls);
-      scrolls = next;
+      if ((((GdkEvent *) prev)->flags & GDK_EVENT_PENDING) == 0 &&
+          ((GdkEvent *) prev)->surface == event->surface)
+        {
+          if (prev->history)
+            {
+              g_clear_pointer (&self->history, g_array_unref);
+              self->history = g_steal_pointer (&prev->history);
+            }
+          else if (!self->history)
+            self->history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
+
+          memset (&hist, 0, sizeof (GdkTimeCoord));
+          hist.time = info->scroll_time;
+          hist.flags = GDK_AXIS_FLAG_DELTA_X | GDK_AXIS_FLAG_DELTA_Y;
+          hist.axes[GDK_AXIS_DELTA_X] = info->scroll_dx;
+          hist.axes[GDK_AXIS_DELTA_Y] = info->scroll_dy;
+          g_array_append_val (self->history, hist);
+
+          self->delta_x += prev->delta_x;
+          self->delta_y += prev->delta_y;
+
+          _gdk_event_queue_remove_link (display, info->scroll);
+          g_list_free_1 (info->scroll);
+          gdk_event_unref ((GdkEvent *) prev);
+        }
     }
 
-  if (scrolls)
-    {
-      GdkEvent *old_event, *event;
-      double dx, dy;
-
-      old_event = scrolls->data;
-
-      gdk_scroll_event_get_deltas (old_event, &dx, &dy);
-      event = gdk_scroll_event_new (surface,
-                                    device,
-                                    gdk_event_get_device_tool (old_event),
-                                    gdk_event_get_time (old_event),
-                                    gdk_event_get_modifier_state (old_event),
-                                    delta_x + dx,
-                                    delta_y + dy,
-                                    gdk_scroll_event_is_stop (old_event));
-
-      ((GdkScrollEvent *)event)->history = history;
-
-      g_queue_delete_link (&display->queued_events, scrolls);
-      g_queue_push_tail (&display->queued_events, event);
+  info->scroll = l;
+  info->scroll_barrier = display->event_barrier;
+  info->scroll_dx = dx;
+  info->scroll_dy = dy;
+  info->scroll_time = event->time;
 
-      gdk_event_unref (old_event);
-    }
-
-  if (g_queue_get_length (&display->queued_events) == 1 &&
-      g_queue_peek_head_link (&display->queued_events) == scrolls)
-    {
-      GdkFrameClock *clock = gdk_surface_get_frame_clock (surface);
-      if (clock) /* might be NULL if surface was destroyed */
-        gdk_frame_clock_request_phase (clock, GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS);
-    }
+  request_flush_if_alone (display, l);
 }
 
 static void
@@ -732,74 +807,69 @@ gdk_motion_event_push_history (GdkEvent *event,
   g_array_append_val (self->history, hist);
 }
 
+/*
+ * If the last event in the event queue is a motion event, drop
+ * the previous motion event of the same device, provided nothing
+ * else happened to that device in between and both are for the
+ * same surface. While a button is held, the dropped event is kept
+ * in the history of the new one.
+ */
 void
 _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
 {
-  GList *tmp_list;
-  GList *pending_motions = NULL;
-  GdkSurface *pending_motion_surface = NULL;
-  GdkDevice *pending_motion_device = NULL;
-  GdkEvent *last_motion = NULL;
-
-  /* If the last N events in the event queue are motion notify
-   * events for the same surface, drop all but the last */
-
-  tmp_list = g_queue_peek_tail_link (&display->queued_events);
-
-  while (tmp_list)
-    {
-      GdkEvent *event = tmp_list->data;
-
-      if (event->flags & GDK_EVENT_PENDING)
-        break;
-
-      if (event->event_type != GDK_MOTION_NOTIFY)
-        break;
-
-      if (pending_motion_surface != NULL &&
-          pending_motion_surface != event->surface)
-        break;
+  GList *l;
+  GdkEvent *event;
+  GdkCoalesceInfo *info;
 
-      if (pending_motion_device != NULL &&
-          pending_motion_device != event->device)
-        break;
+  l = g_queue_peek_tail_link (&display->queued_events);
+  if (l == NULL)
+    return;
 
-      if (!last_motion)
-        last_motion = event;
+  event = l->data;
+  if (event->flags & GDK_EVENT_PENDING)
+    return;
 
-      pending_motion_surface = event->surface;
-      pending_motion_device = event->device;
-      pending_motions = tmp_list;
+  if (event->event_type != GDK_MOTION_NOTIFY)
+    return;
 
-      tmp_list = tmp_list->prev;
-    }
+  info = lookup_coalesce_info (display, event->device, TRUE);
+  if (info == NULL || info->motion == l)
+    return;
 
-  while (pending_motions && pending_motions->next != NULL)
+  if (info->motion != NULL &&
+      info->motion_barrier == display->event_barrier)
     {
-      GList *next = pending_motions->next;
+      GdkEvent *prev = info->motion->data;
 
-      if (last_motion != NULL)
+      if ((prev->flags & GDK_EVENT_PENDING) == 0 &&
+          prev->surface == event->surface)
         {
-          GdkModifierType state = gdk_event_get_modifier_state (last_motion);
+          GdkMotionEvent *self = (GdkMotionEvent *) event;
+          GdkModifierType state = gdk_event_get_modifier_state (event);
 
           if (state &
               (GDK_BUTTON1_MASK | GDK_BUTTON2_MASK | GDK_BUTTON3_MASK |
                GDK_BUTTON4_MASK | GDK_BUTTON5_MASK))
-           gdk_motion_event_push_history (last_motion, pending_motions->data);
-        }
+            {
+              GdkMotionEvent *prev_motion = (GdkMotionEvent *) prev;
 
-      gdk_event_unref (pending_motions->data);
-      g_queue_delete_link (&display->queued_events, pending_motions);
-      pending_motions = next;
-    }
+              /* Keep the history collected by earlier merges */
+              if (prev_motion->history && !self->history)
+                self->history = g_steal_pointer (&prev_motion->history);
 
-  if (g_queue_get_length (&display->queued_events) == 1 &&
-      g_queue_peek_head_link (&display->queued_events) == pending_motions)
-    {
-      GdkFrameClock *clock = gdk_surface_get_frame_clock (pending_motion_surface);
-      if (clock) /* might be NULL if surface was destroyed */
-        gdk_frame_clock_request_phase (clock, GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS);
+              gdk_motion_event_push_history (event, prev);
+            }
+
+          _gdk_event_queue_remove_link (display, info->motion);
+          g_list_free_1 (info->motion);
+          gdk_event_unref (prev);
+        }
     }
+
+  info->motion = l;
+  info->motion_barrier = display->event_barrier;
+
+  request_flush_if_alone (display, l);
 }
 
 void
@@ -808,11 +878,16 @@ _gdk_event_queue_flush (GdkDisplay *display)
   while (TRUE)
     {
       GdkEvent *event;
+      GList *node;
 
-      event = (GdkEvent *)g_queue_pop_head (&display->queued_events);
-      if (!event)
+      node = g_queue_peek_head_link (&display->queued_events);
+      if (!node)
         return;
 
+      event = node->data;
+      _gdk_event_queue_remove_link (display, node);
+      g_list_free_1 (node);
+
       event->flags |= GDK_EVENT_FLUSHED;
       _gdk_event_emit (event);
       gdk_event_unref (event);
@@ -1,4 +1,4 @@
-/* fp16.c
+/* gdkfp16.c
  *
  * Copyright 2021 Red Hat, Inc.
  *
@@ -20,7 +20,7 @@
 
 #include "config.h"
 
-#include "fp16private.h"
+#include "gdkfp16private.h"
 
 static inline guint
 as_uint (const float x)
@@ -1,4 +1,4 @@
-/* fp16i.c
+/* gdkfp16i.c
  *
  * Copyright 2021 Red Hat, Inc.
  *
@@ -20,7 +20,7 @@
 
 #include "config.h"
 
-#include "fp16private.h"
+#include "gdkfp16private.h"
 
 #ifdef HAVE_F16C
 #include <immintrin.h>
@@ -47,7 +47,7 @@ half_to_float4_f16c (const guint16 h[4],
   __m128i i = _mm_loadl_epi64 (CAST_M128I_P (h));
   __m128 s = _mm_cvtph_ps (i);
 
-  _mm_store_ps (f, s);
+  _mm_storeu_ps (f, s);
 }
 
 #endif  /* HAVE_F16C */
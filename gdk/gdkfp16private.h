@@ -1,4 +1,4 @@
-/* fp16private.h
+/* gdkfp16private.h
  *
  * Copyright 2021 Red Hat, Inc.
  *
@@ -18,8 +18,8 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  */
 
-#ifndef __FP16_PRIVATE_H__
-#define __FP16_PRIVATE_H__
+#ifndef __GDK_FP16_PRIVATE_H__
+#define __GDK_FP16_PRIVATE_H__
 
 #include <glib.h>
 
@@ -27,6 +27,9 @@
 #include "gdkframeclockprivate.h"
 #include "gdkinternals.h"
 
+#include <math.h>
+#include <string.h>
+
 /**
  * GdkFrameClock:
  *
@@ -82,6 +85,10 @@ static guint fps_counter;
 
 #define FRAME_HISTORY_MAX_LENGTH 16
 
+/* One histogram per bit in GdkFrameClockPhase */
+#define N_PHASES 7
+#define N_PHASE_BUCKETS 24
+
 struct _GdkFrameClockPrivate
 {
   gint64 frame_counter;
@@ -89,6 +96,10 @@ struct _GdkFrameClockPrivate
   int current;
   GdkFrameTimings *timings[FRAME_HISTORY_MAX_LENGTH];
   int n_freeze_inhibitors;
+
+  guint phase_histograms[N_PHASES][N_PHASE_BUCKETS];
+
+  guint adaptive_scheduling : 1;
 };
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (GdkFrameClock, gdk_frame_clock, G_TYPE_OBJECT)
@@ -663,64 +674,245 @@ gdk_frame_clock_get_refresh_info (GdkFrameClock *frame_clock,
     *refresh_interval_return = default_refresh_interval;
 }
 
+static void
+gdk_frame_clock_end_phase (GdkFrameClock      *frame_clock,
+                           GdkFrameClockPhase  phase,
+                           gint64              before,
+                           const char         *mark_name)
+{
+  GdkFrameClockPrivate *priv = frame_clock->priv;
+  gint64 duration;
+  int bucket;
+
+  duration = g_get_monotonic_time () - before;
+
+  bucket = duration > 0 ? g_bit_storage (duration) : 0;
+  bucket = MIN (bucket, N_PHASE_BUCKETS - 1);
+  priv->phase_histograms[g_bit_nth_lsf (phase, -1)][bucket]++;
+
+  if (mark_name)
+    gdk_profiler_add_mark (before * 1000, duration * 1000, mark_name, NULL);
+}
+
 void
 _gdk_frame_clock_emit_flush_events (GdkFrameClock *frame_clock)
 {
+  gint64 before = g_get_monotonic_time ();
+
   g_signal_emit (frame_clock, signals[FLUSH_EVENTS], 0);
+
+  gdk_frame_clock_end_phase (frame_clock, GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS, before, NULL);
 }
 
 void
 _gdk_frame_clock_emit_before_paint (GdkFrameClock *frame_clock)
 {
+  gint64 before = g_get_monotonic_time ();
+
   g_signal_emit (frame_clock, signals[BEFORE_PAINT], 0);
+
+  gdk_frame_clock_end_phase (frame_clock, GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT, before, NULL);
 }
 
 void
 _gdk_frame_clock_emit_update (GdkFrameClock *frame_clock)
 {
-  gint64 before G_GNUC_UNUSED;
-
-  before = GDK_PROFILER_CURRENT_TIME;
+  gint64 before = g_get_monotonic_time ();
 
   g_signal_emit (frame_clock, signals[UPDATE], 0);
 
-  gdk_profiler_end_mark (before, "frameclock update", NULL);
+  gdk_frame_clock_end_phase (frame_clock, GDK_FRAME_CLOCK_PHASE_UPDATE, before, "frameclock update");
 }
 
 void
 _gdk_frame_clock_emit_layout (GdkFrameClock *frame_clock)
 {
-  gint64 before G_GNUC_UNUSED;
-
-  before = GDK_PROFILER_CURRENT_TIME;
+  gint64 before = g_get_monotonic_time ();
 
   g_signal_emit (frame_clock, signals[LAYOUT], 0);
 
-  gdk_profiler_end_mark (before, "frameclock layout", NULL);
+  gdk_frame_clock_end_phase (frame_clock, GDK_FRAME_CLOCK_PHASE_LAYOUT, before, "frameclock layout");
 }
 
 void
 _gdk_frame_clock_emit_paint (GdkFrameClock *frame_clock)
 {
-  gint64 before G_GNUC_UNUSED;
-
-  before = GDK_PROFILER_CURRENT_TIME;
+  gint64 before = g_get_monotonic_time ();
 
   g_signal_emit (frame_clock, signals[PAINT], 0);
 
-  gdk_profiler_end_mark (before, "frameclock paint", NULL);
+  gdk_frame_clock_end_phase (frame_clock, GDK_FRAME_CLOCK_PHASE_PAINT, before, "frameclock paint");
 }
 
 void
 _gdk_frame_clock_emit_after_paint (GdkFrameClock *frame_clock)
 {
+  gint64 before = g_get_monotonic_time ();
+
   g_signal_emit (frame_clock, signals[AFTER_PAINT], 0);
+
+  gdk_frame_clock_end_phase (frame_clock, GDK_FRAME_CLOCK_PHASE_AFTER_PAINT, before, NULL);
 }
 
 void
 _gdk_frame_clock_emit_resume_events (GdkFrameClock *frame_clock)
 {
+  gint64 before = g_get_monotonic_time ();
+
   g_signal_emit (frame_clock, signals[RESUME_EVENTS], 0);
+
+  gdk_frame_clock_end_phase (frame_clock, GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS, before, NULL);
+}
+
+/**
+ * gdk_frame_clock_get_phase_histogram:
+ * @frame_clock: a `GdkFrameClock`
+ * @phase: a single phase
+ * @n_buckets: (out): return location for the number of buckets
+ *
+ * Returns a histogram of the time spent in @phase.
+ *
+ * Bucket 0 counts phases that took less than a microsecond. For
+ * i > 0, bucket i counts phases that took at least 2^(i-1), but
+ * less than 2^i microseconds. The last bucket also counts all
+ * longer phases.
+ *
+ * The histograms keep counting until they are cleared with
+ * [method@Gdk.FrameClock.reset_phase_histograms].
+ *
+ * Returns: (array length=n_buckets) (transfer none): the histogram
+ *
+ * Since: 4.4
+ */
+const guint *
+gdk_frame_clock_get_phase_histogram (GdkFrameClock      *frame_clock,
+                                     GdkFrameClockPhase  phase,
+                                     gsize              *n_buckets)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), NULL);
+  g_return_val_if_fail (phase != 0 && (phase & (phase - 1)) == 0, NULL);
+  g_return_val_if_fail (phase <= GDK_FRAME_CLOCK_PHASE_AFTER_PAINT, NULL);
+  g_return_val_if_fail (n_buckets != NULL, NULL);
+
+  *n_buckets = N_PHASE_BUCKETS;
+
+  return frame_clock->priv->phase_histograms[g_bit_nth_lsf (phase, -1)];
+}
+
+/**
+ * gdk_frame_clock_get_phase_percentile:
+ * @frame_clock: a `GdkFrameClock`
+ * @phase: a single phase
+ * @percentile: the percentile to compute, between 0 and 100
+ *
+ * Estimates how long @phase takes, from the histogram returned
+ * by [method@Gdk.FrameClock.get_phase_histogram].
+ *
+ * The returned value is the upper end of the histogram bucket that
+ * contains the given percentile, so it is accurate to within a
+ * factor of 2. For example, a @percentile of 95 returns a duration
+ * that at least 95% of the phases did not exceed.
+ *
+ * Returns: the duration in microseconds, or 0 if the phase
+ *   has not run yet
+ *
+ * Since: 4.4
+ */
+gint64
+gdk_frame_clock_get_phase_percentile (GdkFrameClock      *frame_clock,
+                                      GdkFrameClockPhase  phase,
+                                      double              percentile)
+{
+  const guint *histogram;
+  gsize n_buckets, i;
+  guint64 total, sum, target;
+
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), 0);
+  g_return_val_if_fail (percentile >= 0 && percentile <= 100, 0);
+
+  histogram = gdk_frame_clock_get_phase_histogram (frame_clock, phase, &n_buckets);
+  if (histogram == NULL)
+    return 0;
+
+  total = 0;
+  for (i = 0; i < n_buckets; i++)
+    total += histogram[i];
+
+  if (total == 0)
+    return 0;
+
+  target = MAX (1, (guint64) ceil (total * percentile / 100.0));
+
+  sum = 0;
+  for (i = 0; i < n_buckets; i++)
+    {
+      sum += histogram[i];
+      if (sum >= target)
+        break;
+    }
+
+  return G_GINT64_CONSTANT (1) << i;
+}
+
+/**
+ * gdk_frame_clock_reset_phase_histograms:
+ * @frame_clock: a `GdkFrameClock`
+ *
+ * Clears the histograms of all phases.
+ *
+ * Since: 4.4
+ */
+void
+gdk_frame_clock_reset_phase_histograms (GdkFrameClock *frame_clock)
+{
+  g_return_if_fail (GDK_IS_FRAME_CLOCK (frame_clock));
+
+  memset (frame_clock->priv->phase_histograms, 0, sizeof (frame_clock->priv->phase_histograms));
+}
+
+/**
+ * gdk_frame_clock_set_adaptive_scheduling:
+ * @frame_clock: a `GdkFrameClock`
+ * @adaptive: %TRUE to enable adaptive scheduling
+ *
+ * Sets whether @frame_clock delays the start of frames.
+ *
+ * Normally a frame is started right after the previous one was
+ * presented. With adaptive scheduling, if the recent frames needed
+ * only a fraction of the refresh interval, the next frame is started
+ * later, so that input arriving in the meantime is still handled in
+ * that frame. This reduces latency, but makes it more likely to miss
+ * a refresh if the time needed per frame suddenly increases.
+ *
+ * Since: 4.4
+ */
+void
+gdk_frame_clock_set_adaptive_scheduling (GdkFrameClock *frame_clock,
+                                         gboolean       adaptive)
+{
+  g_return_if_fail (GDK_IS_FRAME_CLOCK (frame_clock));
+
+  frame_clock->priv->adaptive_scheduling = !!adaptive;
+}
+
+/**
+ * gdk_frame_clock_get_adaptive_scheduling:
+ * @frame_clock: a `GdkFrameClock`
+ *
+ * Returns whether adaptive scheduling is enabled for @frame_clock.
+ *
+ * See [method@Gdk.FrameClock.set_adaptive_scheduling].
+ *
+ * Returns: %TRUE if adaptive scheduling is enabled
+ *
+ * Since: 4.4
+ */
+gboolean
+gdk_frame_clock_get_adaptive_scheduling (GdkFrameClock *frame_clock)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), FALSE);
+
+  return frame_clock->priv->adaptive_scheduling;
 }
 
 static gint64
@@ -816,5 +1008,6 @@ _gdk_frame_clock_add_timings_to_profiler (GdkFrameClock   *clock,
       gdk_profiler_add_mark (1000 * timings->presentation_time, 0, "presented window", NULL);
     }
 
-  gdk_profiler_set_counter (fps_counter, gdk_frame_clock_get_fps (clock));
+  if (GDK_PROFILER_IS_RUNNING)
+    gdk_profiler_set_counter (fps_counter, gdk_frame_clock_get_fps (clock));
 }
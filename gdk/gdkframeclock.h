@@ -106,6 +106,24 @@ void gdk_frame_clock_get_refresh_info (GdkFrameClock *frame_clock,
 GDK_AVAILABLE_IN_ALL
 double gdk_frame_clock_get_fps (GdkFrameClock *frame_clock);
 
+/* Phase statistics */
+GDK_AVAILABLE_IN_4_4
+const guint *    gdk_frame_clock_get_phase_histogram     (GdkFrameClock      *frame_clock,
+                                                          GdkFrameClockPhase  phase,
+                                                          gsize              *n_buckets);
+GDK_AVAILABLE_IN_4_4
+gint64           gdk_frame_clock_get_phase_percentile    (GdkFrameClock      *frame_clock,
+                                                          GdkFrameClockPhase  phase,
+                                                          double              percentile);
+GDK_AVAILABLE_IN_4_4
+void             gdk_frame_clock_reset_phase_histograms  (GdkFrameClock      *frame_clock);
+
+GDK_AVAILABLE_IN_4_4
+void             gdk_frame_clock_set_adaptive_scheduling (GdkFrameClock      *frame_clock,
+                                                          gboolean            adaptive);
+GDK_AVAILABLE_IN_4_4
+gboolean         gdk_frame_clock_get_adaptive_scheduling (GdkFrameClock      *frame_clock);
+
 G_END_DECLS
 
 #endif /* __GDK_FRAME_CLOCK_H__ */
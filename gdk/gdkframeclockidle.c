@@ -37,6 +37,11 @@
 
 #define FRAME_INTERVAL 16667 /* microseconds */
 
+/* Adaptive scheduling looks at the work of this many frames */
+#define WORK_HISTORY_LENGTH 16
+/* ...and keeps at least this much of the frame interval unused */
+#define MIN_ADAPTIVE_MARGIN 1000 /* microseconds */
+
 typedef enum {
   SMOOTH_PHASE_STATE_VALID = 0,    /* explicit, since we count on zero-init */
   SMOOTH_PHASE_STATE_AWAIT_FIRST,
@@ -59,6 +64,10 @@ struct _GdkFrameClockIdlePrivate
   gint64 sleep_serial;
   gint64 freeze_time; /* in microseconds */
 
+  gint64 work_history[WORK_HISTORY_LENGTH]; /* How long recent frame cycles took, in microseconds */
+  guint n_work_history;
+  gint64 adaptive_delay;               /* How much later than the vsync the current cycle was scheduled */
+
   guint flush_idle_id;
   guint paint_idle_id;
   guint freeze_count;
@@ -392,6 +401,47 @@ positive_modulo (int i, int n)
   return (i % n + n) % n;
 }
 
+static void
+record_frame_work (GdkFrameClockIdlePrivate *priv,
+                   gint64                    work)
+{
+  priv->work_history[priv->n_work_history % WORK_HISTORY_LENGTH] = work;
+  priv->n_work_history++;
+}
+
+/*
+ * With adaptive scheduling, we start the next cycle later than the
+ * vsync when the recent cycles fit well into the frame interval.
+ * Input that arrives in the meantime is then handled in the next
+ * frame instead of the one after it.
+ *
+ * We are conservative: the delay is half of what remains of the frame
+ * interval after the slowest recent cycle and a safety margin, so
+ * that a frame that takes twice as long as usual still makes it.
+ */
+static gint64
+compute_adaptive_delay (GdkFrameClock *clock,
+                        gint64         frame_interval)
+{
+  GdkFrameClockIdlePrivate *priv = GDK_FRAME_CLOCK_IDLE (clock)->priv;
+  gint64 max_work, slack;
+  guint i;
+
+  if (!gdk_frame_clock_get_adaptive_scheduling (clock) ||
+      priv->n_work_history < WORK_HISTORY_LENGTH)
+    return 0;
+
+  max_work = 0;
+  for (i = 0; i < WORK_HISTORY_LENGTH; i++)
+    max_work = MAX (max_work, priv->work_history[i]);
+
+  slack = frame_interval - 2 * max_work - MAX (MIN_ADAPTIVE_MARGIN, frame_interval / 8);
+  if (slack <= 0)
+    return 0;
+
+  return slack / 2;
+}
+
 static gboolean
 gdk_frame_clock_paint_idle (void *data)
 {
@@ -429,11 +479,15 @@ gdk_frame_clock_paint_idle (void *data)
             {
               gint64 frame_interval = FRAME_INTERVAL;
               GdkFrameTimings *prev_timings = gdk_frame_clock_get_current_timings (clock);
+              gint64 vsync_frame_time;
 
               if (prev_timings && prev_timings->refresh_interval)
                 frame_interval = prev_timings->refresh_interval;
 
               priv->frame_time = g_get_monotonic_time ();
+              /* Take out the adaptive delay, so smoothing stays aligned to the vsync */
+              vsync_frame_time = priv->frame_time - priv->adaptive_delay;
+              priv->adaptive_delay = 0;
 
               /*
                * The first clock cycle of an animation might have been triggered by some external event. An external
@@ -496,7 +550,7 @@ gdk_frame_clock_paint_idle (void *data)
                   /* First vsync-related animation cycle, we can now compute the phase. We want the phase to satisfy
                      0 <= phase < frame_interval */
                   priv->smoothed_frame_time_phase =
-                      positive_modulo (priv->smoothed_frame_time_base - priv->frame_time,
+                      positive_modulo (priv->smoothed_frame_time_base - vsync_frame_time,
                                        frame_interval);
                   priv->smooth_phase_state = SMOOTH_PHASE_STATE_VALID;
                 }
@@ -504,13 +558,13 @@ gdk_frame_clock_paint_idle (void *data)
               if (priv->smoothed_frame_time_base == 0)
                 {
                   /* First frame ever, or first cycle in a new animation sequence. Ensure monotonicity */
-                  priv->smoothed_frame_time_base = MAX (priv->frame_time, priv->smoothed_frame_time_reported);
+                  priv->smoothed_frame_time_base = MAX (vsync_frame_time, priv->smoothed_frame_time_reported);
                 }
               else
                 {
                   /* compute_smooth_frame_time() ensures monotonicity */
                   priv->smoothed_frame_time_base =
-                      compute_smooth_frame_time (clock, priv->frame_time + priv->smoothed_frame_time_phase,
+                      compute_smooth_frame_time (clock, vsync_frame_time + priv->smoothed_frame_time_phase,
                                                  priv->paint_is_thaw,
                                                  priv->smoothed_frame_time_base,
                                                  priv->smoothed_frame_time_period);
@@ -612,6 +666,8 @@ gdk_frame_clock_paint_idle (void *data)
               /* the ::after-paint phase doesn't get repeated on freeze/thaw,
                */
               priv->phase = GDK_FRAME_CLOCK_PHASE_NONE;
+
+              record_frame_work (priv, g_get_monotonic_time () - priv->frame_time);
             }
 #ifdef G_ENABLE_DEBUG
             if (GDK_DEBUG_CHECK (FRAMES))
@@ -653,7 +709,9 @@ gdk_frame_clock_paint_idle (void *data)
        * receiving "frame drawn" events shortly after losing them, then we should still be in sync.
        */
       gint64 smooth_cycle_start = priv->smoothed_frame_time_base - priv->smoothed_frame_time_phase;
-      priv->min_next_frame_time = smooth_cycle_start + priv->smoothed_frame_time_period;
+
+      priv->adaptive_delay = compute_adaptive_delay (clock, priv->smoothed_frame_time_period);
+      priv->min_next_frame_time = smooth_cycle_start + priv->smoothed_frame_time_period + priv->adaptive_delay;
 
       maybe_start_idle (clock_idle, FALSE);
     }
@@ -753,6 +811,14 @@ gdk_frame_clock_idle_thaw (GdkFrameClock *clock)
   priv->freeze_count--;
   if (priv->freeze_count == 0)
     {
+      /* Backends that throttle us thaw the clock when the compositor
+       * is ready for the next frame, which is close to the vsync, so
+       * this is where the adaptive delay needs to go for them.
+       */
+      priv->adaptive_delay = compute_adaptive_delay (clock, priv->smoothed_frame_time_period);
+      if (priv->adaptive_delay > 0)
+        priv->min_next_frame_time = g_get_monotonic_time () + priv->adaptive_delay;
+
       maybe_start_idle (clock_idle, TRUE);
       /* If nothing is requested so we didn't start an idle, we need
        * to skip to the end of the state chain, since the idle won't
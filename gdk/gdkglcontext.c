@@ -222,13 +222,24 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
 {
   GdkGLContextPrivate *priv = gdk_gl_context_get_instance_private (context);
   guchar *copy = NULL;
+  guint gl_internalformat;
   guint gl_format;
   guint gl_type;
   guint bpp;
 
   g_return_if_fail (GDK_IS_GL_CONTEXT (context));
 
-  if (priv->use_es)
+  gl_internalformat = GL_RGBA;
+
+  if (priv->use_es && priv->gl_version >= 30 &&
+      data_format == GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED)
+    {
+      gl_internalformat = GL_RGBA16F;
+      gl_format = GL_RGBA;
+      gl_type = GL_HALF_FLOAT;
+      bpp = 8;
+    }
+  else if (priv->use_es)
     {
       /* GLES only supports rgba, so convert if necessary */
       if (data_format != GDK_MEMORY_R8G8B8A8_PREMULTIPLIED)
@@ -266,6 +277,21 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
           gl_type = GL_UNSIGNED_BYTE;
           bpp = 3;
         }
+      else if (data_format == GDK_MEMORY_R16G16B16A16_PREMULTIPLIED)
+        {
+          gl_internalformat = GL_RGBA16;
+          gl_format = GL_RGBA;
+          gl_type = GL_UNSIGNED_SHORT;
+          bpp = 8;
+        }
+      else if (data_format == GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED &&
+               priv->gl_version >= 30)
+        {
+          gl_internalformat = GL_RGBA16F;
+          gl_format = GL_RGBA;
+          gl_type = GL_HALF_FLOAT;
+          bpp = 8;
+        }
       else /* Fall-back, convert to cairo-surface-format */
         {
           copy = g_malloc (width * height * 4);
@@ -288,22 +314,23 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
     {
       glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
 
-      glTexImage2D (texture_target, 0, GL_RGBA, width, height, 0, gl_format, gl_type, data);
+      glTexImage2D (texture_target, 0, gl_internalformat, width, height, 0, gl_format, gl_type, data);
       glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
     }
-  else if ((!priv->use_es ||
+  else if (stride % bpp == 0 &&
+           (!priv->use_es ||
             (priv->use_es && (priv->gl_version >= 30 || priv->has_unpack_subimage))))
     {
       glPixelStorei (GL_UNPACK_ROW_LENGTH, stride / bpp);
 
-      glTexImage2D (texture_target, 0, GL_RGBA, width, height, 0, gl_format, gl_type, data);
+      glTexImage2D (texture_target, 0, gl_internalformat, width, height, 0, gl_format, gl_type, data);
 
       glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
     }
   else
     {
       int i;
-      glTexImage2D (texture_target, 0, GL_RGBA, width, height, 0, gl_format, gl_type, NULL);
+      glTexImage2D (texture_target, 0, gl_internalformat, width, height, 0, gl_format, gl_type, NULL);
       for (i = 0; i < height; i++)
         glTexSubImage2D (texture_target, 0, 0, i, width, 1, gl_format, gl_type, data + (i * stride));
     }
@@ -21,6 +21,14 @@
 
 #include "gdkmemorytextureprivate.h"
 
+#include "gdkfp16private.h"
+
+#include <gio/gio.h>
+
+#ifdef G_OS_UNIX
+#include <fcntl.h>
+#endif
+
 /**
  * GdkMemoryTexture:
  *
@@ -62,6 +70,10 @@ gdk_memory_format_bytes_per_pixel (GdkMemoryFormat format)
     case GDK_MEMORY_B8G8R8:
       return 3;
 
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+      return 8;
+
     case GDK_MEMORY_N_FORMATS:
     default:
       g_assert_not_reached ();
@@ -69,6 +81,34 @@ gdk_memory_format_bytes_per_pixel (GdkMemoryFormat format)
     }
 }
 
+/* The alignment the data and stride of the format must have */
+gsize
+gdk_memory_format_alignment (GdkMemoryFormat format)
+{
+  switch (format)
+    {
+    case GDK_MEMORY_B8G8R8A8_PREMULTIPLIED:
+    case GDK_MEMORY_A8R8G8B8_PREMULTIPLIED:
+    case GDK_MEMORY_R8G8B8A8_PREMULTIPLIED:
+    case GDK_MEMORY_B8G8R8A8:
+    case GDK_MEMORY_A8R8G8B8:
+    case GDK_MEMORY_R8G8B8A8:
+    case GDK_MEMORY_A8B8G8R8:
+    case GDK_MEMORY_R8G8B8:
+    case GDK_MEMORY_B8G8R8:
+      return 1;
+
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+      return 2;
+
+    case GDK_MEMORY_N_FORMATS:
+    default:
+      g_assert_not_reached ();
+      return 1;
+    }
+}
+
 static void
 gdk_memory_texture_dispose (GObject *object)
 {
@@ -125,6 +165,9 @@ gdk_memory_texture_init (GdkMemoryTexture *self)
  * The `GBytes` must contain @stride x @height pixels
  * in the given format.
  *
+ * For formats with 16 bits per channel, the data and @stride should
+ * be aligned to 2 bytes, otherwise the data will be copied.
+ *
  * Returns: A newly-created `GdkTexture`
  */
 GdkTexture *
@@ -135,19 +178,202 @@ gdk_memory_texture_new (int              width,
                         gsize            stride)
 {
   GdkMemoryTexture *self;
+  gsize align;
 
   self = g_object_new (GDK_TYPE_MEMORY_TEXTURE,
                        "width", width,
                        "height", height,
                        NULL);
 
+  align = gdk_memory_format_alignment (format);
+  if (GPOINTER_TO_SIZE (g_bytes_get_data (bytes, NULL)) % align != 0 ||
+      stride % align != 0)
+    {
+      gsize bpp = gdk_memory_format_bytes_per_pixel (format);
+      const guchar *data = g_bytes_get_data (bytes, NULL);
+      guchar *copy;
+      int y;
+
+      copy = g_malloc_n (height, width * bpp);
+      for (y = 0; y < height; y++)
+        memcpy (copy + y * width * bpp, data + y * stride, width * bpp);
+
+      self->bytes = g_bytes_new_take (copy, height * width * bpp);
+      self->stride = width * bpp;
+    }
+  else
+    {
+      self->bytes = g_bytes_ref (bytes);
+      self->stride = stride;
+    }
+
   self->format = format;
-  self->bytes = g_bytes_ref (bytes);
-  self->stride = stride;
 
   return GDK_TEXTURE (self);
 }
 
+/* Checks that @stride can hold a row of @width pixels and that
+ * the image fits into @length bytes, without overflowing.
+ */
+static gboolean
+gdk_memory_texture_check_size (int             width,
+                               int             height,
+                               GdkMemoryFormat format,
+                               gsize           stride,
+                               gsize           length)
+{
+  gsize bpp = gdk_memory_format_bytes_per_pixel (format);
+  gsize row_size;
+
+  if ((gsize) width > G_MAXSIZE / bpp)
+    return FALSE;
+
+  row_size = width * bpp;
+  if (stride < row_size || row_size > length)
+    return FALSE;
+
+  return (gsize) (height - 1) <= (length - row_size) / stride;
+}
+
+/**
+ * gdk_memory_texture_new_from_mapped_file:
+ * @mapped_file: the `GMappedFile` containing the pixel data
+ * @offset: offset of the first pixel in @mapped_file
+ * @width: the width of the texture
+ * @height: the height of the texture
+ * @format: the format of the data
+ * @stride: rowstride for the data
+ *
+ * Creates a new texture for image data in a memory-mapped file.
+ *
+ * The pixel data is used directly, it is not copied. The texture
+ * keeps a reference to @mapped_file for as long as it needs the data.
+ *
+ * The file must not be modified while the texture exists.
+ *
+ * Returns: A newly-created `GdkTexture`
+ *
+ * Since: 4.4
+ */
+GdkTexture *
+gdk_memory_texture_new_from_mapped_file (GMappedFile     *mapped_file,
+                                         gsize            offset,
+                                         int              width,
+                                         int              height,
+                                         GdkMemoryFormat  format,
+                                         gsize            stride)
+{
+  GdkTexture *texture;
+  GBytes *bytes;
+  gsize length;
+
+  g_return_val_if_fail (mapped_file != NULL, NULL);
+  g_return_val_if_fail (width > 0, NULL);
+  g_return_val_if_fail (height > 0, NULL);
+  g_return_val_if_fail (format < GDK_MEMORY_N_FORMATS, NULL);
+
+  length = g_mapped_file_get_length (mapped_file);
+  g_return_val_if_fail (offset <= length, NULL);
+  g_return_val_if_fail (gdk_memory_texture_check_size (width, height, format, stride, length - offset), NULL);
+
+  bytes = g_bytes_new_with_free_func (g_mapped_file_get_contents (mapped_file) + offset,
+                                      length - offset,
+                                      (GDestroyNotify) g_mapped_file_unref,
+                                      g_mapped_file_ref (mapped_file));
+
+  texture = gdk_memory_texture_new (width, height, format, bytes, stride);
+
+  g_bytes_unref (bytes);
+
+  return texture;
+}
+
+/**
+ * gdk_memory_texture_new_from_fd:
+ * @fd: a file descriptor
+ * @offset: offset of the first pixel in the file
+ * @width: the width of the texture
+ * @height: the height of the texture
+ * @format: the format of the data
+ * @stride: rowstride for the data
+ * @error: Return location for an error
+ *
+ * Creates a new texture for image data in a file descriptor,
+ * by mapping it into memory.
+ *
+ * The pixel data is used directly, it is not copied. @fd is not
+ * used after this function returns, so it may be closed.
+ *
+ * If @fd supports sealing, like a memfd created with
+ * `MFD_ALLOW_SEALING`, it must be sealed against writing and
+ * shrinking. Otherwise the caller must make sure that the file
+ * is not modified while the texture exists.
+ *
+ * If %NULL is returned, then @error will be set.
+ *
+ * Returns: A newly-created `GdkTexture`
+ *
+ * Since: 4.4
+ */
+GdkTexture *
+gdk_memory_texture_new_from_fd (int               fd,
+                                gsize             offset,
+                                int               width,
+                                int               height,
+                                GdkMemoryFormat   format,
+                                gsize             stride,
+                                GError          **error)
+{
+  GMappedFile *mapped_file;
+  GdkTexture *texture;
+  gsize length;
+
+  g_return_val_if_fail (fd >= 0, NULL);
+  g_return_val_if_fail (width > 0, NULL);
+  g_return_val_if_fail (height > 0, NULL);
+  g_return_val_if_fail (format < GDK_MEMORY_N_FORMATS, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+#ifdef F_GET_SEALS
+  {
+    const int required = F_SEAL_WRITE | F_SEAL_SHRINK;
+    int seals;
+
+    /* Files that can't be sealed report F_SEAL_SEAL only */
+    seals = fcntl (fd, F_GET_SEALS);
+    if (seals != -1 && seals != F_SEAL_SEAL && (seals & required) != required)
+      {
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                             "File descriptor is not sealed against writing and shrinking");
+        return NULL;
+      }
+  }
+#endif
+
+  mapped_file = g_mapped_file_new_from_fd (fd, FALSE, error);
+  if (mapped_file == NULL)
+    return NULL;
+
+  length = g_mapped_file_get_length (mapped_file);
+  if (offset > length ||
+      !gdk_memory_texture_check_size (width, height, format, stride, length - offset))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                   "Invalid stride or file too small for a %dx%d image with stride %" G_GSIZE_FORMAT,
+                   width, height, stride);
+      g_mapped_file_unref (mapped_file);
+      return NULL;
+    }
+
+  texture = gdk_memory_texture_new_from_mapped_file (mapped_file, offset,
+                                                     width, height,
+                                                     format, stride);
+
+  g_mapped_file_unref (mapped_file);
+
+  return texture;
+}
+
 GdkMemoryFormat 
 gdk_memory_texture_get_format (GdkMemoryTexture *self)
 {
@@ -166,6 +392,382 @@ gdk_memory_texture_get_stride (GdkMemoryTexture *self)
   return self->stride;
 }
 
+/* {{{ SIMD row converters */
+
+/* The SIMD converters convert the beginning of a row and return the
+ * number of pixels they handled, the scalar code does the rest.
+ *
+ * They must give the exact same results as the scalar code.
+ *
+ * @order is the position of the alpha, red, green and blue bytes
+ * in the destination pixel, @src_order the same for the source pixel.
+ */
+typedef gsize (* SwizzleRowFunc) (guchar       *dest,
+                                  const guchar *src,
+                                  gsize         width,
+                                  const guchar  order[4]);
+typedef gsize (* PremultiplyRowFunc) (guchar       *dest,
+                                      const guchar *src,
+                                      gsize         width,
+                                      const guchar  order[4],
+                                      const guchar  src_order[4]);
+
+static gsize
+swizzle_row_none (guchar       *dest,
+                  const guchar *src,
+                  gsize         width,
+                  const guchar  order[4])
+{
+  return 0;
+}
+
+static gsize
+premultiply_row_none (guchar       *dest,
+                      const guchar *src,
+                      gsize         width,
+                      const guchar  order[4],
+                      const guchar  src_order[4])
+{
+  return 0;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+
+__attribute__((target ("ssse3")))
+static gsize
+swizzle_row_ssse3 (guchar       *dest,
+                   const guchar *src,
+                   gsize         width,
+                   const guchar  order[4])
+{
+  gint8 m[16];
+  __m128i mask;
+  gsize i, x;
+
+  for (i = 0; i < 16; i += 4)
+    {
+      m[i + order[0]] = i + 0;
+      m[i + order[1]] = i + 1;
+      m[i + order[2]] = i + 2;
+      m[i + order[3]] = i + 3;
+    }
+  mask = _mm_loadu_si128 ((const __m128i *) m);
+
+  for (x = 0; x + 4 <= width; x += 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (src + 4 * x));
+      _mm_storeu_si128 ((__m128i *) (dest + 4 * x), _mm_shuffle_epi8 (v, mask));
+    }
+
+  return x;
+}
+
+__attribute__((target ("ssse3")))
+static gsize
+swizzle_opaque_row_ssse3 (guchar       *dest,
+                          const guchar *src,
+                          gsize         width,
+                          const guchar  order[4])
+{
+  gint8 m[16], a[16];
+  __m128i mask, alpha;
+  gsize i, x;
+
+  for (i = 0; i < 4; i++)
+    {
+      m[4 * i + order[0]] = -1; /* zero */
+      m[4 * i + order[1]] = 3 * i + 0;
+      m[4 * i + order[2]] = 3 * i + 1;
+      m[4 * i + order[3]] = 3 * i + 2;
+      a[4 * i + order[0]] = -1;
+      a[4 * i + order[1]] = 0;
+      a[4 * i + order[2]] = 0;
+      a[4 * i + order[3]] = 0;
+    }
+  mask = _mm_loadu_si128 ((const __m128i *) m);
+  alpha = _mm_loadu_si128 ((const __m128i *) a);
+
+  /* We load 16 bytes but only use 12, so make sure we don't read
+   * past the end of the row. */
+  for (x = 0; x + 6 <= width; x += 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (src + 3 * x));
+      v = _mm_or_si128 (_mm_shuffle_epi8 (v, mask), alpha);
+      _mm_storeu_si128 ((__m128i *) (dest + 4 * x), v);
+    }
+
+  return x;
+}
+
+/* Computes ((t >> 8) + t) >> 8 with t = c * a + 0x80, like PREMULTIPLY() */
+#define PREMULTIPLY_EPI16(c, a, bias) \
+  _mm_srli_epi16 (_mm_add_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (c, a), bias), \
+                                 _mm_srli_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (c, a), bias), 8)), 8)
+
+__attribute__((target ("ssse3")))
+static gsize
+premultiply_row_ssse3 (guchar       *dest,
+                       const guchar *src,
+                       gsize         width,
+                       const guchar  order[4],
+                       const guchar  src_order[4])
+{
+  gint8 m[16], am[16], k[16];
+  __m128i mask, alpha_mask, keep, zero, bias;
+  gsize i, j, x;
+
+  for (i = 0; i < 16; i += 4)
+    {
+      for (j = 0; j < 4; j++)
+        {
+          m[i + order[j]] = i + src_order[j];
+          am[i + j] = i + order[0];
+          k[i + j] = j == order[0] ? -1 : 0;
+        }
+    }
+  mask = _mm_loadu_si128 ((const __m128i *) m);
+  alpha_mask = _mm_loadu_si128 ((const __m128i *) am);
+  keep = _mm_loadu_si128 ((const __m128i *) k);
+  zero = _mm_setzero_si128 ();
+  bias = _mm_set1_epi16 (0x80);
+
+  for (x = 0; x + 4 <= width; x += 4)
+    {
+      __m128i v, a, lo, hi;
+
+      v = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (src + 4 * x)), mask);
+      a = _mm_shuffle_epi8 (v, alpha_mask);
+
+      lo = PREMULTIPLY_EPI16 (_mm_unpacklo_epi8 (v, zero), _mm_unpacklo_epi8 (a, zero), bias);
+      hi = PREMULTIPLY_EPI16 (_mm_unpackhi_epi8 (v, zero), _mm_unpackhi_epi8 (a, zero), bias);
+
+      /* put the unmodified alpha back */
+      v = _mm_or_si128 (_mm_andnot_si128 (keep, _mm_packus_epi16 (lo, hi)),
+                        _mm_and_si128 (keep, v));
+      _mm_storeu_si128 ((__m128i *) (dest + 4 * x), v);
+    }
+
+  return x;
+}
+
+/* AVX2 shuffles within 128bit lanes, which is all we need for
+ * 4 byte pixels, so the masks are just the SSSE3 ones twice. */
+
+__attribute__((target ("avx2")))
+static gsize
+swizzle_row_avx2 (guchar       *dest,
+                  const guchar *src,
+                  gsize         width,
+                  const guchar  order[4])
+{
+  gint8 m[32];
+  __m256i mask;
+  gsize i, x;
+
+  for (i = 0; i < 32; i += 4)
+    {
+      m[i + order[0]] = (i % 16) + 0;
+      m[i + order[1]] = (i % 16) + 1;
+      m[i + order[2]] = (i % 16) + 2;
+      m[i + order[3]] = (i % 16) + 3;
+    }
+  mask = _mm256_loadu_si256 ((const __m256i *) m);
+
+  for (x = 0; x + 8 <= width; x += 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) (src + 4 * x));
+      _mm256_storeu_si256 ((__m256i *) (dest + 4 * x), _mm256_shuffle_epi8 (v, mask));
+    }
+
+  return x + swizzle_row_ssse3 (dest + 4 * x, src + 4 * x, width - x, order);
+}
+
+#define PREMULTIPLY_EPI16_AVX2(c, a, bias) \
+  _mm256_srli_epi16 (_mm256_add_epi16 (_mm256_add_epi16 (_mm256_mullo_epi16 (c, a), bias), \
+                                       _mm256_srli_epi16 (_mm256_add_epi16 (_mm256_mullo_epi16 (c, a), bias), 8)), 8)
+
+__attribute__((target ("avx2")))
+static gsize
+premultiply_row_avx2 (guchar       *dest,
+                      const guchar *src,
+                      gsize         width,
+                      const guchar  order[4],
+                      const guchar  src_order[4])
+{
+  gint8 m[32], am[32], k[32];
+  __m256i mask, alpha_mask, keep, zero, bias;
+  gsize i, j, x;
+
+  for (i = 0; i < 32; i += 4)
+    {
+      for (j = 0; j < 4; j++)
+        {
+          m[i + order[j]] = (i % 16) + src_order[j];
+          am[i + j] = (i % 16) + order[0];
+          k[i + j] = j == order[0] ? -1 : 0;
+        }
+    }
+  mask = _mm256_loadu_si256 ((const __m256i *) m);
+  alpha_mask = _mm256_loadu_si256 ((const __m256i *) am);
+  keep = _mm256_loadu_si256 ((const __m256i *) k);
+  zero = _mm256_setzero_si256 ();
+  bias = _mm256_set1_epi16 (0x80);
+
+  for (x = 0; x + 8 <= width; x += 8)
+    {
+      __m256i v, a, lo, hi;
+
+      v = _mm256_shuffle_epi8 (_mm256_loadu_si256 ((const __m256i *) (src + 4 * x)), mask);
+      a = _mm256_shuffle_epi8 (v, alpha_mask);
+
+      lo = PREMULTIPLY_EPI16_AVX2 (_mm256_unpacklo_epi8 (v, zero), _mm256_unpacklo_epi8 (a, zero), bias);
+      hi = PREMULTIPLY_EPI16_AVX2 (_mm256_unpackhi_epi8 (v, zero), _mm256_unpackhi_epi8 (a, zero), bias);
+
+      v = _mm256_or_si256 (_mm256_andnot_si256 (keep, _mm256_packus_epi16 (lo, hi)),
+                           _mm256_and_si256 (keep, v));
+      _mm256_storeu_si256 ((__m256i *) (dest + 4 * x), v);
+    }
+
+  return x + premultiply_row_ssse3 (dest + 4 * x, src + 4 * x, width - x, order, src_order);
+}
+
+#elif defined(__ARM_NEON)
+#define HAVE_NEON_SIMD 1
+#include <arm_neon.h>
+
+static gsize
+swizzle_row_neon (guchar       *dest,
+                  const guchar *src,
+                  gsize         width,
+                  const guchar  order[4])
+{
+  gsize x;
+
+  for (x = 0; x + 16 <= width; x += 16)
+    {
+      uint8x16x4_t s, d;
+
+      s = vld4q_u8 (src + 4 * x);
+      d.val[order[0]] = s.val[0];
+      d.val[order[1]] = s.val[1];
+      d.val[order[2]] = s.val[2];
+      d.val[order[3]] = s.val[3];
+      vst4q_u8 (dest + 4 * x, d);
+    }
+
+  return x;
+}
+
+static gsize
+swizzle_opaque_row_neon (guchar       *dest,
+                         const guchar *src,
+                         gsize         width,
+                         const guchar  order[4])
+{
+  gsize x;
+
+  for (x = 0; x + 16 <= width; x += 16)
+    {
+      uint8x16x3_t s;
+      uint8x16x4_t d;
+
+      s = vld3q_u8 (src + 3 * x);
+      d.val[order[0]] = vdupq_n_u8 (0xFF);
+      d.val[order[1]] = s.val[0];
+      d.val[order[2]] = s.val[1];
+      d.val[order[3]] = s.val[2];
+      vst4q_u8 (dest + 4 * x, d);
+    }
+
+  return x;
+}
+
+static inline uint8x8_t
+premultiply_u8x8 (uint8x8_t c,
+                  uint8x8_t a)
+{
+  uint16x8_t t = vaddq_u16 (vmull_u8 (c, a), vdupq_n_u16 (0x80));
+
+  /* (t + (t >> 8)) >> 8, the sum can't overflow */
+  return vaddhn_u16 (t, vshrq_n_u16 (t, 8));
+}
+
+static gsize
+premultiply_row_neon (guchar       *dest,
+                      const guchar *src,
+                      gsize         width,
+                      const guchar  order[4],
+                      const guchar  src_order[4])
+{
+  gsize i, x;
+
+  for (x = 0; x + 16 <= width; x += 16)
+    {
+      uint8x16x4_t s, d;
+      uint8x16_t a;
+
+      s = vld4q_u8 (src + 4 * x);
+      a = s.val[src_order[0]];
+      d.val[order[0]] = a;
+      for (i = 1; i < 4; i++)
+        {
+          uint8x16_t c = s.val[src_order[i]];
+
+          d.val[order[i]] = vcombine_u8 (premultiply_u8x8 (vget_low_u8 (c), vget_low_u8 (a)),
+                                         premultiply_u8x8 (vget_high_u8 (c), vget_high_u8 (a)));
+        }
+      vst4q_u8 (dest + 4 * x, d);
+    }
+
+  return x;
+}
+
+#endif
+
+static struct {
+  SwizzleRowFunc swizzle;
+  SwizzleRowFunc swizzle_opaque;
+  PremultiplyRowFunc premultiply;
+} simd = {
+  swizzle_row_none,
+  swizzle_row_none,
+  premultiply_row_none
+};
+
+static void
+gdk_memory_convert_init_simd (void)
+{
+  static gsize initialized = 0;
+
+  if (!g_once_init_enter (&initialized))
+    return;
+
+#if defined(HAVE_X86_SIMD)
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("ssse3"))
+    {
+      simd.swizzle = swizzle_row_ssse3;
+      simd.swizzle_opaque = swizzle_opaque_row_ssse3;
+      simd.premultiply = premultiply_row_ssse3;
+    }
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      simd.swizzle = swizzle_row_avx2;
+      simd.premultiply = premultiply_row_avx2;
+    }
+#elif defined(HAVE_NEON_SIMD)
+  simd.swizzle = swizzle_row_neon;
+  simd.swizzle_opaque = swizzle_opaque_row_neon;
+  simd.premultiply = premultiply_row_neon;
+#endif
+
+  g_once_init_leave (&initialized, 1);
+}
+
+/* }}} */
+
 static void
 convert_memcpy (guchar       *dest_data,
                 gsize         dest_stride,
@@ -189,11 +791,12 @@ convert_swizzle ## A ## R ## G ## B (guchar       *dest_data, \
                                      gsize         width, \
                                      gsize         height) \
 { \
+  static const guchar order[4] = { A, R, G, B }; \
   gsize x, y; \
 \
   for (y = 0; y < height; y++) \
     { \
-      for (x = 0; x < width; x++) \
+      for (x = simd.swizzle (dest_data, src_data, width, order); x < width; x++) \
         { \
           dest_data[4 * x + A] = src_data[4 * x + 0]; \
           dest_data[4 * x + R] = src_data[4 * x + 1]; \
@@ -220,11 +823,12 @@ convert_swizzle_opaque_## A ## R ## G ## B (guchar       *dest_data, \
                                             gsize         width, \
                                             gsize         height) \
 { \
+  static const guchar order[4] = { A, R, G, B }; \
   gsize x, y; \
 \
   for (y = 0; y < height; y++) \
     { \
-      for (x = 0; x < width; x++) \
+      for (x = simd.swizzle_opaque (dest_data, src_data, width, order); x < width; x++) \
         { \
           dest_data[4 * x + A] = 0xFF; \
           dest_data[4 * x + R] = src_data[3 * x + 0]; \
@@ -253,11 +857,13 @@ convert_swizzle_premultiply_ ## A ## R ## G ## B ## _ ## A2 ## R2 ## G2 ## B2 \
                                      gsize         width, \
                                      gsize         height) \
 { \
+  static const guchar order[4] = { A, R, G, B }; \
+  static const guchar src_order[4] = { A2, R2, G2, B2 }; \
   gsize x, y; \
 \
   for (y = 0; y < height; y++) \
     { \
-      for (x = 0; x < width; x++) \
+      for (x = simd.premultiply (dest_data, src_data, width, order, src_order); x < width; x++) \
         { \
           dest_data[4 * x + A] = src_data[4 * x + A2]; \
           PREMULTIPLY(dest_data[4 * x + R], src_data[4 * x + R2], src_data[4 * x + A2]); \
@@ -283,6 +889,87 @@ SWIZZLE_PREMULTIPLY (3,0,1,2, 0,1,2,3)
 SWIZZLE_PREMULTIPLY (3,0,1,2, 3,0,1,2)
 SWIZZLE_PREMULTIPLY (3,0,1,2, 0,3,2,1)
 
+/* v * 255 / 65535, rounded */
+#define UNORM16_TO_UNORM8(v) (((guint) (v) * 255 + 32767) / 65535)
+
+#define CONVERT_RGBA16(A,R,G,B) \
+static void \
+convert_rgba16_ ## A ## R ## G ## B (guchar       *dest_data, \
+                                     gsize         dest_stride, \
+                                     const guchar *src_data, \
+                                     gsize         src_stride, \
+                                     gsize         width, \
+                                     gsize         height) \
+{ \
+  gsize x, y; \
+\
+  for (y = 0; y < height; y++) \
+    { \
+      const guint16 *src = (const guint16 *) src_data; \
+\
+      for (x = 0; x < width; x++) \
+        { \
+          dest_data[4 * x + A] = UNORM16_TO_UNORM8 (src[4 * x + 3]); \
+          dest_data[4 * x + R] = UNORM16_TO_UNORM8 (src[4 * x + 0]); \
+          dest_data[4 * x + G] = UNORM16_TO_UNORM8 (src[4 * x + 1]); \
+          dest_data[4 * x + B] = UNORM16_TO_UNORM8 (src[4 * x + 2]); \
+        } \
+\
+      dest_data += dest_stride; \
+      src_data += src_stride; \
+    } \
+}
+
+CONVERT_RGBA16(3,2,1,0)
+CONVERT_RGBA16(0,1,2,3)
+CONVERT_RGBA16(3,0,1,2)
+
+static inline guchar
+float_to_unorm8 (float f)
+{
+  /* written so that NaN ends up as 0 */
+  if (!(f > 0.f))
+    return 0;
+  if (f >= 1.f)
+    return 255;
+  return f * 255.f + 0.5f;
+}
+
+#define CONVERT_RGBA16F(A,R,G,B) \
+static void \
+convert_rgba16f_ ## A ## R ## G ## B (guchar       *dest_data, \
+                                      gsize         dest_stride, \
+                                      const guchar *src_data, \
+                                      gsize         src_stride, \
+                                      gsize         width, \
+                                      gsize         height) \
+{ \
+  gsize x, y; \
+\
+  for (y = 0; y < height; y++) \
+    { \
+      const guint16 *src = (const guint16 *) src_data; \
+\
+      for (x = 0; x < width; x++) \
+        { \
+          float f[4]; \
+\
+          half_to_float4 (&src[4 * x], f); \
+          dest_data[4 * x + A] = float_to_unorm8 (f[3]); \
+          dest_data[4 * x + R] = float_to_unorm8 (f[0]); \
+          dest_data[4 * x + G] = float_to_unorm8 (f[1]); \
+          dest_data[4 * x + B] = float_to_unorm8 (f[2]); \
+        } \
+\
+      dest_data += dest_stride; \
+      src_data += src_stride; \
+    } \
+}
+
+CONVERT_RGBA16F(3,2,1,0)
+CONVERT_RGBA16F(0,1,2,3)
+CONVERT_RGBA16F(3,0,1,2)
+
 typedef void (* ConversionFunc) (guchar       *dest_data,
                                  gsize         dest_stride,
                                  const guchar *src_data,
@@ -300,7 +987,9 @@ static ConversionFunc converters[GDK_MEMORY_N_FORMATS][3] =
   { convert_swizzle_premultiply_3210_3012, convert_swizzle_premultiply_0123_3012, convert_swizzle_premultiply_3012_3012 },
   { convert_swizzle_premultiply_3210_0321, convert_swizzle_premultiply_0123_0321, convert_swizzle_premultiply_3012_0321 },
   { convert_swizzle_opaque_3210, convert_swizzle_opaque_0123, convert_swizzle_opaque_3012 },
-  { convert_swizzle_opaque_3012, convert_swizzle_opaque_0321, convert_swizzle_opaque_3210 }
+  { convert_swizzle_opaque_3012, convert_swizzle_opaque_0321, convert_swizzle_opaque_3210 },
+  { convert_rgba16_3210, convert_rgba16_0123, convert_rgba16_3012 },
+  { convert_rgba16f_3210, convert_rgba16f_0123, convert_rgba16f_3012 }
 };
 
 void
@@ -316,5 +1005,7 @@ gdk_memory_convert (guchar          *dest_data,
   g_assert (dest_format < 3);
   g_assert (src_format < GDK_MEMORY_N_FORMATS);
 
+  gdk_memory_convert_init_simd ();
+
   converters[src_format][dest_format] (dest_data, dest_stride, src_data, src_stride, width, height);
 }
@@ -42,6 +42,12 @@ G_BEGIN_DECLS
  * @GDK_MEMORY_A8B8G8R8: 4 bytes; for alpha, blue, green, red.
  * @GDK_MEMORY_R8G8B8: 3 bytes; for red, green, blue. The data is opaque.
  * @GDK_MEMORY_B8G8R8: 3 bytes; for blue, green, red. The data is opaque.
+ * @GDK_MEMORY_R16G16B16A16_PREMULTIPLIED: 4 guint16 values; for red, green,
+ *   blue, alpha. The color values are premultiplied with the alpha value.
+ *   Since 4.4
+ * @GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED: 4 half-float values; for
+ *   red, green, blue, alpha. The color values are premultiplied with the
+ *   alpha value. Since 4.4
  * @GDK_MEMORY_N_FORMATS: The number of formats. This value will change as
  *   more formats get added, so do not rely on its concrete integer.
  *
@@ -53,6 +59,9 @@ G_BEGIN_DECLS
  * CAIRO_FORMAT_ARGB32 is represented by different `GdkMemoryFormats`
  * on architectures with different endiannesses.
  *
+ * Formats with more than 8 bits per channel store each channel as
+ * a 16 bit value in the machine's native endianness.
+ *
  * Its naming is modelled after
  * [VkFormat](https://www.khronos.org/registry/vulkan/specs/1.0/html/vkspec.html#VkFormat)
  * for details).
@@ -67,6 +76,8 @@ typedef enum {
   GDK_MEMORY_A8B8G8R8,
   GDK_MEMORY_R8G8B8,
   GDK_MEMORY_B8G8R8,
+  GDK_MEMORY_R16G16B16A16_PREMULTIPLIED,
+  GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED,
 
   GDK_MEMORY_N_FORMATS
 } GdkMemoryFormat;
@@ -110,6 +121,21 @@ GdkTexture *            gdk_memory_texture_new              (int
                                                              GdkMemoryFormat    format,
                                                              GBytes            *bytes,
                                                              gsize              stride);
+GDK_AVAILABLE_IN_4_4
+GdkTexture *            gdk_memory_texture_new_from_mapped_file (GMappedFile       *mapped_file,
+                                                                 gsize              offset,
+                                                                 int                width,
+                                                                 int                height,
+                                                                 GdkMemoryFormat    format,
+                                                                 gsize              stride);
+GDK_AVAILABLE_IN_4_4
+GdkTexture *            gdk_memory_texture_new_from_fd      (int                fd,
+                                                             gsize              offset,
+                                                             int                width,
+                                                             int                height,
+                                                             GdkMemoryFormat    format,
+                                                             gsize              stride,
+                                                             GError           **error);
 
 
 G_END_DECLS
@@ -32,6 +32,7 @@ G_BEGIN_DECLS
 #define GDK_MEMORY_CAIRO_FORMAT_ARGB32 GDK_MEMORY_DEFAULT
 
 gsize                   gdk_memory_format_bytes_per_pixel   (GdkMemoryFormat    format);
+gsize                   gdk_memory_format_alignment         (GdkMemoryFormat    format);
 
 GdkMemoryFormat         gdk_memory_texture_get_format       (GdkMemoryTexture  *self);
 const guchar *          gdk_memory_texture_get_data         (GdkMemoryTexture  *self);
@@ -24,18 +24,527 @@
 
 #include <sys/types.h>
 #include <signal.h>
+#include <stdlib.h>
+#include <string.h>
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
 
+#ifdef G_OS_UNIX
+#include <glib-unix.h>
+#endif
+
 #include "gdkversionmacros.h"
 #include "gdkframeclockprivate.h"
 
+/* The recorder
+ *
+ * Independent of sysprof, marks and counters can be recorded into
+ * per-thread ring buffers and written to a file later. Only the
+ * owning thread writes to a buffer, so recording does not take any
+ * locks. Each thread keeps the most recent RECORD_BUFFER_SIZE records.
+ *
+ * Dumping may happen on another thread while records are written.
+ * Every record carries a sequence number, which is 0 while the record
+ * is being written and its position in the buffer plus one after that.
+ * The dump copies a record and only uses the copy if the sequence
+ * number was valid and unchanged before and after copying.
+ *
+ * Recording is enabled with the GDK_TRACE_FILE environment variable
+ * or gdk_profiler_start_recording(). If a filename is given, the
+ * records are written to it at exit, and on Unix when receiving
+ * SIGUSR2. Files ending in .json are written in the Chrome trace
+ * event format, everything else in a compact binary format.
+ */
+
+#define RECORD_BUFFER_SIZE 8192
+#define RECORD_NAME_SIZE 32
+#define RECORD_MESSAGE_SIZE 72
+
+typedef enum {
+  RECORD_MARK,
+  RECORD_COUNTER,
+  RECORD_INT_COUNTER
+} RecordType;
+
+typedef struct
+{
+  guint seq;
+  gint64 time;
+  union {
+    gint64 duration;
+    gint64 v64;
+    double vdbl;
+  } value;
+  guint32 type;
+  guint32 counter;
+  char name[RECORD_NAME_SIZE];
+  char message[RECORD_MESSAGE_SIZE];
+} Record;
+
+typedef struct
+{
+  guint tid;
+  int alive;
+  gboolean dumped;
+  guint head;
+  Record records[RECORD_BUFFER_SIZE];
+} RecordBuffer;
+
+typedef struct
+{
+  char *name;
+  char *description;
+  RecordType type;
+#ifdef HAVE_SYSPROF
+  guint sysprof_id;
+#endif
+} Counter;
+
+static int recording;
+static char *recording_filename;
+
+static GMutex recorder_mutex;
+static GSList *record_buffers;
+static guint next_tid = 1;
+static GArray *counters;
+
+static void
+record_buffer_release (gpointer data)
+{
+  RecordBuffer *buffer = data;
+
+  /* Keep the data around for dumping. The buffer is only reused
+   * by a new thread once its records have been dumped.
+   */
+  g_atomic_int_set (&buffer->alive, FALSE);
+}
+
+static GPrivate current_buffer = G_PRIVATE_INIT (record_buffer_release);
+
+static RecordBuffer *
+get_record_buffer (void)
+{
+  RecordBuffer *buffer;
+  GSList *l;
+
+  buffer = g_private_get (&current_buffer);
+  if (G_LIKELY (buffer != NULL))
+    return buffer;
+
+  g_mutex_lock (&recorder_mutex);
+
+  for (l = record_buffers; l; l = l->next)
+    {
+      RecordBuffer *b = l->data;
+
+      if (!g_atomic_int_get (&b->alive) &&
+          (b->dumped || b->head == 0))
+        {
+          buffer = b;
+          break;
+        }
+    }
+
+  if (buffer == NULL)
+    {
+      buffer = g_new (RecordBuffer, 1);
+      record_buffers = g_slist_prepend (record_buffers, buffer);
+    }
+
+  buffer->tid = next_tid++;
+  buffer->dumped = FALSE;
+  buffer->head = 0;
+  g_atomic_int_set (&buffer->alive, TRUE);
+
+  g_mutex_unlock (&recorder_mutex);
+
+  g_private_set (&current_buffer, buffer);
+
+  return buffer;
+}
+
+static inline Record *
+record_begin (RecordType type,
+              gint64     time)
+{
+  RecordBuffer *buffer = get_record_buffer ();
+  Record *record;
+
+  record = &buffer->records[buffer->head % RECORD_BUFFER_SIZE];
+  g_atomic_int_set (&record->seq, 0);
+  record->type = type;
+  record->time = time;
+
+  return record;
+}
+
+static inline void
+record_end (void)
+{
+  RecordBuffer *buffer = g_private_get (&current_buffer);
+  Record *record = &buffer->records[buffer->head % RECORD_BUFFER_SIZE];
+  guint head = buffer->head + 1;
+
+  /* Publish the record */
+  g_atomic_int_set (&record->seq, head);
+  g_atomic_int_set (&buffer->head, head);
+}
+
+static void
+record_mark (gint64      begin_time,
+             gint64      duration,
+             const char *name,
+             const char *message_format,
+             va_list     args)
+{
+  Record *record;
+
+  record = record_begin (RECORD_MARK, begin_time);
+  record->value.duration = duration;
+  g_strlcpy (record->name, name, sizeof record->name);
+  if (message_format)
+    g_vsnprintf (record->message, sizeof record->message, message_format, args);
+  else
+    record->message[0] = '\0';
+  record_end ();
+}
+
+static inline void
+record_markf (gint64      begin_time,
+              gint64      duration,
+              const char *name,
+              const char *message_format,
+              ...)
+{
+  va_list args;
+
+  va_start (args, message_format);
+  record_mark (begin_time, duration, name, message_format, args);
+  va_end (args);
+}
+
+static gboolean
+dump_on_signal (gpointer data)
+{
+  gdk_profiler_dump_recording (recording_filename, NULL);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+dump_on_exit (void)
+{
+  if (g_atomic_int_get (&recording) && recording_filename)
+    gdk_profiler_dump_recording (recording_filename, NULL);
+}
+
+/*< private >
+ * gdk_profiler_start_recording:
+ * @filename: (nullable): file to write the recording to
+ *
+ * Starts recording marks and counters, independent of sysprof.
+ *
+ * If @filename is not %NULL, the recording is written to it when
+ * the process exits and, on Unix, when it receives SIGUSR2.
+ */
+void
+gdk_profiler_start_recording (const char *filename)
+{
+  static gboolean handlers_installed;
+
+  g_mutex_lock (&recorder_mutex);
+
+  g_free (recording_filename);
+  recording_filename = g_strdup (filename);
+
+  if (recording_filename && !handlers_installed)
+    {
+      atexit (dump_on_exit);
+#ifdef G_OS_UNIX
+      g_unix_signal_add (SIGUSR2, dump_on_signal, NULL);
+#endif
+      handlers_installed = TRUE;
+    }
+
+  g_mutex_unlock (&recorder_mutex);
+
+  g_atomic_int_set (&recording, TRUE);
+}
+
+/*< private >
+ * gdk_profiler_stop_recording:
+ *
+ * Stops recording. The records collected so far are kept
+ * and can still be written with gdk_profiler_dump_recording().
+ */
+void
+gdk_profiler_stop_recording (void)
+{
+  g_atomic_int_set (&recording, FALSE);
+}
+
+gboolean
+gdk_profiler_is_recording (void)
+{
+  return g_atomic_int_get (&recording);
+}
+
+static void
+append_json_string (GString    *s,
+                    const char *str)
+{
+  const char *p;
+
+  g_string_append_c (s, '"');
+  for (p = str; *p; p++)
+    {
+      switch (*p)
+        {
+        case '"':
+          g_string_append (s, "\\\"");
+          break;
+        case '\\':
+          g_string_append (s, "\\\\");
+          break;
+        case '\n':
+          g_string_append (s, "\\n");
+          break;
+        default:
+          if ((guchar) *p < 0x20)
+            g_string_append_printf (s, "\\u%04x", (guchar) *p);
+          else
+            g_string_append_c (s, *p);
+          break;
+        }
+    }
+  g_string_append_c (s, '"');
+}
+
+static const char *
+get_counter_name (guint id)
+{
+  if (counters == NULL || id == 0 || id > counters->len)
+    return "counter";
+
+  return g_array_index (counters, Counter, id - 1).name;
+}
+
+static void
+append_json_record (GString      *s,
+                    guint         pid,
+                    guint         tid,
+                    const Record *record)
+{
+  char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+  if (s->str[s->len - 1] != '[')
+    g_string_append (s, ",\n");
+
+  g_string_append (s, "{\"name\":");
+  if (record->type == RECORD_MARK)
+    append_json_string (s, record->name);
+  else
+    append_json_string (s, get_counter_name (record->counter));
+
+  g_string_append_printf (s, ",\"cat\":\"gtk\",\"pid\":%u,\"tid\":%u,\"ts\":%s",
+                          pid, tid,
+                          g_ascii_formatd (buf, sizeof buf, "%.3f", record->time / 1000.0));
+
+  switch (record->type)
+    {
+    case RECORD_MARK:
+      g_string_append_printf (s, ",\"ph\":\"X\",\"dur\":%s",
+                              g_ascii_formatd (buf, sizeof buf, "%.3f", record->value.duration / 1000.0));
+      if (record->message[0])
+        {
+          g_string_append (s, ",\"args\":{\"message\":");
+          append_json_string (s, record->message);
+          g_string_append_c (s, '}');
+        }
+      break;
+
+    case RECORD_COUNTER:
+      g_string_append_printf (s, ",\"ph\":\"C\",\"args\":{\"value\":%s}",
+                              g_ascii_formatd (buf, sizeof buf, "%g", record->value.vdbl));
+      break;
+
+    case RECORD_INT_COUNTER:
+      g_string_append_printf (s, ",\"ph\":\"C\",\"args\":{\"value\":%" G_GINT64_FORMAT "}",
+                              record->value.v64);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  g_string_append_c (s, '}');
+}
+
+#define BINARY_MAGIC "GDKTRACE"
+#define BINARY_VERSION 1
+
+static void
+append_binary_string (GString    *s,
+                      const char *str)
+{
+  guint8 len = MIN (strlen (str), G_MAXUINT8);
+
+  g_string_append_c (s, len);
+  g_string_append_len (s, str, len);
+}
+
+/* The binary format, in native byte order:
+ *
+ *   "GDKTRACE", guint32 version, guint32 pid, guint32 n_counters,
+ *   for each counter: guint32 id, guint8 type, guint8 length, name
+ *   then until the end of the file, records:
+ *   guint8 type, guint32 tid, gint64 time, gint64 value (duration,
+ *   integer or double), and for marks guint8 length, name, guint8
+ *   length, message; for counters guint32 id.
+ */
+static void
+append_binary_record (GString      *s,
+                      guint         tid,
+                      const Record *record)
+{
+  guint32 tid32 = tid;
+
+  g_string_append_c (s, record->type);
+  g_string_append_len (s, (const char *) &tid32, sizeof tid32);
+  g_string_append_len (s, (const char *) &record->time, sizeof record->time);
+  g_string_append_len (s, (const char *) &record->value, sizeof record->value);
+
+  if (record->type == RECORD_MARK)
+    {
+      append_binary_string (s, record->name);
+      append_binary_string (s, record->message);
+    }
+  else
+    {
+      g_string_append_len (s, (const char *) &record->counter, sizeof record->counter);
+    }
+}
+
+/*< private >
+ * gdk_profiler_dump_recording:
+ * @filename: the file to write
+ * @error: Return location for an error
+ *
+ * Writes the records collected so far to @filename.
+ *
+ * If @filename ends in ".json", the Chrome trace event format is
+ * used, which can be loaded in chrome://tracing or Perfetto.
+ * Otherwise a compact binary format is written.
+ *
+ * Returns: %TRUE if the file was written
+ */
+gboolean
+gdk_profiler_dump_recording (const char  *filename,
+                             GError     **error)
+{
+  gboolean json;
+  GString *s;
+  GSList *l;
+  guint pid;
+  gboolean result;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  json = g_str_has_suffix (filename, ".json");
+
+#ifdef HAVE_UNISTD_H
+  pid = getpid ();
+#else
+  pid = 0;
+#endif
+
+  s = g_string_new (NULL);
+
+  g_mutex_lock (&recorder_mutex);
+
+  if (json)
+    {
+      g_string_append (s, "{\"traceEvents\":[");
+    }
+  else
+    {
+      guint32 version = BINARY_VERSION;
+      guint32 pid32 = pid;
+      guint32 n_counters = counters ? counters->len : 0;
+      guint32 i;
+
+      g_string_append_len (s, BINARY_MAGIC, strlen (BINARY_MAGIC));
+      g_string_append_len (s, (const char *) &version, sizeof version);
+      g_string_append_len (s, (const char *) &pid32, sizeof pid32);
+      g_string_append_len (s, (const char *) &n_counters, sizeof n_counters);
+      for (i = 0; i < n_counters; i++)
+        {
+          Counter *counter = &g_array_index (counters, Counter, i);
+          guint32 id = i + 1;
+
+          g_string_append_len (s, (const char *) &id, sizeof id);
+          g_string_append_c (s, counter->type);
+          append_binary_string (s, counter->name);
+        }
+    }
+
+  for (l = record_buffers; l; l = l->next)
+    {
+      RecordBuffer *buffer = l->data;
+      gboolean alive;
+      guint head, n, i;
+
+      /* Check this first, a dead thread won't add records after it */
+      alive = g_atomic_int_get (&buffer->alive);
+      head = g_atomic_int_get (&buffer->head);
+      n = MIN (head, RECORD_BUFFER_SIZE);
+
+      for (i = head - n; i != head; i++)
+        {
+          const Record *record = &buffer->records[i % RECORD_BUFFER_SIZE];
+          Record copy;
+          guint seq;
+
+          /* Skip records that are being overwritten */
+          seq = g_atomic_int_get (&record->seq);
+          if (seq != i + 1)
+            continue;
+
+          memcpy (&copy, record, sizeof (Record));
+
+          if (g_atomic_int_get (&record->seq) != seq)
+            continue;
+
+          if (json)
+            append_json_record (s, pid, buffer->tid, &copy);
+          else
+            append_binary_record (s, buffer->tid, &copy);
+        }
+
+      if (!alive)
+        buffer->dumped = TRUE;
+    }
+
+  g_mutex_unlock (&recorder_mutex);
+
+  if (json)
+    g_string_append (s, "],\"displayTimeUnit\":\"ms\"}\n");
+
+  result = g_file_set_contents (filename, s->str, s->len, error);
+
+  g_string_free (s, TRUE);
+
+  return result;
+}
 
 gboolean
 gdk_profiler_is_running (void)
 {
+  if (g_atomic_int_get (&recording))
+    return TRUE;
+
 #ifdef HAVE_SYSPROF
   return sysprof_collector_is_active ();
 #else
@@ -43,6 +552,12 @@ gdk_profiler_is_running (void)
 #endif
 }
 
+gint64
+gdk_profiler_current_time (void)
+{
+  return g_get_monotonic_time () * 1000;
+}
+
 void
 (gdk_profiler_add_mark) (gint64      begin_time,
                          gint64      duration,
@@ -52,6 +567,9 @@ void
 #ifdef HAVE_SYSPROF
   sysprof_collector_mark (begin_time, duration, "gtk", name, message);
 #endif
+
+  if (g_atomic_int_get (&recording))
+    record_markf (begin_time, duration, name, message ? "%s" : NULL, message);
 }
 
 void
@@ -59,9 +577,7 @@ void
                          const char *name,
                          const char *message)
 {
-#ifdef HAVE_SYSPROF
-  sysprof_collector_mark (begin_time, GDK_PROFILER_CURRENT_TIME - begin_time, "gtk", name, message);
-#endif
+  gdk_profiler_add_mark (begin_time, GDK_PROFILER_CURRENT_TIME - begin_time, name, message);
 }
 
 void
@@ -71,12 +587,20 @@ void
                           const gchar *message_format,
                           ...)
 {
-#ifdef HAVE_SYSPROF
   va_list args;
+
+#ifdef HAVE_SYSPROF
   va_start (args, message_format);
   sysprof_collector_mark_vprintf (begin_time, duration, "gtk", name, message_format, args);
   va_end (args);
 #endif  /* HAVE_SYSPROF */
+
+  if (g_atomic_int_get (&recording))
+    {
+      va_start (args, message_format);
+      record_mark (begin_time, duration, name, message_format, args);
+      va_end (args);
+    }
 }
 
 void
@@ -85,78 +609,154 @@ void
                           const gchar *message_format,
                           ...)
 {
-#ifdef HAVE_SYSPROF
+  gint64 duration = GDK_PROFILER_CURRENT_TIME - begin_time;
   va_list args;
+
+#ifdef HAVE_SYSPROF
   va_start (args, message_format);
-  sysprof_collector_mark_vprintf (begin_time, GDK_PROFILER_CURRENT_TIME - begin_time, "gtk", name, message_format, args);
+  sysprof_collector_mark_vprintf (begin_time, duration, "gtk", name, message_format, args);
   va_end (args);
 #endif  /* HAVE_SYSPROF */
+
+  if (g_atomic_int_get (&recording))
+    {
+      va_start (args, message_format);
+      record_mark (begin_time, duration, name, message_format, args);
+      va_end (args);
+    }
 }
 
-guint
-(gdk_profiler_define_counter) (const char *name,
-                               const char *description)
+static guint
+define_counter (const char *name,
+                const char *description,
+                RecordType  type)
 {
+  Counter counter;
+  guint id;
+
+  counter.name = g_strdup (name);
+  counter.description = g_strdup (description);
+  counter.type = type;
+
 #ifdef HAVE_SYSPROF
-  SysprofCaptureCounter counter;
+  {
+    SysprofCaptureCounter sysprof_counter;
 
-  counter.id = sysprof_collector_request_counters (1);
-  counter.type = SYSPROF_CAPTURE_COUNTER_DOUBLE;
-  counter.value.vdbl = 0.0;
-  g_strlcpy (counter.category, "gtk", sizeof counter.category);
-  g_strlcpy (counter.name, name, sizeof counter.name);
-  g_strlcpy (counter.description, description, sizeof counter.name);
+    sysprof_counter.id = sysprof_collector_request_counters (1);
+    if (type == RECORD_COUNTER)
+      {
+        sysprof_counter.type = SYSPROF_CAPTURE_COUNTER_DOUBLE;
+        sysprof_counter.value.vdbl = 0.0;
+      }
+    else
+      {
+        sysprof_counter.type = SYSPROF_CAPTURE_COUNTER_INT64;
+        sysprof_counter.value.v64 = 0;
+      }
+    g_strlcpy (sysprof_counter.category, "gtk", sizeof sysprof_counter.category);
+    g_strlcpy (sysprof_counter.name, name, sizeof sysprof_counter.name);
+    g_strlcpy (sysprof_counter.description, description, sizeof sysprof_counter.description);
 
-  sysprof_collector_define_counters (&counter, 1);
+    sysprof_collector_define_counters (&sysprof_counter, 1);
 
-  return counter.id;
-#else
-  return 0;
+    counter.sysprof_id = sysprof_counter.id;
+  }
 #endif
+
+  g_mutex_lock (&recorder_mutex);
+
+  if (counters == NULL)
+    counters = g_array_new (FALSE, FALSE, sizeof (Counter));
+  g_array_append_val (counters, counter);
+  id = counters->len;
+
+  g_mutex_unlock (&recorder_mutex);
+
+  return id;
+}
+
+guint
+(gdk_profiler_define_counter) (const char *name,
+                               const char *description)
+{
+  return define_counter (name, description, RECORD_COUNTER);
 }
 
 guint
 (gdk_profiler_define_int_counter) (const char *name,
                                    const char *description)
 {
-#ifdef HAVE_SYSPROF
-  SysprofCaptureCounter counter;
+  return define_counter (name, description, RECORD_INT_COUNTER);
+}
 
-  counter.id = sysprof_collector_request_counters (1);
-  counter.type = SYSPROF_CAPTURE_COUNTER_INT64;
-  counter.value.v64 = 0;
-  g_strlcpy (counter.category, "gtk", sizeof counter.category);
-  g_strlcpy (counter.name, name, sizeof counter.name);
-  g_strlcpy (counter.description, description, sizeof counter.name);
+#ifdef HAVE_SYSPROF
+static guint
+get_sysprof_id (guint id)
+{
+  guint sysprof_id;
 
-  sysprof_collector_define_counters (&counter, 1);
+  g_mutex_lock (&recorder_mutex);
+  sysprof_id = g_array_index (counters, Counter, id - 1).sysprof_id;
+  g_mutex_unlock (&recorder_mutex);
 
-  return counter.id;
-#else
-  return 0;
-#endif
+  return sysprof_id;
 }
+#endif
 
 void
 (gdk_profiler_set_counter) (guint  id,
                             double val)
 {
+  if (id == 0)
+    return;
+
 #ifdef HAVE_SYSPROF
-  SysprofCaptureCounterValue value;
+  if (sysprof_collector_is_active ())
+    {
+      SysprofCaptureCounterValue value;
+      guint sysprof_id = get_sysprof_id (id);
 
-  value.vdbl = val;
-  sysprof_collector_set_counters (&id, &value, 1);
+      value.vdbl = val;
+      sysprof_collector_set_counters (&sysprof_id, &value, 1);
+    }
 #endif
+
+  if (g_atomic_int_get (&recording))
+    {
+      Record *record;
+
+      record = record_begin (RECORD_COUNTER, GDK_PROFILER_CURRENT_TIME);
+      record->counter = id;
+      record->value.vdbl = val;
+      record_end ();
+    }
 }
 
 void
 (gdk_profiler_set_int_counter) (guint  id,
                                 gint64 val)
 {
+  if (id == 0)
+    return;
+
 #ifdef HAVE_SYSPROF
-  SysprofCaptureCounterValue value;
+  if (sysprof_collector_is_active ())
+    {
+      SysprofCaptureCounterValue value;
+      guint sysprof_id = get_sysprof_id (id);
 
-  value.v64 = val;
-  sysprof_collector_set_counters (&id, &value, 1);
+      value.v64 = val;
+      sysprof_collector_set_counters (&sysprof_id, &value, 1);
+    }
 #endif
+
+  if (g_atomic_int_get (&recording))
+    {
+      Record *record;
+
+      record = record_begin (RECORD_INT_COUNTER, GDK_PROFILER_CURRENT_TIME);
+      record->counter = id;
+      record->value.v64 = val;
+      record_end ();
+    }
 }
@@ -32,15 +32,21 @@
 
 G_BEGIN_DECLS
 
-#ifdef HAVE_SYSPROF
 #define GDK_PROFILER_IS_RUNNING (gdk_profiler_is_running ())
+#ifdef HAVE_SYSPROF
 #define GDK_PROFILER_CURRENT_TIME SYSPROF_CAPTURE_CURRENT_TIME
 #else
-#define GDK_PROFILER_IS_RUNNING 0
-#define GDK_PROFILER_CURRENT_TIME 0
+#define GDK_PROFILER_CURRENT_TIME (gdk_profiler_current_time ())
 #endif
 
 gboolean gdk_profiler_is_running (void);
+gint64   gdk_profiler_current_time (void);
+
+void     gdk_profiler_start_recording (const char  *filename);
+void     gdk_profiler_stop_recording  (void);
+gboolean gdk_profiler_is_recording    (void);
+gboolean gdk_profiler_dump_recording  (const char  *filename,
+                                       GError     **error);
 
 /* Note: Times and durations are in nanoseconds;
  * g_get_monotonic_time(), and GdkFrameClock times
@@ -72,26 +78,6 @@ void    gdk_profiler_set_counter        (guint  id,
 void    gdk_profiler_set_int_counter    (guint  id,
                                          gint64 value);
 
-#ifndef HAVE_SYSPROF
-#define gdk_profiler_add_mark(b, d, n, m) G_STMT_START {} G_STMT_END
-#define gdk_profiler_end_mark(b, n, m) G_STMT_START {} G_STMT_END
-/* Optimise the whole call out */
-#if defined(G_HAVE_ISO_VARARGS)
-#define gdk_profiler_add_markf(b, d, n, m, ...) G_STMT_START {} G_STMT_END
-#define gdk_profiler_end_markf(b, n, m, ...) G_STMT_START {} G_STMT_END
-#elif defined(G_HAVE_GNUC_VARARGS)
-#define gdk_profiler_add_markf(b, d, n, m...) G_STMT_START {} G_STMT_END
-#define gdk_profiler_end_markf(b, n, m...) G_STMT_START {} G_STMT_END
-#else
-/* no varargs macro support; the call will have to be optimised out by the compiler */
-#endif
-
-#define gdk_profiler_define_counter(n, d) 0
-#define gdk_profiler_define_int_counter(n, d) 0
-#define gdk_profiler_set_counter(i, v) G_STMT_START {} G_STMT_END
-#define gdk_profiler_set_int_counter(i, v) G_STMT_START {} G_STMT_END
-#endif
-
 G_END_DECLS
 
 #endif  /* __GDK_PROFILER_PRIVATE_H__ */
@@ -2843,7 +2843,6 @@ add_event_mark (GdkEvent *event,
                 gint64    time,
                 gint64    end_time)
 {
-#ifdef HAVE_SYSPROF
   char *message = NULL;
   const char *kind;
   GEnumClass *class;
@@ -2927,7 +2926,6 @@ add_event_mark (GdkEvent *event,
   gdk_profiler_add_mark (time, end_time - time, "event", message ? message : kind);
 
   g_free (message);
-#endif
 }
 
 gboolean
@@ -381,6 +381,283 @@ gdk_texture_new_from_file (GFile   *file,
   return texture;
 }
 
+typedef struct _TextureLoad TextureLoad;
+
+struct _TextureLoad
+{
+  GFile *file;
+  int width;
+  int height;
+  guint sequence;
+};
+
+static void
+texture_load_free (gpointer data)
+{
+  TextureLoad *load = data;
+
+  g_object_unref (load->file);
+  g_slice_free (TextureLoad, load);
+}
+
+static void
+texture_load_size_prepared (GdkPixbufLoader *loader,
+                            int              width,
+                            int              height,
+                            gpointer         data)
+{
+  TextureLoad *load = data;
+  double scale = 1.0;
+
+  if (load->width > 0 && width > load->width)
+    scale = (double) load->width / width;
+  if (load->height > 0 && height > load->height)
+    scale = MIN (scale, (double) load->height / height);
+
+  /* Only ever scale down. Loaders that support it (like JPEG)
+   * will then decode at reduced resolution directly.
+   */
+  if (scale < 1.0)
+    gdk_pixbuf_loader_set_size (loader,
+                                MAX (1, (int) (width * scale + 0.5)),
+                                MAX (1, (int) (height * scale + 0.5)));
+}
+
+#define TEXTURE_LOAD_CHUNK_SIZE 65536
+
+static GdkPixbuf *
+texture_load_pixbuf (TextureLoad   *load,
+                     GCancellable  *cancellable,
+                     GError       **error)
+{
+  GdkPixbufLoader *loader;
+  GInputStream *stream;
+  GdkPixbuf *pixbuf = NULL;
+  guchar *buffer;
+  gssize n_read;
+
+  stream = G_INPUT_STREAM (g_file_read (load->file, cancellable, error));
+  if (stream == NULL)
+    return NULL;
+
+  loader = gdk_pixbuf_loader_new ();
+  g_signal_connect (loader, "size-prepared",
+                    G_CALLBACK (texture_load_size_prepared), load);
+
+  buffer = g_malloc (TEXTURE_LOAD_CHUNK_SIZE);
+
+  while (TRUE)
+    {
+      n_read = g_input_stream_read (stream, buffer, TEXTURE_LOAD_CHUNK_SIZE, cancellable, error);
+      if (n_read < 0)
+        {
+          gdk_pixbuf_loader_close (loader, NULL);
+          goto out;
+        }
+
+      if (n_read == 0)
+        break;
+
+      if (!gdk_pixbuf_loader_write (loader, buffer, n_read, error))
+        {
+          gdk_pixbuf_loader_close (loader, NULL);
+          goto out;
+        }
+    }
+
+  if (!gdk_pixbuf_loader_close (loader, error))
+    goto out;
+
+  pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+  if (pixbuf == NULL)
+    {
+      g_set_error_literal (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_FAILED,
+                           "Image loader did not produce an image");
+      goto out;
+    }
+
+  g_object_ref (pixbuf);
+
+out:
+  g_free (buffer);
+  g_object_unref (loader);
+  g_object_unref (stream);
+
+  return pixbuf;
+}
+
+static void
+texture_load_thread (gpointer data,
+                     gpointer unused)
+{
+  GTask *task = data;
+  TextureLoad *load = g_task_get_task_data (task);
+  GCancellable *cancellable = g_task_get_cancellable (task);
+  GError *error = NULL;
+  GdkPixbuf *pixbuf;
+  GdkTexture *texture;
+
+  /* Jobs that were cancelled while queued don't touch the file at all */
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_object_unref (task);
+      return;
+    }
+
+  pixbuf = texture_load_pixbuf (load, cancellable, &error);
+  if (pixbuf == NULL)
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  /* This wraps the decoded pixels, it does not copy them */
+  texture = gdk_texture_new_for_pixbuf (pixbuf);
+  g_object_unref (pixbuf);
+
+  g_task_return_pointer (task, texture, g_object_unref);
+  g_object_unref (task);
+}
+
+static int
+texture_load_compare (gconstpointer a,
+                      gconstpointer b,
+                      gpointer      unused)
+{
+  GTask *task_a = (GTask *) a;
+  GTask *task_b = (GTask *) b;
+  TextureLoad *load_a = g_task_get_task_data (task_a);
+  TextureLoad *load_b = g_task_get_task_data (task_b);
+  int priority_a = g_task_get_priority (task_a);
+  int priority_b = g_task_get_priority (task_b);
+
+  if (priority_a != priority_b)
+    return priority_a < priority_b ? -1 : 1;
+
+  if (load_a->sequence != load_b->sequence)
+    return load_a->sequence < load_b->sequence ? -1 : 1;
+
+  return 0;
+}
+
+#define TEXTURE_LOAD_MAX_THREADS 4
+
+static GThreadPool *
+texture_load_get_pool (void)
+{
+  static GThreadPool *pool;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *p;
+
+      p = g_thread_pool_new (texture_load_thread,
+                             NULL,
+                             CLAMP (g_get_num_processors (), 1, TEXTURE_LOAD_MAX_THREADS),
+                             FALSE,
+                             NULL);
+      g_thread_pool_set_sort_function (p, texture_load_compare, NULL);
+
+      g_once_init_leave (&pool, p);
+    }
+
+  return pool;
+}
+
+/**
+ * gdk_texture_new_from_file_async:
+ * @file: `GFile` to load
+ * @width: the maximum width of the texture, or -1 for no limit
+ * @height: the maximum height of the texture, or -1 for no limit
+ * @io_priority: the I/O priority of the request
+ * @cancellable: (nullable): optional `GCancellable` object
+ * @callback: (scope async): callback to call when the texture is loaded
+ * @user_data: (closure): data to pass to @callback
+ *
+ * Asynchronously creates a new texture by loading an image from a file.
+ *
+ * Loading and decoding happens on a small pool of worker threads
+ * that is shared by all requests. Requests with a numerically lower
+ * @io_priority are started first; requests of the same priority are
+ * started in the order they were made.
+ *
+ * If @width or @height are positive, the image is scaled down to fit
+ * into that size, keeping its aspect ratio. It is never scaled up.
+ * Image formats that support it, like JPEG, will be decoded at the
+ * reduced size directly, which is much faster than decoding the full
+ * image. This makes this function suitable for loading thumbnails.
+ *
+ * Cancelling @cancellable aborts the request. If the request has not
+ * been started yet, no work is done for it at all. This makes it cheap
+ * to cancel requests for items that are no longer visible, for example
+ * when a list item is unbound in a `GtkListView`.
+ *
+ * Images from resources can be loaded by passing a `GFile` for a
+ * `resource://` URI.
+ *
+ * When the operation is finished, @callback will be called. You can
+ * then call [func@Gdk.Texture.new_from_file_finish] to get the result.
+ *
+ * Since: 4.4
+ */
+void
+gdk_texture_new_from_file_async (GFile               *file,
+                                 int                  width,
+                                 int                  height,
+                                 int                  io_priority,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  static int sequence;
+  TextureLoad *load;
+  GTask *task;
+
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  load = g_slice_new (TextureLoad);
+  load->file = g_object_ref (file);
+  load->width = width;
+  load->height = height;
+  load->sequence = g_atomic_int_add (&sequence, 1);
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gdk_texture_new_from_file_async);
+  g_task_set_priority (task, io_priority);
+  g_task_set_task_data (task, load, texture_load_free);
+
+  /* The pool takes over the reference */
+  g_thread_pool_push (texture_load_get_pool (), task, NULL);
+}
+
+/**
+ * gdk_texture_new_from_file_finish:
+ * @result: a `GAsyncResult`
+ * @error: Return location for an error
+ *
+ * Finishes an asynchronous texture load started with
+ * [func@Gdk.Texture.new_from_file_async].
+ *
+ * If %NULL is returned, then @error will be set. If the request was
+ * cancelled, the error will be %G_IO_ERROR_CANCELLED.
+ *
+ * Returns: (transfer full): A newly-created `GdkTexture`
+ *
+ * Since: 4.4
+ */
+GdkTexture *
+gdk_texture_new_from_file_finish (GAsyncResult  *result,
+                                  GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gdk_texture_new_from_file_async, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 /**
  * gdk_texture_get_width: (attributes org.gtk.Method.get_property=width)
  * @texture: a `GdkTexture`
@@ -413,12 +690,46 @@ gdk_texture_get_height (GdkTexture *texture)
   return texture->height;
 }
 
+/* The returned surface may share its pixels with @texture,
+ * so it must not be drawn to.
+ */
 cairo_surface_t *
 gdk_texture_download_surface (GdkTexture *texture)
 {
+  static const cairo_user_data_key_t key;
   cairo_surface_t *surface;
   cairo_status_t surface_status;
 
+  /* Memory textures in Cairo's format can be wrapped directly, as long
+   * as their layout is exactly what Cairo would have picked, since users
+   * of the surface, like the GL icon uploads, rely on that.
+   */
+  if (GDK_IS_MEMORY_TEXTURE (texture))
+    {
+      GdkMemoryTexture *memtex = GDK_MEMORY_TEXTURE (texture);
+      gsize stride = gdk_memory_texture_get_stride (memtex);
+      const guchar *data = gdk_memory_texture_get_data (memtex);
+
+      if (gdk_memory_texture_get_format (memtex) == GDK_MEMORY_CAIRO_FORMAT_ARGB32 &&
+          GPOINTER_TO_SIZE (data) % 4 == 0 &&
+          stride == cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, texture->width))
+        {
+          surface = cairo_image_surface_create_for_data ((guchar *) data,
+                                                         CAIRO_FORMAT_ARGB32,
+                                                         texture->width, texture->height,
+                                                         stride);
+          if (cairo_surface_status (surface) == CAIRO_STATUS_SUCCESS)
+            {
+              cairo_surface_set_user_data (surface, &key,
+                                           g_object_ref (texture),
+                                           g_object_unref);
+              return surface;
+            }
+
+          cairo_surface_destroy (surface);
+        }
+    }
+
   surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
                                         texture->width, texture->height);
 
@@ -49,6 +49,17 @@ GdkTexture *            gdk_texture_new_from_resource          (const char
 GDK_AVAILABLE_IN_ALL
 GdkTexture *            gdk_texture_new_from_file              (GFile           *file,
                                                                 GError         **error);
+GDK_AVAILABLE_IN_4_4
+void                    gdk_texture_new_from_file_async        (GFile           *file,
+                                                                int              width,
+                                                                int              height,
+                                                                int              io_priority,
+                                                                GCancellable    *cancellable,
+                                                                GAsyncReadyCallback callback,
+                                                                gpointer         user_data);
+GDK_AVAILABLE_IN_4_4
+GdkTexture *            gdk_texture_new_from_file_finish       (GAsyncResult    *result,
+                                                                GError         **error);
 
 GDK_AVAILABLE_IN_ALL
 int                     gdk_texture_get_width                  (GdkTexture      *texture) G_GNUC_PURE;
@@ -25,56 +25,40 @@
 #include "gdkinternals.h"
 #include "gdkprofilerprivate.h"
 
-static const cairo_user_data_key_t gdk_wayland_cairo_context_key;
-static const cairo_user_data_key_t gdk_wayland_cairo_region_key;
-
-G_DEFINE_TYPE (GdkWaylandCairoContext, gdk_wayland_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
+/* The number of buffers kept around never shrinks below 2, so that
+ * one can be painted while the compositor holds on to the other.
+ */
+#define MIN_POOL_SIZE 2
+#define MAX_POOL_SIZE 4
+/* Number of frames after which the pool size is reconsidered */
+#define POOL_WINDOW 60
 
-static void
-gdk_wayland_cairo_context_surface_add_region (cairo_surface_t      *surface,
-                                              const cairo_region_t *region)
+typedef struct
 {
-  cairo_region_t *surface_region;
-
-  surface_region = cairo_surface_get_user_data (surface, &gdk_wayland_cairo_region_key);
-  if (surface_region == NULL)
-    {
-      surface_region = cairo_region_copy (region);
-      cairo_surface_set_user_data (surface,
-                                   &gdk_wayland_cairo_region_key,
-                                   surface_region,
-                                   (cairo_destroy_func_t) cairo_region_destroy);
-    }
-  else
-    {
-      cairo_region_union (surface_region, region);
-    }
-}
+  GdkWaylandCairoContext *context; /* NULL once the context dropped the buffer */
+  guint64 frame;                   /* frame the buffer was last painted in, 0 if never */
+  guint busy : 1;                  /* attached and not yet released by the compositor */
+} GdkWaylandCairoBuffer;
 
-static void
-gdk_wayland_cairo_context_surface_clear_region (cairo_surface_t *surface)
-{
-  cairo_surface_set_user_data (surface, &gdk_wayland_cairo_region_key, NULL, NULL);
-}
+static const cairo_user_data_key_t gdk_wayland_cairo_buffer_key;
 
-static const cairo_region_t *
-gdk_wayland_cairo_context_surface_get_region (cairo_surface_t *surface)
-{
-  return cairo_surface_get_user_data (surface, &gdk_wayland_cairo_region_key);
-}
+G_DEFINE_TYPE (GdkWaylandCairoContext, gdk_wayland_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
 
-static GdkWaylandCairoContext *
-gdk_wayland_cairo_context_get_from_surface (cairo_surface_t *surface)
+static GdkWaylandCairoBuffer *
+gdk_wayland_cairo_context_get_buffer (cairo_surface_t *surface)
 {
-  return cairo_surface_get_user_data (surface, &gdk_wayland_cairo_context_key);
+  return cairo_surface_get_user_data (surface, &gdk_wayland_cairo_buffer_key);
 }
 
 static void
 gdk_wayland_cairo_context_add_surface (GdkWaylandCairoContext *self,
                                        cairo_surface_t        *surface)
 {
-  cairo_surface_reference (surface);
-  cairo_surface_set_user_data (surface, &gdk_wayland_cairo_context_key, self, NULL);
+  GdkWaylandCairoBuffer *buffer;
+
+  buffer = g_new0 (GdkWaylandCairoBuffer, 1);
+  buffer->context = self;
+  cairo_surface_set_user_data (surface, &gdk_wayland_cairo_buffer_key, buffer, g_free);
 
   self->surfaces = g_slist_prepend (self->surfaces, surface);
 }
@@ -83,10 +67,55 @@ static void
 gdk_wayland_cairo_context_remove_surface (GdkWaylandCairoContext *self,
                                           cairo_surface_t        *surface)
 {
+  GdkWaylandCairoBuffer *buffer = gdk_wayland_cairo_context_get_buffer (surface);
+
   self->surfaces = g_slist_remove (self->surfaces, surface);
 
-  cairo_surface_set_user_data (surface, &gdk_wayland_cairo_context_key, NULL, NULL);
-  cairo_surface_destroy (surface);
+  if (buffer->busy)
+    {
+      /* The compositor still uses it, free it when it is released */
+      buffer->context = NULL;
+      self->n_busy--;
+    }
+  else
+    cairo_surface_destroy (surface);
+}
+
+/* Gets rid of the buffers the pool has no more room for, starting
+ * with the one that was painted longest ago. Buffers held by the
+ * compositor are dropped once they are released.
+ */
+static void
+gdk_wayland_cairo_context_trim_pool (GdkWaylandCairoContext *self)
+{
+  guint n_surfaces = g_slist_length (self->surfaces);
+
+  while (n_surfaces > self->pool_size)
+    {
+      cairo_surface_t *oldest = NULL;
+      guint64 oldest_frame = 0;
+      GSList *l;
+
+      for (l = self->surfaces; l; l = l->next)
+        {
+          GdkWaylandCairoBuffer *buffer = gdk_wayland_cairo_context_get_buffer (l->data);
+
+          if (buffer->busy || l->data == self->paint_surface)
+            continue;
+
+          if (oldest == NULL || buffer->frame < oldest_frame)
+            {
+              oldest = l->data;
+              oldest_frame = buffer->frame;
+            }
+        }
+
+      if (oldest == NULL)
+        break;
+
+      gdk_wayland_cairo_context_remove_surface (self, oldest);
+      n_surfaces--;
+    }
 }
 
 static void
@@ -94,23 +123,21 @@ gdk_wayland_cairo_context_buffer_release (void             *_data,
                                           struct wl_buffer *wl_buffer)
 {
   cairo_surface_t *cairo_surface = _data;
-  GdkWaylandCairoContext *self = gdk_wayland_cairo_context_get_from_surface (cairo_surface);
+  GdkWaylandCairoBuffer *buffer = gdk_wayland_cairo_context_get_buffer (cairo_surface);
+  GdkWaylandCairoContext *self = buffer->context;
 
-  /* context was destroyed before compositor released this buffer */
-  if (self == NULL)
-    return;
+  buffer->busy = FALSE;
 
-  /* Cache one surface for reuse when drawing */
-  if (self->cached_surface == NULL)
+  /* context was destroyed or resized before compositor released this buffer */
+  if (self == NULL)
     {
-      self->cached_surface = cairo_surface;
+      cairo_surface_destroy (cairo_surface);
       return;
     }
 
-  /* Get rid of all the extra ones */
-  gdk_wayland_cairo_context_remove_surface (self, cairo_surface);
-  /* Release the reference the compositor held to this surface */
-  cairo_surface_destroy (cairo_surface);
+  self->n_busy--;
+
+  gdk_wayland_cairo_context_trim_pool (self);
 }
 
 static const struct wl_buffer_listener buffer_listener = {
@@ -124,7 +151,6 @@ gdk_wayland_cairo_context_create_surface (GdkWaylandCairoContext *self)
   GdkSurface *surface = gdk_draw_context_get_surface (GDK_DRAW_CONTEXT (self));
   cairo_surface_t *cairo_surface;
   struct wl_buffer *buffer;
-  cairo_region_t *region;
   int width, height;
 
   width = gdk_surface_get_width (surface);
@@ -136,34 +162,74 @@ gdk_wayland_cairo_context_create_surface (GdkWaylandCairoContext *self)
   wl_buffer_add_listener (buffer, &buffer_listener, cairo_surface);
   gdk_wayland_cairo_context_add_surface (self, cairo_surface);
 
-  region = cairo_region_create_rectangle (&(cairo_rectangle_int_t) { 0, 0, width, height });
-  gdk_wayland_cairo_context_surface_add_region (cairo_surface, region);
-  cairo_region_destroy (region);
-
   return cairo_surface;
 }
 
+/* Of the buffers not held by the compositor, pick the one that was
+ * painted most recently, it needs the least repainting.
+ */
+static cairo_surface_t *
+gdk_wayland_cairo_context_get_free_surface (GdkWaylandCairoContext *self)
+{
+  cairo_surface_t *result = NULL;
+  guint64 result_frame = 0;
+  GSList *l;
+
+  for (l = self->surfaces; l; l = l->next)
+    {
+      GdkWaylandCairoBuffer *buffer = gdk_wayland_cairo_context_get_buffer (l->data);
+
+      if (buffer->busy)
+        continue;
+
+      if (result == NULL || buffer->frame > result_frame)
+        {
+          result = l->data;
+          result_frame = buffer->frame;
+        }
+    }
+
+  return result;
+}
+
 static void
 gdk_wayland_cairo_context_begin_frame (GdkDrawContext *draw_context,
                                        cairo_region_t *region)
 {
   GdkWaylandCairoContext *self = GDK_WAYLAND_CAIRO_CONTEXT (draw_context);
-  const cairo_region_t *surface_region;
-  GSList *l;
+  GdkWaylandCairoBuffer *buffer;
+  GdkSurface *surface;
+  guint64 age;
   cairo_t *cr;
 
-  if (self->cached_surface)
-    self->paint_surface = g_steal_pointer (&self->cached_surface);
-  else
+  surface = gdk_draw_context_get_surface (draw_context);
+
+  self->paint_surface = gdk_wayland_cairo_context_get_free_surface (self);
+  if (self->paint_surface == NULL)
     self->paint_surface = gdk_wayland_cairo_context_create_surface (self);
 
-  surface_region = gdk_wayland_cairo_context_surface_get_region (self->paint_surface);
-  if (surface_region)
-    cairo_region_union (region, surface_region);
+  self->frame_counter++;
+  self->frame_region = cairo_region_copy (region);
 
-  for (l = self->surfaces; l; l = l->next)
+  /* Repaint everything that changed since this buffer was last used */
+  buffer = gdk_wayland_cairo_context_get_buffer (self->paint_surface);
+  age = buffer->frame ? self->frame_counter - buffer->frame : 0;
+
+  if (age == 0 || age > GDK_WAYLAND_CAIRO_DAMAGE_HISTORY)
     {
-      gdk_wayland_cairo_context_surface_add_region (l->data, region);
+      cairo_region_union_rectangle (region,
+                                    &(cairo_rectangle_int_t) {
+                                        0, 0,
+                                        gdk_surface_get_width (surface),
+                                        gdk_surface_get_height (surface)
+                                    });
+    }
+  else
+    {
+      guint64 i;
+
+      for (i = buffer->frame + 1; i < self->frame_counter; i++)
+        cairo_region_union (region, self->damage[i % GDK_WAYLAND_CAIRO_DAMAGE_HISTORY]);
     }
 
   /* clear the repaint area */
@@ -180,6 +246,8 @@ gdk_wayland_cairo_context_end_frame (GdkDrawContext *draw_context,
 {
   GdkWaylandCairoContext *self = GDK_WAYLAND_CAIRO_CONTEXT (draw_context);
   GdkSurface *surface = gdk_draw_context_get_surface (draw_context);
+  GdkWaylandCairoBuffer *buffer;
+  guint slot;
 
   gdk_wayland_surface_attach_image (surface, self->paint_surface, painted);
   gdk_wayland_surface_sync (surface);
@@ -189,16 +257,47 @@ gdk_wayland_cairo_context_end_frame (GdkDrawContext *draw_context,
   gdk_wayland_surface_commit (surface);
   gdk_wayland_surface_notify_committed (surface);
 
-  gdk_wayland_cairo_context_surface_clear_region (self->paint_surface);
+  buffer = gdk_wayland_cairo_context_get_buffer (self->paint_surface);
+  buffer->frame = self->frame_counter;
+  /* Nothing gets attached to destroyed surfaces, so nothing will be released */
+  if (!GDK_SURFACE_DESTROYED (surface))
+    {
+      buffer->busy = TRUE;
+      self->n_busy++;
+    }
   self->paint_surface = NULL;
+
+  slot = self->frame_counter % GDK_WAYLAND_CAIRO_DAMAGE_HISTORY;
+  g_clear_pointer (&self->damage[slot], cairo_region_destroy);
+  self->damage[slot] = g_steal_pointer (&self->frame_region);
+
+  /* Grow the pool right away when the compositor holds on to more
+   * buffers, but only shrink it when it didn't need them for a while.
+   */
+  self->busy_peak = MAX (self->busy_peak, self->n_busy);
+  if (self->busy_peak + 1 > self->pool_size)
+    self->pool_size = MIN (self->busy_peak + 1, MAX_POOL_SIZE);
+
+  if (++self->pool_frames >= POOL_WINDOW)
+    {
+      self->pool_size = CLAMP (self->busy_peak + 1, MIN_POOL_SIZE, MAX_POOL_SIZE);
+      self->busy_peak = self->n_busy;
+      self->pool_frames = 0;
+
+      gdk_wayland_cairo_context_trim_pool (self);
+    }
 }
 
 static void
 gdk_wayland_cairo_context_clear_all_cairo_surfaces (GdkWaylandCairoContext *self)
 {
-  g_clear_pointer (&self->cached_surface, cairo_surface_destroy);
+  guint i;
+
   while (self->surfaces)
     gdk_wayland_cairo_context_remove_surface (self, self->surfaces->data);
+
+  for (i = 0; i < GDK_WAYLAND_CAIRO_DAMAGE_HISTORY; i++)
+    g_clear_pointer (&self->damage[i], cairo_region_destroy);
 }
 
 static void
@@ -223,8 +322,8 @@ gdk_wayland_cairo_context_dispose (GObject *object)
   GdkWaylandCairoContext *self = GDK_WAYLAND_CAIRO_CONTEXT (object);
 
   gdk_wayland_cairo_context_clear_all_cairo_surfaces (self);
-  g_assert (self->cached_surface == NULL);
   g_assert (self->paint_surface == NULL);
+  g_assert (self->frame_region == NULL);
 
   G_OBJECT_CLASS (gdk_wayland_cairo_context_parent_class)->dispose (object);
 }
@@ -248,5 +347,6 @@ gdk_wayland_cairo_context_class_init (GdkWaylandCairoContextClass *klass)
 static void
 gdk_wayland_cairo_context_init (GdkWaylandCairoContext *self)
 {
+  self->pool_size = MIN_POOL_SIZE;
 }
 
@@ -35,13 +35,25 @@ G_BEGIN_DECLS
 typedef struct _GdkWaylandCairoContext GdkWaylandCairoContext;
 typedef struct _GdkWaylandCairoContextClass GdkWaylandCairoContextClass;
 
+#define GDK_WAYLAND_CAIRO_DAMAGE_HISTORY 8
+
 struct _GdkWaylandCairoContext
 {
   GdkCairoContext parent_instance;
 
-  GSList *surfaces;
-  cairo_surface_t *cached_surface;
+  GSList *surfaces;                 /* all buffers, free or in use */
   cairo_surface_t *paint_surface;
+  cairo_region_t *frame_region;     /* damage of the frame being painted */
+
+  /* damage of the last frames, indexed by frame_counter */
+  cairo_region_t *damage[GDK_WAYLAND_CAIRO_DAMAGE_HISTORY];
+  guint64 frame_counter;
+
+  /* adapting the pool to how long the compositor holds on to buffers */
+  guint n_busy;
+  guint busy_peak;
+  guint pool_size;
+  guint pool_frames;
 };
 
 struct _GdkWaylandCairoContextClass
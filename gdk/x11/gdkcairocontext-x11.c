@@ -22,6 +22,7 @@
 
 #include "gdkcairocontext-x11.h"
 
+#include "gdkdisplay-x11.h"
 #include "gdkprivate-x11.h"
 
 #include "gdkcairo.h"
@@ -30,6 +31,23 @@
 
 #include <X11/Xlib.h>
 
+#ifdef HAVE_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
+
+struct _GdkX11ShmBuffer
+{
+#ifdef HAVE_XSHM
+  XShmSegmentInfo shm_info;
+#endif
+  XImage *ximage;
+  cairo_surface_t *surface;
+  /* Serial of the last request reading from this buffer */
+  unsigned long serial;
+};
+
 G_DEFINE_TYPE (GdkX11CairoContext, gdk_x11_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
 
 static cairo_surface_t *
@@ -54,6 +72,255 @@ create_cairo_surface_for_surface (GdkSurface *surface)
   return cairo_surface;
 }
 
+#ifdef HAVE_XSHM
+static void
+gdk_x11_shm_buffer_free (GdkX11ShmBuffer *buffer,
+                         Display         *xdisplay)
+{
+  cairo_surface_destroy (buffer->surface);
+
+  XShmDetach (xdisplay, &buffer->shm_info);
+  /* The data is the shared segment, XDestroyImage must not free it */
+  buffer->ximage->data = NULL;
+  XDestroyImage (buffer->ximage);
+  shmdt (buffer->shm_info.shmaddr);
+
+  g_free (buffer);
+}
+
+static gboolean
+get_shm_format (GdkX11Display  *display_x11,
+                cairo_format_t *format)
+{
+  Visual *visual = display_x11->window_visual;
+
+  if (!display_x11->have_xshm)
+    return FALSE;
+
+  /* Cairo image surfaces are native-endian xRGB */
+  if (visual->red_mask != 0xff0000 ||
+      visual->green_mask != 0xff00 ||
+      visual->blue_mask != 0xff)
+    return FALSE;
+
+  if (ImageByteOrder (display_x11->xdisplay) != (G_BYTE_ORDER == G_LITTLE_ENDIAN ? LSBFirst : MSBFirst))
+    return FALSE;
+
+  switch (display_x11->window_depth)
+    {
+    case 32:
+      *format = CAIRO_FORMAT_ARGB32;
+      return TRUE;
+    case 24:
+      *format = CAIRO_FORMAT_RGB24;
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+static GdkX11ShmBuffer *
+gdk_x11_shm_buffer_new (GdkDisplay *display,
+                        int         width,
+                        int         height)
+{
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (display);
+  Display *xdisplay = display_x11->xdisplay;
+  GdkX11ShmBuffer *buffer;
+  cairo_format_t format;
+  XImage *ximage;
+  int shmid;
+  int error;
+
+  if (!get_shm_format (display_x11, &format))
+    return NULL;
+
+  buffer = g_new0 (GdkX11ShmBuffer, 1);
+
+  ximage = XShmCreateImage (xdisplay,
+                            display_x11->window_visual,
+                            display_x11->window_depth,
+                            ZPixmap,
+                            NULL,
+                            &buffer->shm_info,
+                            width, height);
+  if (ximage == NULL)
+    goto fail;
+
+  if (ximage->bits_per_pixel != 32 ||
+      ximage->bytes_per_line != cairo_format_stride_for_width (format, width))
+    goto fail_image;
+
+  shmid = shmget (IPC_PRIVATE, ximage->bytes_per_line * ximage->height, IPC_CREAT | 0600);
+  if (shmid < 0)
+    goto fail_image;
+
+  buffer->shm_info.shmid = shmid;
+  buffer->shm_info.shmaddr = shmat (shmid, NULL, 0);
+  buffer->shm_info.readOnly = False;
+
+  if (buffer->shm_info.shmaddr == (char *) -1)
+    {
+      shmctl (shmid, IPC_RMID, NULL);
+      goto fail_image;
+    }
+
+  ximage->data = buffer->shm_info.shmaddr;
+
+  /* Attaching fails for clients that don't share memory with the
+   * server, so find out now and fall back to the protocol path.
+   */
+  gdk_x11_display_error_trap_push (display);
+  XShmAttach (xdisplay, &buffer->shm_info);
+  XSync (xdisplay, False);
+  error = gdk_x11_display_error_trap_pop (display);
+
+  /* The segment goes away once both sides have detached */
+  shmctl (shmid, IPC_RMID, NULL);
+
+  if (error)
+    {
+      GDK_DISPLAY_NOTE (display, MISC, g_message ("Attaching MIT-SHM segment failed, disabling MIT-SHM"));
+      display_x11->have_xshm = FALSE;
+      shmdt (buffer->shm_info.shmaddr);
+      goto fail_image;
+    }
+
+  buffer->ximage = ximage;
+  buffer->surface = cairo_image_surface_create_for_data ((guchar *) ximage->data,
+                                                         format,
+                                                         width, height,
+                                                         ximage->bytes_per_line);
+
+  return buffer;
+
+fail_image:
+  ximage->data = NULL;
+  XDestroyImage (ximage);
+fail:
+  g_free (buffer);
+  return NULL;
+}
+
+static void
+gdk_x11_cairo_context_clear_shm (GdkX11CairoContext *self)
+{
+  GdkDisplay *display = gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self));
+  Display *xdisplay = gdk_x11_display_get_xdisplay (display);
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (self->shm_buffers); i++)
+    {
+      if (self->shm_buffers[i])
+        gdk_x11_shm_buffer_free (self->shm_buffers[i], xdisplay);
+      self->shm_buffers[i] = NULL;
+    }
+
+  self->current_shm_buffer = NULL;
+}
+
+/* Picks the buffer that was not used for the previous frame and makes
+ * sure it has the right size and the server is done reading from it.
+ */
+static GdkX11ShmBuffer *
+gdk_x11_cairo_context_get_shm_buffer (GdkX11CairoContext *self,
+                                      GdkSurface         *surface)
+{
+  GdkDisplay *display = gdk_surface_get_display (surface);
+  Display *xdisplay = gdk_x11_display_get_xdisplay (display);
+  GdkX11ShmBuffer *buffer;
+  int scale, width, height;
+  guint i;
+
+  scale = gdk_surface_get_scale_factor (surface);
+  width = gdk_surface_get_width (surface) * scale;
+  height = gdk_surface_get_height (surface) * scale;
+
+  if (width <= 0 || height <= 0)
+    return NULL;
+
+  i = self->current_shm_buffer == self->shm_buffers[0] ? 1 : 0;
+  buffer = self->shm_buffers[i];
+
+  if (buffer &&
+      (cairo_image_surface_get_width (buffer->surface) != width ||
+       cairo_image_surface_get_height (buffer->surface) != height))
+    {
+      gdk_x11_shm_buffer_free (buffer, xdisplay);
+      self->shm_buffers[i] = NULL;
+    }
+
+  if (self->shm_buffers[i] == NULL)
+    self->shm_buffers[i] = gdk_x11_shm_buffer_new (display, width, height);
+
+  buffer = self->shm_buffers[i];
+  if (buffer == NULL)
+    return NULL;
+
+  if (buffer->serial != 0 &&
+      LastKnownRequestProcessed (xdisplay) < buffer->serial)
+    XSync (xdisplay, False);
+
+  if (self->shm_gc == NULL)
+    self->shm_gc = XCreateGC (xdisplay, GDK_SURFACE_XID (surface), 0, NULL);
+
+  cairo_surface_set_device_scale (buffer->surface, scale, scale);
+
+  return buffer;
+}
+
+static void
+gdk_x11_cairo_context_put_shm_buffer (GdkX11CairoContext *self,
+                                      GdkX11ShmBuffer    *buffer,
+                                      cairo_region_t     *painted)
+{
+  GdkSurface *surface = gdk_draw_context_get_surface (GDK_DRAW_CONTEXT (self));
+  Display *xdisplay = gdk_x11_display_get_xdisplay (gdk_surface_get_display (surface));
+  cairo_rectangle_int_t extents = { 0, 0, 0, 0 };
+  cairo_region_t *damage;
+  int scale, i, n;
+
+  cairo_surface_flush (buffer->surface);
+
+  scale = gdk_surface_get_scale_factor (surface);
+  extents.width = cairo_image_surface_get_width (buffer->surface);
+  extents.height = cairo_image_surface_get_height (buffer->surface);
+
+  damage = cairo_region_create ();
+  n = cairo_region_num_rectangles (painted);
+  for (i = 0; i < n; i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (painted, i, &rect);
+      rect.x *= scale;
+      rect.y *= scale;
+      rect.width *= scale;
+      rect.height *= scale;
+      cairo_region_union_rectangle (damage, &rect);
+    }
+  cairo_region_intersect_rectangle (damage, &extents);
+
+  n = cairo_region_num_rectangles (damage);
+  for (i = 0; i < n; i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (damage, i, &rect);
+      XShmPutImage (xdisplay, GDK_SURFACE_XID (surface), self->shm_gc, buffer->ximage,
+                    rect.x, rect.y,
+                    rect.x, rect.y,
+                    rect.width, rect.height,
+                    False);
+    }
+
+  buffer->serial = NextRequest (xdisplay) - 1;
+  XFlush (xdisplay);
+
+  cairo_region_destroy (damage);
+}
+#endif
+
 static void
 gdk_x11_cairo_context_begin_frame (GdkDrawContext *draw_context,
                                    cairo_region_t *region)
@@ -64,6 +331,29 @@ gdk_x11_cairo_context_begin_frame (GdkDrawContext *draw_context,
   double sx, sy;
 
   surface = gdk_draw_context_get_surface (draw_context);
+
+#ifdef HAVE_XSHM
+  self->current_shm_buffer = gdk_x11_cairo_context_get_shm_buffer (self, surface);
+  if (self->current_shm_buffer)
+    {
+      cairo_t *cr;
+
+      self->paint_surface = cairo_surface_reference (self->current_shm_buffer->surface);
+
+      /* The buffer still holds an older frame, start from a clear slate
+       * like the protocol path does.
+       */
+      cr = cairo_create (self->paint_surface);
+      gdk_cairo_region (cr, region);
+      cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+      cairo_fill (cr);
+      cairo_destroy (cr);
+
+      return;
+    }
+  gdk_x11_cairo_context_clear_shm (self);
+#endif
+
   cairo_region_get_extents (region, &clip_box);
 
   self->window_surface = create_cairo_surface_for_surface (surface);
@@ -84,6 +374,15 @@ gdk_x11_cairo_context_end_frame (GdkDrawContext *draw_context,
   GdkX11CairoContext *self = GDK_X11_CAIRO_CONTEXT (draw_context);
   cairo_t *cr;
 
+#ifdef HAVE_XSHM
+  if (self->current_shm_buffer)
+    {
+      gdk_x11_cairo_context_put_shm_buffer (self, self->current_shm_buffer, painted);
+      g_clear_pointer (&self->paint_surface, cairo_surface_destroy);
+      return;
+    }
+#endif
+
   cr = cairo_create (self->window_surface);
 
   cairo_set_source_surface (cr, self->paint_surface, 0, 0);
@@ -109,12 +408,35 @@ gdk_x11_cairo_context_cairo_create (GdkCairoContext *context)
   return cairo_create (self->paint_surface);
 }
 
+static void
+gdk_x11_cairo_context_dispose (GObject *object)
+{
+  GdkX11CairoContext *self = GDK_X11_CAIRO_CONTEXT (object);
+
+#ifdef HAVE_XSHM
+  gdk_x11_cairo_context_clear_shm (self);
+#endif
+
+  if (self->shm_gc)
+    {
+      GdkDisplay *display = gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self));
+
+      XFreeGC (gdk_x11_display_get_xdisplay (display), self->shm_gc);
+      self->shm_gc = NULL;
+    }
+
+  G_OBJECT_CLASS (gdk_x11_cairo_context_parent_class)->dispose (object);
+}
+
 static void
 gdk_x11_cairo_context_class_init (GdkX11CairoContextClass *klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GdkDrawContextClass *draw_context_class = GDK_DRAW_CONTEXT_CLASS (klass);
   GdkCairoContextClass *cairo_context_class = GDK_CAIRO_CONTEXT_CLASS (klass);
 
+  gobject_class->dispose = gdk_x11_cairo_context_dispose;
+
   draw_context_class->begin_frame = gdk_x11_cairo_context_begin_frame;
   draw_context_class->end_frame = gdk_x11_cairo_context_end_frame;
 
@@ -77,6 +77,12 @@
 #include <X11/extensions/Xrandr.h>
 #endif
 
+#ifdef HAVE_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
+
 enum {
   XEVENT,
   LAST_SIGNAL
@@ -829,7 +835,8 @@ gdk_x11_display_translate_event (GdkEventTranslator *translator,
 
           _gdk_x11_surface_grab_check_unmap (surface, xevent->xany.serial);
 
-          gdk_profiler_add_markf (GDK_PROFILER_CURRENT_TIME, 0, "unmapped window", "0x%lx", GDK_SURFACE_XID (surface));
+          if (GDK_PROFILER_IS_RUNNING)
+            gdk_profiler_add_markf (GDK_PROFILER_CURRENT_TIME, 0, "unmapped window", "0x%lx", GDK_SURFACE_XID (surface));
         }
 
       break;
@@ -1602,6 +1609,11 @@ gdk_x11_display_open (const char *display_name)
     display_x11->have_damage = TRUE;
 #endif
 
+#ifdef HAVE_XSHM
+  display_x11->have_xshm = XShmQueryExtension (display_x11->xdisplay) &&
+                           !GDK_DISPLAY_DEBUG_CHECK (display, SHM_DISABLE);
+#endif
+
   display->clipboard = gdk_x11_clipboard_new (display, "CLIPBOARD");
   display->primary_clipboard = gdk_x11_clipboard_new (display, "PRIMARY");
 
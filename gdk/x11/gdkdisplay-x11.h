@@ -132,6 +132,11 @@ struct _GdkX11Display
   guint have_damage;
 #endif
 
+#ifdef HAVE_XSHM
+  /* Cleared again if attaching a segment fails, e.g. for remote displays */
+  guint have_xshm : 1;
+#endif
+
   /* GLX information */
   int glx_version;
   int glx_error_base;
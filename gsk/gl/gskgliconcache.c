@@ -139,6 +139,7 @@ gsk_gl_icon_cache_lookup_or_add (GskGLIconCache  *self,
     guchar *free_data = NULL;
     guint gl_format;
     guint gl_type;
+    int row_length;
 
     gsk_gl_texture_atlases_pack (self->atlases, width + 2, height + 2, &atlas, &packed_x, &packed_y);
 
@@ -170,15 +171,18 @@ gsk_gl_icon_cache_lookup_or_add (GskGLIconCache  *self,
                             GDK_MEMORY_DEFAULT, width, height);
         gl_format = GL_RGBA;
         gl_type = GL_UNSIGNED_BYTE;
+        row_length = width;
       }
     else
       {
         pixel_data = surface_data;
         gl_format = GL_BGRA;
         gl_type = GL_UNSIGNED_INT_8_8_8_8_REV;
+        row_length = cairo_image_surface_get_stride (surface) / 4;
       }
 
     glBindTexture (GL_TEXTURE_2D, atlas->texture_id);
+    glPixelStorei (GL_UNPACK_ROW_LENGTH, row_length);
 
     glTexSubImage2D (GL_TEXTURE_2D, 0,
                      packed_x + 1, packed_y + 1,
@@ -205,7 +209,7 @@ gsk_gl_icon_cache_lookup_or_add (GskGLIconCache  *self,
                      pixel_data);
 
     /* Padding right */
-    glPixelStorei (GL_UNPACK_ROW_LENGTH, width);
+    glPixelStorei (GL_UNPACK_ROW_LENGTH, row_length);
     glPixelStorei (GL_UNPACK_SKIP_PIXELS, width - 1);
     glTexSubImage2D (GL_TEXTURE_2D, 0,
                      packed_x + width + 1, packed_y + 1,
@@ -220,7 +224,7 @@ gsk_gl_icon_cache_lookup_or_add (GskGLIconCache  *self,
                      pixel_data);
     /* Padding bottom */
     glPixelStorei (GL_UNPACK_SKIP_PIXELS, 0);
-    glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei (GL_UNPACK_ROW_LENGTH, row_length);
     glPixelStorei (GL_UNPACK_SKIP_ROWS, height - 1);
     glTexSubImage2D (GL_TEXTURE_2D, 0,
                      packed_x + 1, packed_y + 1 + height,
@@ -234,7 +238,7 @@ gsk_gl_icon_cache_lookup_or_add (GskGLIconCache  *self,
                      gl_format, gl_type,
                      pixel_data);
     /* Padding bottom right */
-    glPixelStorei (GL_UNPACK_ROW_LENGTH, width);
+    glPixelStorei (GL_UNPACK_ROW_LENGTH, row_length);
     glPixelStorei (GL_UNPACK_SKIP_PIXELS, width - 1);
     glTexSubImage2D (GL_TEXTURE_2D, 0,
                      packed_x + 1 + width, packed_y + 1 + height,
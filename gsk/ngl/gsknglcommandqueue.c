@@ -1145,12 +1145,15 @@ gsk_ngl_command_queue_execute (GskNglCommandQueue   *self,
   glDeleteBuffers (1, &vbo_id);
   glDeleteVertexArrays (1, &vao_id);
 
-  gdk_profiler_set_int_counter (self->metrics.n_binds, n_binds);
-  gdk_profiler_set_int_counter (self->metrics.n_uniforms, n_uniforms);
-  gdk_profiler_set_int_counter (self->metrics.n_fbos, n_fbos);
-  gdk_profiler_set_int_counter (self->metrics.n_programs, n_programs);
-  gdk_profiler_set_int_counter (self->metrics.n_uploads, self->n_uploads);
-  gdk_profiler_set_int_counter (self->metrics.queue_depth, self->batches.len);
+  if (gdk_profiler_is_running ())
+    {
+      gdk_profiler_set_int_counter (self->metrics.n_binds, n_binds);
+      gdk_profiler_set_int_counter (self->metrics.n_uniforms, n_uniforms);
+      gdk_profiler_set_int_counter (self->metrics.n_fbos, n_fbos);
+      gdk_profiler_set_int_counter (self->metrics.n_programs, n_programs);
+      gdk_profiler_set_int_counter (self->metrics.n_uploads, self->n_uploads);
+      gdk_profiler_set_int_counter (self->metrics.queue_depth, self->batches.len);
+    }
 
 #ifdef G_ENABLE_DEBUG
   {
@@ -82,6 +82,7 @@ gsk_ngl_icon_library_add (GskNglIconLibrary     *self,
   guint8 *free_data = NULL;
   guint gl_format;
   guint gl_type;
+  int row_length;
   guint packed_x;
   guint packed_y;
   int width;
@@ -117,17 +118,20 @@ gsk_ngl_icon_library_add (GskNglIconLibrary     *self,
                           GDK_MEMORY_DEFAULT, width, height);
       gl_format = GL_RGBA;
       gl_type = GL_UNSIGNED_BYTE;
+      row_length = width;
     }
   else
     {
       pixel_data = surface_data;
       gl_format = GL_BGRA;
       gl_type = GL_UNSIGNED_INT_8_8_8_8_REV;
+      row_length = cairo_image_surface_get_stride (surface) / 4;
     }
 
   texture_id = GSK_NGL_TEXTURE_ATLAS_ENTRY_TEXTURE (icon_data);
 
   glBindTexture (GL_TEXTURE_2D, texture_id);
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, row_length);
 
   glTexSubImage2D (GL_TEXTURE_2D, 0,
                    packed_x + 1, packed_y + 1,
@@ -154,7 +158,7 @@ gsk_ngl_icon_library_add (GskNglIconLibrary     *self,
                    pixel_data);
 
   /* Padding right */
-  glPixelStorei (GL_UNPACK_ROW_LENGTH, width);
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, row_length);
   glPixelStorei (GL_UNPACK_SKIP_PIXELS, width - 1);
   glTexSubImage2D (GL_TEXTURE_2D, 0,
                    packed_x + width + 1, packed_y + 1,
@@ -169,7 +173,7 @@ gsk_ngl_icon_library_add (GskNglIconLibrary     *self,
                    pixel_data);
   /* Padding bottom */
   glPixelStorei (GL_UNPACK_SKIP_PIXELS, 0);
-  glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, row_length);
   glPixelStorei (GL_UNPACK_SKIP_ROWS, height - 1);
   glTexSubImage2D (GL_TEXTURE_2D, 0,
                    packed_x + 1, packed_y + 1 + height,
@@ -183,7 +187,7 @@ gsk_ngl_icon_library_add (GskNglIconLibrary     *self,
                    gl_format, gl_type,
                    pixel_data);
   /* Padding bottom right */
-  glPixelStorei (GL_UNPACK_ROW_LENGTH, width);
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, row_length);
   glPixelStorei (GL_UNPACK_SKIP_PIXELS, width - 1);
   glTexSubImage2D (GL_TEXTURE_2D, 0,
                    packed_x + 1 + width, packed_y + 1 + height,
@@ -23,6 +23,7 @@
 
 #include "config.h"
 
+#include <gdk/gdkfp16private.h>
 #include <gdk/gdkglcontextprivate.h>
 #include <gdk/gdkprofilerprivate.h>
 #include <gdk/gdkrgbaprivate.h>
@@ -43,7 +44,6 @@
 #include "gsknglshadowlibraryprivate.h"
 
 #include "ninesliceprivate.h"
-#include "fp16private.h"
 
 #define ORTHO_NEAR_PLANE   -10000
 #define ORTHO_FAR_PLANE     10000
@@ -47,8 +47,92 @@ struct _GtkBitset
 {
   int ref_count;
   roaring_bitmap_t roaring;
+
+  /* Cumulative cardinalities of the containers, so rank and select
+   * can binary search instead of summing up all containers.
+   * Only the first n_valid_sizes entries are up to date, every change
+   * invalidates the entries starting at the first affected container.
+   */
+  guint64 *sizes;
+  int n_sizes;
+  int n_valid_sizes;
 };
 
+/* Invalidates the cached sizes for all containers that may hold
+ * values >= @value.
+ */
+static inline void
+gtk_bitset_invalidate_from (GtkBitset *self,
+                            guint      value)
+{
+  const roaring_array_t *ra = &self->roaring.high_low_container;
+  int i;
+
+  if (self->n_valid_sizes == 0)
+    return;
+
+  i = ra_get_index (ra, value >> 16);
+  if (i < 0)
+    i = -i - 1;
+
+  self->n_valid_sizes = MIN (self->n_valid_sizes, i);
+}
+
+static inline void
+gtk_bitset_invalidate (GtkBitset *self)
+{
+  self->n_valid_sizes = 0;
+}
+
+static void
+gtk_bitset_ensure_sizes (const GtkBitset *bitset)
+{
+  /* the cache is not part of the value */
+  GtkBitset *self = (GtkBitset *) bitset;
+  const roaring_array_t *ra = &self->roaring.high_low_container;
+  guint64 size;
+  int i;
+
+  if (self->n_valid_sizes == ra->size)
+    return;
+
+  if (self->n_sizes < ra->size)
+    {
+      self->n_sizes = MAX (ra->size, 2 * self->n_sizes);
+      self->sizes = g_renew (guint64, self->sizes, self->n_sizes);
+    }
+
+  size = self->n_valid_sizes > 0 ? self->sizes[self->n_valid_sizes - 1] : 0;
+  for (i = self->n_valid_sizes; i < ra->size; i++)
+    {
+      size += container_get_cardinality (ra->containers[i], ra->typecodes[i]);
+      self->sizes[i] = size;
+    }
+
+  self->n_valid_sizes = ra->size;
+}
+
+/* Returns the number of values in @self that are <= @value */
+static guint64
+gtk_bitset_rank (const GtkBitset *self,
+                 guint            value)
+{
+  const roaring_array_t *ra = &self->roaring.high_low_container;
+  int i;
+
+  gtk_bitset_ensure_sizes (self);
+
+  i = ra_get_index (ra, value >> 16);
+  if (i < 0)
+    {
+      i = -i - 1;
+      return i > 0 ? self->sizes[i - 1] : 0;
+    }
+
+  return (i > 0 ? self->sizes[i - 1] : 0) +
+         container_rank (ra->containers[i], ra->typecodes[i], value & 0xFFFF);
+}
+
 
 G_DEFINE_BOXED_TYPE (GtkBitset, gtk_bitset,
                      gtk_bitset_ref,
@@ -92,6 +176,7 @@ gtk_bitset_unref (GtkBitset *self)
     return;
 
   ra_clear (&self->roaring.high_low_container);
+  g_free (self->sizes);
   g_slice_free (GtkBitset, self);
 }
 
@@ -207,7 +292,12 @@ gtk_bitset_get_size (const GtkBitset *self)
 {
   g_return_val_if_fail (self != NULL, 0);
 
-  return roaring_bitmap_get_cardinality (&self->roaring);
+  if (roaring_bitmap_is_empty (&self->roaring))
+    return 0;
+
+  gtk_bitset_ensure_sizes (self);
+
+  return self->sizes[self->roaring.high_low_container.size - 1];
 }
 
 /**
@@ -233,7 +323,10 @@ gtk_bitset_get_size_in_range (const GtkBitset *self,
   g_return_val_if_fail (self != NULL, 0);
   g_return_val_if_fail (last >= first, 0);
 
-  return roaring_bitmap_range_cardinality (&self->roaring, first, ((uint64_t) last) + 1);
+  if (first == 0)
+    return gtk_bitset_rank (self, last);
+
+  return gtk_bitset_rank (self, last) - gtk_bitset_rank (self, first - 1);
 }
 
 /**
@@ -251,12 +344,39 @@ guint
 gtk_bitset_get_nth (const GtkBitset *self,
                     guint            nth)
 {
-  uint32_t result;
+  const roaring_array_t *ra;
+  uint32_t start, result;
+  int min, max;
 
-  if (!roaring_bitmap_select (&self->roaring, nth, &result))
+  g_return_val_if_fail (self != NULL, 0);
+
+  ra = &self->roaring.high_low_container;
+  if (ra->size == 0)
     return 0;
 
-  return result;
+  gtk_bitset_ensure_sizes (self);
+
+  if (nth >= self->sizes[ra->size - 1])
+    return 0;
+
+  /* find the first container with a cumulative size > nth */
+  min = 0;
+  max = ra->size - 1;
+  while (min < max)
+    {
+      int mid = (min + max) / 2;
+
+      if (self->sizes[mid] > nth)
+        max = mid;
+      else
+        min = mid + 1;
+    }
+
+  start = min > 0 ? self->sizes[min - 1] : 0;
+  if (!container_select (ra->containers[min], ra->typecodes[min], &start, nth, &result))
+    g_assert_not_reached ();
+
+  return result | ((uint32_t) ra->keys[min] << 16);
 }
 
 /**
@@ -336,6 +456,7 @@ gtk_bitset_remove_all (GtkBitset *self)
   g_return_if_fail (self != NULL);
 
   roaring_bitmap_clear (&self->roaring);
+  gtk_bitset_invalidate (self);
 }
 
 /**
@@ -354,6 +475,8 @@ gtk_bitset_add (GtkBitset *self,
 {
   g_return_val_if_fail (self != NULL, FALSE);
 
+  gtk_bitset_invalidate_from (self, value);
+
   return roaring_bitmap_add_checked (&self->roaring, value);
 }
 
@@ -373,6 +496,8 @@ gtk_bitset_remove (GtkBitset *self,
 {
   g_return_val_if_fail (self != NULL, FALSE);
 
+  gtk_bitset_invalidate_from (self, value);
+
   return roaring_bitmap_remove_checked (&self->roaring, value);
 }
 
@@ -398,6 +523,7 @@ gtk_bitset_add_range (GtkBitset *self,
   /* overflow check, the == 0 is to allow add_range(G_MAXUINT, 1); */
   g_return_if_fail (start + n_items == 0 || start + n_items > start);
 
+  gtk_bitset_invalidate_from (self, start);
   roaring_bitmap_add_range_closed (&self->roaring, start, start + n_items - 1);
 }
 
@@ -423,6 +549,7 @@ gtk_bitset_remove_range (GtkBitset *self,
   /* overflow check, the == 0 is to allow add_range(G_MAXUINT, 1); */
   g_return_if_fail (start + n_items == 0 || start + n_items > start);
 
+  gtk_bitset_invalidate_from (self, start);
   roaring_bitmap_remove_range_closed (&self->roaring, start, start + n_items - 1);
 }
 
@@ -443,6 +570,7 @@ gtk_bitset_add_range_closed (GtkBitset *self,
   g_return_if_fail (self != NULL);
   g_return_if_fail (first <= last);
 
+  gtk_bitset_invalidate_from (self, first);
   roaring_bitmap_add_range_closed (&self->roaring, first, last);
 }
 
@@ -463,6 +591,7 @@ gtk_bitset_remove_range_closed (GtkBitset *self,
   g_return_if_fail (self != NULL);
   g_return_if_fail (first <= last);
 
+  gtk_bitset_invalidate_from (self, first);
   roaring_bitmap_remove_range_closed (&self->roaring, first, last);
 }
 
@@ -550,6 +679,7 @@ gtk_bitset_union (GtkBitset       *self,
   if (self == other)
     return;
 
+  gtk_bitset_invalidate (self);
   roaring_bitmap_or_inplace (&self->roaring, &other->roaring);
 }
 
@@ -575,6 +705,7 @@ gtk_bitset_intersect (GtkBitset       *self,
   if (self == other)
     return;
 
+  gtk_bitset_invalidate (self);
   roaring_bitmap_and_inplace (&self->roaring, &other->roaring);
 }
 
@@ -597,6 +728,8 @@ gtk_bitset_subtract (GtkBitset       *self,
   g_return_if_fail (self != NULL);
   g_return_if_fail (other != NULL);
   
+  gtk_bitset_invalidate (self);
+
   if (self == other)
     {
       roaring_bitmap_clear (&self->roaring);
@@ -627,6 +760,8 @@ gtk_bitset_difference (GtkBitset       *self,
   g_return_if_fail (self != NULL);
   g_return_if_fail (other != NULL);
   
+  gtk_bitset_invalidate (self);
+
   if (self == other)
     {
       roaring_bitmap_clear (&self->roaring);
@@ -559,6 +559,11 @@ gtk_builder_get_parameters (GtkBuilder         *builder,
           else
             g_assert_not_reached ();
         }
+      else if (G_IS_VALUE (&prop->parsed))
+        {
+          g_value_init (&property_value, G_VALUE_TYPE (&prop->parsed));
+          g_value_copy (&prop->parsed, &property_value);
+        }
       else if (prop->bound && (!prop->text || prop->text->len == 0))
         {
           /* Ignore properties with a binding and no value since they are
@@ -2723,6 +2728,15 @@ _gtk_builder_get_template_type (GtkBuilder *builder)
   return priv->template_type;
 }
 
+/* Returns the objects of @builder, by id */
+GHashTable *
+_gtk_builder_get_named_objects (GtkBuilder *builder)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+
+  return priv->objects;
+}
+
 /**
  * gtk_builder_create_closure:
  * @builder: a `GtkBuilder`
@@ -24,6 +24,7 @@
 #include "gtkbuilderscopeprivate.h"
 #include "gtkdebug.h"
 #include "gtkintl.h"
+#include "gtklazywidgetprivate.h"
 #include "gtktypebuiltins.h"
 #include "gtkversion.h"
 #include "gdkprofilerprivate.h"
@@ -541,6 +542,178 @@ parse_requires (ParserData   *data,
   req_info->tag_type = TAG_REQUIRES;
 }
 
+/* Objects with lazy="yes" are not built while parsing. Instead,
+ * their XML is recorded and a GtkLazyWidget takes their place,
+ * which builds them when it is needed. This only works for widgets
+ * in templates, everywhere else the attribute is ignored.
+ */
+static gboolean
+can_be_lazy (ParserData *data,
+             CommonInfo *parent_info,
+             GType       object_type)
+{
+  ObjectInfo *template_info;
+
+  if (data->requested_objects)
+    return FALSE;
+
+  if (!g_type_is_a (object_type, GTK_TYPE_WIDGET))
+    return FALSE;
+
+  if (parent_info == NULL)
+    return FALSE;
+
+  if (parent_info->tag_type == TAG_CHILD)
+    {
+      if (((ChildInfo *) parent_info)->internal_child)
+        return FALSE;
+    }
+  else if (parent_info->tag_type != TAG_PROPERTY)
+    return FALSE;
+
+  template_info = g_ptr_array_index (data->stack, 0);
+  if (template_info->tag_type != TAG_TEMPLATE ||
+      !GTK_IS_WIDGET (template_info->object))
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+record_lazy_start (ParserData  *data,
+                   const char  *element_name,
+                   const char **names,
+                   const char **values)
+{
+  const char *id = NULL;
+  int i;
+
+  g_string_append_printf (data->lazy, "<%s", element_name);
+
+  for (i = 0; names[i]; i++)
+    {
+      char *escaped;
+
+      /* Everything inside is built at once */
+      if (strcmp (names[i], "lazy") == 0 &&
+          strcmp (element_name, "object") == 0)
+        continue;
+
+      if (strcmp (names[i], "id") == 0)
+        id = values[i];
+
+      escaped = g_markup_escape_text (values[i], -1);
+      g_string_append_printf (data->lazy, " %s=\"%s\"", names[i], escaped);
+      g_free (escaped);
+    }
+
+  if (strcmp (element_name, "object") == 0)
+    {
+      if (id == NULL && data->lazy_level == 0)
+        {
+          id = "___lazy_object___";
+          g_string_append_printf (data->lazy, " id=\"%s\"", id);
+        }
+
+      if (id)
+        g_ptr_array_add (data->lazy_ids, g_strdup (id));
+    }
+
+  g_string_append_c (data->lazy, '>');
+
+  data->lazy_level++;
+}
+
+/* The placeholder stands in for the lazy object in its parent,
+ * so anything that is meant for the parent can't be deferred.
+ */
+static gboolean
+check_lazy_element (ParserData   *data,
+                    const char   *element_name,
+                    const char  **names,
+                    const char  **values,
+                    GError      **error)
+{
+  const char *what = NULL;
+  int line, col;
+  int i;
+
+  if (strcmp (element_name, "layout") == 0)
+    what = "<layout>";
+  else if (strcmp (element_name, "property") == 0)
+    {
+      for (i = 0; names[i]; i++)
+        {
+          if (strcmp (names[i], "name") == 0 && strcmp (values[i], "visible") == 0)
+            what = "The visible property";
+        }
+    }
+
+  if (what == NULL)
+    return TRUE;
+
+  gtk_buildable_parse_context_get_position (&data->ctx, &line, &col);
+  g_set_error (error,
+               GTK_BUILDER_ERROR,
+               GTK_BUILDER_ERROR_INVALID_TAG,
+               "%s:%d:%d %s can not be used on an object with lazy=\"yes\"",
+               data->filename, line, col, what);
+
+  return FALSE;
+}
+
+static gboolean
+record_lazy_end (ParserData *data,
+                 const char *element_name)
+{
+  g_string_append_printf (data->lazy, "</%s>", element_name);
+
+  data->lazy_level--;
+  if (data->lazy_level > 0)
+    return FALSE;
+
+  g_string_append (data->lazy, "</interface>");
+
+  return TRUE;
+}
+
+static void
+record_lazy_text (ParserData *data,
+                  const char *text,
+                  gsize       text_len)
+{
+  char *escaped;
+
+  escaped = g_markup_escape_text (text, text_len);
+  g_string_append (data->lazy, escaped);
+  g_free (escaped);
+}
+
+static void
+finish_lazy (ParserData *data,
+             GObject    *object)
+{
+  ObjectInfo *template_info;
+  GBytes *bytes;
+  char **ids;
+
+  template_info = g_ptr_array_index (data->stack, 0);
+
+  g_ptr_array_add (data->lazy_ids, NULL);
+  ids = (char **) g_ptr_array_free (data->lazy_ids, FALSE);
+  bytes = g_string_free_to_bytes (data->lazy);
+
+  gtk_lazy_widget_setup (GTK_LAZY_WIDGET (object),
+                         data->builder,
+                         GTK_WIDGET (template_info->object),
+                         bytes,
+                         ids);
+
+  g_bytes_unref (bytes);
+  data->lazy = NULL;
+  data->lazy_ids = NULL;
+}
+
 static gboolean
 is_requested_object (const char *object,
                      ParserData  *data)
@@ -572,6 +745,7 @@ parse_object (GtkBuildableParseContext  *context,
   const char *type_func = NULL;
   const char *object_id = NULL;
   char *internal_id = NULL;
+  gboolean lazy = FALSE;
   int line;
 
   child_info = state_peek_info (data, ChildInfo);
@@ -592,6 +766,7 @@ parse_object (GtkBuildableParseContext  *context,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "constructor", &constructor,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "type-func", &type_func,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "id", &object_id,
+                                    G_MARKUP_COLLECT_BOOLEAN|G_MARKUP_COLLECT_OPTIONAL, "lazy", &lazy,
                                     G_MARKUP_COLLECT_INVALID))
     {
       _gtk_builder_prefix_error (data->builder, &data->ctx, error);
@@ -636,6 +811,17 @@ parse_object (GtkBuildableParseContext  *context,
        }
     }
 
+  if (lazy && can_be_lazy (data, (CommonInfo *) child_info, object_type))
+    {
+      data->lazy = g_string_new ("<interface>");
+      data->lazy_ids = g_ptr_array_new_with_free_func (g_free);
+      record_lazy_start (data, element_name, names, values);
+
+      /* The placeholder goes where the object would have been */
+      object_type = GTK_TYPE_LAZY_WIDGET;
+      object_id = NULL;
+    }
+
   if (!object_id)
     {
       internal_id = g_strdup_printf ("___object_%d___", ++data->object_counter);
@@ -1045,6 +1231,8 @@ free_property_info (PropertyInfo *info)
       else
         g_assert_not_reached();
     }
+  if (G_IS_VALUE (&info->parsed))
+    g_value_unset (&info->parsed);
   g_string_free (info->text, TRUE);
   g_free (info->context);
   g_slice_free (PropertyInfo, info);
@@ -1784,6 +1972,16 @@ start_element (GtkBuildableParseContext  *context,
     }
   data->last_element = element_name;
 
+  if (data->lazy)
+    {
+      if (data->lazy_level == 1 &&
+          !check_lazy_element (data, element_name, names, values, error))
+        return;
+
+      record_lazy_start (data, element_name, names, values);
+      return;
+    }
+
   if (data->subparser)
     {
       if (!subparser_start (context, element_name, names, values, data, error))
@@ -1853,6 +2051,10 @@ end_element (GtkBuildableParseContext  *context,
 
   GTK_NOTE (BUILDER, g_message ("</%s>", element_name));
 
+  /* The end of the lazy object itself is handled like any other object */
+  if (data->lazy && !record_lazy_end (data, element_name))
+    return;
+
   if (data->subparser && data->subparser->start)
     {
       subparser_end (context, element_name, data, error);
@@ -1950,6 +2152,8 @@ end_element (GtkBuildableParseContext  *context,
           free_object_info (object_info);
           return;
         }
+      if (data->lazy)
+        finish_lazy (data, object_info->object);
       if (child_info)
         child_info->object = object_info->object;
       if (prop_info)
@@ -2091,6 +2295,12 @@ text (GtkBuildableParseContext  *context,
   ParserData *data = (ParserData*)user_data;
   CommonInfo *info;
 
+  if (data->lazy)
+    {
+      record_lazy_text (data, text, text_len);
+      return;
+    }
+
   if (data->subparser && data->subparser->start)
     {
       GError *tmp_error = NULL;
@@ -2230,6 +2440,10 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
  out:
 
   g_slist_free_full (data.custom_finalizers, (GDestroyNotify)free_subparser);
+  if (data.lazy)
+    g_string_free (data.lazy, TRUE);
+  if (data.lazy_ids)
+    g_ptr_array_free (data.lazy_ids, TRUE);
   g_free (data.domain);
   g_hash_table_destroy (data.object_ids);
   g_ptr_array_free (data.stack, TRUE);
@@ -2248,3 +2462,95 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
         }
     }
 }
+
+/*
+ * _gtk_builder_parser_set_parsed_value:
+ * @context: the parse context
+ * @fundamental: the fundamental type of the value
+ * @bits: the value, as stored by _gtk_buildable_parser_compile()
+ *
+ * Provides the value of the property that is currently being
+ * parsed, so it does not need to be converted from its text.
+ * If the value does not match the property, it is ignored and
+ * the text is used as usual.
+ */
+void
+_gtk_builder_parser_set_parsed_value (GtkBuildableParseContext *context,
+                                      GType                     fundamental,
+                                      guint64                   bits)
+{
+  ParserData *data;
+  PropertyInfo *prop_info;
+  GValue *value;
+  GType type;
+  double d;
+
+  /* Custom tags have their own ideas about properties */
+  if (context->parser != &parser)
+    return;
+
+  data = context->user_data;
+
+  if (data->subparser && data->subparser->start)
+    return;
+
+  if (data->requested_objects && !data->inside_requested_object)
+    return;
+
+  prop_info = state_peek_info (data, PropertyInfo);
+  if (prop_info == NULL ||
+      prop_info->tag_type != TAG_PROPERTY ||
+      prop_info->translatable ||
+      prop_info->bound ||
+      G_IS_VALUE (&prop_info->parsed))
+    return;
+
+  type = G_PARAM_SPEC_VALUE_TYPE (prop_info->pspec);
+  if (G_TYPE_FUNDAMENTAL (type) != fundamental)
+    return;
+
+  value = &prop_info->parsed;
+  g_value_init (value, type);
+
+  switch (fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      g_value_set_boolean (value, bits != 0);
+      break;
+    case G_TYPE_INT:
+      g_value_set_int (value, (int) (gint64) bits);
+      break;
+    case G_TYPE_UINT:
+      g_value_set_uint (value, (guint) bits);
+      break;
+    case G_TYPE_LONG:
+      g_value_set_long (value, (long) (gint64) bits);
+      break;
+    case G_TYPE_ULONG:
+      g_value_set_ulong (value, (gulong) bits);
+      break;
+    case G_TYPE_INT64:
+      g_value_set_int64 (value, (gint64) bits);
+      break;
+    case G_TYPE_UINT64:
+      g_value_set_uint64 (value, bits);
+      break;
+    case G_TYPE_ENUM:
+      g_value_set_enum (value, (int) (gint64) bits);
+      break;
+    case G_TYPE_FLAGS:
+      g_value_set_flags (value, (guint) bits);
+      break;
+    case G_TYPE_FLOAT:
+      memcpy (&d, &bits, sizeof (double));
+      g_value_set_float (value, (float) d);
+      break;
+    case G_TYPE_DOUBLE:
+      memcpy (&d, &bits, sizeof (double));
+      g_value_set_double (value, d);
+      break;
+    default:
+      g_value_unset (value);
+      break;
+    }
+}
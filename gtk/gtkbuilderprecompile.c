@@ -19,6 +19,7 @@
 #include "config.h"
 
 #include <gio/gio.h>
+#include <string.h>
 #include "gtkbuilderprivate.h"
 #include "gtkbuilder.h"
 #include "gtkbuildableprivate.h"
@@ -30,6 +31,7 @@ typedef enum
  RECORD_TYPE_ELEMENT,
  RECORD_TYPE_END_ELEMENT,
  RECORD_TYPE_TEXT,
+ RECORD_TYPE_VALUE,
 } RecordTreeType;
 
 typedef struct RecordDataTree RecordDataTree;
@@ -43,6 +45,9 @@ struct RecordDataTree {
   const char **attributes;
   const char **values;
   GList *children;
+  /* For RECORD_TYPE_VALUE */
+  GType fundamental;
+  guint64 bits;
 };
 
 typedef struct {
@@ -178,6 +183,174 @@ static const GMarkupParser record_parser =
   NULL, // error, fails immediately
 };
 
+/*****************************************  Resolve property values ***************************/
+
+static gboolean
+value_to_bits (const GValue *value,
+               guint64      *bits)
+{
+  double d;
+
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (value)))
+    {
+    case G_TYPE_BOOLEAN:
+      *bits = g_value_get_boolean (value) ? 1 : 0;
+      return TRUE;
+    case G_TYPE_INT:
+      *bits = (guint64) (gint64) g_value_get_int (value);
+      return TRUE;
+    case G_TYPE_UINT:
+      *bits = g_value_get_uint (value);
+      return TRUE;
+    case G_TYPE_LONG:
+      *bits = (guint64) (gint64) g_value_get_long (value);
+      return TRUE;
+    case G_TYPE_ULONG:
+      *bits = g_value_get_ulong (value);
+      return TRUE;
+    case G_TYPE_INT64:
+      *bits = (guint64) g_value_get_int64 (value);
+      return TRUE;
+    case G_TYPE_UINT64:
+      *bits = g_value_get_uint64 (value);
+      return TRUE;
+    case G_TYPE_ENUM:
+      *bits = (guint64) (gint64) g_value_get_enum (value);
+      return TRUE;
+    case G_TYPE_FLAGS:
+      *bits = g_value_get_flags (value);
+      return TRUE;
+    case G_TYPE_FLOAT:
+      d = g_value_get_float (value);
+      memcpy (bits, &d, sizeof (double));
+      return TRUE;
+    case G_TYPE_DOUBLE:
+      d = g_value_get_double (value);
+      memcpy (bits, &d, sizeof (double));
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+static void
+compile_property (GtkBuilder     *builder,
+                  RecordDataTree *tree,
+                  GObjectClass   *oclass)
+{
+  const char *name = NULL;
+  GString *text;
+  GParamSpec *pspec;
+  GValue value = G_VALUE_INIT;
+  RecordDataTree *child;
+  guint64 bits;
+  GList *l;
+  int i;
+
+  for (i = 0; i < tree->n_attributes; i++)
+    {
+      if (strcmp (tree->attributes[i], "name") == 0)
+        name = tree->values[i];
+      else if (strcmp (tree->attributes[i], "comments") != 0)
+        return; /* translatable, bindings, ... */
+    }
+
+  if (name == NULL)
+    return;
+
+  pspec = g_object_class_find_property (oclass, name);
+  if (pspec == NULL)
+    return;
+
+  text = g_string_new ("");
+  for (l = g_list_last (tree->children); l != NULL; l = l->prev)
+    {
+      child = l->data;
+
+      if (child->type != RECORD_TYPE_TEXT)
+        {
+          g_string_free (text, TRUE);
+          return;
+        }
+
+      g_string_append (text, child->data);
+    }
+
+  if (gtk_builder_value_from_string (builder, pspec, text->str, &value, NULL))
+    {
+      if (value_to_bits (&value, &bits))
+        {
+          child = record_data_tree_new (tree, RECORD_TYPE_VALUE, NULL);
+          child->fundamental = G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (&value));
+          child->bits = bits;
+        }
+
+      g_value_unset (&value);
+    }
+
+  g_string_free (text, TRUE);
+}
+
+static GType
+compile_object_type (GtkBuilder     *builder,
+                     RecordDataTree *tree)
+{
+  const char *class_name = NULL;
+  int i;
+
+  for (i = 0; i < tree->n_attributes; i++)
+    {
+      if (strcmp (tree->attributes[i], "class") == 0)
+        class_name = tree->values[i];
+      else if (strcmp (tree->attributes[i], "type-func") == 0)
+        return G_TYPE_INVALID;
+    }
+
+  if (class_name == NULL)
+    return G_TYPE_INVALID;
+
+  return gtk_builder_get_type_from_name (builder, class_name);
+}
+
+/* Converts the values of all <property> elements of <object> elements
+ * whose type we know. Properties of templates are left alone, since
+ * the template class is usually not available here.
+ */
+static void
+compile_tree (GtkBuilder     *builder,
+              RecordDataTree *tree,
+              GObjectClass   *oclass)
+{
+  GList *l;
+
+  for (l = tree->children; l != NULL; l = l->next)
+    {
+      RecordDataTree *child = l->data;
+
+      if (child->type != RECORD_TYPE_ELEMENT)
+        continue;
+
+      if (strcmp (child->data, "object") == 0)
+        {
+          GType type = compile_object_type (builder, child);
+
+          if (G_TYPE_IS_OBJECT (type))
+            {
+              GObjectClass *child_class = g_type_class_ref (type);
+              compile_tree (builder, child, child_class);
+              g_type_class_unref (child_class);
+              continue;
+            }
+        }
+      else if (oclass != NULL && strcmp (child->data, "property") == 0)
+        {
+          compile_property (builder, child, oclass);
+        }
+
+      compile_tree (builder, child, NULL);
+    }
+}
+
 static int
 compare_string (gconstpointer _a,
                 gconstpointer _b)
@@ -285,27 +458,23 @@ marshal_tree (GString *marshaled,
       marshal_uint32 (marshaled, RECORD_TYPE_TEXT);
       marshal_string (marshaled, strings, tree->data);
       break;
+    case RECORD_TYPE_VALUE:
+      marshal_uint32 (marshaled, RECORD_TYPE_VALUE);
+      marshal_uint32 (marshaled, tree->fundamental >> G_TYPE_FUNDAMENTAL_SHIFT);
+      marshal_uint32 (marshaled, tree->bits >> 32);
+      marshal_uint32 (marshaled, tree->bits & 0xffffffff);
+      break;
     case RECORD_TYPE_END_ELEMENT:
     default:
       g_assert_not_reached ();
     }
 }
 
-/**
- * _gtk_buildable_parser_precompile:
- * @text: chunk of text to parse
- * @text_len: length of @text in bytes
- *
- * Converts the xml format typically used by GtkBuilder to a
- * binary form that is more efficient to parse. This is a custom
- * format that is only supported by GtkBuilder.
- *
- * returns: A `GBytes` with the precompiled data
- **/
-GBytes *
-_gtk_buildable_parser_precompile (const char          *text,
-                                  gssize               text_len,
-                                  GError             **error)
+static GBytes *
+precompile (GtkBuilder  *builder,
+            const char  *text,
+            gssize       text_len,
+            GError     **error)
 {
   GMarkupParseContext *ctx;
   RecordData data = { 0 };
@@ -330,6 +499,9 @@ _gtk_buildable_parser_precompile (const char          *text,
 
   g_markup_parse_context_free (ctx);
 
+  if (builder)
+    compile_tree (builder, data.root, NULL);
+
   string_table = g_hash_table_get_values (data.strings);
 
   string_table = g_list_sort (string_table, compare_string);
@@ -343,8 +515,8 @@ _gtk_buildable_parser_precompile (const char          *text,
     }
 
   marshaled = g_string_new ("");
-  /* Magic marker */
-  g_string_append_len (marshaled, "GBU\0", 4);
+  /* Magic marker, the last byte tells if there are values */
+  g_string_append_len (marshaled, builder ? "GBU\1" : "GBU\0", 4);
   marshal_uint32 (marshaled, offset);
 
   for (l = string_table; l != NULL; l = l->next)
@@ -363,6 +535,53 @@ _gtk_buildable_parser_precompile (const char          *text,
   return g_string_free_to_bytes (marshaled);
 }
 
+/**
+ * _gtk_buildable_parser_precompile:
+ * @text: chunk of text to parse
+ * @text_len: length of @text in bytes
+ *
+ * Converts the xml format typically used by GtkBuilder to a
+ * binary form that is more efficient to parse. This is a custom
+ * format that is only supported by GtkBuilder.
+ *
+ * returns: A `GBytes` with the precompiled data
+ **/
+GBytes *
+_gtk_buildable_parser_precompile (const char          *text,
+                                  gssize               text_len,
+                                  GError             **error)
+{
+  return precompile (NULL, text, text_len, error);
+}
+
+/**
+ * _gtk_buildable_parser_compile:
+ * @builder: a `GtkBuilder` to resolve types and values with
+ * @text: chunk of text to parse
+ * @text_len: length of @text in bytes
+ *
+ * Like _gtk_buildable_parser_precompile(), but also stores
+ * the converted values of simple properties like numbers,
+ * booleans, enums and flags, so they don't need to be parsed
+ * from text for every instance.
+ *
+ * This is meant to be done ahead of time, with
+ * `gtk4-builder-tool compile`. The result is only valid for
+ * the GTK version that produced it.
+ *
+ * returns: A `GBytes` with the compiled data
+ **/
+GBytes *
+_gtk_buildable_parser_compile (GtkBuilder          *builder,
+                               const char          *text,
+                               gssize               text_len,
+                               GError             **error)
+{
+  g_return_val_if_fail (GTK_IS_BUILDER (builder), NULL);
+
+  return precompile (builder, text, text_len, error);
+}
+
 /*****************************************  Replay GMarkup parser callbacks ***************************/
 
 static guint32
@@ -504,6 +723,24 @@ replay_text (GtkBuildableParseContext *context,
   return TRUE;
 }
 
+static gboolean
+replay_value (GtkBuildableParseContext *context,
+              const char **tree,
+              const char *strings,
+              GError **error)
+{
+  GType fundamental;
+  guint64 bits;
+
+  fundamental = G_TYPE_MAKE_FUNDAMENTAL (demarshal_uint32 (tree));
+  bits = (guint64) demarshal_uint32 (tree) << 32;
+  bits |= demarshal_uint32 (tree);
+
+  _gtk_builder_parser_set_parsed_value (context, fundamental, bits);
+
+  return TRUE;
+}
+
 gboolean
 _gtk_buildable_parser_is_precompiled (const char           *data,
                                       gssize                data_len)
@@ -513,7 +750,7 @@ _gtk_buildable_parser_is_precompiled (const char           *data,
     data[0] == 'G' &&
     data[1] == 'B' &&
     data[2] == 'U' &&
-    data[3] == 0;
+    (data[3] == 0 || data[3] == 1);
 }
 
 gboolean
@@ -551,6 +788,9 @@ _gtk_buildable_parser_replay_precompiled (GtkBuildableParseContext *context,
         case RECORD_TYPE_TEXT:
           res = replay_text (context, &tree, strings, error);
           break;
+        case RECORD_TYPE_VALUE:
+          res = replay_value (context, &tree, strings, error);
+          break;
         default:
           g_assert_not_reached ();
         }
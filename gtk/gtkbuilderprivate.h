@@ -70,6 +70,7 @@ typedef struct {
   guint tag_type;
   GParamSpec *pspec;
   gpointer value;
+  GValue parsed; /* from compiled data, see _gtk_buildable_parser_compile() */
   GString *text;
   gboolean translatable:1;
   gboolean bound:1;
@@ -190,18 +191,32 @@ typedef struct {
   int object_counter;
 
   GHashTable *object_ids;
+
+  /* Recording an object with lazy="yes", see record_lazy_start() */
+  GString *lazy;
+  GPtrArray *lazy_ids;
+  int lazy_level;
 } ParserData;
 
 /* Things only GtkBuilder should use */
 GBytes * _gtk_buildable_parser_precompile (const char               *text,
                                            gssize                    text_len,
                                            GError                  **error);
+/* Exported for gtk4-builder-tool */
+GDK_AVAILABLE_IN_ALL
+GBytes * _gtk_buildable_parser_compile (GtkBuilder                  *builder,
+                                        const char                  *text,
+                                        gssize                       text_len,
+                                        GError                     **error);
 gboolean _gtk_buildable_parser_is_precompiled (const char           *data,
                                                gssize                data_len);
 gboolean _gtk_buildable_parser_replay_precompiled (GtkBuildableParseContext *context,
                                                    const char           *data,
                                                    gssize                data_len,
                                                    GError              **error);
+void _gtk_builder_parser_set_parsed_value (GtkBuildableParseContext *context,
+                                           GType                     fundamental,
+                                           guint64                   bits);
 void _gtk_builder_parser_parse_buffer (GtkBuilder *builder,
                                        const char *filename,
                                        const char *buffer,
@@ -262,6 +277,7 @@ void      _gtk_builder_menu_start (ParserData   *parser_data,
 void      _gtk_builder_menu_end   (ParserData  *parser_data);
 
 GType     _gtk_builder_get_template_type (GtkBuilder *builder);
+GHashTable *_gtk_builder_get_named_objects (GtkBuilder *builder);
 
 void     _gtk_builder_prefix_error        (GtkBuilder                *builder,
                                            GtkBuildableParseContext  *context,
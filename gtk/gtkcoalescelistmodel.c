@@ -0,0 +1,478 @@
+/*
+ * Copyright © 2021 The GTK Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkcoalescelistmodel.h"
+
+#include "gtkbitset.h"
+#include "gtkintl.h"
+#include "gtkprivate.h"
+
+#include <string.h>
+
+/**
+ * GtkCoalesceListModel:
+ *
+ * `GtkCoalesceListModel` is a list model that merges the changes of
+ * another model.
+ *
+ * Every time the wrapped model emits [signal@Gio.ListModel::items-changed],
+ * the change is recorded instead of being forwarded. Once per main loop
+ * iteration, right before the frame clock runs, all recorded changes are
+ * merged into a single emission of [signal@Gio.ListModel::items-changed].
+ *
+ * This is useful when a model that delivers its items in many small
+ * batches, like `GtkDirectoryList`, is wrapped by expensive models like
+ * `GtkSortListModel` or `GtkFilterListModel`, which otherwise have to
+ * react to every single batch.
+ *
+ * Until the changes have been merged, the `GtkCoalesceListModel` keeps
+ * presenting the items as they were before the changes. To do this it
+ * holds a reference to every item of the wrapped model.
+ *
+ * Since: 4.4
+ */
+
+/* Run before GTK_PRIORITY_RESIZE and GDK_PRIORITY_REDRAW, so that
+ * the merged change is handled in the same frame it arrived in.
+ */
+#define GTK_COALESCE_LIST_MODEL_PRIORITY (G_PRIORITY_HIGH_IDLE + 5)
+
+enum {
+  PROP_0,
+  PROP_MODEL,
+  PROP_PENDING,
+  NUM_PROPERTIES
+};
+
+struct _GtkCoalesceListModel
+{
+  GObject parent_instance;
+
+  GListModel *model;
+
+  /* the items as presented to our users */
+  GPtrArray *items;
+  /* positions in @model that differ from @items */
+  GtkBitset *dirty;
+  guint flush_cb;
+};
+
+struct _GtkCoalesceListModelClass
+{
+  GObjectClass parent_class;
+};
+
+static GParamSpec *properties[NUM_PROPERTIES] = { NULL, };
+
+static GType
+gtk_coalesce_list_model_get_item_type (GListModel *list)
+{
+  return G_TYPE_OBJECT;
+}
+
+static guint
+gtk_coalesce_list_model_get_n_items (GListModel *list)
+{
+  GtkCoalesceListModel *self = GTK_COALESCE_LIST_MODEL (list);
+
+  return self->items->len;
+}
+
+static gpointer
+gtk_coalesce_list_model_get_item (GListModel *list,
+                                  guint       position)
+{
+  GtkCoalesceListModel *self = GTK_COALESCE_LIST_MODEL (list);
+
+  if (position >= self->items->len)
+    return NULL;
+
+  return g_object_ref (g_ptr_array_index (self->items, position));
+}
+
+static void
+gtk_coalesce_list_model_model_init (GListModelInterface *iface)
+{
+  iface->get_item_type = gtk_coalesce_list_model_get_item_type;
+  iface->get_n_items = gtk_coalesce_list_model_get_n_items;
+  iface->get_item = gtk_coalesce_list_model_get_item;
+}
+
+G_DEFINE_TYPE_WITH_CODE (GtkCoalesceListModel, gtk_coalesce_list_model, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, gtk_coalesce_list_model_model_init))
+
+/* Replaces @removed items at @position in our cache with
+ * @added items from the model.
+ */
+static void
+gtk_coalesce_list_model_splice_items (GtkCoalesceListModel *self,
+                                      guint                 position,
+                                      guint                 removed,
+                                      guint                 added)
+{
+  guint i, n_after;
+
+  if (removed > 0)
+    g_ptr_array_remove_range (self->items, position, removed);
+
+  if (added == 0)
+    return;
+
+  n_after = self->items->len - position;
+  g_ptr_array_set_size (self->items, self->items->len + added);
+  memmove (&self->items->pdata[position + added],
+           &self->items->pdata[position],
+           n_after * sizeof (gpointer));
+
+  for (i = 0; i < added; i++)
+    self->items->pdata[position + i] = g_list_model_get_item (self->model, position + i);
+}
+
+static gboolean
+gtk_coalesce_list_model_flush_cb (gpointer data)
+{
+  GtkCoalesceListModel *self = data;
+
+  self->flush_cb = 0;
+  gtk_coalesce_list_model_flush (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtk_coalesce_list_model_items_changed_cb (GListModel           *model,
+                                          guint                 position,
+                                          guint                 removed,
+                                          guint                 added,
+                                          GtkCoalesceListModel *self)
+{
+  gtk_bitset_splice (self->dirty, position, removed, added);
+  /* For pure removals, mark the seam so the merged change covers it. */
+  if (added > 0)
+    gtk_bitset_add_range (self->dirty, position, added);
+  else
+    gtk_bitset_add (self->dirty, position);
+
+  if (self->flush_cb != 0)
+    return;
+
+  self->flush_cb = g_idle_add_full (GTK_COALESCE_LIST_MODEL_PRIORITY,
+                                    gtk_coalesce_list_model_flush_cb,
+                                    self,
+                                    NULL);
+  g_source_set_name_by_id (self->flush_cb, "[gtk] gtk_coalesce_list_model_flush_cb");
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+}
+
+static void
+gtk_coalesce_list_model_set_property (GObject      *object,
+                                      guint         prop_id,
+                                      const GValue *value,
+                                      GParamSpec   *pspec)
+{
+  GtkCoalesceListModel *self = GTK_COALESCE_LIST_MODEL (object);
+
+  switch (prop_id)
+    {
+    case PROP_MODEL:
+      gtk_coalesce_list_model_set_model (self, g_value_get_object (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+gtk_coalesce_list_model_get_property (GObject     *object,
+                                      guint        prop_id,
+                                      GValue      *value,
+                                      GParamSpec  *pspec)
+{
+  GtkCoalesceListModel *self = GTK_COALESCE_LIST_MODEL (object);
+
+  switch (prop_id)
+    {
+    case PROP_MODEL:
+      g_value_set_object (value, self->model);
+      break;
+
+    case PROP_PENDING:
+      g_value_set_boolean (value, gtk_coalesce_list_model_get_pending (self));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+gtk_coalesce_list_model_clear_model (GtkCoalesceListModel *self)
+{
+  g_clear_handle_id (&self->flush_cb, g_source_remove);
+  gtk_bitset_remove_all (self->dirty);
+
+  if (self->model == NULL)
+    return;
+
+  g_signal_handlers_disconnect_by_func (self->model, gtk_coalesce_list_model_items_changed_cb, self);
+  g_clear_object (&self->model);
+}
+
+static void
+gtk_coalesce_list_model_dispose (GObject *object)
+{
+  GtkCoalesceListModel *self = GTK_COALESCE_LIST_MODEL (object);
+
+  gtk_coalesce_list_model_clear_model (self);
+  g_ptr_array_set_size (self->items, 0);
+
+  G_OBJECT_CLASS (gtk_coalesce_list_model_parent_class)->dispose (object);
+}
+
+static void
+gtk_coalesce_list_model_finalize (GObject *object)
+{
+  GtkCoalesceListModel *self = GTK_COALESCE_LIST_MODEL (object);
+
+  g_ptr_array_unref (self->items);
+  gtk_bitset_unref (self->dirty);
+
+  G_OBJECT_CLASS (gtk_coalesce_list_model_parent_class)->finalize (object);
+}
+
+static void
+gtk_coalesce_list_model_class_init (GtkCoalesceListModelClass *class)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+
+  gobject_class->set_property = gtk_coalesce_list_model_set_property;
+  gobject_class->get_property = gtk_coalesce_list_model_get_property;
+  gobject_class->dispose = gtk_coalesce_list_model_dispose;
+  gobject_class->finalize = gtk_coalesce_list_model_finalize;
+
+  /**
+   * GtkCoalesceListModel:model: (attributes org.gtk.Property.get=gtk_coalesce_list_model_get_model org.gtk.Property.set=gtk_coalesce_list_model_set_model)
+   *
+   * Child model to merge changes of.
+   *
+   * Since: 4.4
+   */
+  properties[PROP_MODEL] =
+      g_param_spec_object ("model",
+                           P_("Model"),
+                           P_("Child model to merge changes of"),
+                           G_TYPE_LIST_MODEL,
+                           GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
+  /**
+   * GtkCoalesceListModel:pending: (attributes org.gtk.Property.get=gtk_coalesce_list_model_get_pending)
+   *
+   * If changes of the child model have not been merged yet.
+   *
+   * Since: 4.4
+   */
+  properties[PROP_PENDING] =
+      g_param_spec_boolean ("pending",
+                            P_("Pending"),
+                            P_("If changes have not been merged yet"),
+                            FALSE,
+                            GTK_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY);
+
+  g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
+}
+
+static void
+gtk_coalesce_list_model_init (GtkCoalesceListModel *self)
+{
+  self->items = g_ptr_array_new_with_free_func (g_object_unref);
+  self->dirty = gtk_bitset_new_empty ();
+}
+
+/**
+ * gtk_coalesce_list_model_new:
+ * @model: (transfer full) (nullable): The model to use
+ *
+ * Creates a new model that merges the changes of @model.
+ *
+ * Returns: A new `GtkCoalesceListModel`
+ *
+ * Since: 4.4
+ */
+GtkCoalesceListModel *
+gtk_coalesce_list_model_new (GListModel *model)
+{
+  GtkCoalesceListModel *self;
+
+  g_return_val_if_fail (model == NULL || G_IS_LIST_MODEL (model), NULL);
+
+  self = g_object_new (GTK_TYPE_COALESCE_LIST_MODEL,
+                       "model", model,
+                       NULL);
+
+  /* consume the reference */
+  g_clear_object (&model);
+
+  return self;
+}
+
+/**
+ * gtk_coalesce_list_model_set_model: (attributes org.gtk.Method.set_property=model)
+ * @self: a `GtkCoalesceListModel`
+ * @model: (nullable): The model to merge changes of
+ *
+ * Sets the model to merge changes of.
+ *
+ * Changes of a previously set model that have not been merged
+ * yet are discarded.
+ *
+ * Since: 4.4
+ */
+void
+gtk_coalesce_list_model_set_model (GtkCoalesceListModel *self,
+                                   GListModel           *model)
+{
+  gboolean was_pending;
+  guint removed, added;
+
+  g_return_if_fail (GTK_IS_COALESCE_LIST_MODEL (self));
+  g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
+
+  if (self->model == model)
+    return;
+
+  was_pending = gtk_coalesce_list_model_get_pending (self);
+  removed = self->items->len;
+  gtk_coalesce_list_model_clear_model (self);
+  g_ptr_array_set_size (self->items, 0);
+
+  if (model)
+    {
+      self->model = g_object_ref (model);
+      g_signal_connect (model, "items-changed", G_CALLBACK (gtk_coalesce_list_model_items_changed_cb), self);
+      added = g_list_model_get_n_items (model);
+      gtk_coalesce_list_model_splice_items (self, 0, 0, added);
+    }
+  else
+    {
+      added = 0;
+    }
+
+  if (removed > 0 || added > 0)
+    g_list_model_items_changed (G_LIST_MODEL (self), 0, removed, added);
+
+  g_object_freeze_notify (G_OBJECT (self));
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MODEL]);
+  if (was_pending)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+  g_object_thaw_notify (G_OBJECT (self));
+}
+
+/**
+ * gtk_coalesce_list_model_get_model: (attributes org.gtk.Method.get_property=model)
+ * @self: a `GtkCoalesceListModel`
+ *
+ * Gets the model that is currently being used or %NULL if none.
+ *
+ * Returns: (nullable) (transfer none): The model in use
+ *
+ * Since: 4.4
+ */
+GListModel *
+gtk_coalesce_list_model_get_model (GtkCoalesceListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_COALESCE_LIST_MODEL (self), NULL);
+
+  return self->model;
+}
+
+/**
+ * gtk_coalesce_list_model_get_pending: (attributes org.gtk.Method.get_property=pending)
+ * @self: a `GtkCoalesceListModel`
+ *
+ * Checks if @self has changes of its model that have not been
+ * merged yet.
+ *
+ * Returns: %TRUE if changes are pending
+ *
+ * Since: 4.4
+ */
+gboolean
+gtk_coalesce_list_model_get_pending (GtkCoalesceListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_COALESCE_LIST_MODEL (self), FALSE);
+
+  return !gtk_bitset_is_empty (self->dirty);
+}
+
+/**
+ * gtk_coalesce_list_model_flush:
+ * @self: a `GtkCoalesceListModel`
+ *
+ * Merges all pending changes immediately instead of waiting
+ * for the main loop.
+ *
+ * If there are pending changes, this emits
+ * [signal@Gio.ListModel::items-changed] once.
+ *
+ * Since: 4.4
+ */
+void
+gtk_coalesce_list_model_flush (GtkCoalesceListModel *self)
+{
+  guint first, last, n_items, suffix, removed, added;
+
+  g_return_if_fail (GTK_IS_COALESCE_LIST_MODEL (self));
+
+  g_clear_handle_id (&self->flush_cb, g_source_remove);
+
+  if (gtk_bitset_is_empty (self->dirty))
+    return;
+
+  /* Every change marks its position, and positions are moved along
+   * with later changes. So everything before the first dirty position
+   * is an unchanged prefix and everything after the last one is an
+   * unchanged suffix of our cached items.
+   */
+  first = gtk_bitset_get_minimum (self->dirty);
+  last = gtk_bitset_get_maximum (self->dirty);
+  gtk_bitset_remove_all (self->dirty);
+
+  n_items = g_list_model_get_n_items (self->model);
+  if (last < n_items)
+    suffix = n_items - last - 1;
+  else
+    suffix = 0;
+
+  g_assert (first + suffix <= n_items);
+  g_assert (first + suffix <= self->items->len);
+
+  removed = self->items->len - first - suffix;
+  added = n_items - first - suffix;
+
+  gtk_coalesce_list_model_splice_items (self, first, removed, added);
+
+  if (removed > 0 || added > 0)
+    g_list_model_items_changed (G_LIST_MODEL (self), first, removed, added);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+}
@@ -72,6 +72,10 @@ struct _GtkEntryBufferPrivate
   gsize  normal_text_bytes;
   guint  normal_text_chars;
 
+  /* Last character offset we converted to a byte offset */
+  guint  cached_char;
+  gsize  cached_byte;
+
   int    max_length;
 };
 
@@ -95,6 +99,52 @@ trash_area (char *area,
     *varea++ = 0;
 }
 
+/* Converting a character offset to a byte offset is linear in the
+ * length of the text, which makes typing into long texts quadratic.
+ * Edits tend to happen close to each other, so we start from the
+ * last converted offset, or from either end of the text if that is
+ * closer.
+ */
+static gsize
+gtk_entry_buffer_normal_offset_to_byte (GtkEntryBufferPrivate *pv,
+                                        guint                  offset)
+{
+  const char *text = pv->normal_text;
+  const char *p;
+
+  if (offset == 0)
+    return 0;
+
+  if (offset >= pv->normal_text_chars)
+    return pv->normal_text_bytes;
+
+  /* All ASCII */
+  if (pv->normal_text_chars == pv->normal_text_bytes)
+    return offset;
+
+  if (offset >= pv->cached_char)
+    {
+      if (offset - pv->cached_char <= pv->normal_text_chars - offset)
+        p = g_utf8_offset_to_pointer (text + pv->cached_byte, offset - pv->cached_char);
+      else
+        p = g_utf8_offset_to_pointer (text + pv->normal_text_bytes,
+                                      - (glong) (pv->normal_text_chars - offset));
+    }
+  else
+    {
+      if (offset <= pv->cached_char - offset)
+        p = g_utf8_offset_to_pointer (text, offset);
+      else
+        p = g_utf8_offset_to_pointer (text + pv->cached_byte,
+                                      - (glong) (pv->cached_char - offset));
+    }
+
+  pv->cached_char = offset;
+  pv->cached_byte = p - text;
+
+  return pv->cached_byte;
+}
+
 static const char *
 gtk_entry_buffer_normal_get_text (GtkEntryBuffer *buffer,
                                   gsize          *n_bytes)
@@ -170,7 +220,7 @@ gtk_entry_buffer_normal_insert_text (GtkEntryBuffer *buffer,
     }
 
   /* Actual text insertion */
-  at = g_utf8_offset_to_pointer (pv->normal_text, position) - pv->normal_text;
+  at = gtk_entry_buffer_normal_offset_to_byte (pv, position);
   memmove (pv->normal_text + at + n_bytes, pv->normal_text + at, pv->normal_text_bytes - at);
   memcpy (pv->normal_text + at, chars, n_bytes);
 
@@ -179,6 +229,10 @@ gtk_entry_buffer_normal_insert_text (GtkEntryBuffer *buffer,
   pv->normal_text_chars += n_chars;
   pv->normal_text[pv->normal_text_bytes] = '\0';
 
+  /* The next insertion is likely right after this one */
+  pv->cached_char = position + n_chars;
+  pv->cached_byte = at + n_bytes;
+
   gtk_entry_buffer_emit_inserted_text (buffer, position, chars, n_chars);
   return n_chars;
 }
@@ -223,12 +277,14 @@ gtk_entry_buffer_real_deleted_text (GtkEntryBuffer *buffer,
   GtkEntryBufferPrivate *pv = gtk_entry_buffer_get_instance_private (buffer);
   gsize start, end;
 
-  start = g_utf8_offset_to_pointer (pv->normal_text, position) - pv->normal_text;
-  end = g_utf8_offset_to_pointer (pv->normal_text, position + n_chars) - pv->normal_text;
+  start = gtk_entry_buffer_normal_offset_to_byte (pv, position);
+  end = gtk_entry_buffer_normal_offset_to_byte (pv, position + n_chars);
 
   memmove (pv->normal_text + start, pv->normal_text + end, pv->normal_text_bytes + 1 - end);
   pv->normal_text_chars -= n_chars;
   pv->normal_text_bytes -= (end - start);
+  pv->cached_char = position;
+  pv->cached_byte = start;
 
   /*
    * Could be a password, make sure we don't leave anything sensitive after
@@ -254,6 +310,8 @@ gtk_entry_buffer_init (GtkEntryBuffer *buffer)
   pv->normal_text_chars = 0;
   pv->normal_text_bytes = 0;
   pv->normal_text_size = 0;
+  pv->cached_char = 0;
+  pv->cached_byte = 0;
 }
 
 static void
@@ -269,6 +327,8 @@ gtk_entry_buffer_finalize (GObject *obj)
       pv->normal_text = NULL;
       pv->normal_text_bytes = pv->normal_text_size = 0;
       pv->normal_text_chars = 0;
+      pv->cached_char = 0;
+      pv->cached_byte = 0;
     }
 
   G_OBJECT_CLASS (gtk_entry_buffer_parent_class)->finalize (obj);
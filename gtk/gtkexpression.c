@@ -230,6 +230,7 @@ struct _GtkExpressionWatch
   GDestroyNotify         user_destroy;
   GtkExpressionNotify    notify;
   gpointer               user_data;
+  guint                  pending : 1;
   guchar                 sub[0];
 };
 
@@ -237,6 +238,102 @@ G_DEFINE_BOXED_TYPE (GtkExpressionWatch, gtk_expression_watch,
                      gtk_expression_watch_ref,
                      gtk_expression_watch_unref)
 
+/* While a property notification is dispatched, watches only get
+ * queued. They are notified once the outermost dispatch is done,
+ * so a watch that depends on the changed property multiple times
+ * only gets notified (and re-evaluated) once. Property changes
+ * caused by those notifications are batched the same way.
+ *
+ * The batch follows the call stack of the notification, so it is
+ * kept per thread. Objects that are used from another thread than
+ * the main thread get their own batches there.
+ */
+typedef struct {
+  guint depth;
+  GPtrArray *pending;
+} WatchBatch;
+
+static GPrivate watch_batch_key = G_PRIVATE_INIT (g_free);
+
+static WatchBatch *
+gtk_expression_watch_get_batch (void)
+{
+  WatchBatch *batch = g_private_get (&watch_batch_key);
+
+  if (G_UNLIKELY (batch == NULL))
+    {
+      batch = g_new0 (WatchBatch, 1);
+      g_private_set (&watch_batch_key, batch);
+    }
+
+  return batch;
+}
+
+static void
+gtk_expression_watch_begin_batch (void)
+{
+  gtk_expression_watch_get_batch ()->depth++;
+}
+
+static void
+gtk_expression_watch_end_batch (void)
+{
+  WatchBatch *batch = gtk_expression_watch_get_batch ();
+
+  g_assert (batch->depth > 0);
+
+  if (batch->depth > 1)
+    {
+      batch->depth--;
+      return;
+    }
+
+  /* Keep batching while notifying, so that changes caused by the
+   * notifications get collected into the next round.
+   */
+  while (batch->pending && batch->pending->len > 0)
+    {
+      GPtrArray *pending = batch->pending;
+      guint i;
+
+      batch->pending = NULL;
+
+      for (i = 0; i < pending->len; i++)
+        {
+          GtkExpressionWatch *watch = g_ptr_array_index (pending, i);
+
+          watch->pending = FALSE;
+          if (watch->expression)
+            watch->notify (watch->user_data);
+        }
+
+      g_ptr_array_unref (pending);
+    }
+
+  batch->depth--;
+}
+
+/* Returns TRUE if @watch was queued, FALSE if no batch is running */
+static gboolean
+gtk_expression_watch_queue (GtkExpressionWatch *watch)
+{
+  WatchBatch *batch = g_private_get (&watch_batch_key);
+
+  if (batch == NULL || batch->depth == 0)
+    return FALSE;
+
+  if (watch->pending)
+    return TRUE;
+
+  if (batch->pending == NULL)
+    batch->pending = g_ptr_array_new_with_free_func ((GDestroyNotify) gtk_expression_watch_unref);
+
+  watch->pending = TRUE;
+  g_ptr_array_add (batch->pending, gtk_expression_watch_ref (watch));
+
+  return TRUE;
+}
+
 #define GTK_EXPRESSION_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_TYPE_EXPRESSION, GtkExpressionClass))
 
 /*< private >
@@ -1145,6 +1242,7 @@ gtk_property_expression_evaluate (GtkExpression *expr,
 }
 
 typedef struct _GtkPropertyExpressionWatch GtkPropertyExpressionWatch;
+typedef struct _GtkPropertyExpressionWatchers GtkPropertyExpressionWatchers;
 
 struct _GtkPropertyExpressionWatch
 {
@@ -1153,47 +1251,199 @@ struct _GtkPropertyExpressionWatch
 
   GtkPropertyExpression *expr;
   gpointer               this;
-  GClosure              *closure;
+  GtkPropertyExpressionWatchers *watchers;
   guchar                 sub[0];
 };
 
+/* All property watches for the same property on the same object
+ * share one notify handler. Rows in list views tend to bind many
+ * expressions to the same item, so this saves lots of handlers.
+ */
+struct _GtkPropertyExpressionWatchers
+{
+  GObject               *object; /* NULL once object is finalized */
+  GQuark                 detail;
+  gulong                 notify_id;
+  GPtrArray             *watches;
+  guint                  n_watches;
+  guint                  dispatching;
+};
+
+static GQuark watchers_quark;
+
 static void
-gtk_property_expression_watch_destroy_closure (GtkPropertyExpressionWatch *pwatch)
+gtk_property_expression_watchers_list_free (gpointer data)
 {
-  if (pwatch->closure == NULL)
-    return;
+  GSList *l;
 
-  g_closure_invalidate (pwatch->closure);
-  g_closure_unref (pwatch->closure);
-  pwatch->closure = NULL;
+  for (l = data; l; l = l->next)
+    {
+      GtkPropertyExpressionWatchers *watchers = l->data;
+
+      /* watches still exist, they'll free this when they go away */
+      watchers->object = NULL;
+      watchers->notify_id = 0;
+    }
+
+  g_slist_free (data);
 }
 
 static void
-gtk_property_expression_watch_notify_cb (GObject                    *object,
-                                         GParamSpec                 *pspec,
-                                         GtkPropertyExpressionWatch *pwatch)
+gtk_property_expression_watchers_free (GtkPropertyExpressionWatchers *watchers)
 {
-  pwatch->notify (pwatch->user_data);
+  if (watchers->object)
+    {
+      GSList *list;
+
+      if (g_signal_handler_is_connected (watchers->object, watchers->notify_id))
+        g_signal_handler_disconnect (watchers->object, watchers->notify_id);
+
+      list = g_object_steal_qdata (watchers->object, watchers_quark);
+      list = g_slist_remove (list, watchers);
+      if (list)
+        g_object_set_qdata_full (watchers->object, watchers_quark, list, gtk_property_expression_watchers_list_free);
+    }
+
+  g_ptr_array_unref (watchers->watches);
+  g_slice_free (GtkPropertyExpressionWatchers, watchers);
 }
 
+/* Drops the slots of watches that were removed while dispatching */
 static void
-gtk_property_expression_watch_create_closure (GtkPropertyExpressionWatch *pwatch)
+gtk_property_expression_watchers_compact (GtkPropertyExpressionWatchers *watchers)
 {
+  guint i, j;
+
+  for (i = 0, j = 0; i < watchers->watches->len; i++)
+    {
+      gpointer pwatch = g_ptr_array_index (watchers->watches, i);
+
+      if (pwatch)
+        g_ptr_array_index (watchers->watches, j++) = pwatch;
+    }
+  g_ptr_array_set_size (watchers->watches, j);
+}
+
+static void
+gtk_property_expression_watchers_notify_cb (GObject                       *object,
+                                            GParamSpec                    *pspec,
+                                            GtkPropertyExpressionWatchers *watchers)
+{
+  guint i, n;
+
+  gtk_expression_watch_begin_batch ();
+  watchers->dispatching++;
+
+  /* watches added while dispatching are not notified */
+  n = watchers->watches->len;
+  for (i = 0; i < n; i++)
+    {
+      GtkPropertyExpressionWatch *pwatch = g_ptr_array_index (watchers->watches, i);
+
+      if (pwatch)
+        pwatch->notify (pwatch->user_data);
+    }
+
+  watchers->dispatching--;
+  if (watchers->dispatching == 0)
+    {
+      if (watchers->n_watches == 0)
+        gtk_property_expression_watchers_free (watchers);
+      else if (watchers->n_watches < watchers->watches->len)
+        gtk_property_expression_watchers_compact (watchers);
+    }
+
+  gtk_expression_watch_end_batch ();
+}
+
+static GtkPropertyExpressionWatchers *
+gtk_property_expression_watchers_lookup (GObject    *object,
+                                         GParamSpec *pspec)
+{
+  GtkPropertyExpressionWatchers *watchers;
+  GQuark detail;
+  GSList *list, *l;
+
+  if (G_UNLIKELY (watchers_quark == 0))
+    watchers_quark = g_quark_from_static_string ("gtk-expression-property-watchers");
+
+  detail = g_quark_from_string (pspec->name);
+  list = g_object_get_qdata (object, watchers_quark);
+  for (l = list; l; l = l->next)
+    {
+      watchers = l->data;
+      if (watchers->detail == detail)
+        break;
+    }
+
+  if (l == NULL)
+    {
+      watchers = g_slice_new0 (GtkPropertyExpressionWatchers);
+      watchers->object = object;
+      watchers->detail = detail;
+      watchers->watches = g_ptr_array_new ();
+
+      list = g_object_steal_qdata (object, watchers_quark);
+      list = g_slist_prepend (list, watchers);
+      g_object_set_qdata_full (object, watchers_quark, list, gtk_property_expression_watchers_list_free);
+    }
+  else if (g_signal_handler_is_connected (object, watchers->notify_id))
+    {
+      return watchers;
+    }
+
+  /* New watchers, or the handler got destroyed when the object was disposed */
+  watchers->notify_id = g_signal_connect_closure_by_id (object,
+                                                        g_signal_lookup ("notify", G_OBJECT_TYPE (object)),
+                                                        detail,
+                                                        g_cclosure_new (G_CALLBACK (gtk_property_expression_watchers_notify_cb), watchers, NULL),
+                                                        FALSE);
+  if (watchers->notify_id == 0)
+    g_assert_not_reached ();
+
+  return watchers;
+}
+
+static void
+gtk_property_expression_watch_detach (GtkPropertyExpressionWatch *pwatch)
+{
+  GtkPropertyExpressionWatchers *watchers = pwatch->watchers;
+
+  if (watchers == NULL)
+    return;
+
+  pwatch->watchers = NULL;
+  watchers->n_watches--;
+
+  if (watchers->dispatching)
+    {
+      guint i;
+
+      if (g_ptr_array_find (watchers->watches, pwatch, &i))
+        g_ptr_array_index (watchers->watches, i) = NULL;
+    }
+  else
+    {
+      g_ptr_array_remove (watchers->watches, pwatch);
+      if (watchers->n_watches == 0)
+        gtk_property_expression_watchers_free (watchers);
+    }
+}
+
+static void
+gtk_property_expression_watch_attach (GtkPropertyExpressionWatch *pwatch)
+{
+  GtkPropertyExpressionWatchers *watchers;
   GObject *object;
 
   object = gtk_property_expression_get_object (pwatch->expr, pwatch->this);
   if (object == NULL)
     return;
 
-  pwatch->closure = g_cclosure_new (G_CALLBACK (gtk_property_expression_watch_notify_cb), pwatch, NULL);
-  if (!g_signal_connect_closure_by_id (object,
-                                       g_signal_lookup ("notify", G_OBJECT_TYPE (object)),
-                                       g_quark_from_string (pwatch->expr->pspec->name),
-                                       g_closure_ref (pwatch->closure),
-                                       FALSE))
-    {
-      g_assert_not_reached ();
-    }
+  watchers = gtk_property_expression_watchers_lookup (object, pwatch->expr->pspec);
+  g_ptr_array_add (watchers->watches, pwatch);
+  watchers->n_watches++;
+  pwatch->watchers = watchers;
 
   g_object_unref (object);
 }
@@ -1203,8 +1453,8 @@ gtk_property_expression_watch_expr_notify_cb (gpointer data)
 {
   GtkPropertyExpressionWatch *pwatch = data;
 
-  gtk_property_expression_watch_destroy_closure (pwatch);
-  gtk_property_expression_watch_create_closure (pwatch);
+  gtk_property_expression_watch_detach (pwatch);
+  gtk_property_expression_watch_attach (pwatch);
   pwatch->notify (pwatch->user_data);
 }
 
@@ -1235,6 +1485,7 @@ gtk_property_expression_watch (GtkExpression         *expr,
   pwatch->user_data = user_data;
   pwatch->expr = self;
   pwatch->this = this_;
+  pwatch->watchers = NULL;
   if (self->expr && !gtk_expression_is_static (self->expr))
     {
       gtk_expression_subwatch_init (self->expr,
@@ -1244,7 +1495,7 @@ gtk_property_expression_watch (GtkExpression         *expr,
                                     pwatch);
     }
 
-  gtk_property_expression_watch_create_closure (pwatch);
+  gtk_property_expression_watch_attach (pwatch);
 }
 
 static void
@@ -1254,7 +1505,7 @@ gtk_property_expression_unwatch (GtkExpression         *expr,
   GtkPropertyExpressionWatch *pwatch = (GtkPropertyExpressionWatch *) watch;
   GtkPropertyExpression *self = (GtkPropertyExpression *) expr;
 
-  gtk_property_expression_watch_destroy_closure (pwatch);
+  gtk_property_expression_watch_detach (pwatch);
 
   if (self->expr && !gtk_expression_is_static (self->expr))
     gtk_expression_subwatch_finish (self->expr, (GtkExpressionSubWatch *) pwatch->sub);
@@ -1864,7 +2115,8 @@ gtk_expression_watch_cb (gpointer data)
   if (!gtk_expression_watch_is_watching (watch))
     return;
 
-  watch->notify (watch->user_data);
+  if (!gtk_expression_watch_queue (watch))
+    watch->notify (watch->user_data);
 }
 
 /**
@@ -0,0 +1,275 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2021 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkicontexturecacheprivate.h"
+
+#include "gtkdebug.h"
+#include "gtkversion.h"
+
+#include <string.h>
+#include <glib/gstdio.h>
+
+/* A per-user cache of rasterized SVG icons.
+ *
+ * Rendering SVGs, and symbolic ones in particular, is by far the most
+ * expensive part of loading icons, and every application does it again
+ * for the same few hundred icons at startup. So we keep the pixels in
+ * $XDG_CACHE_HOME/gtk-4.0/icon-textures, one file per icon, and map them
+ * straight into textures.
+ *
+ * Files are named after a hash of the icon file, the size, the scale
+ * and whether it is rendered as symbolic. They are only used if the
+ * icon file still has the size, inode and modification and change
+ * times (with nanoseconds, where available) that are recorded in them,
+ * and if they were written by the same version of GTK. Otherwise they
+ * are overwritten once the icon has been rendered again, so the cache
+ * does not grow beyond one file per icon and size.
+ */
+
+#define CACHE_MAGIC "GtkIcT2"
+
+typedef struct {
+  guint64 mtime;
+  guint64 ctime;
+  guint64 inode;
+  guint64 size;
+  guint32 mtime_nsec;
+  guint32 ctime_nsec;
+} IconFileInfo;
+
+G_STATIC_ASSERT (sizeof (IconFileInfo) == 40);
+
+typedef struct {
+  char magic[8];
+  guint32 gtk_version;
+  guint32 width;
+  guint32 height;
+  guint32 stride;
+  guint32 has_alpha;
+  guint32 padding;
+  IconFileInfo file;
+} CacheHeader;
+
+G_STATIC_ASSERT (sizeof (CacheHeader) == 72);
+
+#define GTK_VERSION_NUMBER ((GTK_MAJOR_VERSION << 16) | (GTK_MINOR_VERSION << 8) | GTK_MICRO_VERSION)
+
+static const char *
+get_cache_dir (void)
+{
+  static char *cache_dir = NULL;
+
+  if (g_once_init_enter (&cache_dir))
+    {
+      char *dir = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "icon-textures", NULL);
+
+      g_once_init_leave (&cache_dir, dir);
+    }
+
+  return cache_dir;
+}
+
+static char *
+get_cache_path (const char *filename,
+                int         pixel_size,
+                int         scale,
+                gboolean    symbolic)
+{
+  char *key, *checksum, *path;
+
+  key = g_strdup_printf ("%s\n%d\n%d\n%d", filename, pixel_size, scale, symbolic);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, key, -1);
+  path = g_build_filename (get_cache_dir (), checksum, NULL);
+
+  g_free (checksum);
+  g_free (key);
+
+  return path;
+}
+
+static gboolean
+stat_icon_file (const char   *filename,
+                IconFileInfo *info)
+{
+  GStatBuf st;
+
+  if (g_stat (filename, &st) != 0)
+    return FALSE;
+
+  memset (info, 0, sizeof (IconFileInfo));
+  info->mtime = st.st_mtime;
+  info->ctime = st.st_ctime;
+  info->inode = st.st_ino;
+  info->size = st.st_size;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+  info->mtime_nsec = st.st_mtim.tv_nsec;
+  info->ctime_nsec = st.st_ctim.tv_nsec;
+#endif
+
+  return TRUE;
+}
+
+/*
+ * gtk_icon_texture_cache_lookup:
+ * @filename: the path of the icon file
+ * @pixel_size: the size the icon is rendered at, in device pixels
+ * @scale: the scale the icon is rendered for
+ * @symbolic: whether the icon is rendered as symbolic icon
+ *
+ * Looks for an up-to-date rendering of the icon that was
+ * stored with gtk_icon_texture_cache_store().
+ *
+ * The returned texture uses the memory of the cache file
+ * directly.
+ *
+ * Returns: (transfer full) (nullable): the texture
+ */
+GdkTexture *
+gtk_icon_texture_cache_lookup (const char *filename,
+                               int         pixel_size,
+                               int         scale,
+                               gboolean    symbolic)
+{
+  CacheHeader header;
+  GMappedFile *map;
+  GBytes *bytes, *pixels;
+  GdkTexture *texture;
+  IconFileInfo info;
+  char *path;
+  gsize length;
+
+  if (!stat_icon_file (filename, &info))
+    return NULL;
+
+  path = get_cache_path (filename, pixel_size, scale, symbolic);
+  map = g_mapped_file_new (path, FALSE, NULL);
+  g_free (path);
+
+  if (map == NULL)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (map);
+  g_mapped_file_unref (map);
+
+  length = g_bytes_get_size (bytes);
+  if (length < sizeof (CacheHeader))
+    goto invalid;
+
+  memcpy (&header, g_bytes_get_data (bytes, NULL), sizeof (CacheHeader));
+
+  if (memcmp (header.magic, CACHE_MAGIC, sizeof (header.magic)) != 0 ||
+      header.gtk_version != GTK_VERSION_NUMBER ||
+      memcmp (&header.file, &info, sizeof (IconFileInfo)) != 0)
+    goto invalid;
+
+  if (header.width == 0 || header.width > G_MAXINT ||
+      header.height == 0 || header.height > G_MAXINT ||
+      header.stride < (guint64) header.width * (header.has_alpha ? 4 : 3) ||
+      (length - sizeof (CacheHeader)) / header.stride < header.height)
+    goto invalid;
+
+  pixels = g_bytes_new_from_bytes (bytes, sizeof (CacheHeader), (gsize) header.stride * header.height);
+  texture = gdk_memory_texture_new (header.width, header.height,
+                                    header.has_alpha ? GDK_MEMORY_GDK_PIXBUF_ALPHA
+                                                     : GDK_MEMORY_GDK_PIXBUF_OPAQUE,
+                                    pixels,
+                                    header.stride);
+  g_bytes_unref (pixels);
+  g_bytes_unref (bytes);
+
+  return texture;
+
+invalid:
+  g_bytes_unref (bytes);
+  return NULL;
+}
+
+/*
+ * gtk_icon_texture_cache_store:
+ * @filename: the path of the icon file
+ * @pixel_size: the size the icon is rendered at, in device pixels
+ * @scale: the scale the icon is rendered for
+ * @symbolic: whether the icon is rendered as symbolic icon
+ * @pixbuf: the rendered icon
+ *
+ * Stores the rendering of an icon, so that later calls to
+ * gtk_icon_texture_cache_lookup() can find it, even in
+ * other processes.
+ *
+ * Failures are silently ignored, the cache is only an
+ * optimization.
+ */
+void
+gtk_icon_texture_cache_store (const char *filename,
+                              int         pixel_size,
+                              int         scale,
+                              gboolean    symbolic,
+                              GdkPixbuf  *pixbuf)
+{
+  CacheHeader header = { CACHE_MAGIC, };
+  const guchar *pixels;
+  GError *error = NULL;
+  IconFileInfo info;
+  gsize row_length;
+  GString *contents;
+  char *path;
+  int width, height, stride;
+  int y;
+
+  if (gdk_pixbuf_get_bits_per_sample (pixbuf) != 8 ||
+      gdk_pixbuf_get_n_channels (pixbuf) != (gdk_pixbuf_get_has_alpha (pixbuf) ? 4 : 3))
+    return;
+
+  if (!stat_icon_file (filename, &info))
+    return;
+
+  if (g_mkdir_with_parents (get_cache_dir (), 0700) != 0)
+    return;
+
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+  stride = gdk_pixbuf_get_rowstride (pixbuf);
+  pixels = gdk_pixbuf_read_pixels (pixbuf);
+  row_length = width * gdk_pixbuf_get_n_channels (pixbuf);
+
+  header.gtk_version = GTK_VERSION_NUMBER;
+  header.width = width;
+  header.height = height;
+  header.stride = row_length;
+  header.has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
+  header.file = info;
+
+  contents = g_string_sized_new (sizeof (CacheHeader) + row_length * height);
+  g_string_append_len (contents, (const char *) &header, sizeof (CacheHeader));
+  for (y = 0; y < height; y++)
+    g_string_append_len (contents, (const char *) pixels + y * stride, row_length);
+
+  /* This replaces the file atomically, so processes that have
+   * the old one mapped keep seeing the old contents.
+   */
+  path = get_cache_path (filename, pixel_size, scale, symbolic);
+  if (!g_file_set_contents (path, contents->str, contents->len, &error))
+    {
+      GTK_NOTE (ICONTHEME, g_message ("Failed to write icon cache %s: %s", path, error->message));
+      g_error_free (error);
+    }
+
+  g_free (path);
+  g_string_free (contents, TRUE);
+}
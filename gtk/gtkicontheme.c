@@ -43,6 +43,7 @@
 #include "gtkcsscolorvalueprivate.h"
 #include "gtkdebug.h"
 #include "gtkiconcacheprivate.h"
+#include "gtkicontexturecacheprivate.h"
 #include "gtkintl.h"
 #include "gtkmain.h"
 #include "gtksettingsprivate.h"
@@ -3831,6 +3832,14 @@ icon_ensure_texture__locked (GtkIconPaintable *icon,
           g_clear_error (&load_error);
         }
     }
+  else if (icon->is_svg && icon->filename &&
+           (icon->texture = gtk_icon_texture_cache_lookup (icon->filename,
+                                                           pixel_size,
+                                                           icon->desired_scale,
+                                                           gtk_icon_paintable_is_symbolic (icon))))
+    {
+      /* Rendered before, possibly by another process */
+    }
   else
     {
       GLoadableIcon *loadable;
@@ -3869,6 +3878,13 @@ icon_ensure_texture__locked (GtkIconPaintable *icon,
           g_object_unref (stream);
         }
 
+      if (source_pixbuf && icon->is_svg && icon->filename)
+        gtk_icon_texture_cache_store (icon->filename,
+                                      pixel_size,
+                                      icon->desired_scale,
+                                      gtk_icon_paintable_is_symbolic (icon),
+                                      source_pixbuf);
+
       if (source_pixbuf == NULL)
         {
           g_warning ("Failed to load icon %s: %s", icon->filename, load_error->message);
@@ -3876,17 +3892,20 @@ icon_ensure_texture__locked (GtkIconPaintable *icon,
         }
     }
 
-  if (!source_pixbuf)
+  if (icon->texture == NULL)
     {
-      source_pixbuf = _gdk_pixbuf_new_from_resource (IMAGE_MISSING_RESOURCE_PATH, "png", NULL);
-      icon->icon_name = g_strdup ("image-missing");
-      icon->is_symbolic = FALSE;
-      g_assert (source_pixbuf != NULL);
-    }
+      if (!source_pixbuf)
+        {
+          source_pixbuf = _gdk_pixbuf_new_from_resource (IMAGE_MISSING_RESOURCE_PATH, "png", NULL);
+          icon->icon_name = g_strdup ("image-missing");
+          icon->is_symbolic = FALSE;
+          g_assert (source_pixbuf != NULL);
+        }
 
-  /* Actual scaling is done during rendering, so just keep the source pixbuf as a texture */
-  icon->texture = gdk_texture_new_for_pixbuf (source_pixbuf);
-  g_object_unref (source_pixbuf);
+      /* Actual scaling is done during rendering, so just keep the source pixbuf as a texture */
+      icon->texture = gdk_texture_new_for_pixbuf (source_pixbuf);
+      g_object_unref (source_pixbuf);
+    }
 
   g_assert (icon->texture != NULL);
 
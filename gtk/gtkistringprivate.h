@@ -118,7 +118,7 @@ static inline void
 istring_prepend (IString *str,
                  IString *other)
 {
-  if G_LIKELY (str->n_bytes + other->n_bytes < sizeof str->u.buf - 1)
+  if G_LIKELY (str->n_bytes + other->n_bytes <= sizeof str->u.buf - 1)
     {
       memmove (str->u.buf + other->n_bytes, str->u.buf, str->n_bytes);
       memcpy (str->u.buf, other->u.buf, other->n_bytes);
@@ -133,7 +133,7 @@ istring_prepend (IString *str,
       if (!istring_is_inline (str))
         old = str->u.str;
 
-      str->u.str = g_strconcat (istring_str (str), istring_str (other), NULL);
+      str->u.str = g_strconcat (istring_str (other), istring_str (str), NULL);
       str->n_bytes += other->n_bytes;
       str->n_chars += other->n_chars;
 
@@ -53,6 +53,7 @@
 #include "gtkdragicon.h"
 #include "gtkcsscolorvalueprivate.h"
 #include "gtkjoinedmenuprivate.h"
+#include "gdkprofilerprivate.h"
 
 #include <math.h>
 #include <string.h>
@@ -243,6 +244,7 @@
 
 typedef struct _GtkLabelClass         GtkLabelClass;
 typedef struct _GtkLabelSelectionInfo GtkLabelSelectionInfo;
+typedef struct _GtkLabelWrapCache     GtkLabelWrapCache;
 
 struct _GtkLabel
 {
@@ -256,6 +258,8 @@ struct _GtkLabel
   PangoAttrList *markup_attrs;
   PangoLayout   *layout;
 
+  GtkLabelWrapCache *wrap_cache;
+
   GtkWidget *popup_menu;
   GMenuModel *extra_menu;
 
@@ -283,6 +287,37 @@ struct _GtkLabel
   int      lines;
 };
 
+/* Height-for-width results of a wrapping label.
+ *
+ * Lines are broken greedily, so the line breaks found for a width
+ * stay the same for all widths between the widest resulting line
+ * and that width. Each entry covers such a range, which saves us
+ * from shaping the text again for every width we get asked about,
+ * e.g. while resizing a window.
+ */
+#define WRAP_CACHE_SIZE 8
+
+typedef struct
+{
+  int min_width; /* in Pango units */
+  int max_width;
+  int height;
+  int baseline;
+} GtkLabelWrapCacheEntry;
+
+struct _GtkLabelWrapCache
+{
+  guint context_serial;
+  guint n_entries;
+  guint next;
+  GtkLabelWrapCacheEntry entries[WRAP_CACHE_SIZE];
+};
+
+static guint wrap_cache_hits;
+static guint wrap_cache_misses;
+static guint wrap_cache_hits_counter;
+static guint wrap_cache_misses_counter;
+
 struct _GtkLabelClass
 {
   GtkWidgetClass parent_class;
@@ -862,6 +897,7 @@ gtk_label_css_changed (GtkWidget         *widget,
 
   if (change == NULL || attrs_affected  || (self->select_info && self->select_info->links))
     {
+      g_clear_pointer (&self->wrap_cache, g_free);
       gtk_label_update_layout_attributes (self, new_attrs);
 
       if (attrs_affected)
@@ -1017,6 +1053,96 @@ gtk_label_get_measuring_layout (GtkLabel    *self,
   return copy;
 }
 
+static gboolean
+gtk_label_lookup_wrap_cache (GtkLabel *self,
+                             int       width,
+                             int      *height,
+                             int      *baseline)
+{
+  GtkLabelWrapCache *cache = self->wrap_cache;
+  PangoContext *context;
+  guint i;
+
+  if (cache == NULL)
+    return FALSE;
+
+  /* Fonts or font options changed */
+  context = gtk_widget_get_pango_context (GTK_WIDGET (self));
+  if (cache->context_serial != pango_context_get_serial (context))
+    {
+      g_clear_pointer (&self->wrap_cache, g_free);
+      return FALSE;
+    }
+
+  width *= PANGO_SCALE;
+
+  for (i = 0; i < cache->n_entries; i++)
+    {
+      const GtkLabelWrapCacheEntry *entry = &cache->entries[i];
+
+      if (entry->min_width <= width && width <= entry->max_width)
+        {
+          *height = entry->height;
+          *baseline = entry->baseline;
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+static void
+gtk_label_add_wrap_cache (GtkLabel    *self,
+                          PangoLayout *layout,
+                          int          width,
+                          int          height,
+                          int          baseline)
+{
+  GtkLabelWrapCache *cache;
+  GtkLabelWrapCacheEntry *entry;
+  PangoContext *context;
+  GSList *l;
+  int min_width;
+
+  /* Ellipsizing and justifying don't keep the line breaks */
+  if (self->ellipsize || self->jtype == GTK_JUSTIFY_FILL)
+    return;
+
+  width *= PANGO_SCALE;
+
+  min_width = 0;
+  for (l = pango_layout_get_lines_readonly (layout); l; l = l->next)
+    {
+      PangoRectangle logical;
+
+      pango_layout_line_get_extents (l->data, NULL, &logical);
+      min_width = MAX (min_width, logical.width);
+    }
+
+  /* Something did not fit, e.g. a single long word */
+  if (min_width > width)
+    return;
+
+  context = gtk_widget_get_pango_context (GTK_WIDGET (self));
+
+  if (self->wrap_cache == NULL)
+    {
+      self->wrap_cache = g_new0 (GtkLabelWrapCache, 1);
+      self->wrap_cache->context_serial = pango_context_get_serial (context);
+    }
+
+  cache = self->wrap_cache;
+
+  entry = &cache->entries[cache->next];
+  entry->min_width = min_width;
+  entry->max_width = width;
+  entry->height = height;
+  entry->baseline = baseline;
+
+  cache->next = (cache->next + 1) % WRAP_CACHE_SIZE;
+  cache->n_entries = MIN (cache->n_entries + 1, WRAP_CACHE_SIZE);
+}
+
 static void
 get_height_for_width (GtkLabel *self,
                       int       width,
@@ -1028,18 +1154,37 @@ get_height_for_width (GtkLabel *self,
   PangoLayout *layout;
   int text_height, baseline;
 
-  layout = gtk_label_get_measuring_layout (self, NULL, width * PANGO_SCALE);
+  if (gtk_label_lookup_wrap_cache (self, width, &text_height, &baseline))
+    {
+      wrap_cache_hits++;
+    }
+  else
+    {
+      wrap_cache_misses++;
+
+      /* Don't measure with a layout that is wrapped for our allocation */
+      g_clear_object (&self->layout);
+
+      layout = gtk_label_get_measuring_layout (self, NULL, width * PANGO_SCALE);
+
+      pango_layout_get_pixel_size (layout, NULL, &text_height);
+      baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
+
+      gtk_label_add_wrap_cache (self, layout, width, text_height, baseline);
+
+      g_object_unref (layout);
+    }
 
-  pango_layout_get_pixel_size (layout, NULL, &text_height);
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      gdk_profiler_set_int_counter (wrap_cache_hits_counter, wrap_cache_hits);
+      gdk_profiler_set_int_counter (wrap_cache_misses_counter, wrap_cache_misses);
+    }
 
   *minimum_height = text_height;
   *natural_height = text_height;
-
-  baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
   *minimum_baseline = baseline;
   *natural_baseline = baseline;
-
-  g_object_unref (layout);
 }
 
 static int
@@ -1202,8 +1347,6 @@ gtk_label_measure (GtkWidget      *widget,
 
   if (orientation == GTK_ORIENTATION_VERTICAL && for_size != -1 && self->wrap)
     {
-      gtk_label_clear_layout (self);
-
       get_height_for_width (self, for_size, minimum, natural, minimum_baseline, natural_baseline);
     }
   else
@@ -1448,6 +1591,7 @@ gtk_label_finalize (GObject *object)
   g_free (self->text);
 
   g_clear_object (&self->layout);
+  g_clear_pointer (&self->wrap_cache, g_free);
   g_clear_pointer (&self->attrs, pango_attr_list_unref);
   g_clear_pointer (&self->markup_attrs, pango_attr_list_unref);
 
@@ -2585,6 +2729,9 @@ gtk_label_class_init (GtkLabelClass *class)
 
   quark_mnemonics_visible_connected = g_quark_from_static_string ("gtk-label-mnemonics-visible-connected");
 
+  wrap_cache_hits_counter = gdk_profiler_define_int_counter ("label-wrap-hits", "Label heights found in wrap cache");
+  wrap_cache_misses_counter = gdk_profiler_define_int_counter ("label-wrap-misses", "Label heights measured");
+
   /**
    * GtkLabel|clipboard.cut:
    *
@@ -3940,6 +4087,7 @@ gtk_label_set_wrap_mode (GtkLabel *self,
       self->wrap_mode = wrap_mode;
       g_object_notify_by_pspec (G_OBJECT (self), label_props[PROP_WRAP_MODE]);
 
+      gtk_label_clear_layout (self);
       gtk_widget_queue_resize (GTK_WIDGET (self));
     }
 }
@@ -3966,6 +4114,7 @@ static void
 gtk_label_clear_layout (GtkLabel *self)
 {
   g_clear_object (&self->layout);
+  g_clear_pointer (&self->wrap_cache, g_free);
 }
 
 static void
@@ -0,0 +1,424 @@
+/*
+ * Copyright © 2021 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtklazywidgetprivate.h"
+
+#include "gtkbinlayout.h"
+#include "gtkbuilderprivate.h"
+#include "gtkwidgetprivate.h"
+#include "gdk/gdkprofilerprivate.h"
+
+/*
+ * GtkLazyWidget:
+ *
+ * A placeholder for an object in a template that was marked with
+ * `lazy="yes"`.
+ *
+ * The builder records the XML of the object instead of building it,
+ * and puts a `GtkLazyWidget` in its place. The object is built and
+ * added as the only child of the placeholder when it is mapped for
+ * the first time, or when one of the template children inside of it
+ * is requested with gtk_widget_get_template_child().
+ *
+ * The placeholder is not removed once the object is built, it stays
+ * in the tree as the parent of the object. Code that looks at the
+ * parent of the object, like gtk_widget_get_parent(), the child of a
+ * stack page or CSS child selectors, sees the placeholder.
+ *
+ * Pending placeholders are kept in a list on the template object, so
+ * template children can be looked up without walking the widget tree.
+ *
+ * Once the template is built, the placeholders also get a table of all
+ * the objects in it, so the lazy object can refer to any of them, not
+ * just to bound template children. Widgets are only referenced weakly
+ * there, their parents keep them alive, and holding on to them could
+ * create a reference cycle through the placeholder.
+ */
+
+struct _GtkLazyWidget
+{
+  GtkWidget parent_instance;
+
+  GBytes *data;
+  char **ids;
+
+  GtkWidget *template_object;
+  GType template_type;
+  GObject *current_object;
+  GtkBuilderScope *scope;
+  char *domain;
+
+  GHashTable *template_objects; /* id => TemplateObject */
+};
+
+typedef struct
+{
+  GObject *object;
+  GWeakRef weak_ref;
+} TemplateObject;
+
+G_DEFINE_TYPE (GtkLazyWidget, gtk_lazy_widget, GTK_TYPE_WIDGET)
+
+static GQuark quark_lazy_widgets;
+
+static void
+template_object_free (gpointer data)
+{
+  TemplateObject *tobj = data;
+
+  g_clear_object (&tobj->object);
+  g_weak_ref_clear (&tobj->weak_ref);
+  g_free (tobj);
+}
+
+static GObject *
+template_object_get (TemplateObject *tobj)
+{
+  if (tobj->object)
+    return g_object_ref (tobj->object);
+
+  return g_weak_ref_get (&tobj->weak_ref);
+}
+
+static void
+gtk_lazy_widget_clear (GtkLazyWidget *self)
+{
+  if (self->template_object)
+    {
+      GSList *pending;
+
+      pending = g_object_steal_qdata (G_OBJECT (self->template_object), quark_lazy_widgets);
+      pending = g_slist_remove (pending, self);
+      g_object_set_qdata_full (G_OBJECT (self->template_object), quark_lazy_widgets,
+                               pending, (GDestroyNotify) g_slist_free);
+
+      g_object_remove_weak_pointer (G_OBJECT (self->template_object),
+                                    (gpointer *) &self->template_object);
+      self->template_object = NULL;
+    }
+
+  if (self->current_object)
+    {
+      g_object_remove_weak_pointer (self->current_object,
+                                    (gpointer *) &self->current_object);
+      self->current_object = NULL;
+    }
+
+  g_clear_pointer (&self->data, g_bytes_unref);
+  g_clear_pointer (&self->ids, g_strfreev);
+  g_clear_object (&self->scope);
+  g_clear_pointer (&self->domain, g_free);
+  g_clear_pointer (&self->template_objects, g_hash_table_unref);
+}
+
+static void
+gtk_lazy_widget_map (GtkWidget *widget)
+{
+  GtkLazyWidget *self = GTK_LAZY_WIDGET (widget);
+
+  if (self->data)
+    gtk_lazy_widget_instantiate (self);
+
+  GTK_WIDGET_CLASS (gtk_lazy_widget_parent_class)->map (widget);
+}
+
+static void
+gtk_lazy_widget_dispose (GObject *object)
+{
+  GtkLazyWidget *self = GTK_LAZY_WIDGET (object);
+  GtkWidget *child;
+
+  gtk_lazy_widget_clear (self);
+
+  while ((child = gtk_widget_get_first_child (GTK_WIDGET (self))))
+    gtk_widget_unparent (child);
+
+  G_OBJECT_CLASS (gtk_lazy_widget_parent_class)->dispose (object);
+}
+
+static void
+gtk_lazy_widget_class_init (GtkLazyWidgetClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->dispose = gtk_lazy_widget_dispose;
+
+  widget_class->map = gtk_lazy_widget_map;
+
+  gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_BIN_LAYOUT);
+
+  quark_lazy_widgets = g_quark_from_static_string ("gtk-lazy-widgets");
+}
+
+static void
+gtk_lazy_widget_init (GtkLazyWidget *self)
+{
+}
+
+/*
+ * gtk_lazy_widget_setup:
+ * @self: a `GtkLazyWidget`
+ * @builder: the builder that is building the template
+ * @template_object: the object the template is applied to
+ * @data: the XML to build, as an `<interface>`
+ * @ids: (transfer full): the ids of all objects in @data,
+ *   starting with the toplevel one
+ *
+ * Sets up the placeholder with everything that is needed to
+ * build @data later on, without keeping @builder alive.
+ */
+void
+gtk_lazy_widget_setup (GtkLazyWidget  *self,
+                       GtkBuilder     *builder,
+                       GtkWidget      *template_object,
+                       GBytes         *data,
+                       char          **ids)
+{
+  GSList *pending;
+  GObject *current_object;
+
+  g_return_if_fail (GTK_IS_LAZY_WIDGET (self));
+  g_return_if_fail (self->data == NULL);
+  g_return_if_fail (ids != NULL && ids[0] != NULL);
+
+  self->data = g_bytes_ref (data);
+  self->ids = ids;
+  g_set_object (&self->scope, gtk_builder_get_scope (builder));
+  self->domain = g_strdup (gtk_builder_get_translation_domain (builder));
+  self->template_type = _gtk_builder_get_template_type (builder);
+
+  self->template_object = template_object;
+  g_object_add_weak_pointer (G_OBJECT (self->template_object),
+                             (gpointer *) &self->template_object);
+
+  current_object = gtk_builder_get_current_object (builder);
+  if (current_object)
+    {
+      self->current_object = current_object;
+      g_object_add_weak_pointer (self->current_object,
+                                 (gpointer *) &self->current_object);
+    }
+
+  pending = g_object_steal_qdata (G_OBJECT (template_object), quark_lazy_widgets);
+  pending = g_slist_prepend (pending, self);
+  g_object_set_qdata_full (G_OBJECT (template_object), quark_lazy_widgets,
+                           pending, (GDestroyNotify) g_slist_free);
+}
+
+/*
+ * gtk_lazy_widget_instantiate:
+ * @self: a `GtkLazyWidget`
+ *
+ * Builds the object that @self is standing in for, unless
+ * that has already happened.
+ */
+void
+gtk_lazy_widget_instantiate (GtkLazyWidget *self)
+{
+  GtkBuilder *builder;
+  GtkWidget *template_object;
+  GHashTable *template_objects;
+  GBytes *data;
+  char **ids;
+  GObject *object;
+  GError *error = NULL;
+  gint64 before;
+
+  g_return_if_fail (GTK_IS_LAZY_WIDGET (self));
+
+  if (self->data == NULL)
+    return;
+
+  before = GDK_PROFILER_CURRENT_TIME;
+
+  builder = gtk_builder_new ();
+  gtk_builder_set_scope (builder, self->scope);
+  gtk_builder_set_translation_domain (builder, self->domain);
+  if (self->current_object)
+    gtk_builder_set_current_object (builder, self->current_object);
+
+  template_object = self->template_object;
+  if (template_object)
+    {
+      g_object_ref (template_object);
+      gtk_builder_expose_object (builder, g_type_name (self->template_type), G_OBJECT (template_object));
+      gtk_widget_expose_template_children (template_object, self->template_type, builder);
+    }
+
+  if (self->template_objects)
+    {
+      GHashTableIter iter;
+      gpointer id, value;
+
+      g_hash_table_iter_init (&iter, self->template_objects);
+      while (g_hash_table_iter_next (&iter, &id, &value))
+        {
+          GObject *tobj;
+
+          if (gtk_builder_get_object (builder, id))
+            continue;
+
+          tobj = template_object_get (value);
+          if (tobj)
+            {
+              gtk_builder_expose_object (builder, id, tobj);
+              g_object_unref (tobj);
+            }
+        }
+    }
+
+  /* Take everything out first, so a template child lookup from
+   * inside of the build does not end up here again.
+   */
+  data = g_steal_pointer (&self->data);
+  ids = g_steal_pointer (&self->ids);
+  template_objects = g_steal_pointer (&self->template_objects);
+  gtk_lazy_widget_clear (self);
+
+  if (!gtk_builder_add_from_string (builder,
+                                    g_bytes_get_data (data, NULL),
+                                    g_bytes_get_size (data),
+                                    &error))
+    {
+      g_critical ("Error building lazy object in template for type '%s': %s",
+                  g_type_name (self->template_type), error->message);
+      g_error_free (error);
+      goto out;
+    }
+
+  object = gtk_builder_get_object (builder, ids[0]);
+  g_assert (GTK_IS_WIDGET (object));
+  gtk_widget_set_parent (GTK_WIDGET (object), GTK_WIDGET (self));
+
+  if (template_object)
+    gtk_widget_bind_lazy_template_children (template_object, self->template_type, builder);
+
+  gdk_profiler_end_mark (before, "lazy widget build", ids[0]);
+
+out:
+  g_strfreev (ids);
+  g_bytes_unref (data);
+  g_clear_pointer (&template_objects, g_hash_table_unref);
+  g_object_unref (builder);
+  g_clear_object (&template_object);
+}
+
+/*
+ * gtk_lazy_widget_lookup:
+ * @template_object: the object a template was applied to
+ * @template_type: the type that defined the template
+ * @id: the id of an object in the template
+ * @instantiate: whether to build the object
+ *
+ * Checks if the object with @id in the template for @template_type
+ * has not been built yet because it is part of a lazy object, and
+ * optionally builds it.
+ *
+ * Returns: %TRUE if a pending lazy object contains @id
+ */
+gboolean
+gtk_lazy_widget_lookup (GtkWidget  *template_object,
+                        GType       template_type,
+                        const char *id,
+                        gboolean    instantiate)
+{
+  GSList *l;
+
+  if (quark_lazy_widgets == 0)
+    return FALSE;
+
+  for (l = g_object_get_qdata (G_OBJECT (template_object), quark_lazy_widgets); l; l = l->next)
+    {
+      GtkLazyWidget *self = l->data;
+
+      if (self->template_type != template_type ||
+          !g_strv_contains ((const char * const *) self->ids, id))
+        continue;
+
+      if (instantiate)
+        gtk_lazy_widget_instantiate (self);
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*
+ * gtk_lazy_widget_set_template_objects:
+ * @template_object: the object a template was applied to
+ * @template_type: the type that defined the template
+ * @builder: the builder that built the template
+ *
+ * Lets the pending lazy objects of the template for @template_type
+ * refer to all the objects that @builder built.
+ */
+void
+gtk_lazy_widget_set_template_objects (GtkWidget  *template_object,
+                                      GType       template_type,
+                                      GtkBuilder *builder)
+{
+  GHashTable *template_objects = NULL;
+  GSList *l;
+
+  if (quark_lazy_widgets == 0)
+    return;
+
+  for (l = g_object_get_qdata (G_OBJECT (template_object), quark_lazy_widgets); l; l = l->next)
+    {
+      GtkLazyWidget *self = l->data;
+
+      if (self->template_type != template_type || self->template_objects != NULL)
+        continue;
+
+      if (template_objects == NULL)
+        {
+          GHashTableIter iter;
+          gpointer id, object;
+
+          template_objects = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    g_free, template_object_free);
+
+          g_hash_table_iter_init (&iter, _gtk_builder_get_named_objects (builder));
+          while (g_hash_table_iter_next (&iter, &id, &object))
+            {
+              TemplateObject *tobj;
+
+              /* Those are exposed separately, or can't be referred to */
+              if (object == (gpointer) template_object ||
+                  GTK_IS_LAZY_WIDGET (object) ||
+                  (g_str_has_prefix (id, "___") && g_str_has_suffix (id, "___")))
+                continue;
+
+              tobj = g_new0 (TemplateObject, 1);
+              if (GTK_IS_WIDGET (object))
+                g_weak_ref_init (&tobj->weak_ref, object);
+              else
+                tobj->object = g_object_ref (object);
+
+              g_hash_table_insert (template_objects, g_strdup (id), tobj);
+            }
+        }
+
+      self->template_objects = g_hash_table_ref (template_objects);
+    }
+
+  g_clear_pointer (&template_objects, g_hash_table_unref);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright © 2021 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_LAZY_WIDGET_PRIVATE_H__
+#define __GTK_LAZY_WIDGET_PRIVATE_H__
+
+#include "gtkbuilder.h"
+#include "gtkwidget.h"
+
+G_BEGIN_DECLS
+
+#define GTK_TYPE_LAZY_WIDGET (gtk_lazy_widget_get_type ())
+
+G_DECLARE_FINAL_TYPE (GtkLazyWidget, gtk_lazy_widget, GTK, LAZY_WIDGET, GtkWidget)
+
+void            gtk_lazy_widget_setup                   (GtkLazyWidget          *self,
+                                                         GtkBuilder             *builder,
+                                                         GtkWidget              *template_object,
+                                                         GBytes                 *data,
+                                                         char                  **ids);
+void            gtk_lazy_widget_instantiate             (GtkLazyWidget          *self);
+void            gtk_lazy_widget_set_template_objects    (GtkWidget              *template_object,
+                                                         GType                   template_type,
+                                                         GtkBuilder             *builder);
+
+gboolean        gtk_lazy_widget_lookup                  (GtkWidget              *template_object,
+                                                         GType                   template_type,
+                                                         const char             *id,
+                                                         gboolean                instantiate);
+
+G_END_DECLS
+
+#endif /* __GTK_LAZY_WIDGET_PRIVATE_H__ */
@@ -30,8 +30,20 @@
  *
  * `GtkMultiSelection` is a `GtkSelectionModel` that allows selecting multiple
  * elements.
+ *
+ * Selected items keep their selection when the underlying model removes and
+ * re-adds them in a single change. To keep selecting large ranges cheap, only
+ * the items of small selections are looked up right away. When selecting many
+ * items at once, like with gtk_selection_model_select_all(), the items are
+ * looked up when they are requested from the selection or, in batches, when
+ * the main loop is idle. Until then, items that are removed and re-added lose
+ * their selection.
  */
 
+/* selections up to this size are looked up right away,
+ * larger ones in batches of this size when idle */
+#define RESOLVE_BATCH_SIZE 512
+
 struct _GtkMultiSelection
 {
   GObject parent_instance;
@@ -40,6 +52,8 @@ struct _GtkMultiSelection
 
   GtkBitset *selected;
   GHashTable *items; /* item => position */
+  GtkBitset *unresolved; /* selected positions not yet in items */
+  guint resolve_cb; /* idle callback handle */
 };
 
 struct _GtkMultiSelectionClass
@@ -78,11 +92,21 @@ gtk_multi_selection_get_item (GListModel *list,
                               guint       position)
 {
   GtkMultiSelection *self = GTK_MULTI_SELECTION (list);
+  gpointer item;
 
   if (self->model == NULL)
     return NULL;
 
-  return g_list_model_get_item (self->model, position);
+  item = g_list_model_get_item (self->model, position);
+
+  /* Start tracking selected items once somebody looks at them */
+  if (item && gtk_bitset_contains (self->unresolved, position))
+    {
+      g_hash_table_insert (self->items, g_object_ref (item), GUINT_TO_POINTER (position));
+      gtk_bitset_remove (self->unresolved, position);
+    }
+
+  return item;
 }
 
 static void
@@ -112,47 +136,129 @@ gtk_multi_selection_get_selection_in_range (GtkSelectionModel *model,
   return gtk_bitset_ref (self->selected);
 }
 
+/* Looks up up to @max_items of the unresolved selected items
+ * and starts tracking them.
+ */
+static void
+gtk_multi_selection_resolve (GtkMultiSelection *self,
+                             guint              max_items)
+{
+  GtkBitsetIter iter;
+  guint i, pos;
+  gboolean more;
+
+  for (i = 0, more = gtk_bitset_iter_init_first (&iter, self->unresolved, &pos);
+       i < max_items && more;
+       i++, more = gtk_bitset_iter_next (&iter, &pos))
+    {
+      gpointer item = g_list_model_get_item (self->model, pos);
+
+      g_hash_table_insert (self->items, item, GUINT_TO_POINTER (pos));
+    }
+
+  if (more)
+    gtk_bitset_remove_range (self->unresolved, 0, pos);
+  else
+    gtk_bitset_remove_all (self->unresolved);
+}
+
+static gboolean
+gtk_multi_selection_resolve_cb (gpointer data)
+{
+  GtkMultiSelection *self = data;
+
+  gtk_multi_selection_resolve (self, RESOLVE_BATCH_SIZE);
+
+  if (gtk_bitset_is_empty (self->unresolved))
+    {
+      self->resolve_cb = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+gtk_multi_selection_clear_unresolved (GtkMultiSelection *self)
+{
+  gtk_bitset_remove_all (self->unresolved);
+  g_clear_handle_id (&self->resolve_cb, g_source_remove);
+}
+
 static void
 gtk_multi_selection_toggle_selection (GtkMultiSelection *self,
                                       GtkBitset         *changes)
 {
-  GListModel *model = G_LIST_MODEL (self);
-  GtkBitsetIter change_iter, selected_iter;
-  GtkBitset *selected;
-  guint change_pos, selected_pos;
-  gboolean more;
+  GtkBitset *selected, *unselected;
+  guint n_unselected;
 
   gtk_bitset_difference (self->selected, changes);
 
-  selected = gtk_bitset_copy (changes);
-  gtk_bitset_intersect (selected, self->selected);
+  /* Stop tracking unselected items. Those that were never looked up
+   * just need to be forgotten.
+   */
+  unselected = gtk_bitset_copy (changes);
+  gtk_bitset_subtract (unselected, self->selected);
+  gtk_bitset_subtract (unselected, self->unresolved);
+  gtk_bitset_subtract (self->unresolved, changes);
 
-  if (!gtk_bitset_iter_init_first (&selected_iter, selected, &selected_pos))
-    selected_pos = G_MAXUINT;
+  n_unselected = gtk_bitset_get_size (unselected);
+  if (n_unselected > g_hash_table_size (self->items) / 2)
+    {
+      GHashTableIter iter;
+      gpointer pos_pointer;
 
-  for (more = gtk_bitset_iter_init_first (&change_iter, changes, &change_pos);
-       more;
-       more = gtk_bitset_iter_next (&change_iter, &change_pos))
+      /* cheaper than looking up all the items */
+      g_hash_table_iter_init (&iter, self->items);
+      while (g_hash_table_iter_next (&iter, NULL, &pos_pointer))
+        {
+          if (gtk_bitset_contains (unselected, GPOINTER_TO_UINT (pos_pointer)))
+            g_hash_table_iter_remove (&iter);
+        }
+    }
+  else if (n_unselected > 0)
     {
-      gpointer item = g_list_model_get_item (model, change_pos);
+      GtkBitsetIter iter;
+      guint pos;
+      gboolean more;
 
-      if (change_pos < selected_pos)
+      for (more = gtk_bitset_iter_init_first (&iter, unselected, &pos);
+           more;
+           more = gtk_bitset_iter_next (&iter, &pos))
         {
+          gpointer item = g_list_model_get_item (self->model, pos);
+
           g_hash_table_remove (self->items, item);
           g_object_unref (item);
         }
-      else
-        {
-          g_assert (change_pos == selected_pos);
+    }
 
-          g_hash_table_insert (self->items, item, GUINT_TO_POINTER (change_pos));
+  gtk_bitset_unref (unselected);
 
-          if (!gtk_bitset_iter_next (&selected_iter, &selected_pos))
-            selected_pos = G_MAXUINT;
-        }
-    }
+  /* Start tracking newly selected items. Small selections are
+   * tracked right away, large ones when their items are requested,
+   * see gtk_multi_selection_get_item(), or when idle.
+   */
+  selected = gtk_bitset_copy (changes);
+  gtk_bitset_intersect (selected, self->selected);
+  gtk_bitset_union (self->unresolved, selected);
+
+  if (gtk_bitset_get_size (selected) <= RESOLVE_BATCH_SIZE)
+    gtk_multi_selection_resolve (self, RESOLVE_BATCH_SIZE);
 
   gtk_bitset_unref (selected);
+
+  if (gtk_bitset_is_empty (self->unresolved))
+    {
+      g_clear_handle_id (&self->resolve_cb, g_source_remove);
+    }
+  else if (self->resolve_cb == 0)
+    {
+      self->resolve_cb = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE + 10,
+                                          gtk_multi_selection_resolve_cb,
+                                          self, NULL);
+      g_source_set_name_by_id (self->resolve_cb, "[gtk] gtk_multi_selection_resolve_cb");
+    }
 }
 
 static gboolean
@@ -220,6 +326,7 @@ gtk_multi_selection_items_changed_cb (GListModel        *model,
   guint i;
 
   gtk_bitset_splice (self->selected, position, removed, added);
+  gtk_bitset_splice (self->unresolved, position, removed, added);
 
   g_hash_table_iter_init (&iter, self->items);
   while (g_hash_table_iter_next (&iter, &item, &pos_pointer))
@@ -278,6 +385,7 @@ gtk_multi_selection_clear_model (GtkMultiSelection *self)
                                         gtk_multi_selection_items_changed_cb,
                                         self);
   g_clear_object (&self->model);
+  gtk_multi_selection_clear_unresolved (self);
 }
 
 static void
@@ -329,6 +437,7 @@ gtk_multi_selection_dispose (GObject *object)
   gtk_multi_selection_clear_model (self);
 
   g_clear_pointer (&self->selected, gtk_bitset_unref);
+  g_clear_pointer (&self->unresolved, gtk_bitset_unref);
   g_clear_pointer (&self->items, g_hash_table_unref);
 
   G_OBJECT_CLASS (gtk_multi_selection_parent_class)->dispose (object);
@@ -362,6 +471,7 @@ static void
 gtk_multi_selection_init (GtkMultiSelection *self)
 {
   self->selected = gtk_bitset_new_empty ();
+  self->unresolved = gtk_bitset_new_empty ();
   self->items = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
 }
 
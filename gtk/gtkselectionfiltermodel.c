@@ -30,6 +30,9 @@
  *
  * `GtkSelectionFilterModel` is a list model that presents the selection from
  * a `GtkSelectionModel`.
+ *
+ * The items are looked up in the selection model when they are requested,
+ * so even huge selections do not need to be copied.
  */
 
 enum {
@@ -145,7 +148,38 @@ gtk_selection_filter_model_selection_changed_cb (GListModel              *model,
                                                  guint                    n_items,
                                                  GtkSelectionFilterModel *self)
 {
-  selection_filter_model_items_changed (self, position, n_items, n_items);
+  GtkBitset *selection, *changes;
+  guint first, last;
+
+  if (n_items == 0)
+    return;
+
+  selection = gtk_selection_model_get_selection (self->model);
+
+  /* Only look at the items that actually changed their selection,
+   * the signal's range can be much larger than that, like when
+   * selecting all items.
+   */
+  changes = gtk_bitset_copy (self->selection);
+  gtk_bitset_difference (changes, selection);
+  if (position > 0)
+    gtk_bitset_remove_range (changes, 0, position);
+  if (position + n_items > position)
+    gtk_bitset_remove_range_closed (changes, position + n_items, G_MAXUINT);
+
+  if (gtk_bitset_is_empty (changes))
+    {
+      gtk_bitset_unref (changes);
+      gtk_bitset_unref (selection);
+      return;
+    }
+
+  first = gtk_bitset_get_minimum (changes);
+  last = gtk_bitset_get_maximum (changes);
+  gtk_bitset_unref (changes);
+  gtk_bitset_unref (selection);
+
+  selection_filter_model_items_changed (self, first, last - first + 1, last - first + 1);
 }
 
 static void
@@ -26,6 +26,8 @@
 #include "gtkintl.h"
 #include "gtkprivate.h"
 
+#include <string.h>
+
 /**
  * GtkStringList:
  *
@@ -36,6 +38,12 @@
  * `GtkStringList` is well-suited for any place where you would
  * typically use a `char*[]`, but need a list model.
  *
+ * The strings are stored compactly and the `GtkStringObject`s wrapping
+ * them are only created when they are requested, so `GtkStringList`
+ * can hold millions of strings. Use [ctor@Gtk.StringList.new_from_bytes]
+ * or [method@Gtk.StringList.splice_bytes] to load a large amount of
+ * strings at once.
+ *
  * # GtkStringList as GtkBuildable
  *
  * The `GtkStringList` implementation of the `GtkBuildable` interface
@@ -66,16 +74,41 @@
  * a [property@Gtk.StringObject:string] property.
  */
 
-#define GDK_ARRAY_ELEMENT_TYPE GtkStringObject *
-#define GDK_ARRAY_NAME objects
-#define GDK_ARRAY_TYPE_NAME Objects
-#define GDK_ARRAY_FREE_FUNC g_object_unref
+/* The strings are kept in a string pool owned by the list, and the
+ * GtkStringObjects are only created when somebody asks for them. The
+ * list does not keep them alive, it only remembers them for as long as
+ * somebody else holds a reference, so that repeated lookups of the same
+ * position return the same object.
+ *
+ * Strings never move once they are in the pool, so the pointers returned
+ * by gtk_string_list_get_string() stay valid for as long as the item is
+ * in the list. The pool is made of blocks that count how many of their
+ * strings are still in use, and a block is freed when that drops to 0.
+ */
+#define GDK_ARRAY_ELEMENT_TYPE const char *
+#define GDK_ARRAY_NAME strings
+#define GDK_ARRAY_TYPE_NAME Strings
 #include "gdk/gdkarrayimpl.c"
 
+/* default block size of the string pool */
+#define POOL_BLOCK_SIZE 4096
+
+typedef struct _PoolBlock PoolBlock;
+
+struct _PoolBlock
+{
+  guint n_strings;  /* strings in this block that are still in the list */
+  gsize size;
+  gsize used;
+  char data[];
+};
+
 struct _GtkStringObject
 {
   GObject parent_instance;
   char *string;
+  /* the string in the pool of the list that created this object */
+  const char *pooled;
 };
 
 enum {
@@ -188,7 +221,12 @@ struct _GtkStringList
 {
   GObject parent_instance;
 
-  Objects items;
+  Strings items;
+  GPtrArray *blocks;  /* PoolBlock, sorted by address */
+  PoolBlock *current; /* block that small strings are added to */
+
+  /* pooled string => GtkStringObject, not referenced */
+  GHashTable *objects;
 };
 
 struct _GtkStringListClass
@@ -207,7 +245,25 @@ gtk_string_list_get_n_items (GListModel *list)
 {
   GtkStringList *self = GTK_STRING_LIST (list);
 
-  return objects_get_size (&self->items);
+  return strings_get_size (&self->items);
+}
+
+static void
+gtk_string_list_object_disposed (gpointer  data,
+                                 GObject  *where_the_object_was)
+{
+  GtkStringList *self = data;
+  GtkStringObject *object = (GtkStringObject *) where_the_object_was;
+
+  g_hash_table_remove (self->objects, object->pooled);
+}
+
+static void
+gtk_string_list_forget_object (GtkStringList   *self,
+                               GtkStringObject *object)
+{
+  g_object_weak_unref (G_OBJECT (object), gtk_string_list_object_disposed, self);
+  object->pooled = NULL;
 }
 
 static gpointer
@@ -215,11 +271,23 @@ gtk_string_list_get_item (GListModel *list,
                           guint       position)
 {
   GtkStringList *self = GTK_STRING_LIST (list);
+  GtkStringObject *object;
+  const char *string;
 
-  if (position >= objects_get_size (&self->items))
+  if (position >= strings_get_size (&self->items))
     return NULL;
 
-  return g_object_ref (objects_get (&self->items, position));
+  string = strings_get (&self->items, position);
+  object = g_hash_table_lookup (self->objects, string);
+  if (object)
+    return g_object_ref (object);
+
+  object = gtk_string_object_new (string);
+  object->pooled = string;
+  g_object_weak_ref (G_OBJECT (object), gtk_string_list_object_disposed, self);
+  g_hash_table_insert (self->objects, (gpointer) string, object);
+
+  return object;
 }
 
 static void
@@ -405,24 +473,184 @@ static void
 gtk_string_list_dispose (GObject *object)
 {
   GtkStringList *self = GTK_STRING_LIST (object);
+  GHashTableIter iter;
+  gpointer value;
 
-  objects_clear (&self->items);
+  g_hash_table_iter_init (&iter, self->objects);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      gtk_string_list_forget_object (self, value);
+      g_hash_table_iter_remove (&iter);
+    }
+
+  strings_clear (&self->items);
+  g_ptr_array_set_size (self->blocks, 0);
+  self->current = NULL;
 
   G_OBJECT_CLASS (gtk_string_list_parent_class)->dispose (object);
 }
 
+static void
+gtk_string_list_finalize (GObject *object)
+{
+  GtkStringList *self = GTK_STRING_LIST (object);
+
+  g_hash_table_unref (self->objects);
+  g_ptr_array_unref (self->blocks);
+
+  G_OBJECT_CLASS (gtk_string_list_parent_class)->finalize (object);
+}
+
 static void
 gtk_string_list_class_init (GtkStringListClass *class)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
 
   gobject_class->dispose = gtk_string_list_dispose;
+  gobject_class->finalize = gtk_string_list_finalize;
 }
 
 static void
 gtk_string_list_init (GtkStringList *self)
 {
-  objects_init (&self->items);
+  strings_init (&self->items);
+  self->blocks = g_ptr_array_new_with_free_func (g_free);
+  self->objects = g_hash_table_new (NULL, NULL);
+}
+
+/* Returns the index of the first block in the pool that starts
+ * after @string, or the number of blocks if there is none.
+ */
+static guint
+gtk_string_list_pool_search (GtkStringList *self,
+                             const char    *string)
+{
+  guint lo, hi;
+
+  lo = 0;
+  hi = self->blocks->len;
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+      PoolBlock *block = g_ptr_array_index (self->blocks, mid);
+
+      if (GPOINTER_TO_SIZE (block->data) <= GPOINTER_TO_SIZE (string))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static PoolBlock *
+gtk_string_list_pool_add_block (GtkStringList *self,
+                                gsize          size)
+{
+  PoolBlock *block;
+
+  block = g_malloc (sizeof (PoolBlock) + size);
+  block->n_strings = 0;
+  block->size = size;
+  block->used = 0;
+
+  g_ptr_array_insert (self->blocks,
+                      gtk_string_list_pool_search (self, block->data),
+                      block);
+
+  return block;
+}
+
+/* Reserves @size bytes in the pool for @n_strings strings */
+static char *
+gtk_string_list_pool_alloc (GtkStringList *self,
+                            gsize          size,
+                            guint          n_strings)
+{
+  PoolBlock *block;
+  char *result;
+
+  if (size > POOL_BLOCK_SIZE / 4)
+    {
+      /* big allocations get their own block, so they can be
+       * given back as soon as they are removed */
+      block = gtk_string_list_pool_add_block (self, size);
+    }
+  else
+    {
+      if (self->current == NULL ||
+          self->current->size - self->current->used < size)
+        self->current = gtk_string_list_pool_add_block (self, POOL_BLOCK_SIZE);
+
+      block = self->current;
+    }
+
+  result = block->data + block->used;
+  block->used += size;
+  block->n_strings += n_strings;
+
+  return result;
+}
+
+static const char *
+gtk_string_list_pool_insert (GtkStringList *self,
+                             const char    *string)
+{
+  gsize len = strlen (string);
+  char *pooled;
+
+  pooled = gtk_string_list_pool_alloc (self, len + 1, 1);
+  memcpy (pooled, string, len + 1);
+
+  return pooled;
+}
+
+static void
+gtk_string_list_pool_remove (GtkStringList *self,
+                             const char    *string)
+{
+  PoolBlock *block;
+  guint pos;
+
+  pos = gtk_string_list_pool_search (self, string) - 1;
+  block = g_ptr_array_index (self->blocks, pos);
+
+  g_assert (block->n_strings > 0);
+  block->n_strings--;
+  if (block->n_strings > 0)
+    return;
+
+  if (block == self->current)
+    block->used = 0;
+  else
+    g_ptr_array_remove_index (self->blocks, pos);
+}
+
+/* Releases the items from @position to @position + @n_items.
+ * They need to be removed from the array afterwards, and they
+ * may not be accessed anymore.
+ */
+static void
+gtk_string_list_release (GtkStringList *self,
+                         guint          position,
+                         guint          n_items)
+{
+  guint i;
+
+  for (i = position; i < position + n_items; i++)
+    {
+      const char *string = strings_get (&self->items, i);
+
+      if (g_hash_table_size (self->objects) > 0)
+        {
+          GtkStringObject *object;
+
+          if (g_hash_table_steal_extended (self->objects, string, NULL, (gpointer *) &object))
+            gtk_string_list_forget_object (self, object);
+        }
+
+      gtk_string_list_pool_remove (self, string);
+    }
 }
 
 /**
@@ -445,6 +673,33 @@ gtk_string_list_new (const char * const *strings)
   return self;
 }
 
+/**
+ * gtk_string_list_new_from_bytes:
+ * @bytes: newline-separated UTF-8 text
+ *
+ * Creates a new `GtkStringList` with one item for each line
+ * in @bytes.
+ *
+ * See [method@Gtk.StringList.splice_bytes] for details.
+ *
+ * Returns: a new `GtkStringList`
+ *
+ * Since: 4.4
+ */
+GtkStringList *
+gtk_string_list_new_from_bytes (GBytes *bytes)
+{
+  GtkStringList *self;
+
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  self = g_object_new (GTK_TYPE_STRING_LIST, NULL);
+
+  gtk_string_list_splice_bytes (self, 0, 0, bytes);
+
+  return self;
+}
+
 /**
  * gtk_string_list_splice:
  * @self: a `GtkStringList`
@@ -471,22 +726,113 @@ gtk_string_list_splice (GtkStringList      *self,
                         guint               n_removals,
                         const char * const *additions)
 {
+  const char **pooled;
   guint i, n_additions;
 
   g_return_if_fail (GTK_IS_STRING_LIST (self));
   g_return_if_fail (position + n_removals >= position); /* overflow */
-  g_return_if_fail (position + n_removals <= objects_get_size (&self->items));
+  g_return_if_fail (position + n_removals <= strings_get_size (&self->items));
 
   if (additions)
     n_additions = g_strv_length ((char **) additions);
   else
     n_additions = 0;
 
-  objects_splice (&self->items, position, n_removals, FALSE, NULL, n_additions);
+  /* Copy the additions before releasing the removed strings,
+   * they might be the same memory */
+  pooled = g_new (const char *, n_additions);
+  for (i = 0; i < n_additions; i++)
+    pooled[i] = gtk_string_list_pool_insert (self, additions[i]);
+
+  gtk_string_list_release (self, position, n_removals);
+  strings_splice (&self->items, position, n_removals, FALSE, pooled, n_additions);
 
+  g_free (pooled);
+
+  if (n_removals || n_additions)
+    g_list_model_items_changed (G_LIST_MODEL (self), position, n_removals, n_additions);
+}
+
+/**
+ * gtk_string_list_splice_bytes:
+ * @self: a `GtkStringList`
+ * @position: the position at which to make the change
+ * @n_removals: the number of strings to remove
+ * @bytes: newline-separated UTF-8 text
+ *
+ * Changes @self by removing @n_removals strings and adding one
+ * string for each line in @bytes.
+ *
+ * Lines are separated by `\n` or `\r\n`. A newline at the end of
+ * @bytes does not add an empty string. Text after a nul byte in
+ * a line is ignored.
+ *
+ * This is the fastest way to fill a `GtkStringList` with a large
+ * number of strings, as the text is copied in one piece and no
+ * objects are created until they are requested with
+ * g_list_model_get_item().
+ *
+ * The parameters @position and @n_removals must be correct (ie:
+ * @position + @n_removals must be less than or equal to the length
+ * of the list at the time this function is called).
+ *
+ * Since: 4.4
+ */
+void
+gtk_string_list_splice_bytes (GtkStringList *self,
+                              guint          position,
+                              guint          n_removals,
+                              GBytes        *bytes)
+{
+  const char *data;
+  char *text, *end, *line, *next;
+  gsize size;
+  guint i, n_additions;
+
+  g_return_if_fail (GTK_IS_STRING_LIST (self));
+  g_return_if_fail (position + n_removals >= position); /* overflow */
+  g_return_if_fail (position + n_removals <= strings_get_size (&self->items));
+  g_return_if_fail (bytes != NULL);
+
+  data = g_bytes_get_data (bytes, &size);
+
+  if (size > 0)
+    {
+      if (data[size - 1] == '\n')
+        size--;
+
+      n_additions = 1;
+      for (line = memchr (data, '\n', size); line; line = memchr (line + 1, '\n', data + size - line - 1))
+        n_additions++;
+
+      /* Copy all of the text at once and terminate the lines in place */
+      text = gtk_string_list_pool_alloc (self, size + 1, n_additions);
+      memcpy (text, data, size);
+      text[size] = '\0';
+      end = text + size;
+    }
+  else
+    {
+      text = end = NULL;
+      n_additions = 0;
+    }
+
+  gtk_string_list_release (self, position, n_removals);
+  strings_splice (&self->items, position, n_removals, FALSE, NULL, n_additions);
+
+  line = text;
   for (i = 0; i < n_additions; i++)
     {
-      *objects_index (&self->items, position + i) = gtk_string_object_new (additions[i]);
+      next = memchr (line, '\n', end - line);
+      if (next == NULL)
+        next = end;
+
+      *next = '\0';
+      if (next > line && next[-1] == '\r')
+        next[-1] = '\0';
+
+      *strings_index (&self->items, position + i) = line;
+      line = next + 1;
     }
 
   if (n_removals || n_additions)
@@ -509,9 +855,9 @@ gtk_string_list_append (GtkStringList *self,
 {
   g_return_if_fail (GTK_IS_STRING_LIST (self));
 
-  objects_append (&self->items, gtk_string_object_new (string));
+  strings_append (&self->items, gtk_string_list_pool_insert (self, string));
 
-  g_list_model_items_changed (G_LIST_MODEL (self), objects_get_size (&self->items) - 1, 0, 1);
+  g_list_model_items_changed (G_LIST_MODEL (self), strings_get_size (&self->items) - 1, 0, 1);
 }
 
 /**
@@ -535,9 +881,10 @@ gtk_string_list_take (GtkStringList *self,
 {
   g_return_if_fail (GTK_IS_STRING_LIST (self));
 
-  objects_append (&self->items, gtk_string_object_new_take (string));
+  strings_append (&self->items, gtk_string_list_pool_insert (self, string));
+  g_free (string);
 
-  g_list_model_items_changed (G_LIST_MODEL (self), objects_get_size (&self->items) - 1, 0, 1);
+  g_list_model_items_changed (G_LIST_MODEL (self), strings_get_size (&self->items) - 1, 0, 1);
 }
 
 /**
@@ -579,8 +926,8 @@ gtk_string_list_get_string (GtkStringList *self,
 {
   g_return_val_if_fail (GTK_IS_STRING_LIST (self), NULL);
 
-  if (position >= objects_get_size (&self->items))
+  if (position >= strings_get_size (&self->items))
     return NULL;
 
-  return objects_get (&self->items, position)->string;
+  return strings_get (&self->items, position);
 }
@@ -48,6 +48,8 @@ G_DECLARE_FINAL_TYPE (GtkStringList, gtk_string_list, GTK, STRING_LIST, GObject)
 
 GDK_AVAILABLE_IN_ALL
 GtkStringList * gtk_string_list_new             (const char * const    *strings);
+GDK_AVAILABLE_IN_4_4
+GtkStringList * gtk_string_list_new_from_bytes  (GBytes                *bytes);
 
 GDK_AVAILABLE_IN_ALL
 void            gtk_string_list_append          (GtkStringList         *self,
@@ -66,6 +68,11 @@ void            gtk_string_list_splice          (GtkStringList         *self,
                                                  guint                  position,
                                                  guint                  n_removals,
                                                  const char * const    *additions);
+GDK_AVAILABLE_IN_4_4
+void            gtk_string_list_splice_bytes    (GtkStringList         *self,
+                                                 guint                  position,
+                                                 guint                  n_removals,
+                                                 GBytes                *bytes);
 
 GDK_AVAILABLE_IN_ALL
 const char *    gtk_string_list_get_string      (GtkStringList         *self,
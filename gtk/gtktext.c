@@ -212,6 +212,7 @@ struct _GtkTextPrivate
 
   guint64       blink_start_time;
   guint         blink_tick;
+  guint         recompute_tick;
   float         cursor_alpha;
 
   guint16       preedit_length;              /* length of preedit string, in bytes */
@@ -1988,6 +1989,12 @@ gtk_text_dispose (GObject *object)
       priv->blink_tick = 0;
     }
 
+  if (priv->recompute_tick)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (object), priv->recompute_tick);
+      priv->recompute_tick = 0;
+    }
+
   if (priv->magnifier)
     _gtk_magnifier_set_inspected (GTK_MAGNIFIER (priv->magnifier), NULL);
 
@@ -2208,6 +2215,12 @@ gtk_text_unmap (GtkWidget *widget)
   gtk_text_update_handles (self);
   priv->cursor_alpha = 1.0;
 
+  if (priv->recompute_tick)
+    {
+      gtk_widget_remove_tick_callback (widget, priv->recompute_tick);
+      priv->recompute_tick = 0;
+    }
+
   GTK_WIDGET_CLASS (gtk_text_parent_class)->unmap (widget);
 }
 
@@ -4424,19 +4437,56 @@ gtk_text_reset_layout (GtkText *self)
     }
 }
 
+static gboolean
+recompute_cb (GtkWidget     *widget,
+              GdkFrameClock *clock,
+              gpointer       user_data)
+{
+  GtkText *self = GTK_TEXT (widget);
+  GtkTextPrivate *priv = gtk_text_get_instance_private (self);
+
+  priv->recompute_tick = 0;
+
+  gtk_text_check_cursor_blink (self);
+  gtk_text_adjust_scroll (self);
+  update_im_cursor_location (self);
+  gtk_text_update_handles (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtk_text_flush_recompute (GtkText *self)
+{
+  GtkTextPrivate *priv = gtk_text_get_instance_private (self);
+
+  if (priv->recompute_tick)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->recompute_tick);
+      recompute_cb (GTK_WIDGET (self), NULL, NULL);
+    }
+}
+
 static void
 gtk_text_recompute (GtkText *self)
 {
+  GtkTextPrivate *priv = gtk_text_get_instance_private (self);
+
   gtk_text_reset_layout (self);
   gtk_widget_queue_draw (GTK_WIDGET (self));
 
   if (!gtk_widget_get_mapped (GTK_WIDGET (self)))
     return;
 
-  gtk_text_check_cursor_blink (self);
-  gtk_text_adjust_scroll (self);
-  update_im_cursor_location (self);
-  gtk_text_update_handles (self);
+  /* Keeping the cursor in view needs a layout of the whole text.
+   * A single edit often recomputes several times, e.g. for the
+   * deletion, the insertion and the cursor move, so only do this
+   * once, before the next frame.
+   */
+  if (priv->recompute_tick == 0)
+    priv->recompute_tick = gtk_widget_add_tick_callback (GTK_WIDGET (self),
+                                                         recompute_cb,
+                                                         NULL, NULL);
 }
 
 static PangoLayout *
@@ -5898,6 +5948,7 @@ gtk_text_get_layout_offsets (GtkText *self,
 {
   g_return_if_fail (GTK_IS_TEXT (self));
 
+  gtk_text_flush_recompute (self);
   get_layout_position (self, x, y);
 }
 
@@ -149,6 +149,11 @@ struct _GtkTextBTreeNode {
   } children;
 
   NodeData *node_data;
+
+  GtkTextSearchChunk *search_chunk;     /* Text of the lines below this node,
+                                         * for searching, or NULL. Only
+                                         * level 1 nodes (and a level 0
+                                         * root) have one. */
 };
 
 
@@ -209,6 +214,9 @@ struct _GtkTextBTree {
   guint end_iter_segment_stamp;
   
   GHashTable *child_anchor_table;
+
+  /* Number of nodes that have a search chunk */
+  guint n_search_chunks;
 };
 
 
@@ -332,6 +340,12 @@ static void redisplay_region (GtkTextBTree      *tree,
                               const GtkTextIter *end,
                               gboolean           cursors_only);
 
+static void gtk_text_btree_node_clear_search_chunk (GtkTextBTree     *tree,
+                                                    GtkTextBTreeNode *node);
+static void invalidate_search_chunks               (GtkTextBTree     *tree,
+                                                    GtkTextLine      *start_line,
+                                                    GtkTextLine      *end_line);
+
 /* Inline thingies */
 
 static inline void
@@ -748,6 +762,9 @@ _gtk_text_btree_delete (GtkTextIter *start,
   /* Broadcast the need for redisplay before we break the iterators */
   DV (g_print ("invalidating due to deleting some text (%s)\n", G_STRLOC));
   _gtk_text_btree_invalidate_region (tree, start, end, FALSE);
+  invalidate_search_chunks (tree,
+                            _gtk_text_iter_get_text_line (start),
+                            _gtk_text_iter_get_text_line (end));
 
   /* Save the byte offset so we can reset the iterators */
   start_byte_offset = gtk_text_iter_get_line_index (start);
@@ -1214,6 +1231,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
     }
 
   post_insert_fixup (tree, line, line_count_delta, char_count_delta);
+  invalidate_search_chunks (tree, start_line, line);
 
   /* Invalidate our region, and reset the iterator the user
      passed in to point to the end of the inserted text. */
@@ -1244,6 +1262,498 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   }
 }
 
+/*
+ * Bulk loading
+ *
+ * A builder chops text into lines and assembles complete, balanced
+ * nodes bottom-up as the lines come in, without looking at any tree.
+ * That makes it usable from a thread; only _gtk_text_btree_load()
+ * needs to run where the tree lives.
+ */
+
+struct _GtkTextBTreeBuilder {
+  /* Text after the last paragraph delimiter seen so far */
+  GString *pending;
+  gsize pending_start;
+  gsize scan_from;
+
+  /* The node being filled at each level, and its last child */
+  GPtrArray *nodes;
+  GPtrArray *tails;
+
+  GtkTextLine *first_line;
+  GtkTextLine *last_line;
+
+  /* Lines whose backward bidi direction is still unknown */
+  GPtrArray *neutral_lines;
+  PangoDirection last_strong;
+};
+
+GtkTextBTreeBuilder *
+_gtk_text_btree_builder_new (void)
+{
+  GtkTextBTreeBuilder *builder;
+
+  builder = g_slice_new0 (GtkTextBTreeBuilder);
+  builder->pending = g_string_new (NULL);
+  builder->nodes = g_ptr_array_new ();
+  builder->tails = g_ptr_array_new ();
+  builder->neutral_lines = g_ptr_array_new ();
+  builder->last_strong = PANGO_DIRECTION_NEUTRAL;
+
+  return builder;
+}
+
+static void
+gtk_text_btree_builder_add_child (GtkTextBTreeBuilder *builder,
+                                  guint                level,
+                                  gpointer             child,
+                                  int                  num_lines,
+                                  int                  num_chars);
+
+static void
+gtk_text_btree_builder_close_node (GtkTextBTreeBuilder *builder,
+                                   guint                level)
+{
+  GtkTextBTreeNode *node = g_ptr_array_index (builder->nodes, level);
+
+  builder->nodes->pdata[level] = NULL;
+  builder->tails->pdata[level] = NULL;
+
+  gtk_text_btree_builder_add_child (builder, level + 1, node,
+                                    node->num_lines, node->num_chars);
+}
+
+static void
+gtk_text_btree_builder_add_child (GtkTextBTreeBuilder *builder,
+                                  guint                level,
+                                  gpointer             child,
+                                  int                  num_lines,
+                                  int                  num_chars)
+{
+  GtkTextBTreeNode *node;
+  gpointer tail;
+
+  if (level == builder->nodes->len)
+    {
+      g_ptr_array_add (builder->nodes, NULL);
+      g_ptr_array_add (builder->tails, NULL);
+    }
+
+  /* Full nodes are done; only the last node of each level can end
+   * up with too few children, and gtk_text_btree_rebalance() takes
+   * care of those once the tree is in place.
+   */
+  node = g_ptr_array_index (builder->nodes, level);
+  if (node != NULL && node->num_children == MAX_CHILDREN)
+    {
+      gtk_text_btree_builder_close_node (builder, level);
+      node = NULL;
+    }
+
+  if (node == NULL)
+    {
+      node = gtk_text_btree_node_new ();
+      node->parent = NULL;
+      node->next = NULL;
+      node->summary = NULL;
+      node->level = level;
+      node->num_lines = 0;
+      node->num_chars = 0;
+      node->num_children = 0;
+      node->children.node = NULL;
+
+      builder->nodes->pdata[level] = node;
+    }
+
+  tail = g_ptr_array_index (builder->tails, level);
+
+  if (level == 0)
+    {
+      GtkTextLine *line = child;
+
+      line->parent = node;
+      if (tail)
+        ((GtkTextLine *) tail)->next = line;
+      else
+        node->children.line = line;
+    }
+  else
+    {
+      GtkTextBTreeNode *child_node = child;
+
+      child_node->parent = node;
+      if (tail)
+        ((GtkTextBTreeNode *) tail)->next = child_node;
+      else
+        node->children.node = child_node;
+    }
+
+  builder->tails->pdata[level] = child;
+
+  node->num_children++;
+  node->num_lines += num_lines;
+  node->num_chars += num_chars;
+}
+
+static void
+gtk_text_btree_builder_add_line (GtkTextBTreeBuilder *builder,
+                                 GtkTextLineSegment  *seg)
+{
+  GtkTextLine *line;
+  PangoDirection dir;
+  guint i;
+
+  line = gtk_text_line_new ();
+  line->segments = seg;
+
+  /* Same as gtk_text_btree_resolve_bidi(), in a single pass */
+  dir = gdk_find_base_dir (seg->body.chars, seg->byte_count);
+  line->dir_strong = dir;
+  if (dir != PANGO_DIRECTION_NEUTRAL)
+    {
+      for (i = 0; i < builder->neutral_lines->len; i++)
+        ((GtkTextLine *) g_ptr_array_index (builder->neutral_lines, i))->dir_propagated_back = dir;
+      g_ptr_array_set_size (builder->neutral_lines, 0);
+
+      builder->last_strong = dir;
+      line->dir_propagated_back = dir;
+    }
+  else
+    g_ptr_array_add (builder->neutral_lines, line);
+  line->dir_propagated_forward = builder->last_strong;
+
+  if (builder->first_line == NULL)
+    builder->first_line = line;
+  builder->last_line = line;
+
+  gtk_text_btree_builder_add_child (builder, 0, line, 1, seg->char_count);
+}
+
+static GtkTextLineSegment *
+char_segment_new_validated (const char *text,
+                            gsize       len)
+{
+  GtkTextLineSegment *seg;
+  char *valid;
+
+  if (g_utf8_validate (text, len, NULL))
+    return _gtk_char_segment_new (text, len);
+
+  valid = g_utf8_make_valid (text, len);
+  seg = _gtk_char_segment_new (valid, strlen (valid));
+  g_free (valid);
+
+  return seg;
+}
+
+/* Turns all complete paragraphs in @text into lines, starting the
+ * search for delimiters at @scan_from. Returns the length of the
+ * consumed text and sets @scan_from to where the next search has to
+ * start once more text is available.
+ */
+static gsize
+gtk_text_btree_builder_add_lines (GtkTextBTreeBuilder *builder,
+                                  const char          *text,
+                                  gsize                len,
+                                  gsize               *scan_from)
+{
+  gsize sol = 0;
+  gsize i = *scan_from;
+
+  while (i < len)
+    {
+      const guchar c = text[i];
+      gsize eol;
+
+      /* The same delimiters as pango_find_paragraph_boundary() */
+      if (c == '\n')
+        eol = i + 1;
+      else if (c == '\r')
+        {
+          if (i + 1 == len)
+            break;
+          eol = text[i + 1] == '\n' ? i + 2 : i + 1;
+        }
+      else if (c == 0xe2)
+        {
+          if (i + 2 >= len)
+            break;
+          if ((guchar) text[i + 1] != 0x80 || (guchar) text[i + 2] != 0xa9)
+            {
+              i++;
+              continue;
+            }
+          eol = i + 3;
+        }
+      else
+        {
+          i++;
+          continue;
+        }
+
+      gtk_text_btree_builder_add_line (builder,
+                                       char_segment_new_validated (text + sol, eol - sol));
+      sol = i = eol;
+    }
+
+  *scan_from = i - sol;
+
+  return sol;
+}
+
+/*
+ * _gtk_text_btree_builder_append:
+ * @builder: a `GtkTextBTreeBuilder`
+ * @text: text, not necessarily valid UTF-8
+ * @len: length of @text in bytes
+ *
+ * Adds @text to the end of the text built so far. The text may be
+ * split anywhere, even in the middle of a character or of a "\r\n"
+ * sequence. Invalid UTF-8 is replaced.
+ */
+void
+_gtk_text_btree_builder_append (GtkTextBTreeBuilder *builder,
+                                const char          *text,
+                                gsize                len)
+{
+  gsize consumed;
+
+  if (len == 0)
+    return;
+
+  if (builder->pending->len == builder->pending_start)
+    {
+      /* Common case: take the lines straight out of @text */
+      gsize scan_from = 0;
+
+      consumed = gtk_text_btree_builder_add_lines (builder, text, len, &scan_from);
+
+      g_string_truncate (builder->pending, 0);
+      g_string_append_len (builder->pending, text + consumed, len - consumed);
+      builder->pending_start = 0;
+      builder->scan_from = scan_from;
+      return;
+    }
+
+  g_string_append_len (builder->pending, text, len);
+
+  consumed = gtk_text_btree_builder_add_lines (builder,
+                                               builder->pending->str + builder->pending_start,
+                                               builder->pending->len - builder->pending_start,
+                                               &builder->scan_from);
+  builder->pending_start += consumed;
+
+  /* Don't move a long line around for every chunk */
+  if (builder->pending_start > builder->pending->len / 2)
+    {
+      g_string_erase (builder->pending, 0, builder->pending_start);
+      builder->pending_start = 0;
+    }
+}
+
+static GtkTextBTreeNode *
+gtk_text_btree_builder_finish (GtkTextBTreeBuilder *builder)
+{
+  const char *text = builder->pending->str + builder->pending_start;
+  gsize len = builder->pending->len - builder->pending_start;
+  GtkTextLineSegment *seg;
+  guint level;
+
+  /* A lone "\r" or a truncated character at the very end */
+  if (builder->scan_from < len)
+    {
+      gsize consumed = 0;
+      gsize i;
+
+      for (i = builder->scan_from; i < len; i++)
+        {
+          if (text[i] == '\r')
+            {
+              gtk_text_btree_builder_add_line (builder,
+                                               char_segment_new_validated (text + consumed, i + 1 - consumed));
+              consumed = i + 1;
+            }
+        }
+
+      text += consumed;
+      len -= consumed;
+    }
+
+  /* The last line ends in the newline that's not part of the text */
+  if (g_utf8_validate (text, len, NULL))
+    seg = _gtk_char_segment_new_from_two_strings (text, len, g_utf8_strlen (text, len),
+                                                  "\n", 1, 1);
+  else
+    {
+      char *valid = g_utf8_make_valid (text, len);
+
+      seg = _gtk_char_segment_new_from_two_strings (valid, strlen (valid), g_utf8_strlen (valid, -1),
+                                                    "\n", 1, 1);
+      g_free (valid);
+    }
+  gtk_text_btree_builder_add_line (builder, seg);
+
+  for (level = 0; level + 1 < builder->nodes->len; level++)
+    {
+      if (g_ptr_array_index (builder->nodes, level) != NULL)
+        gtk_text_btree_builder_close_node (builder, level);
+    }
+
+  return g_ptr_array_index (builder->nodes, builder->nodes->len - 1);
+}
+
+static void
+gtk_text_btree_builder_free_tree (GtkTextBTreeNode *node)
+{
+  if (node->level == 0)
+    {
+      GtkTextLine *line, *next;
+
+      for (line = node->children.line; line; line = next)
+        {
+          next = line->next;
+          while (line->segments != NULL)
+            {
+              GtkTextLineSegment *seg = line->segments;
+
+              line->segments = seg->next;
+              (*seg->type->deleteFunc) (seg, line, TRUE);
+            }
+          g_slice_free (GtkTextLine, line);
+        }
+    }
+  else
+    {
+      GtkTextBTreeNode *child, *next;
+
+      for (child = node->children.node; child; child = next)
+        {
+          next = child->next;
+          gtk_text_btree_builder_free_tree (child);
+        }
+    }
+
+  g_slice_free (GtkTextBTreeNode, node);
+}
+
+/*
+ * _gtk_text_btree_builder_free:
+ * @builder: a `GtkTextBTreeBuilder`
+ *
+ * Frees a builder that has not been passed to _gtk_text_btree_load(),
+ * along with all the lines built so far.
+ */
+void
+_gtk_text_btree_builder_free (GtkTextBTreeBuilder *builder)
+{
+  guint level;
+
+  /* Open nodes are not linked into their parents yet */
+  for (level = 0; level < builder->nodes->len; level++)
+    {
+      GtkTextBTreeNode *node = g_ptr_array_index (builder->nodes, level);
+
+      if (node)
+        gtk_text_btree_builder_free_tree (node);
+    }
+
+  g_ptr_array_unref (builder->nodes);
+  g_ptr_array_unref (builder->tails);
+  g_ptr_array_unref (builder->neutral_lines);
+  g_string_free (builder->pending, TRUE);
+  g_slice_free (GtkTextBTreeBuilder, builder);
+}
+
+/*
+ * _gtk_text_btree_load:
+ * @tree: an empty `GtkTextBTree`
+ * @builder: (transfer full): the text to load
+ *
+ * Replaces the contents of an empty @tree with the lines built by
+ * @builder, in one go. The marks in @tree stay at the start.
+ */
+void
+_gtk_text_btree_load (GtkTextBTree        *tree,
+                      GtkTextBTreeBuilder *builder)
+{
+  GtkTextBTreeNode *root, *node, *old_root;
+  GtkTextLine *first_line, *last_line, *line, *extra_line;
+  GtkTextLineSegment *seg, **prev_p;
+  GtkTextIter start, end;
+
+  g_return_if_fail (tree->root_node->num_lines == 2);
+  g_return_if_fail (tree->root_node->num_chars == 2);
+
+  root = gtk_text_btree_builder_finish (builder);
+  first_line = builder->first_line;
+  last_line = builder->last_line;
+
+  /* Keep the existing line objects, views and marks refer to them */
+  old_root = tree->root_node;
+  line = _gtk_text_btree_get_line (tree, 0, NULL);
+  extra_line = _gtk_text_line_next (line);
+
+  line->parent->children.line = NULL;
+  extra_line->parent->children.line = NULL;
+  gtk_text_btree_node_destroy (tree, old_root);
+
+  /* Only marks remain in an empty buffer, next to its newline */
+  prev_p = &line->segments;
+  while ((seg = *prev_p) != NULL)
+    {
+      if (seg->type == &gtk_text_char_type)
+        {
+          *prev_p = seg->next;
+          (*seg->type->deleteFunc) (seg, line, TRUE);
+        }
+      else
+        prev_p = &seg->next;
+    }
+  *prev_p = first_line->segments;
+
+  line->dir_strong = first_line->dir_strong;
+  line->dir_propagated_forward = first_line->dir_propagated_forward;
+  line->dir_propagated_back = first_line->dir_propagated_back;
+  line->next = first_line->next;
+  line->parent = first_line->parent;
+  line->parent->children.line = line;
+  if (last_line == first_line)
+    last_line = line;
+  g_slice_free (GtkTextLine, first_line);
+
+  extra_line->next = NULL;
+  extra_line->parent = last_line->parent;
+  last_line->next = extra_line;
+  extra_line->parent->num_children++;
+  for (node = extra_line->parent; node != NULL; node = node->parent)
+    {
+      node->num_lines++;
+      node->num_chars++;
+    }
+
+  /* Now owned by the tree */
+  g_ptr_array_set_size (builder->nodes, 0);
+  _gtk_text_btree_builder_free (builder);
+
+  tree->root_node = root;
+  gtk_text_btree_rebalance (tree, extra_line->parent);
+
+  chars_changed (tree);
+  segments_changed (tree);
+
+  _gtk_text_btree_get_iter_at_line (tree, &start, line, 0);
+  _gtk_text_btree_get_end_iter (tree, &end);
+
+  DV (g_print ("invalidating due to loading text (%s)\n", G_STRLOC));
+  _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
+
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DEBUG_CHECK (TEXT))
+    _gtk_text_btree_check (tree);
+#endif
+}
+
 static void
 insert_paintable_or_widget_segment (GtkTextIter        *iter,
                                     GtkTextLineSegment *seg)
@@ -1271,6 +1781,7 @@ insert_paintable_or_widget_segment (GtkTextIter        *iter,
     }
 
   post_insert_fixup (tree, line, 0, seg->char_count);
+  invalidate_search_chunks (tree, line, line);
 
   chars_changed (tree);
   segments_changed (tree);
@@ -1651,6 +2162,223 @@ _gtk_text_btree_get_view_size (GtkTextBTree *tree,
                                 width, height);
 }
 
+/*
+ * Search chunks
+ *
+ * To search large buffers we keep the text of the lines below each
+ * level 1 node in one flat string, so that it can be scanned with
+ * strstr() instead of being pulled out of the segments line by line.
+ * Chunks are built on demand, and dropped whenever the characters
+ * or lines below their node change.
+ */
+
+static GtkTextBTreeNode *
+search_chunk_node (GtkTextLine *line)
+{
+  GtkTextBTreeNode *node = line->parent;
+
+  if (node->parent != NULL)
+    node = node->parent;
+
+  return node;
+}
+
+static void
+search_chunk_free (GtkTextSearchChunk *chunk)
+{
+  g_free (chunk->lines);
+  g_free (chunk->text);
+  g_free (chunk->offsets);
+  g_free (chunk->caseless);
+  g_free (chunk->caseless_offsets);
+  g_slice_free (GtkTextSearchChunk, chunk);
+}
+
+static void
+gtk_text_btree_node_clear_search_chunk (GtkTextBTree     *tree,
+                                        GtkTextBTreeNode *node)
+{
+  if (node->search_chunk == NULL)
+    return;
+
+  search_chunk_free (node->search_chunk);
+  node->search_chunk = NULL;
+  tree->n_search_chunks--;
+}
+
+static void
+invalidate_search_chunks (GtkTextBTree *tree,
+                          GtkTextLine  *start_line,
+                          GtkTextLine  *end_line)
+{
+  GtkTextBTreeNode *node = NULL;
+  GtkTextLine *line;
+
+  for (line = start_line;
+       line != NULL && tree->n_search_chunks > 0;
+       line = _gtk_text_line_next (line))
+    {
+      if (line->parent != node)
+        {
+          node = line->parent;
+          gtk_text_btree_node_clear_search_chunk (tree, node);
+          if (node->parent != NULL)
+            gtk_text_btree_node_clear_search_chunk (tree, node->parent);
+        }
+
+      if (line == end_line)
+        break;
+    }
+}
+
+static void
+search_chunk_add_lines (GtkTextBTree       *tree,
+                        GtkTextSearchChunk *chunk,
+                        GString            *text,
+                        GtkTextBTreeNode   *leaf)
+{
+  GtkTextLine *line;
+  GtkTextLineSegment *seg;
+
+  for (line = leaf->children.line; line != NULL; line = line->next)
+    {
+      /* The last line is never searched */
+      if (_gtk_text_line_is_last (line, tree))
+        break;
+
+      chunk->lines[chunk->n_lines] = line;
+      chunk->offsets[chunk->n_lines] = text->len;
+      chunk->n_lines++;
+
+      for (seg = line->segments; seg != NULL; seg = seg->next)
+        {
+          if (seg->type == &gtk_text_char_type)
+            {
+              g_string_append_len (text, seg->body.chars, seg->byte_count);
+            }
+          else if (seg->byte_count > 0)
+            {
+              g_assert (seg->byte_count == GTK_TEXT_UNKNOWN_CHAR_UTF8_LEN);
+              g_string_append_len (text, _gtk_text_unknown_char_utf8,
+                                   GTK_TEXT_UNKNOWN_CHAR_UTF8_LEN);
+              chunk->has_unknown_chars = TRUE;
+            }
+        }
+    }
+}
+
+static GtkTextSearchChunk *
+search_chunk_new (GtkTextBTree     *tree,
+                  GtkTextBTreeNode *node)
+{
+  GtkTextSearchChunk *chunk;
+  GtkTextBTreeNode *child;
+  GString *text;
+
+  chunk = g_slice_new0 (GtkTextSearchChunk);
+  chunk->lines = g_new (GtkTextLine *, node->num_lines);
+  chunk->offsets = g_new (int, node->num_lines + 1);
+
+  /* Roughly the size of the text, assuming mostly ASCII */
+  text = g_string_sized_new (node->num_chars + 1);
+
+  if (node->level == 0)
+    search_chunk_add_lines (tree, chunk, text, node);
+  else
+    {
+      for (child = node->children.node; child != NULL; child = child->next)
+        search_chunk_add_lines (tree, chunk, text, child);
+    }
+
+  chunk->offsets[chunk->n_lines] = text->len;
+  chunk->text = g_string_free (text, FALSE);
+
+  return chunk;
+}
+
+static void
+search_chunk_ensure_caseless (GtkTextSearchChunk *chunk)
+{
+  GString *caseless;
+  char *casefold, *normal;
+  int i;
+
+  if (chunk->caseless != NULL)
+    return;
+
+  caseless = g_string_sized_new (chunk->offsets[chunk->n_lines] + 1);
+  chunk->caseless_offsets = g_new (int, chunk->n_lines + 1);
+
+  /* Fold each line by itself, the same way utf8_strcasestr() in
+   * gtktextiter.c does, so that offsets can be mapped back per line
+   */
+  for (i = 0; i < chunk->n_lines; i++)
+    {
+      chunk->caseless_offsets[i] = caseless->len;
+
+      casefold = g_utf8_casefold (chunk->text + chunk->offsets[i],
+                                  chunk->offsets[i + 1] - chunk->offsets[i]);
+      normal = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFD);
+      g_string_append (caseless, normal);
+      g_free (normal);
+      g_free (casefold);
+    }
+
+  chunk->caseless_offsets[chunk->n_lines] = caseless->len;
+  chunk->caseless = g_string_free (caseless, FALSE);
+}
+
+/*
+ * _gtk_text_btree_get_search_chunk:
+ * @tree: a `GtkTextBTree`
+ * @line: a line in @tree
+ * @caseless: whether the casefolded text is needed, too
+ * @line_index: (out): return location for the index of @line in the chunk
+ *
+ * Returns the search chunk containing @line, building it if needed.
+ * The chunk stays valid until the text of the tree is changed.
+ *
+ * Returns: the chunk, or %NULL if @line is the last line
+ */
+const GtkTextSearchChunk *
+_gtk_text_btree_get_search_chunk (GtkTextBTree *tree,
+                                  GtkTextLine  *line,
+                                  gboolean      caseless,
+                                  int          *line_index)
+{
+  GtkTextBTreeNode *node;
+  GtkTextSearchChunk *chunk;
+  int i;
+
+  if (_gtk_text_line_is_last (line, tree))
+    return NULL;
+
+  node = search_chunk_node (line);
+
+  if (node->search_chunk == NULL)
+    {
+      node->search_chunk = search_chunk_new (tree, node);
+      tree->n_search_chunks++;
+    }
+
+  chunk = node->search_chunk;
+
+  for (i = 0; i < chunk->n_lines; i++)
+    {
+      if (chunk->lines[i] == line)
+        break;
+    }
+
+  g_assert (i < chunk->n_lines);
+
+  if (caseless)
+    search_chunk_ensure_caseless (chunk);
+
+  *line_index = i;
+
+  return chunk;
+}
+
 /*
  * Tag
  */
@@ -4864,6 +5592,7 @@ gtk_text_btree_node_new (void)
   node = g_slice_new (GtkTextBTreeNode);
 
   node->node_data = NULL;
+  node->search_chunk = NULL;
 
   return node;
 }
@@ -5429,6 +6158,100 @@ _gtk_text_btree_validate_line (GtkTextBTree     *tree,
     }
 }
 
+static GtkTextLine *
+gtk_text_btree_node_find_invalid_line (GtkTextBTreeNode *node,
+                                       gpointer          view_id)
+{
+  NodeData *nd;
+
+  nd = node_data_find (node->node_data, view_id);
+  if (nd && nd->valid)
+    return NULL;
+
+  if (node->level == 0)
+    {
+      GtkTextLine *line;
+
+      for (line = node->children.line; line != NULL; line = line->next)
+        {
+          GtkTextLineData *ld = _gtk_text_line_get_data (line, view_id);
+
+          if (!ld || !ld->valid)
+            return line;
+        }
+    }
+  else
+    {
+      GtkTextBTreeNode *child;
+
+      for (child = node->children.node; child != NULL; child = child->next)
+        {
+          GtkTextLine *line = gtk_text_btree_node_find_invalid_line (child, view_id);
+
+          if (line)
+            return line;
+        }
+    }
+
+  return NULL;
+}
+
+/**
+ * _gtk_text_btree_find_invalid_line:
+ * @tree: a GtkTextBTree
+ * @view_id: view ID for the view to look at
+ * @after: (nullable): line to start after, or %NULL to start at
+ *   the first line
+ *
+ * Finds the first line after @after that is not valid for the
+ * given view. Subtrees that are entirely valid are skipped, so this
+ * is cheap even in large buffers when most lines are valid.
+ *
+ * Returns: (nullable): the line, or %NULL if all lines are valid
+ **/
+GtkTextLine *
+_gtk_text_btree_find_invalid_line (GtkTextBTree *tree,
+                                   gpointer      view_id,
+                                   GtkTextLine  *after)
+{
+  GtkTextBTreeNode *node;
+  GtkTextLine *result = NULL;
+
+  g_return_val_if_fail (tree != NULL, NULL);
+
+  if (after == NULL)
+    {
+      result = gtk_text_btree_node_find_invalid_line (tree->root_node, view_id);
+    }
+  else
+    {
+      GtkTextLine *l;
+
+      for (l = after->next; l != NULL && result == NULL; l = l->next)
+        {
+          GtkTextLineData *ld = _gtk_text_line_get_data (l, view_id);
+
+          if (!ld || !ld->valid)
+            result = l;
+        }
+
+      /* Continue with the siblings of the nodes above @after */
+      for (node = after->parent; node != NULL && result == NULL; node = node->parent)
+        {
+          GtkTextBTreeNode *sibling;
+
+          for (sibling = node->next; sibling != NULL && result == NULL; sibling = sibling->next)
+            result = gtk_text_btree_node_find_invalid_line (sibling, view_id);
+        }
+    }
+
+  /* The last line is not part of the text */
+  if (result == get_last_line (tree))
+    result = NULL;
+
+  return result;
+}
+
 static void
 gtk_text_btree_node_remove_view (BTreeView *view, GtkTextBTreeNode *node, gpointer view_id)
 {
@@ -5513,6 +6336,7 @@ gtk_text_btree_node_free_empty (GtkTextBTree *tree,
 
   summary_list_destroy (node->summary);
   node_data_list_destroy (node->node_data);
+  gtk_text_btree_node_clear_search_chunk (tree, node);
   g_slice_free (GtkTextBTreeNode, node);
 }
 
@@ -6172,6 +6996,9 @@ recompute_node_counts (GtkTextBTree *tree, GtkTextBTreeNode *node)
   node->num_lines = 0;
   node->num_chars = 0;
 
+  /* Lines may have moved in or out of the node */
+  gtk_text_btree_node_clear_search_chunk (tree, node);
+
   /*
    * Scan through the children, adding the childrens’ tag counts into
    * the GtkTextBTreeNode’s tag counts and adding new Summary structures if
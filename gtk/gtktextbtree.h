@@ -74,8 +74,42 @@ void _gtk_text_btree_insert_paintable (GtkTextIter  *iter,
 void _gtk_text_btree_insert_child_anchor (GtkTextIter        *iter,
                                           GtkTextChildAnchor *anchor);
 
+/* Bulk loading */
+
+typedef struct _GtkTextBTreeBuilder GtkTextBTreeBuilder;
+
+GtkTextBTreeBuilder *_gtk_text_btree_builder_new    (void);
+void                 _gtk_text_btree_builder_append (GtkTextBTreeBuilder *builder,
+                                                     const char          *text,
+                                                     gsize                len);
+void                 _gtk_text_btree_builder_free   (GtkTextBTreeBuilder *builder);
+void                 _gtk_text_btree_load           (GtkTextBTree        *tree,
+                                                     GtkTextBTreeBuilder *builder);
+
 void _gtk_text_btree_unregister_child_anchor (GtkTextChildAnchor *anchor);
 
+/* Search */
+
+typedef struct _GtkTextSearchChunk GtkTextSearchChunk;
+
+struct _GtkTextSearchChunk
+{
+  GtkTextLine **lines;          /* the lines in the chunk */
+  int           n_lines;
+  char         *text;           /* the slices of all lines, including
+                                 * paragraph delimiters */
+  int          *offsets;        /* n_lines + 1 byte offsets into text */
+  char         *caseless;       /* casefolded and NFD normalized text,
+                                 * or NULL if not needed yet */
+  int          *caseless_offsets;
+  guint         has_unknown_chars : 1;
+};
+
+const GtkTextSearchChunk *_gtk_text_btree_get_search_chunk (GtkTextBTree *tree,
+                                                            GtkTextLine  *line,
+                                                            gboolean      caseless,
+                                                            int          *line_index);
+
 /* View stuff */
 GtkTextLine *_gtk_text_btree_find_line_by_y    (GtkTextBTree      *tree,
                                                 gpointer           view_id,
@@ -107,6 +141,9 @@ gboolean     _gtk_text_btree_validate          (GtkTextBTree      *tree,
 void         _gtk_text_btree_validate_line     (GtkTextBTree      *tree,
                                                 GtkTextLine       *line,
                                                 gpointer           view_id);
+GtkTextLine *_gtk_text_btree_find_invalid_line (GtkTextBTree      *tree,
+                                                gpointer           view_id,
+                                                GtkTextLine       *after);
 
 /* Tag */
 
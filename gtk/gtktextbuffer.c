@@ -39,6 +39,7 @@
 #include "gtkintl.h"
 
 #define DEFAULT_MAX_UNDO 200
+#define DEFAULT_MAX_UNDO_BYTES (64 * 1024 * 1024)
 
 /**
  * GtkTextBuffer:
@@ -941,6 +942,7 @@ gtk_text_buffer_init (GtkTextBuffer *buffer)
   buffer->priv->history = gtk_text_history_new (&history_funcs, buffer);
 
   gtk_text_history_set_max_undo_levels (buffer->priv->history, DEFAULT_MAX_UNDO);
+  gtk_text_history_set_max_undo_bytes (buffer->priv->history, DEFAULT_MAX_UNDO_BYTES);
 }
 
 static void
@@ -1186,6 +1188,271 @@ gtk_text_buffer_set_text (GtkTextBuffer *buffer,
   gtk_text_history_end_irreversible_action (buffer->priv->history);
 }
 
+/*
+ * Bulk loading
+ */
+
+#define LOAD_CHUNK_SIZE (1024 * 1024)
+
+static void
+gtk_text_buffer_load_builder (GtkTextBuffer       *buffer,
+                              GtkTextBTreeBuilder *builder)
+{
+  GtkTextIter start, end;
+
+  gtk_text_history_begin_irreversible_action (buffer->priv->history);
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  gtk_text_buffer_delete (buffer, &start, &end);
+
+  _gtk_text_btree_load (get_btree (buffer), builder);
+
+  g_signal_emit (buffer, signals[CHANGED], 0);
+  g_object_notify_by_pspec (G_OBJECT (buffer), text_buffer_props[PROP_CURSOR_POSITION]);
+
+  gtk_text_history_end_irreversible_action (buffer->priv->history);
+}
+
+/**
+ * gtk_text_buffer_load_bytes:
+ * @buffer: a `GtkTextBuffer`
+ * @bytes: UTF-8 text
+ *
+ * Deletes current contents of @buffer, and loads the text
+ * in @bytes instead.
+ *
+ * The result is the same as with [method@Gtk.TextBuffer.set_text],
+ * but large texts load a lot faster: the lines are assembled
+ * directly, and instead of [signal@Gtk.TextBuffer::insert-text],
+ * only [signal@Gtk.TextBuffer::changed] is emitted.
+ *
+ * Invalid UTF-8 in @bytes is replaced with U+FFFD.
+ *
+ * Since: 4.4
+ */
+void
+gtk_text_buffer_load_bytes (GtkTextBuffer *buffer,
+                            GBytes        *bytes)
+{
+  GtkTextBTreeBuilder *builder;
+  gconstpointer data;
+  gsize size;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (bytes != NULL);
+
+  data = g_bytes_get_data (bytes, &size);
+
+  builder = _gtk_text_btree_builder_new ();
+  _gtk_text_btree_builder_append (builder, data, size);
+
+  gtk_text_buffer_load_builder (buffer, builder);
+}
+
+typedef struct {
+  GInputStream *stream;
+  GtkTextBTreeBuilder *builder;
+
+  GFileProgressCallback progress_callback;
+  gpointer progress_data;
+
+  GMutex mutex;
+  goffset current;
+  goffset total;
+  gboolean progress_pending;
+  gboolean done;
+} LoadData;
+
+static void
+load_data_free (gpointer data)
+{
+  LoadData *load = data;
+
+  g_object_unref (load->stream);
+  g_clear_pointer (&load->builder, _gtk_text_btree_builder_free);
+  g_mutex_clear (&load->mutex);
+  g_slice_free (LoadData, load);
+}
+
+static gboolean
+load_progress_cb (gpointer data)
+{
+  GTask *task = data;
+  LoadData *load = g_task_get_task_data (task);
+  goffset current, total;
+
+  g_mutex_lock (&load->mutex);
+  current = load->current;
+  total = load->total;
+  load->progress_pending = FALSE;
+  g_mutex_unlock (&load->mutex);
+
+  if (!load->done)
+    load->progress_callback (current, total, load->progress_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+load_stream_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  LoadData *load = task_data;
+  GError *error = NULL;
+  char *chunk;
+  gssize n_read;
+
+  if (G_IS_SEEKABLE (load->stream) && g_seekable_can_seek (G_SEEKABLE (load->stream)))
+    {
+      goffset pos = g_seekable_tell (G_SEEKABLE (load->stream));
+
+      if (g_seekable_seek (G_SEEKABLE (load->stream), 0, G_SEEK_END, cancellable, NULL))
+        {
+          load->total = g_seekable_tell (G_SEEKABLE (load->stream)) - pos;
+          g_seekable_seek (G_SEEKABLE (load->stream), pos, G_SEEK_SET, cancellable, NULL);
+        }
+    }
+
+  chunk = g_malloc (LOAD_CHUNK_SIZE);
+
+  while ((n_read = g_input_stream_read (load->stream, chunk, LOAD_CHUNK_SIZE,
+                                        cancellable, &error)) > 0)
+    {
+      _gtk_text_btree_builder_append (load->builder, chunk, n_read);
+
+      if (load->progress_callback)
+        {
+          g_mutex_lock (&load->mutex);
+          load->current += n_read;
+          if (!load->progress_pending)
+            {
+              load->progress_pending = TRUE;
+              g_main_context_invoke_full (g_task_get_context (task),
+                                          g_task_get_priority (task),
+                                          load_progress_cb,
+                                          g_object_ref (task),
+                                          g_object_unref);
+            }
+          g_mutex_unlock (&load->mutex);
+        }
+    }
+
+  g_free (chunk);
+
+  if (n_read < 0)
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+load_stream_done (GObject      *source,
+                  GAsyncResult *result,
+                  gpointer      data)
+{
+  GtkTextBuffer *buffer = GTK_TEXT_BUFFER (source);
+  GTask *task = data;
+  LoadData *load = g_task_get_task_data (G_TASK (result));
+  GError *error = NULL;
+
+  load->done = TRUE;
+
+  if (g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      gtk_text_buffer_load_builder (buffer, g_steal_pointer (&load->builder));
+      g_task_return_boolean (task, TRUE);
+    }
+  else
+    g_task_return_error (task, error);
+
+  g_object_unref (task);
+}
+
+/**
+ * gtk_text_buffer_load_stream_async:
+ * @buffer: a `GtkTextBuffer`
+ * @stream: the `GInputStream` to read UTF-8 text from
+ * @io_priority: the I/O priority of the request
+ * @cancellable: (nullable): optional `GCancellable` object
+ * @progress_callback: (nullable) (scope call): function to call with
+ *   the number of bytes read so far
+ * @progress_data: (closure progress_callback): data to pass to
+ *   @progress_callback
+ * @callback: (scope async): callback to call when the text is loaded
+ * @user_data: (closure): data to pass to @callback
+ *
+ * Reads @stream to the end in a thread, and replaces the contents
+ * of @buffer with it when done, like [method@Gtk.TextBuffer.load_bytes].
+ *
+ * The buffer is not changed until the stream has been read
+ * successfully. The total size passed to @progress_callback is
+ * 0 if it can't be determined.
+ *
+ * Since: 4.4
+ */
+void
+gtk_text_buffer_load_stream_async (GtkTextBuffer         *buffer,
+                                   GInputStream          *stream,
+                                   int                    io_priority,
+                                   GCancellable          *cancellable,
+                                   GFileProgressCallback  progress_callback,
+                                   gpointer               progress_data,
+                                   GAsyncReadyCallback    callback,
+                                   gpointer               user_data)
+{
+  GTask *task, *thread_task;
+  LoadData *load;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (G_IS_INPUT_STREAM (stream));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (buffer, cancellable, callback, user_data);
+  g_task_set_priority (task, io_priority);
+  g_task_set_source_tag (task, gtk_text_buffer_load_stream_async);
+
+  load = g_slice_new0 (LoadData);
+  load->stream = g_object_ref (stream);
+  load->builder = _gtk_text_btree_builder_new ();
+  load->progress_callback = progress_callback;
+  load->progress_data = progress_data;
+  g_mutex_init (&load->mutex);
+
+  /* The buffer has to be updated by the time @callback runs */
+  thread_task = g_task_new (buffer, cancellable, load_stream_done, task);
+  g_task_set_priority (thread_task, io_priority);
+  g_task_set_task_data (thread_task, load, load_data_free);
+  g_task_run_in_thread (thread_task, load_stream_thread);
+  g_object_unref (thread_task);
+}
+
+/**
+ * gtk_text_buffer_load_stream_finish:
+ * @buffer: a `GtkTextBuffer`
+ * @result: a `GAsyncResult`
+ * @error: return location for a `GError`
+ *
+ * Finishes an operation started with
+ * [method@Gtk.TextBuffer.load_stream_async].
+ *
+ * Returns: %TRUE if the text has been loaded
+ *
+ * Since: 4.4
+ */
+gboolean
+gtk_text_buffer_load_stream_finish (GtkTextBuffer  *buffer,
+                                    GAsyncResult   *result,
+                                    GError        **error)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, buffer), FALSE);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gtk_text_buffer_load_stream_async, FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /*
  * Insertion
  */
@@ -5086,6 +5353,9 @@ gtk_text_buffer_get_max_undo_levels (GtkTextBuffer *buffer)
  * If 0, unlimited undo actions may be performed. Note that this may
  * have a memory usage impact as it requires storing an additional
  * copy of the inserted or removed text within the text buffer.
+ * To limit that impact, older changes are kept compressed. As long
+ * as @max_undo_levels is not 0, the oldest changes are also dropped
+ * once their text exceeds 64 MiB.
  */
 void
 gtk_text_buffer_set_max_undo_levels (GtkTextBuffer *buffer,
@@ -5094,4 +5364,7 @@ gtk_text_buffer_set_max_undo_levels (GtkTextBuffer *buffer,
   g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
 
   gtk_text_history_set_max_undo_levels (buffer->priv->history, max_undo_levels);
+  /* Unlimited means unlimited */
+  gtk_text_history_set_max_undo_bytes (buffer->priv->history,
+                                       max_undo_levels > 0 ? DEFAULT_MAX_UNDO_BYTES : 0);
 }
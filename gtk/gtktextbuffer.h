@@ -158,6 +158,24 @@ void gtk_text_buffer_set_text          (GtkTextBuffer *buffer,
                                         const char    *text,
                                         int            len);
 
+/* Delete whole buffer, then load lots of text */
+GDK_AVAILABLE_IN_4_4
+void     gtk_text_buffer_load_bytes         (GtkTextBuffer         *buffer,
+                                             GBytes                *bytes);
+GDK_AVAILABLE_IN_4_4
+void     gtk_text_buffer_load_stream_async  (GtkTextBuffer         *buffer,
+                                             GInputStream          *stream,
+                                             int                    io_priority,
+                                             GCancellable          *cancellable,
+                                             GFileProgressCallback  progress_callback,
+                                             gpointer               progress_data,
+                                             GAsyncReadyCallback    callback,
+                                             gpointer               user_data);
+GDK_AVAILABLE_IN_4_4
+gboolean gtk_text_buffer_load_stream_finish (GtkTextBuffer         *buffer,
+                                             GAsyncResult          *result,
+                                             GError               **error);
+
 /* Insert into the buffer */
 GDK_AVAILABLE_IN_ALL
 void gtk_text_buffer_insert            (GtkTextBuffer *buffer,
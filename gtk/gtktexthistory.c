@@ -16,6 +16,10 @@
 
 #include "config.h"
 
+#include <string.h>
+
+#include <gio/gio.h>
+
 #include "gtkistringprivate.h"
 #include "gtktexthistoryprivate.h"
 
@@ -36,8 +40,20 @@
  * gtk_text_history_end_irreversible_action() can be used to denote a
  * section of operations that cannot be undone. This will cause all previous
  * changes tracked by the GtkTextHistory to be discarded.
+ *
+ * To keep the memory used by large edits in check, the text of actions
+ * that are more than PACK_AFTER_LEVELS undo levels old is compressed,
+ * and is only uncompressed again when the action is undone, redone or
+ * chained to. Besides max_undo_levels, the history can be limited to
+ * max_undo_bytes of (possibly compressed) text, in which case the
+ * oldest actions are discarded first.
  */
 
+/* Only compress text larger than this */
+#define PACK_MIN_BYTES    4096
+/* Number of recent undo levels that are never compressed */
+#define PACK_AFTER_LEVELS 16
+
 typedef struct _Action     Action;
 typedef enum   _ActionKind ActionKind;
 
@@ -58,6 +74,9 @@ struct _Action
   GList link;
   guint is_modified : 1;
   guint is_modified_set : 1;
+  guint pack_tried : 1;
+  /* The compressed text while the istr is empty, see gtk_text_history_pack() */
+  GBytes *packed;
   union {
     struct {
       IString istr;
@@ -99,6 +118,10 @@ struct _GtkTextHistory
   guint               in_user;
   guint               max_undo_levels;
 
+  /* Size of the text in both queues */
+  gsize               n_bytes;
+  gsize               max_undo_bytes;
+
   guint               can_undo : 1;
   guint               can_redo : 1;
   guint               is_modified : 1;
@@ -167,6 +190,8 @@ action_new (ActionKind kind)
 static void
 action_free (Action *action)
 {
+  g_clear_pointer (&action->packed, g_bytes_unref);
+
   if (action->kind == ACTION_KIND_INSERT)
     istring_clear (&action->u.insert.istr);
   else if (action->kind == ACTION_KIND_DELETE_BACKSPACE ||
@@ -180,6 +205,90 @@ action_free (Action *action)
   g_slice_free (Action, action);
 }
 
+static IString *
+action_get_istring (Action *action)
+{
+  switch (action->kind)
+    {
+    case ACTION_KIND_INSERT:
+      return &action->u.insert.istr;
+
+    case ACTION_KIND_DELETE_BACKSPACE:
+    case ACTION_KIND_DELETE_KEY:
+    case ACTION_KIND_DELETE_PROGRAMMATIC:
+    case ACTION_KIND_DELETE_SELECTION:
+      return &action->u.delete.istr;
+
+    case ACTION_KIND_BARRIER:
+    case ACTION_KIND_GROUP:
+    default:
+      return NULL;
+    }
+}
+
+static gsize
+action_get_size (Action *action)
+{
+  IString *istr;
+
+  if (action->kind == ACTION_KIND_GROUP)
+    {
+      gsize size = 0;
+
+      for (const GList *iter = action->u.group.actions.head; iter; iter = iter->next)
+        size += action_get_size (iter->data);
+
+      return size;
+    }
+
+  if (action->packed != NULL)
+    return g_bytes_get_size (action->packed);
+
+  istr = action_get_istring (action);
+  if (istr != NULL)
+    return istr->n_bytes;
+
+  return 0;
+}
+
+static GBytes *
+convert_bytes (GConverter *converter,
+               const char *data,
+               gsize       len)
+{
+  GByteArray *out;
+  char buf[8192];
+  gsize pos = 0;
+
+  out = g_byte_array_new ();
+
+  for (;;)
+    {
+      GConverterResult res;
+      gsize n_read, n_written;
+
+      res = g_converter_convert (converter,
+                                 data + pos, len - pos,
+                                 buf, sizeof buf,
+                                 G_CONVERTER_INPUT_AT_END,
+                                 &n_read, &n_written,
+                                 NULL);
+      if (res == G_CONVERTER_ERROR)
+        {
+          g_byte_array_unref (out);
+          return NULL;
+        }
+
+      pos += n_read;
+      g_byte_array_append (out, (const guint8 *) buf, n_written);
+
+      if (res == G_CONVERTER_FINISHED)
+        break;
+    }
+
+  return g_byte_array_free_to_bytes (out);
+}
+
 static gboolean
 action_group_is_empty (const Action *action)
 {
@@ -299,11 +408,35 @@ action_chain (Action   *action,
     }
 
     case ACTION_KIND_DELETE_PROGRAMMATIC:
-      /* We can't tell if this should be chained because we don't
-       * have a group to coalesce. But unless each action deletes
-       * a single character, the overhead isn't too bad as we embed
-       * the strings in the action.
+      /* Outside of a user action, we can't tell if this should be
+       * chained because we don't have a group to coalesce. But unless
+       * each action deletes a single character, the overhead isn't too
+       * bad as we embed the strings in the action.
+       *
+       * Within a group, everything is undone at once anyway, so join
+       * deletes of adjacent text into a single run.
        */
+      if (!in_user_action ||
+          action->u.delete.begin > action->u.delete.end ||
+          other->u.delete.begin > other->u.delete.end)
+        return FALSE;
+
+      if (other->u.delete.begin == action->u.delete.begin)
+        {
+          istring_append (&action->u.delete.istr, &other->u.delete.istr);
+          action->u.delete.end += other->u.delete.end - other->u.delete.begin;
+          action_free (other);
+          return TRUE;
+        }
+
+      if (other->u.delete.end == action->u.delete.begin)
+        {
+          istring_prepend (&action->u.delete.istr, &other->u.delete.istr);
+          action->u.delete.begin = other->u.delete.begin;
+          action_free (other);
+          return TRUE;
+        }
+
       return FALSE;
 
     case ACTION_KIND_DELETE_SELECTION:
@@ -400,25 +533,128 @@ gtk_text_history_do_select (GtkTextHistory *self,
   self->funcs.select (self->funcs_data, selection_insert, selection_bound);
 }
 
+/*
+ * gtk_text_history_pack:
+ *
+ * Compresses the text of @action, if it is large enough and
+ * compresses well. Text that is packed must be unpacked with
+ * gtk_text_history_unpack() before it is used.
+ */
 static void
-gtk_text_history_truncate_one (GtkTextHistory *self)
+gtk_text_history_pack (GtkTextHistory *self,
+                       Action         *action)
 {
-  if (self->undo_queue.length > 0)
+  GZlibCompressor *compressor;
+  GBytes *packed;
+  IString *istr;
+
+  if (action->kind == ACTION_KIND_GROUP)
     {
-      Action *action = g_queue_peek_head (&self->undo_queue);
-      g_queue_unlink (&self->undo_queue, &action->link);
-      action_free (action);
+      for (const GList *iter = action->u.group.actions.head; iter; iter = iter->next)
+        gtk_text_history_pack (self, iter->data);
+
+      return;
     }
-  else if (self->redo_queue.length > 0)
+
+  istr = action_get_istring (action);
+
+  if (istr == NULL ||
+      action->packed != NULL ||
+      action->pack_tried ||
+      istr->n_bytes < PACK_MIN_BYTES)
+    return;
+
+  action->pack_tried = TRUE;
+
+  /* Favor speed, text compresses well anyway */
+  compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, 1);
+  packed = convert_bytes (G_CONVERTER (compressor), istr->u.str, istr->n_bytes);
+  g_object_unref (compressor);
+
+  if (packed == NULL)
+    return;
+
+  if (g_bytes_get_size (packed) > istr->n_bytes / 4 * 3)
     {
-      Action *action = g_queue_peek_tail (&self->redo_queue);
-      g_queue_unlink (&self->redo_queue, &action->link);
-      action_free (action);
+      g_bytes_unref (packed);
+      return;
     }
-  else
+
+  self->n_bytes -= istr->n_bytes - g_bytes_get_size (packed);
+
+  /* Keep n_bytes and n_chars, so the istr stays non-inline */
+  g_clear_pointer (&istr->u.str, g_free);
+  action->packed = packed;
+}
+
+static void
+gtk_text_history_unpack (GtkTextHistory *self,
+                         Action         *action)
+{
+  GZlibDecompressor *decompressor;
+  GBytes *bytes;
+  IString *istr;
+
+  action->pack_tried = FALSE;
+
+  if (action->kind == ACTION_KIND_GROUP)
     {
-      g_assert_not_reached ();
+      for (const GList *iter = action->u.group.actions.head; iter; iter = iter->next)
+        gtk_text_history_unpack (self, iter->data);
+
+      return;
     }
+
+  if (action->packed == NULL)
+    return;
+
+  istr = action_get_istring (action);
+
+  decompressor = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
+  bytes = convert_bytes (G_CONVERTER (decompressor),
+                         g_bytes_get_data (action->packed, NULL),
+                         g_bytes_get_size (action->packed));
+  g_object_unref (decompressor);
+
+  g_assert (bytes != NULL);
+  g_assert (g_bytes_get_size (bytes) == istr->n_bytes);
+
+  istr->u.str = g_malloc (istr->n_bytes + 1);
+  memcpy (istr->u.str, g_bytes_get_data (bytes, NULL), istr->n_bytes);
+  istr->u.str[istr->n_bytes] = 0;
+  g_bytes_unref (bytes);
+
+  self->n_bytes += istr->n_bytes - g_bytes_get_size (action->packed);
+  g_clear_pointer (&action->packed, g_bytes_unref);
+}
+
+static void
+gtk_text_history_drop (GtkTextHistory *self,
+                       GQueue         *queue,
+                       Action         *action)
+{
+  self->n_bytes -= action_get_size (action);
+  g_queue_unlink (queue, &action->link);
+  action_free (action);
+}
+
+static void
+gtk_text_history_clear_queue (GtkTextHistory *self,
+                              GQueue         *queue)
+{
+  while (queue->length > 0)
+    gtk_text_history_drop (self, queue, g_queue_peek_head (queue));
+}
+
+static void
+gtk_text_history_truncate_one (GtkTextHistory *self)
+{
+  if (self->undo_queue.length > 0)
+    gtk_text_history_drop (self, &self->undo_queue, g_queue_peek_head (&self->undo_queue));
+  else if (self->redo_queue.length > 0)
+    gtk_text_history_drop (self, &self->redo_queue, g_queue_peek_tail (&self->redo_queue));
+  else
+    g_assert_not_reached ();
 }
 
 static void
@@ -426,11 +662,21 @@ gtk_text_history_truncate (GtkTextHistory *self)
 {
   g_assert (GTK_IS_TEXT_HISTORY (self));
 
-  if (self->max_undo_levels == 0)
-    return;
+  if (self->max_undo_levels > 0)
+    {
+      while (self->undo_queue.length + self->redo_queue.length > self->max_undo_levels)
+        gtk_text_history_truncate_one (self);
+    }
 
-  while (self->undo_queue.length + self->redo_queue.length > self->max_undo_levels)
-    gtk_text_history_truncate_one (self);
+  /* Always keep the most recent action, so that a single
+   * change larger than the budget can still be undone.
+   */
+  if (self->max_undo_bytes > 0)
+    {
+      while (self->n_bytes > self->max_undo_bytes &&
+             self->undo_queue.length > 1)
+        gtk_text_history_drop (self, &self->undo_queue, g_queue_peek_head (&self->undo_queue));
+    }
 }
 
 static void
@@ -512,24 +758,40 @@ gtk_text_history_push (GtkTextHistory *self,
   Action *peek;
   gboolean in_user_action;
 
+  GList *cold;
+
   g_assert (GTK_IS_TEXT_HISTORY (self));
   g_assert (self->enabled);
   g_assert (action != NULL);
 
-  while (self->redo_queue.length > 0)
-    {
-      peek = g_queue_peek_head (&self->redo_queue);
-      g_queue_unlink (&self->redo_queue, &peek->link);
-      action_free (peek);
-    }
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   peek = g_queue_peek_tail (&self->undo_queue);
   in_user_action = self->in_user > 0;
 
+  self->n_bytes += action_get_size (action);
+
+  /* The tail may have been compressed if we undid past it */
+  if (peek != NULL && peek->kind == ACTION_KIND_GROUP)
+    {
+      if (peek->u.group.actions.tail != NULL)
+        gtk_text_history_unpack (self, peek->u.group.actions.tail->data);
+    }
+  else if (peek != NULL)
+    gtk_text_history_unpack (self, peek);
+
   if (peek == NULL || !action_chain (peek, action, in_user_action))
     g_queue_push_tail_link (&self->undo_queue, &action->link);
 
   gtk_text_history_truncate (self);
+
+  /* Compress the action that just became old enough */
+  cold = self->undo_queue.tail;
+  for (guint i = 0; cold != NULL && i < PACK_AFTER_LEVELS; i++)
+    cold = cold->prev;
+  if (cold != NULL)
+    gtk_text_history_pack (self, cold->data);
+
   gtk_text_history_update_state (self);
 }
 
@@ -729,6 +991,7 @@ gtk_text_history_undo (GtkTextHistory *self)
 
       g_queue_unlink (&self->undo_queue, &action->link);
       g_queue_push_head_link (&self->redo_queue, &action->link);
+      gtk_text_history_unpack (self, action);
       gtk_text_history_reverse (self, action);
       gtk_text_history_update_state (self);
 
@@ -765,6 +1028,7 @@ gtk_text_history_redo (GtkTextHistory *self)
 
       peek = g_queue_peek_head (&self->redo_queue);
 
+      gtk_text_history_unpack (self, action);
       gtk_text_history_apply (self, action, peek);
       gtk_text_history_update_state (self);
 
@@ -809,7 +1073,7 @@ gtk_text_history_end_user_action (GtkTextHistory *self)
   return_if_applying (self);
   return_if_irreversible (self);
 
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   peek = g_queue_peek_tail (&self->undo_queue);
 
@@ -851,6 +1115,8 @@ gtk_text_history_end_user_action (GtkTextHistory *self)
       g_queue_unlink (&self->undo_queue, &peek->link);
       action_free (peek);
 
+      /* Accounted for again when pushed */
+      self->n_bytes -= action_get_size (replaced);
       gtk_text_history_push (self, replaced);
 
       goto update_state;
@@ -883,6 +1149,7 @@ gtk_text_history_begin_irreversible_action (GtkTextHistory *self)
 
   clear_action_queue (&self->undo_queue);
   clear_action_queue (&self->redo_queue);
+  self->n_bytes = 0;
 
   gtk_text_history_update_state (self);
 }
@@ -905,6 +1172,7 @@ gtk_text_history_end_irreversible_action (GtkTextHistory *self)
 
   clear_action_queue (&self->undo_queue);
   clear_action_queue (&self->redo_queue);
+  self->n_bytes = 0;
 
   gtk_text_history_update_state (self);
 }
@@ -1073,6 +1341,7 @@ gtk_text_history_set_enabled (GtkTextHistory *self,
           self->in_user = 0;
           clear_action_queue (&self->undo_queue);
           clear_action_queue (&self->redo_queue);
+          self->n_bytes = 0;
         }
 
       gtk_text_history_update_state (self);
@@ -1099,3 +1368,25 @@ gtk_text_history_set_max_undo_levels (GtkTextHistory *self,
       gtk_text_history_truncate (self);
     }
 }
+
+gsize
+gtk_text_history_get_max_undo_bytes (GtkTextHistory *self)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_HISTORY (self), 0);
+
+  return self->max_undo_bytes;
+}
+
+void
+gtk_text_history_set_max_undo_bytes (GtkTextHistory *self,
+                                     gsize           max_undo_bytes)
+{
+  g_return_if_fail (GTK_IS_TEXT_HISTORY (self));
+
+  if (self->max_undo_bytes != max_undo_bytes)
+    {
+      self->max_undo_bytes = max_undo_bytes;
+      gtk_text_history_truncate (self);
+      gtk_text_history_update_state (self);
+    }
+}
@@ -4950,6 +4950,155 @@ strbreakup (const char *string,
   return str_array;
 }
 
+/* Finds the first match of @needle in the lines @first to @last
+ * of @chunk, the same way lines_match() would when called on each
+ * line in turn. @needle must not contain a newline.
+ */
+static gboolean
+search_chunk_match (GtkTextBTree             *tree,
+                    const GtkTextSearchChunk *chunk,
+                    int                       first,
+                    int                       last,
+                    const char               *needle,
+                    gboolean                  slice,
+                    gboolean                  case_insensitive,
+                    GtkTextIter              *match_start,
+                    GtkTextIter              *match_end)
+{
+  const char *text;
+  const int *offsets;
+  const char *p;
+  const char *line_text;
+  int needle_len;
+  int byte_index;
+  int pos;
+  int i;
+
+  if (case_insensitive)
+    {
+      text = chunk->caseless;
+      offsets = chunk->caseless_offsets;
+    }
+  else
+    {
+      text = chunk->text;
+      offsets = chunk->offsets;
+    }
+
+  needle_len = strlen (needle);
+  p = text + offsets[first];
+  i = first;
+
+  while ((p = strstr (p, needle)) != NULL)
+    {
+      pos = p - text;
+
+      if (pos + needle_len > offsets[last + 1])
+        return FALSE;
+
+      while (offsets[i + 1] <= pos)
+        i++;
+
+      /* The match must not span lines, and when ignoring case, it
+       * must not end in the middle of a combining sequence, see
+       * exact_prefix_cmp().
+       */
+      if (pos + needle_len > offsets[i + 1] ||
+          (case_insensitive &&
+           pos + needle_len < offsets[i + 1] &&
+           !exact_prefix_cmp (p, needle, needle_len)))
+        {
+          p = g_utf8_next_char (p);
+          continue;
+        }
+
+      line_text = text + offsets[i];
+
+      if (case_insensitive)
+        {
+          const char *orig_line_text = chunk->text + chunk->offsets[i];
+          const char *found;
+
+          found = pointer_from_offset_skipping_decomp (orig_line_text,
+                                                       g_utf8_strlen (line_text, p - line_text));
+          byte_index = found - orig_line_text;
+        }
+      else
+        byte_index = p - line_text;
+
+      _gtk_text_btree_get_iter_at_line (tree, match_start, chunk->lines[i], byte_index);
+
+      *match_end = *match_start;
+      forward_chars_with_skipping (match_end, g_utf8_strlen (needle, -1),
+                                   FALSE, !slice, case_insensitive);
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Searches from the start of @line to the end of @limit_line (or
+ * the end of the buffer) for a single line of text. This is what
+ * gtk_text_iter_forward_search() does for needles without newlines,
+ * but instead of fetching each line from the btree, it runs strstr()
+ * over the search chunks that the btree keeps for its nodes, which
+ * stay cached until the text changes.
+ */
+static gboolean
+forward_search_chunks (GtkTextBTree  *tree,
+                       GtkTextLine   *line,
+                       const char   **lines,
+                       gboolean       slice,
+                       gboolean       case_insensitive,
+                       GtkTextLine   *limit_line,
+                       GtkTextIter   *match_start,
+                       GtkTextIter   *match_end)
+{
+  const GtkTextSearchChunk *chunk;
+  GtkTextIter start;
+  int first, last;
+
+  while (line != NULL)
+    {
+      chunk = _gtk_text_btree_get_search_chunk (tree, line, case_insensitive, &first);
+      if (chunk == NULL)
+        return FALSE;
+
+      for (last = first; last < chunk->n_lines - 1; last++)
+        {
+          if (chunk->lines[last] == limit_line)
+            break;
+        }
+
+      if (!slice && chunk->has_unknown_chars)
+        {
+          /* The text excludes paintables and widgets then, so the
+           * offsets in the chunk don't apply. Do it line by line.
+           */
+          for (; first <= last; first++)
+            {
+              _gtk_text_btree_get_iter_at_line (tree, &start, chunk->lines[first], 0);
+
+              if (lines_match (&start, lines, FALSE, slice, case_insensitive,
+                               match_start, match_end))
+                return TRUE;
+            }
+        }
+      else if (search_chunk_match (tree, chunk, first, last, lines[0],
+                                   slice, case_insensitive,
+                                   match_start, match_end))
+        return TRUE;
+
+      if (chunk->lines[last] == limit_line)
+        return FALSE;
+
+      line = _gtk_text_line_next (chunk->lines[chunk->n_lines - 1]);
+    }
+
+  return FALSE;
+}
+
 /**
  * gtk_text_iter_forward_search:
  * @iter: start of search
@@ -4970,6 +5119,13 @@ strbreakup (const char *string,
  * @match_start will never be set to a `GtkTextIter` located before @iter,
  * even if there is a possible @match_end after or at @iter.
  *
+ * Unless @flags contains %GTK_TEXT_SEARCH_VISIBLE_ONLY, searches for
+ * text without newlines use a cache of the buffer contents that is
+ * kept until the text changes. To find all matches in a range, call
+ * this function repeatedly, starting each search at the previous
+ * @match_end; this only reads as much of the buffer as needed to
+ * find the next match.
+ *
  * Returns: whether a match was found
  */
 gboolean
@@ -5026,6 +5182,52 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
 
   search = *iter;
 
+  if (!visible_only && strchr (str, '\n') == NULL)
+    {
+      GtkTextIter end;
+      gboolean found;
+
+      /* Only the rest of the first line needs to be looked at
+       * separately, after that we can search whole lines.
+       */
+      if (gtk_text_iter_starts_line (&search))
+        found = FALSE;
+      else if (lines_match (&search, (const char **)lines,
+                            FALSE, slice, case_insensitive, &match, &end))
+        found = TRUE;
+      else if (gtk_text_iter_forward_line (&search))
+        found = FALSE;
+      else
+        goto out;
+
+      if (!found && limit &&
+          gtk_text_iter_compare (&search, limit) >= 0)
+        goto out;
+
+      if (!found)
+        found = forward_search_chunks (_gtk_text_iter_get_btree (&search),
+                                       _gtk_text_iter_get_text_line (&search),
+                                       (const char **)lines,
+                                       slice, case_insensitive,
+                                       limit ? _gtk_text_iter_get_text_line (limit) : NULL,
+                                       &match, &end);
+
+      if (found &&
+          (limit == NULL ||
+           gtk_text_iter_compare (&end, limit) <= 0))
+        {
+          retval = TRUE;
+
+          if (match_start)
+            *match_start = match;
+
+          if (match_end)
+            *match_end = end;
+        }
+
+      goto out;
+    }
+
   do
     {
       /* This loop has an inefficient worst-case, where
@@ -5059,6 +5261,7 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
     }
   while (gtk_text_iter_forward_line (&search));
 
+out:
   g_strfreev ((char **)lines);
 
   return retval;
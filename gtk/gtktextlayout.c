@@ -109,6 +109,38 @@ struct _GtkTextLayoutPrivate
 
   /* Cache for GtkTextLineDisplay to reduce overhead creating layouts */
   GtkTextLineDisplayCache *cache;
+
+  /* Background wrapping, see gtk_text_layout_set_background_wrap() */
+  guint background_wrap : 1;
+  guint scan_started : 1;
+  guint n_wrap_batches;
+  guint wrap_generation;
+  guint scan_generation;
+  GtkTextLine *scan_line;
+  GCancellable *wrap_cancellable;
+  /* Result handed to gtk_text_layout_wrap() while committing a batch */
+  const struct _WrapJob *committing;
+
+  /* The lines drawn by the last snapshot, reused while the same lines
+   * are visible and nothing was invalidated, see gtk_text_layout_snapshot()
+   */
+  GskRenderNode *snapshot_node;
+  GtkTextLine *snapshot_first_line;
+  GtkTextLine *snapshot_last_line;
+  guint snapshot_generation;
+  GdkRGBA snapshot_color;
+  GdkRGBA snapshot_selection;
+  int snapshot_selection_start;
+  int snapshot_selection_end;
+  GArray *snapshot_cursors;
+};
+
+typedef struct _SnapshotCursors SnapshotCursors;
+
+struct _SnapshotCursors
+{
+  GtkTextLineDisplay *display;
+  int offset_y;
 };
 
 static void gtk_text_layout_invalidated     (GtkTextLayout     *layout);
@@ -124,6 +156,18 @@ static void gtk_text_layout_emit_changed           (GtkTextLayout     *layout,
 						    int                new_height);
 
 static void gtk_text_layout_invalidate_all (GtkTextLayout *layout);
+static void gtk_text_layout_clear_snapshot (GtkTextLayout *layout);
+
+static GtkTextLineDisplay *gtk_text_layout_build_display (GtkTextLayout *layout,
+                                                          GtkTextLine   *line,
+                                                          gboolean       size_only,
+                                                          gboolean       measure);
+static gboolean totally_invisible_line                   (GtkTextLayout *layout,
+                                                          GtkTextLine   *line,
+                                                          GtkTextIter   *iter);
+
+static gboolean gtk_text_layout_wrap_in_background (GtkTextLayout *layout);
+static void     gtk_text_layout_cancel_wrap        (GtkTextLayout *layout);
 
 static PangoAttribute *gtk_text_attr_appearance_new (const GtkTextAppearance *appearance);
 
@@ -193,6 +237,8 @@ gtk_text_layout_dispose (GObject *object)
   GtkTextLayout *layout = GTK_TEXT_LAYOUT (object);
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
 
+  gtk_text_layout_clear_snapshot (layout);
+  g_clear_pointer (&priv->snapshot_cursors, g_array_unref);
   g_clear_pointer (&priv->cache, gtk_text_line_display_cache_free);
 
   gtk_text_layout_set_buffer (layout, NULL);
@@ -314,6 +360,8 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
     return;
 
   free_style_cache (layout);
+  gtk_text_layout_cancel_wrap (layout);
+  gtk_text_layout_clear_snapshot (layout);
 
   if (layout->buffer)
     {
@@ -802,6 +850,9 @@ gtk_text_layout_invalidate (GtkTextLayout     *layout,
   gtk_text_view_index_spew (end_index, "invalidate end");
 #endif
 
+  /* Snapshots taken for background wrapping may be outdated now */
+  GTK_TEXT_LAYOUT_GET_PRIVATE (layout)->wrap_generation++;
+
   last_line = _gtk_text_iter_get_text_line (end);
   line = _gtk_text_iter_get_text_line (start);
 
@@ -1020,6 +1071,467 @@ gtk_text_layout_validate_yrange (GtkTextLayout *layout,
     }
 }
 
+/*
+ * Background wrapping
+ *
+ * Validating a big buffer in the incremental idle is dominated by
+ * Pango shaping and line breaking. In background mode, paragraphs
+ * are snapshotted on the main thread (text, attributes and paragraph
+ * settings, exactly as gtk_text_layout_create_display() sets them up),
+ * then measured on worker threads using their own PangoContexts, and
+ * finally committed into the btree in batches.
+ *
+ * Lines that can't be measured without the main thread - the cursor
+ * line, lines with paintables or child widgets - as well as anything
+ * left over when a batch is outdated are validated the usual way.
+ */
+
+#define WRAP_BATCH_LINES 512
+#define WRAP_MIN_BATCH_LINES 64
+#define WRAP_MAX_BATCHES 4
+
+typedef struct _WrapJob WrapJob;
+
+struct _WrapJob
+{
+  GtkTextLine *line;            /* only ever looked at on the main thread */
+
+  char *text;
+  PangoAttrList *attrs;
+  PangoTabArray *tabs;
+  guint rtl : 1;
+  guint justify : 1;
+  guint invisible : 1;
+  PangoAlignment alignment;
+  PangoWrapMode wrap;
+  int width;
+  int indent;
+  int spacing;
+  int extra_width;
+  int extra_height;
+
+  int result_width;
+  int result_height;
+  int top_ink;
+  int bottom_ink;
+};
+
+typedef struct
+{
+  guint generation;
+  guint chars_stamp;
+  guint segments_stamp;
+
+  /* What the worker needs to recreate the layout's contexts */
+  PangoFontDescription *font_desc;
+  PangoLanguage *language;
+  PangoGravity gravity;
+  PangoGravityHint gravity_hint;
+  PangoMatrix matrix;
+  gboolean has_matrix;
+  cairo_font_options_t *font_options;
+  double resolution;
+  gboolean round_glyph_positions;
+
+  GArray *jobs;
+} WrapBatch;
+
+static void
+wrap_job_clear (gpointer data)
+{
+  WrapJob *job = data;
+
+  g_free (job->text);
+  g_clear_pointer (&job->attrs, pango_attr_list_unref);
+  g_clear_pointer (&job->tabs, pango_tab_array_free);
+}
+
+static void
+wrap_batch_free (gpointer data)
+{
+  WrapBatch *batch = data;
+
+  pango_font_description_free (batch->font_desc);
+  g_clear_pointer (&batch->font_options, cairo_font_options_destroy);
+  g_array_unref (batch->jobs);
+  g_free (batch);
+}
+
+static gboolean
+wrap_job_snapshot (GtkTextLayout *layout,
+                   GtkTextLine   *line,
+                   WrapJob       *job)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLineDisplay *display;
+  GtkTextLineSegment *seg;
+  GtkTextIter iter;
+
+  /* Depends on the preedit and keyboard direction */
+  if (line == priv->cursor_line)
+    return FALSE;
+
+  for (seg = line->segments; seg; seg = seg->next)
+    {
+      if (seg->type == &gtk_text_paintable_type ||
+          seg->type == &gtk_text_child_type)
+        return FALSE;
+    }
+
+  memset (job, 0, sizeof (WrapJob));
+  job->line = line;
+
+  if (totally_invisible_line (layout, line, &iter))
+    {
+      job->invisible = TRUE;
+      return TRUE;
+    }
+
+  display = gtk_text_layout_build_display (layout, line, TRUE, FALSE);
+
+  job->text = g_strdup (pango_layout_get_text (display->layout));
+  /* Copied, the worker must not share anything with the main thread */
+  job->attrs = pango_attr_list_copy (pango_layout_get_attributes (display->layout));
+  job->tabs = pango_layout_get_tabs (display->layout);
+  job->rtl = pango_layout_get_context (display->layout) == layout->rtl_context;
+  job->justify = pango_layout_get_justify (display->layout);
+  job->alignment = pango_layout_get_alignment (display->layout);
+  job->wrap = pango_layout_get_wrap (display->layout);
+  job->width = pango_layout_get_width (display->layout);
+  job->indent = pango_layout_get_indent (display->layout);
+  job->spacing = pango_layout_get_spacing (display->layout);
+  job->extra_width = display->left_margin + display->right_margin +
+                     layout->left_padding + layout->right_padding;
+  job->extra_height = display->height;
+
+  gtk_text_line_display_unref (display);
+
+  return TRUE;
+}
+
+static PangoContext *
+wrap_batch_create_context (WrapBatch      *batch,
+                           PangoDirection  dir)
+{
+  PangoContext *context;
+
+  /* The default font map is per thread */
+  context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+
+  pango_context_set_font_description (context, batch->font_desc);
+  pango_context_set_language (context, batch->language);
+  pango_context_set_base_dir (context, dir);
+  pango_context_set_base_gravity (context, batch->gravity);
+  pango_context_set_gravity_hint (context, batch->gravity_hint);
+  pango_context_set_matrix (context, batch->has_matrix ? &batch->matrix : NULL);
+  pango_context_set_round_glyph_positions (context, batch->round_glyph_positions);
+  pango_cairo_context_set_resolution (context, batch->resolution);
+  pango_cairo_context_set_font_options (context, batch->font_options);
+
+  return context;
+}
+
+static void
+wrap_batch_thread (GTask        *task,
+                   gpointer      source_object,
+                   gpointer      task_data,
+                   GCancellable *cancellable)
+{
+  WrapBatch *batch = task_data;
+  PangoContext *contexts[2];
+  guint i;
+
+  contexts[0] = wrap_batch_create_context (batch, PANGO_DIRECTION_LTR);
+  contexts[1] = wrap_batch_create_context (batch, PANGO_DIRECTION_RTL);
+
+  for (i = 0; i < batch->jobs->len; i++)
+    {
+      WrapJob *job = &g_array_index (batch->jobs, WrapJob, i);
+      PangoRectangle ink_rect, logical_rect;
+      PangoLayout *layout;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      if (job->invisible)
+        continue;
+
+      layout = pango_layout_new (contexts[job->rtl]);
+      pango_layout_set_text (layout, job->text, -1);
+      pango_layout_set_attributes (layout, job->attrs);
+      pango_layout_set_alignment (layout, job->alignment);
+      pango_layout_set_justify (layout, job->justify);
+      pango_layout_set_spacing (layout, job->spacing);
+      pango_layout_set_indent (layout, job->indent);
+      pango_layout_set_tabs (layout, job->tabs);
+      pango_layout_set_width (layout, job->width);
+      pango_layout_set_wrap (layout, job->wrap);
+
+      /* Same as gtk_text_layout_create_display() and gtk_text_layout_wrap() */
+      pango_layout_get_extents (layout, NULL, &logical_rect);
+      job->result_width = PIXEL_BOUND (logical_rect.width) + job->extra_width;
+      job->result_height = PANGO_PIXELS (logical_rect.height) + job->extra_height;
+
+      pango_layout_get_pixel_extents (layout, &ink_rect, &logical_rect);
+      job->top_ink = MAX (0, logical_rect.x - ink_rect.x);
+      job->bottom_ink = MAX (0, logical_rect.x + logical_rect.width - ink_rect.x - ink_rect.width);
+
+      g_object_unref (layout);
+    }
+
+  g_object_unref (contexts[0]);
+  g_object_unref (contexts[1]);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+wrap_batch_done (GObject      *source,
+                 GAsyncResult *result,
+                 gpointer      data)
+{
+  GtkTextLayout *layout = GTK_TEXT_LAYOUT (source);
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  WrapBatch *batch = g_task_get_task_data (G_TASK (result));
+  GtkTextBTree *btree;
+  GtkTextLine *first_line = NULL;
+  int old_height = 0, new_height = 0;
+  guint i;
+
+  /* Cancelled batches have already been forgotten about */
+  if (!g_task_propagate_boolean (G_TASK (result), NULL))
+    return;
+
+  btree = _gtk_text_buffer_get_btree (layout->buffer);
+
+  /* Lines may have changed or even gone away since the snapshot */
+  if (batch->generation == priv->wrap_generation &&
+      batch->chars_stamp == _gtk_text_btree_get_chars_changed_stamp (btree) &&
+      batch->segments_stamp == _gtk_text_btree_get_segments_changed_stamp (btree))
+    {
+      for (i = 0; i < batch->jobs->len; i++)
+        {
+          WrapJob *job = &g_array_index (batch->jobs, WrapJob, i);
+          GtkTextLineData *line_data;
+
+          if (job->line == priv->cursor_line)
+            continue;
+
+          line_data = _gtk_text_line_get_data (job->line, layout);
+          if (line_data && line_data->valid)
+            continue;
+
+          if (first_line == NULL)
+            first_line = job->line;
+
+          old_height += line_data ? line_data->height : 0;
+
+          priv->committing = job;
+          _gtk_text_btree_validate_line (btree, job->line, layout);
+          priv->committing = NULL;
+
+          line_data = _gtk_text_line_get_data (job->line, layout);
+          new_height += line_data->height;
+        }
+    }
+
+  /* Emitted while still counted as in flight, so that handlers can
+   * tell background results from synchronous validation.
+   */
+  if (first_line)
+    {
+      int y;
+
+      update_layout_size (layout);
+
+      y = _gtk_text_btree_find_line_top (btree, first_line, layout);
+      gtk_text_layout_emit_changed (layout, y, old_height, new_height);
+    }
+
+  priv->n_wrap_batches--;
+
+  /* Keep going, or let the owner finish the rest synchronously */
+  if (!gtk_text_layout_wrap_in_background (layout) &&
+      !gtk_text_layout_is_valid (layout))
+    gtk_text_layout_invalidated (layout);
+}
+
+static WrapBatch *
+wrap_batch_new (GtkTextLayout *layout)
+{
+  PangoContext *context = layout->ltr_context;
+  GtkTextBTree *btree = _gtk_text_buffer_get_btree (layout->buffer);
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  const cairo_font_options_t *font_options;
+  const PangoMatrix *matrix;
+  WrapBatch *batch;
+
+  batch = g_new0 (WrapBatch, 1);
+  batch->generation = priv->wrap_generation;
+  batch->chars_stamp = _gtk_text_btree_get_chars_changed_stamp (btree);
+  batch->segments_stamp = _gtk_text_btree_get_segments_changed_stamp (btree);
+
+  batch->font_desc = pango_font_description_copy (pango_context_get_font_description (context));
+  batch->language = pango_context_get_language (context);
+  batch->gravity = pango_context_get_base_gravity (context);
+  batch->gravity_hint = pango_context_get_gravity_hint (context);
+  matrix = pango_context_get_matrix (context);
+  if (matrix)
+    {
+      batch->matrix = *matrix;
+      batch->has_matrix = TRUE;
+    }
+  font_options = pango_cairo_context_get_font_options (context);
+  if (font_options)
+    batch->font_options = cairo_font_options_copy (font_options);
+  batch->resolution = pango_cairo_context_get_resolution (context);
+  batch->round_glyph_positions = pango_context_get_round_glyph_positions (context);
+
+  batch->jobs = g_array_sized_new (FALSE, FALSE, sizeof (WrapJob), WRAP_BATCH_LINES);
+  g_array_set_clear_func (batch->jobs, wrap_job_clear);
+
+  return batch;
+}
+
+static void
+gtk_text_layout_cancel_wrap (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (priv->wrap_cancellable)
+    {
+      g_cancellable_cancel (priv->wrap_cancellable);
+      g_clear_object (&priv->wrap_cancellable);
+    }
+
+  priv->n_wrap_batches = 0;
+  priv->scan_started = FALSE;
+  priv->scan_line = NULL;
+}
+
+/* Snapshots the next invalid lines and hands them to worker threads.
+ * Returns %FALSE if there's not enough work to bother, so that the
+ * caller should validate synchronously.
+ */
+static gboolean
+gtk_text_layout_wrap_in_background (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextBTree *btree;
+
+  if (!priv->background_wrap || layout->buffer == NULL)
+    return FALSE;
+
+  /* Worker threads can only recreate contexts for the default font map */
+  if (layout->ltr_context == NULL || layout->rtl_context == NULL ||
+      pango_context_get_font_map (layout->ltr_context) != pango_cairo_font_map_get_default () ||
+      pango_context_get_font_map (layout->rtl_context) != pango_cairo_font_map_get_default ())
+    return priv->n_wrap_batches > 0;
+
+  btree = _gtk_text_buffer_get_btree (layout->buffer);
+
+  if (!priv->scan_started || priv->scan_generation != priv->wrap_generation)
+    {
+      /* Outdated batches aren't worth finishing */
+      gtk_text_layout_cancel_wrap (layout);
+
+      priv->scan_started = TRUE;
+      priv->scan_generation = priv->wrap_generation;
+      priv->scan_line = _gtk_text_btree_find_invalid_line (btree, layout, NULL);
+    }
+
+  if (priv->wrap_cancellable == NULL)
+    priv->wrap_cancellable = g_cancellable_new ();
+
+  while (priv->n_wrap_batches < WRAP_MAX_BATCHES && priv->scan_line != NULL)
+    {
+      WrapBatch *batch = NULL;
+      GtkTextLine *line;
+      GTask *task;
+
+      gtk_text_layout_wrap_loop_start (layout);
+
+      /* Valid stretches of the buffer are skipped a node at a time,
+       * so this stays cheap when an edit invalidated a few lines.
+       */
+      for (line = priv->scan_line;
+           line != NULL && (batch == NULL || batch->jobs->len < WRAP_BATCH_LINES);
+           line = _gtk_text_btree_find_invalid_line (btree, layout, line))
+        {
+          GtkTextLineData *line_data = _gtk_text_line_get_data (line, layout);
+          WrapJob job;
+
+          /* The line we stopped at last time may have been validated since */
+          if (line_data && line_data->valid)
+            continue;
+
+          if (batch == NULL)
+            batch = wrap_batch_new (layout);
+
+          if (wrap_job_snapshot (layout, line, &job))
+            g_array_append_val (batch->jobs, job);
+        }
+
+      gtk_text_layout_wrap_loop_end (layout);
+
+      priv->scan_line = line;
+
+      if (batch == NULL)
+        break;
+
+      /* A handful of lines at the end is quicker done right here */
+      if (priv->n_wrap_batches == 0 && line == NULL &&
+          batch->jobs->len < WRAP_MIN_BATCH_LINES)
+        {
+          wrap_batch_free (batch);
+          break;
+        }
+
+      task = g_task_new (layout, priv->wrap_cancellable, wrap_batch_done, NULL);
+      g_task_set_source_tag (task, gtk_text_layout_wrap_in_background);
+      g_task_set_priority (task, GTK_TEXT_VIEW_PRIORITY_VALIDATE);
+      g_task_set_task_data (task, batch, wrap_batch_free);
+      g_task_run_in_thread (task, wrap_batch_thread);
+      g_object_unref (task);
+
+      priv->n_wrap_batches++;
+    }
+
+  return priv->n_wrap_batches > 0;
+}
+
+/**
+ * gtk_text_layout_set_background_wrap:
+ * @layout: a `GtkTextLayout`
+ * @background_wrap: whether to wrap paragraphs on worker threads
+ *
+ * Lets gtk_text_layout_validate() measure paragraphs on worker
+ * threads. While that is happening, gtk_text_layout_is_wrapping()
+ * returns %TRUE and results arrive via the ::changed signal. The
+ * ::invalidated signal is emitted when the remaining invalid lines
+ * have to be validated synchronously.
+ */
+void
+gtk_text_layout_set_background_wrap (GtkTextLayout *layout,
+                                     gboolean       background_wrap)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+
+  priv->background_wrap = !!background_wrap;
+}
+
+gboolean
+gtk_text_layout_is_wrapping (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  g_return_val_if_fail (GTK_IS_TEXT_LAYOUT (layout), FALSE);
+
+  return priv->n_wrap_batches > 0;
+}
+
 /**
  * gtk_text_layout_validate:
  * @tree: a `GtkTextLayout`
@@ -1038,6 +1550,9 @@ gtk_text_layout_validate (GtkTextLayout *layout,
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
 
+  if (gtk_text_layout_wrap_in_background (layout))
+    return;
+
   btree = _gtk_text_buffer_get_btree (layout->buffer);
   while (max_pixels > 0 &&
          _gtk_text_btree_validate (btree,
@@ -1057,6 +1572,7 @@ gtk_text_layout_wrap (GtkTextLayout   *layout,
                       /* may be NULL */
                       GtkTextLineData *line_data)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
   PangoRectangle ink_rect, logical_rect;
 
@@ -1069,6 +1585,16 @@ gtk_text_layout_wrap (GtkTextLayout   *layout,
       _gtk_text_line_add_data (line, line_data);
     }
 
+  if (priv->committing != NULL && priv->committing->line == line)
+    {
+      line_data->width = priv->committing->result_width;
+      line_data->height = priv->committing->result_height;
+      line_data->top_ink = priv->committing->top_ink;
+      line_data->bottom_ink = priv->committing->bottom_ink;
+      line_data->valid = TRUE;
+      return line_data;
+    }
+
   display = gtk_text_layout_get_line_display (layout, line, TRUE);
   line_data->width = display->width;
   line_data->height = display->height;
@@ -2246,10 +2772,14 @@ tags_array_toggle_tag (GPtrArray  *array,
   return array;
 }
 
-GtkTextLineDisplay *
-gtk_text_layout_create_display (GtkTextLayout *layout,
-                                GtkTextLine   *line,
-                                gboolean       size_only)
+/* With @measure set to %FALSE, the PangoLayout is set up but not
+ * laid out, and the display's width and height are not final.
+ */
+static GtkTextLineDisplay *
+gtk_text_layout_build_display (GtkTextLayout *layout,
+                               GtkTextLine   *line,
+                               gboolean       size_only,
+                               gboolean       measure)
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
@@ -2560,34 +3090,37 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
   g_slist_free (cursor_byte_offsets);
   g_slist_free (cursor_segs);
 
-  pango_layout_get_extents (display->layout, NULL, &extents);
+  if (measure)
+    {
+      pango_layout_get_extents (display->layout, NULL, &extents);
 
-  text_pixel_width = PIXEL_BOUND (extents.width);
+      text_pixel_width = PIXEL_BOUND (extents.width);
 
-  h_margin = display->left_margin + display->right_margin;
-  h_padding = layout->left_padding + layout->right_padding;
+      h_margin = display->left_margin + display->right_margin;
+      h_padding = layout->left_padding + layout->right_padding;
 
-  display->width = text_pixel_width + h_margin + h_padding;
-  display->height += PANGO_PIXELS (extents.height);
+      display->width = text_pixel_width + h_margin + h_padding;
+      display->height += PANGO_PIXELS (extents.height);
 
-  /* If we aren't wrapping, we need to do the alignment of each
-   * paragraph ourselves.
-   */
-  if (pango_layout_get_width (display->layout) < 0)
-    {
-      int excess = display->total_width - text_pixel_width;
-
-      switch (pango_layout_get_alignment (display->layout))
+      /* If we aren't wrapping, we need to do the alignment of each
+       * paragraph ourselves.
+       */
+      if (pango_layout_get_width (display->layout) < 0)
         {
-        case PANGO_ALIGN_LEFT:
-        default:
-          break;
-        case PANGO_ALIGN_CENTER:
-          display->x_offset += excess / 2;
-          break;
-        case PANGO_ALIGN_RIGHT:
-          display->x_offset += excess;
-          break;
+          int excess = display->total_width - text_pixel_width;
+
+          switch (pango_layout_get_alignment (display->layout))
+            {
+            case PANGO_ALIGN_LEFT:
+            default:
+              break;
+            case PANGO_ALIGN_CENTER:
+              display->x_offset += excess / 2;
+              break;
+            case PANGO_ALIGN_RIGHT:
+              display->x_offset += excess;
+              break;
+            }
         }
     }
   
@@ -2608,6 +3141,14 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
   return g_steal_pointer (&display);
 }
 
+GtkTextLineDisplay *
+gtk_text_layout_create_display (GtkTextLayout *layout,
+                                GtkTextLine   *line,
+                                gboolean       size_only)
+{
+  return gtk_text_layout_build_display (layout, line, size_only, TRUE);
+}
+
 GtkTextLineDisplay *
 gtk_text_layout_get_line_display (GtkTextLayout *layout,
                                   GtkTextLine   *line,
@@ -4065,6 +4606,56 @@ snapshot_shape (PangoAttrShape         *attr,
   return FALSE;
 }
 
+static void
+snapshot_display_cursors (GtkSnapshot        *snapshot,
+                          GtkStyleContext    *context,
+                          GtkTextLineDisplay *line_display,
+                          int                 offset_y,
+                          float               cursor_alpha)
+{
+  PangoDirection dir;
+
+  dir = (line_display->direction == GTK_TEXT_DIR_RTL) ? PANGO_DIRECTION_RTL : PANGO_DIRECTION_LTR;
+
+  for (int i = 0; i < line_display->cursors->len; i++)
+    {
+      CursorPosition cursor;
+
+      cursor = g_array_index (line_display->cursors, CursorPosition, i);
+
+      if (cursor.is_insert || cursor.is_selection_bound)
+        gtk_snapshot_push_opacity (snapshot, cursor_alpha);
+
+      gtk_snapshot_render_insertion_cursor (snapshot, context,
+                                            line_display->x_offset, offset_y + line_display->top_margin,
+                                            line_display->layout, cursor.pos, dir);
+
+      if (cursor.is_insert || cursor.is_selection_bound)
+        gtk_snapshot_pop (snapshot);
+    }
+}
+
+static void
+clear_snapshot_cursors (gpointer data)
+{
+  SnapshotCursors *cursors = data;
+
+  gtk_text_line_display_unref (cursors->display);
+}
+
+static void
+gtk_text_layout_clear_snapshot (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  g_clear_pointer (&priv->snapshot_node, gsk_render_node_unref);
+  priv->snapshot_first_line = NULL;
+  priv->snapshot_last_line = NULL;
+
+  if (priv->snapshot_cursors)
+    g_array_set_size (priv->snapshot_cursors, 0);
+}
+
 void
 gtk_text_layout_snapshot (GtkTextLayout      *layout,
                           GtkWidget          *widget,
@@ -4079,6 +4670,8 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
   GtkTextIter selection_start, selection_end;
   int selection_start_line;
   int selection_end_line;
+  int selection_start_offset;
+  int selection_end_offset;
   gboolean have_selection;
   gboolean draw_selection_text;
   const GdkRGBA *selection;
@@ -4087,6 +4680,9 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
   GtkTextBTree *btree;
   GtkTextLine *first_line;
   GtkTextLine *last_line;
+  GskRenderNode *lines_node;
+  guint generation;
+  gboolean cacheable;
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
   g_return_if_fail (layout->default_style != NULL);
@@ -4116,14 +4712,6 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
 
   cursor_snapshot = NULL;
 
-  crenderer = gsk_pango_renderer_acquire ();
-
-  gsk_pango_renderer_set_shape_handler (crenderer, snapshot_shape);
-
-  crenderer->widget = widget;
-  crenderer->snapshot = snapshot;
-  crenderer->fg_color = &color;
-
   have_selection = gtk_text_buffer_get_selection_bounds (layout->buffer,
                                                          &selection_start,
                                                          &selection_end);
@@ -4144,6 +4732,9 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
       draw_selection_text = text_color.alpha > 0;
 
       gtk_style_context_restore (context);
+
+      selection_start_offset = gtk_text_iter_get_offset (&selection_start);
+      selection_end_offset = gtk_text_iter_get_offset (&selection_end);
     }
   else
     {
@@ -4151,8 +4742,66 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
       selection_end_line = -1;
       selection = NULL;
       draw_selection_text = FALSE;
+      selection_start_offset = -1;
+      selection_end_offset = -1;
+    }
+
+  /* When only the scroll offset changed, the same lines are usually
+   * still visible. If none of their displays was invalidated since,
+   * the node for them can be reused as is.
+   */
+  generation = gtk_text_line_display_cache_get_generation (priv->cache);
+
+  if (priv->snapshot_node != NULL &&
+      priv->snapshot_generation == generation &&
+      priv->snapshot_first_line == first_line &&
+      priv->snapshot_last_line == last_line &&
+      gdk_rgba_equal (&priv->snapshot_color, &color) &&
+      /* The selection is drawn into the node, and moving only the
+       * selection bound doesn't invalidate any display.
+       */
+      priv->snapshot_selection_start == selection_start_offset &&
+      priv->snapshot_selection_end == selection_end_offset &&
+      gdk_rgba_equal (&priv->snapshot_selection,
+                      selection && draw_selection_text ? selection : &(GdkRGBA) { 0, 0, 0, 0 }))
+    {
+      gtk_snapshot_append_node (snapshot, priv->snapshot_node);
+
+      for (guint i = 0; i < priv->snapshot_cursors->len; i++)
+        {
+          SnapshotCursors *cursors = &g_array_index (priv->snapshot_cursors, SnapshotCursors, i);
+
+          snapshot_display_cursors (snapshot, context, cursors->display, cursors->offset_y, cursor_alpha);
+        }
+
+      gtk_text_line_display_cache_delay_eviction (priv->cache);
+
+      return;
     }
 
+  gtk_text_layout_clear_snapshot (layout);
+
+  if (priv->snapshot_cursors == NULL)
+    {
+      priv->snapshot_cursors = g_array_new (FALSE, FALSE, sizeof (SnapshotCursors));
+      g_array_set_clear_func (priv->snapshot_cursors, clear_snapshot_cursors);
+    }
+
+  /* Lines with a block cursor depend on the cursor blink, and child
+   * widgets need to be allocated, so those can't be reused.
+   */
+  cacheable = TRUE;
+
+  crenderer = gsk_pango_renderer_acquire ();
+
+  gsk_pango_renderer_set_shape_handler (crenderer, snapshot_shape);
+
+  crenderer->widget = widget;
+  crenderer->snapshot = snapshot;
+  crenderer->fg_color = &color;
+
+  gtk_snapshot_push_collect (snapshot);
+
   gtk_text_layout_wrap_loop_start (layout);
 
   for (GtkTextLine *line = first_line;
@@ -4165,6 +4814,9 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
 
       line_display = gtk_text_layout_get_line_display (layout, line, FALSE);
 
+      if (line_display->has_block_cursor || line_display->has_children)
+        cacheable = FALSE;
+
       if (line_display->height > 0)
         {
           g_assert (line_display->layout != NULL);
@@ -4238,27 +4890,13 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
            */
           if (line_display->cursors != NULL)
             {
+              SnapshotCursors cursors = { gtk_text_line_display_ref (line_display), offset_y };
+
               if (cursor_snapshot == NULL)
                 cursor_snapshot = gtk_snapshot_new ();
 
-              for (int i = 0; i < line_display->cursors->len; i++)
-                {
-                  PangoDirection dir;
-                  CursorPosition cursor;
-
-                  cursor = g_array_index (line_display->cursors, CursorPosition, i);
-                  dir = (line_display->direction == GTK_TEXT_DIR_RTL) ? PANGO_DIRECTION_RTL : PANGO_DIRECTION_LTR;
-
-                  if (cursor.is_insert || cursor.is_selection_bound)
-                    gtk_snapshot_push_opacity (cursor_snapshot, cursor_alpha);
-
-                  gtk_snapshot_render_insertion_cursor (cursor_snapshot, context,
-                                                        line_display->x_offset, offset_y + line_display->top_margin,
-                                                        line_display->layout, cursor.pos, dir);
-
-                  if (cursor.is_insert || cursor.is_selection_bound)
-                    gtk_snapshot_pop (cursor_snapshot);
-                }
+              snapshot_display_cursors (cursor_snapshot, context, line_display, offset_y, cursor_alpha);
+              g_array_append_val (priv->snapshot_cursors, cursors);
             }
         } /* line_display->height > 0 */
 
@@ -4272,6 +4910,33 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
 
   gtk_text_layout_wrap_loop_end (layout);
 
+  lines_node = gtk_snapshot_pop_collect (snapshot);
+  if (lines_node)
+    {
+      gtk_snapshot_append_node (snapshot, lines_node);
+
+      /* Creating displays may have evicted others from the cache,
+       * only keep the node if nothing changed while drawing.
+       */
+      if (cacheable &&
+          generation == gtk_text_line_display_cache_get_generation (priv->cache))
+        {
+          priv->snapshot_node = lines_node;
+          priv->snapshot_first_line = first_line;
+          priv->snapshot_last_line = last_line;
+          priv->snapshot_generation = generation;
+          priv->snapshot_color = color;
+          priv->snapshot_selection = selection && draw_selection_text ? *selection : (GdkRGBA) { 0, 0, 0, 0 };
+          priv->snapshot_selection_start = selection_start_offset;
+          priv->snapshot_selection_end = selection_end_offset;
+        }
+      else
+        gsk_render_node_unref (lines_node);
+    }
+
+  if (priv->snapshot_node == NULL)
+    g_array_set_size (priv->snapshot_cursors, 0);
+
   if (cursor_snapshot)
     {
       GskRenderNode *cursors;
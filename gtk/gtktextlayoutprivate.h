@@ -300,6 +300,10 @@ void     gtk_text_layout_validate_yrange (GtkTextLayout *layout,
 void     gtk_text_layout_validate        (GtkTextLayout *layout,
                                           int            max_pixels);
 
+void     gtk_text_layout_set_background_wrap (GtkTextLayout *layout,
+                                              gboolean       background_wrap);
+gboolean gtk_text_layout_is_wrapping         (GtkTextLayout *layout);
+
 GtkTextLineData* gtk_text_layout_wrap  (GtkTextLayout   *layout,
                                         GtkTextLine     *line,
                                         GtkTextLineData *line_data);
@@ -36,6 +36,7 @@ struct _GtkTextLineDisplayCache
   GQueue       mru;
   GSource     *evict_source;
   guint        mru_size;
+  guint        generation;
 
 #if DEBUG_LINE_DISPLAY_CACHE
   guint       log_source;
@@ -231,6 +232,8 @@ gtk_text_line_display_cache_invalidate_display (GtkTextLineDisplayCache *cache,
   g_assert (display != NULL);
   g_assert (display->line != NULL);
 
+  cache->generation++;
+
   if (cursors_only)
     {
       g_clear_pointer (&display->cursors, g_array_unref);
@@ -345,6 +348,7 @@ gtk_text_line_display_cache_invalidate (GtkTextLineDisplayCache *cache)
 
   STAT_ADD (cache->inval, g_hash_table_size (cache->line_to_display));
 
+  cache->generation++;
   cache->cursor_line = NULL;
 
   while (cache->mru.head != NULL)
@@ -370,6 +374,8 @@ gtk_text_line_display_cache_invalidate_cursors (GtkTextLineDisplayCache *cache,
 
   STAT_INC (cache->inval_cursors);
 
+  cache->generation++;
+
   display = g_hash_table_lookup (cache->line_to_display, line);
 
   if (display != NULL)
@@ -395,6 +401,8 @@ gtk_text_line_display_cache_invalidate_line (GtkTextLineDisplayCache *cache,
   g_assert (cache != NULL);
   g_assert (line != NULL);
 
+  cache->generation++;
+
   display = g_hash_table_lookup (cache->line_to_display, line);
 
   if (display != NULL)
@@ -503,6 +511,8 @@ gtk_text_line_display_cache_invalidate_range (GtkTextLineDisplayCache *cache,
 
   STAT_INC (cache->inval_by_range);
 
+  cache->generation++;
+
   /* Short-circuit, is_empty() is O(1) */
   if (g_sequence_is_empty (cache->sorted_by_line))
     return;
@@ -671,6 +681,8 @@ gtk_text_line_display_cache_invalidate_y_range (GtkTextLineDisplayCache *cache,
 
   STAT_INC (cache->inval_by_y_range);
 
+  cache->generation++;
+
   /* A common pattern is to invalidate the whole buffer using y==0 and
    * old_height==new_height. So special case that instead of walking through
    * each display item one at a time.
@@ -725,6 +737,8 @@ gtk_text_line_display_cache_set_cursor_line (GtkTextLineDisplayCache *cache,
   if (cursor_line == cache->cursor_line)
     return;
 
+  cache->generation++;
+
   display = g_hash_table_lookup (cache->line_to_display, cache->cursor_line);
 
   if (display != NULL)
@@ -761,3 +775,24 @@ gtk_text_line_display_cache_set_mru_size (GtkTextLineDisplayCache *cache,
         }
     }
 }
+
+/*
+ * gtk_text_line_display_cache_get_generation:
+ * @cache: a `GtkTextLineDisplayCache`
+ *
+ * Gets a counter that changes whenever anything in @cache is
+ * invalidated, even if no cached display was affected.
+ *
+ * This allows callers to keep things derived from the displays,
+ * such as the render nodes for a range of lines, for as long as
+ * the generation stays the same.
+ *
+ * Returns: the current generation
+ */
+guint
+gtk_text_line_display_cache_get_generation (GtkTextLineDisplayCache *cache)
+{
+  g_assert (cache != NULL);
+
+  return cache->generation;
+}
@@ -56,6 +56,7 @@ void                     gtk_text_line_display_cache_invalidate_y_range (GtkText
                                                                          gboolean                 cursors_only);
 void                     gtk_text_line_display_cache_set_mru_size       (GtkTextLineDisplayCache *cache,
                                                                          guint                    mru_size);
+guint                    gtk_text_line_display_cache_get_generation     (GtkTextLineDisplayCache *cache);
 
 G_END_DECLS
 
@@ -4795,7 +4795,11 @@ incremental_validate_callback (gpointer data)
 
   gtk_text_view_update_adjustments (text_view);
   
-  if (gtk_text_layout_is_valid (text_view->priv->layout))
+  /* Worker threads are wrapping, changed_handler() picks up their
+   * results and the layout emits ::invalidated if anything is left.
+   */
+  if (gtk_text_layout_is_valid (text_view->priv->layout) ||
+      gtk_text_layout_is_wrapping (text_view->priv->layout))
     {
       text_view->priv->incremental_validate_idle = 0;
       result = FALSE;
@@ -7723,6 +7727,7 @@ gtk_text_view_ensure_layout (GtkTextView *text_view)
       DV(g_print(G_STRLOC"\n"));
       
       priv->layout = gtk_text_layout_new ();
+      gtk_text_layout_set_background_wrap (priv->layout, TRUE);
 
       g_signal_connect (priv->layout,
 			"invalidated",
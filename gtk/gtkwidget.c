@@ -48,6 +48,7 @@
 #include "gtkgestureprivate.h"
 #include "gtkintl.h"
 #include "gtklayoutmanagerprivate.h"
+#include "gtklazywidgetprivate.h"
 #include "gtkmain.h"
 #include "gtkmarshalers.h"
 #include "gtknative.h"
@@ -450,6 +451,44 @@
  *   gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), hello_button_clicked);
  * }
  * ```
+ *
+ * Since GTK 4.4, parts of a template that are not shown right away, like
+ * the pages of a `GtkStack` or the content of a popover, can be marked with
+ * `lazy="yes"` on their `<object>` tag:
+ *
+ * ```xml
+ * <child>
+ *   <object class="GtkStackPage">
+ *     <property name="name">advanced</property>
+ *     <property name="child">
+ *       <object class="GtkBox" id="advanced_page" lazy="yes">
+ *         ...
+ *       </object>
+ *     </property>
+ *   </object>
+ * </child>
+ * ```
+ *
+ * Such an object and everything inside of it is only built when it is
+ * mapped for the first time, or when a template child inside of it is
+ * requested with [method@Gtk.Widget.get_template_child]. Until then,
+ * pointers to bound template children inside of it are %NULL.
+ *
+ * The lazy object is put into a placeholder widget, which is added to the
+ * parent instead of it. The placeholder stays in the widget tree after the
+ * object was built, as the parent of the object. So in the example above,
+ * the child of the stack page and [method@Gtk.Stack.get_visible_child]
+ * return the placeholder, [method@Gtk.Widget.get_parent] of `advanced_page`
+ * returns the placeholder, and CSS child selectors see the placeholder
+ * between the stack and `advanced_page`.
+ *
+ * A lazy object can refer to the template object and to all other objects
+ * in the template, but other objects can not refer to objects inside of it.
+ * Since the placeholder is what gets added to the parent, a lazy object can
+ * not have a `<layout>` element or set the [property@Gtk.Widget:visible]
+ * property, doing so is an error. The `lazy` attribute is only supported
+ * for widgets that are children or property values inside of a template,
+ * and ignored elsewhere.
  */
 
 #define GTK_STATE_FLAGS_DO_SET_PROPAGATE   (GTK_STATE_FLAG_INSENSITIVE | \
@@ -7483,11 +7522,13 @@ gtk_widget_real_destroy (GtkWidget *object)
               for (l = class->priv->template->children; l; l = l->next)
                 {
                   AutomaticChildClass *child_class = l->data;
-                  GObject *child_object = gtk_widget_get_template_child (widget,
-                                                                         class_type,
-                                                                         child_class->name);
+                  GHashTable *auto_child_hash = get_auto_child_hash (widget, class_type, FALSE);
+                  GObject *child_object;
 
-                  g_assert (child_object);
+                  /* Children of lazy objects may never have been built */
+                  child_object = auto_child_hash ? g_hash_table_lookup (auto_child_hash, child_class->name) : NULL;
+                  if (child_object == NULL)
+                    continue;
 
                   if (!G_IS_OBJECT (child_object))
                     {
@@ -10933,6 +10974,96 @@ get_auto_child_hash (GtkWidget *widget,
   return auto_child_hash;
 }
 
+static void
+bind_template_child (GtkWidget           *widget,
+                     GType                class_type,
+                     AutomaticChildClass *child_class,
+                     GObject             *child)
+{
+  GHashTable *auto_child_hash;
+
+  /* Insert into the hash so that it can be fetched with
+   * gtk_widget_get_template_child() and also in automated
+   * implementations of GtkBuildable.get_internal_child() */
+  auto_child_hash = get_auto_child_hash (widget, class_type, TRUE);
+  g_hash_table_insert (auto_child_hash, child_class->name, g_object_ref (child));
+
+  if (child_class->offset != 0)
+    {
+      gpointer field_p;
+
+      /* Assign 'object' to the specified offset in the instance (or private) data */
+      field_p = G_STRUCT_MEMBER_P (widget, child_class->offset);
+      (* (gpointer *) field_p) = child;
+    }
+}
+
+/*
+ * gtk_widget_expose_template_children:
+ * @widget: a `GtkWidget`
+ * @class_type: the type that defined the template
+ * @builder: a `GtkBuilder`
+ *
+ * Exposes the template children of @class_type that have
+ * been built already in @builder, so that lazy objects can
+ * refer to them.
+ */
+void
+gtk_widget_expose_template_children (GtkWidget  *widget,
+                                     GType       class_type,
+                                     GtkBuilder *builder)
+{
+  GHashTable *auto_child_hash;
+  GHashTableIter iter;
+  gpointer name, child;
+
+  auto_child_hash = get_auto_child_hash (widget, class_type, FALSE);
+  if (auto_child_hash == NULL)
+    return;
+
+  g_hash_table_iter_init (&iter, auto_child_hash);
+  while (g_hash_table_iter_next (&iter, &name, &child))
+    gtk_builder_expose_object (builder, name, child);
+}
+
+/*
+ * gtk_widget_bind_lazy_template_children:
+ * @widget: a `GtkWidget`
+ * @class_type: the type that defined the template
+ * @builder: the `GtkBuilder` that built a lazy object
+ *
+ * Binds the template children of @class_type that were
+ * just built by @builder.
+ */
+void
+gtk_widget_bind_lazy_template_children (GtkWidget  *widget,
+                                        GType       class_type,
+                                        GtkBuilder *builder)
+{
+  GtkWidgetTemplate *template;
+  GHashTable *auto_child_hash;
+  GSList *l;
+
+  template = GTK_WIDGET_CLASS (g_type_class_peek (class_type))->priv->template;
+  if (template == NULL)
+    return;
+
+  auto_child_hash = get_auto_child_hash (widget, class_type, FALSE);
+
+  for (l = template->children; l; l = l->next)
+    {
+      AutomaticChildClass *child_class = l->data;
+      GObject *child;
+
+      if (auto_child_hash && g_hash_table_contains (auto_child_hash, child_class->name))
+        continue;
+
+      child = gtk_builder_get_object (builder, child_class->name);
+      if (child)
+        bind_template_child (widget, class_type, child_class, child);
+    }
+}
+
 /**
  * gtk_widget_init_template:
  * @widget: a `GtkWidget`
@@ -10967,6 +11098,7 @@ gtk_widget_init_template (GtkWidget *widget)
   GObject *object;
   GSList *l;
   GType class_type;
+  gint64 before;
 
   g_return_if_fail (GTK_IS_WIDGET (widget));
 
@@ -10976,6 +11108,8 @@ gtk_widget_init_template (GtkWidget *widget)
   template = GTK_WIDGET_GET_CLASS (widget)->priv->template;
   g_return_if_fail (template != NULL);
 
+  before = GDK_PROFILER_CURRENT_TIME;
+
   builder = gtk_builder_new ();
 
   if (template->scope)
@@ -11005,7 +11139,6 @@ gtk_widget_init_template (GtkWidget *widget)
   for (l = template->children; l; l = l->next)
     {
       AutomaticChildClass *child_class = l->data;
-      GHashTable *auto_child_hash;
       GObject *child;
 
       /* This will setup the pointer of an automated child, and cause
@@ -11014,27 +11147,23 @@ gtk_widget_init_template (GtkWidget *widget)
       child = gtk_builder_get_object (builder, child_class->name);
       if (!child)
         {
+          /* Bound when the lazy object is built */
+          if (gtk_lazy_widget_lookup (widget, class_type, child_class->name, FALSE))
+            continue;
+
           g_critical ("Unable to retrieve child object '%s' from class "
                       "template for type '%s' while building a '%s'",
                       child_class->name, g_type_name (class_type), G_OBJECT_TYPE_NAME (widget));
           goto out;
         }
 
-      /* Insert into the hash so that it can be fetched with
-       * gtk_widget_get_template_child() and also in automated
-       * implementations of GtkBuildable.get_internal_child() */
-      auto_child_hash = get_auto_child_hash (widget, class_type, TRUE);
-      g_hash_table_insert (auto_child_hash, child_class->name, g_object_ref (child));
+      bind_template_child (widget, class_type, child_class, child);
+    }
 
-      if (child_class->offset != 0)
-        {
-          gpointer field_p;
+  /* Lazy objects may refer to anything in the template */
+  gtk_lazy_widget_set_template_objects (widget, class_type, builder);
 
-          /* Assign 'object' to the specified offset in the instance (or private) data */
-          field_p = G_STRUCT_MEMBER_P (widget, child_class->offset);
-          (* (gpointer *) field_p) = child;
-        }
-    }
+  gdk_profiler_end_mark (before, "widget init template", g_type_name (class_type));
 
 out:
   g_object_unref (builder);
@@ -11273,6 +11402,9 @@ gtk_widget_class_bind_template_child_full (GtkWidgetClass *widget_class,
  * to the @widget_type which declared the child and is meant for language
  * bindings which cannot easily make use of the GObject structure offsets.
  *
+ * If the child is part of an object that is marked with `lazy="yes"`
+ * in the template and has not been built yet, it is built now.
+ *
  * Returns: (transfer none): The object built in the template XML with
  *   the id @name
  */
@@ -11293,6 +11425,14 @@ gtk_widget_get_template_child (GtkWidget   *widget,
   if (auto_child_hash)
     ret = g_hash_table_lookup (auto_child_hash, name);
 
+  if (ret == NULL &&
+      gtk_lazy_widget_lookup (widget, widget_type, name, TRUE))
+    {
+      auto_child_hash = get_auto_child_hash (widget, widget_type, FALSE);
+      if (auto_child_hash)
+        ret = g_hash_table_lookup (auto_child_hash, name);
+    }
+
   return ret;
 }
 
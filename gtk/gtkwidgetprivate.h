@@ -326,6 +326,13 @@ GtkWidget *       gtk_widget_common_ancestor               (GtkWidget *widget_a,
 void              gtk_widget_set_active_state              (GtkWidget *widget,
                                                             gboolean   active);
 
+void              gtk_widget_expose_template_children      (GtkWidget           *widget,
+                                                            GType                class_type,
+                                                            GtkBuilder          *builder);
+void              gtk_widget_bind_lazy_template_children   (GtkWidget           *widget,
+                                                            GType                class_type,
+                                                            GtkBuilder          *builder);
+
 void              gtk_widget_cancel_event_sequence         (GtkWidget             *widget,
                                                             GtkGesture            *gesture,
                                                             GdkEventSequence      *sequence,
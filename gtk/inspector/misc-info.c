@@ -74,6 +74,8 @@ struct _GtkInspectorMiscInfo
   GtkWidget *framerate;
   GtkWidget *framecount_row;
   GtkWidget *framecount;
+  GtkWidget *framephases_row;
+  GtkWidget *framephases;
   GtkWidget *mapped_row;
   GtkWidget *mapped;
   GtkWidget *realized_row;
@@ -418,6 +420,13 @@ update_info (gpointer data)
           gtk_label_set_label (GTK_LABEL (sl->framerate), "—");
         }
 
+      tmp = g_strdup_printf ("update %.1f ms, layout %.1f ms, paint %.1f ms",
+                             gdk_frame_clock_get_phase_percentile (clock, GDK_FRAME_CLOCK_PHASE_UPDATE, 95) / 1000.,
+                             gdk_frame_clock_get_phase_percentile (clock, GDK_FRAME_CLOCK_PHASE_LAYOUT, 95) / 1000.,
+                             gdk_frame_clock_get_phase_percentile (clock, GDK_FRAME_CLOCK_PHASE_PAINT, 95) / 1000.);
+      gtk_label_set_label (GTK_LABEL (sl->framephases), tmp);
+      g_free (tmp);
+
       sl->last_frame = frame;
     }
 
@@ -492,11 +501,13 @@ gtk_inspector_misc_info_set_object (GtkInspectorMiscInfo *sl,
     {
       gtk_widget_show (sl->framecount_row);
       gtk_widget_show (sl->framerate_row);
+      gtk_widget_show (sl->framephases_row);
     }
   else
     {
       gtk_widget_hide (sl->framecount_row);
       gtk_widget_hide (sl->framerate_row);
+      gtk_widget_hide (sl->framephases_row);
     }
 
   update_info (sl);
@@ -591,6 +602,8 @@ gtk_inspector_misc_info_class_init (GtkInspectorMiscInfoClass *klass)
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorMiscInfo, framecount);
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorMiscInfo, framerate_row);
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorMiscInfo, framerate);
+  gtk_widget_class_bind_template_child (widget_class, GtkInspectorMiscInfo, framephases_row);
+  gtk_widget_class_bind_template_child (widget_class, GtkInspectorMiscInfo, framephases);
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorMiscInfo, mapped_row);
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorMiscInfo, mapped);
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorMiscInfo, realized_row);
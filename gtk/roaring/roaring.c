@@ -4006,6 +4006,16 @@ bool bitset_container_is_subset(const bitset_container_t *container1,
 	return true;
 }
 
+/* Returns the position of the n-th set bit (0-based) of w, n < hamming(w) */
+static inline int select_in_word(uint64_t w, uint32_t n) {
+#if defined(__BMI2__)
+    return __builtin_ctzll(_pdep_u64(UINT64_C(1) << n, w));
+#else
+    for (; n > 0; n--) w &= w - 1;  // clear the lowest set bit
+    return __builtin_ctzll(w);
+#endif
+}
+
 bool bitset_container_select(const bitset_container_t *container, uint32_t *start_rank, uint32_t rank, uint32_t *element) {
     int card = bitset_container_cardinality(container);
     if(rank >= *start_rank + card) {
@@ -4013,25 +4023,15 @@ bool bitset_container_select(const bitset_container_t *container, uint32_t *star
         return false;
     }
     const uint64_t *array = container->array;
-    int32_t size;
+    uint32_t left = rank - *start_rank;
     for (int i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; i += 1) {
-        size = hamming(array[i]);
-        if(rank <= *start_rank + size) {
-            uint64_t w = container->array[i];
-            uint16_t base = i*64;
-            while (w != 0) {
-                uint64_t t = w & (~w + 1);
-                int r = __builtin_ctzll(w);
-                if(*start_rank == rank) {
-                    *element = r+base;
-                    return true;
-                }
-                w ^= t;
-                *start_rank += 1;
-            }
+        uint32_t size = (uint32_t) hamming(array[i]);
+        if(left < size) {
+            *element = i * 64 + select_in_word(array[i], left);
+            *start_rank = rank;
+            return true;
         }
-        else
-            *start_rank += size;
+        left -= size;
     }
     assert(false);
     __builtin_unreachable();
@@ -4067,6 +4067,15 @@ int bitset_container_rank(const bitset_container_t *container, uint16_t x) {
   // credit: aqrit
   int sum = 0;
   int i = 0;
+#ifdef USEAVX
+  // count whole 256bit blocks in one go
+  int blocks = x / 256;
+  if (blocks > 0) {
+    sum = (int) avx2_harley_seal_popcount256(
+        (const __m256i *)container->array, blocks);
+    i = blocks * 4;
+  }
+#endif
   for (int end = x / 64; i < end; i++){
     sum += hamming(container->array[i]);
   }
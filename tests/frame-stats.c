@@ -23,11 +23,13 @@ struct FrameStats
 static int max_stats = -1;
 static double statistics_time = 5.;
 static gboolean machine_readable = FALSE;
+static gboolean adaptive = FALSE;
 
 static GOptionEntry frame_sync_options[] = {
   { "max-statistics", 'm', 0, G_OPTION_ARG_INT, &max_stats, "Maximum statistics printed", NULL },
   { "machine-readable", 0, 0, G_OPTION_ARG_NONE, &machine_readable, "Print statistics in columns", NULL },
   { "statistics-time", 's', 0, G_OPTION_ARG_DOUBLE, &statistics_time, "Statistics accumulation time", "TIME" },
+  { "adaptive", 'a', 0, G_OPTION_ARG_NONE, &adaptive, "Use adaptive frame scheduling", NULL },
   { NULL }
 };
 
@@ -85,7 +87,7 @@ on_frame_clock_after_paint (GdkFrameClock *frame_clock,
         {
           if (frame_stats->num_stats == 0 && machine_readable)
             {
-              g_print ("# load_factor frame_rate latency\n");
+              g_print ("# load_factor frame_rate latency update layout paint\n");
             }
 
           frame_stats->num_stats++;
@@ -95,12 +97,20 @@ on_frame_clock_after_paint (GdkFrameClock *frame_clock,
 
           print_variable ("Latency", &frame_stats->latency);
 
+          print_double ("Update (95%, ms)",
+                        gdk_frame_clock_get_phase_percentile (frame_clock, GDK_FRAME_CLOCK_PHASE_UPDATE, 95) / 1000.);
+          print_double ("Layout (95%, ms)",
+                        gdk_frame_clock_get_phase_percentile (frame_clock, GDK_FRAME_CLOCK_PHASE_LAYOUT, 95) / 1000.);
+          print_double ("Paint (95%, ms)",
+                        gdk_frame_clock_get_phase_percentile (frame_clock, GDK_FRAME_CLOCK_PHASE_PAINT, 95) / 1000.);
+
           g_print ("\n");
         }
 
       frame_stats->last_print_time = current_time;
       frame_stats->frames_since_last_print = 0;
       variable_init (&frame_stats->latency);
+      gdk_frame_clock_reset_phase_histograms (frame_clock);
 
       if (frame_stats->num_stats == max_stats)
         exit (0);
@@ -135,6 +145,7 @@ on_window_realize (GtkWidget  *window,
                    FrameStats *frame_stats)
 {
   frame_stats->frame_clock = gtk_widget_get_frame_clock (GTK_WIDGET (window));
+  gdk_frame_clock_set_adaptive_scheduling (frame_stats->frame_clock, adaptive);
   g_signal_connect (frame_stats->frame_clock, "after-paint",
                     G_CALLBACK (on_frame_clock_after_paint), frame_stats);
 }
@@ -3,6 +3,8 @@
 
 GtkAdjustment *adjustment;
 int cursor_x, cursor_y;
+guint n_motions, n_history;
+gint64 busy_time;
 
 static void
 motion_cb (GtkEventControllerMotion *motion,
@@ -11,7 +13,22 @@ motion_cb (GtkEventControllerMotion *motion,
            GtkWidget                *widget)
 {
   float processing_ms = gtk_adjustment_get_value (adjustment);
+  GdkEvent *event;
+  gint64 start;
+  guint n_coords;
+
+  start = g_get_monotonic_time ();
+
+  event = gtk_event_controller_get_current_event (GTK_EVENT_CONTROLLER (motion));
+  if (event)
+    {
+      g_free (gdk_event_get_history (event, &n_coords));
+      n_history += n_coords;
+    }
+  n_motions++;
+
   g_usleep (processing_ms * 1000);
+  busy_time += g_get_monotonic_time () - start;
 
   cursor_x = x;
   cursor_y = y;
@@ -34,6 +51,25 @@ on_draw (GtkDrawingArea *da,
   cairo_stroke (cr);
 }
 
+static gboolean
+update_stats (gpointer data)
+{
+  GtkLabel *label = data;
+  char *text;
+
+  /* Called once per second, so the counters are rates */
+  text = g_strdup_printf ("%u motion events/s, %u history coordinates/s, %.0f%% busy",
+                          n_motions, n_history, busy_time / 10000.0);
+  gtk_label_set_label (label, text);
+  g_free (text);
+
+  n_motions = 0;
+  n_history = 0;
+  busy_time = 0;
+
+  return G_SOURCE_CONTINUE;
+}
+
 static void
 quit_cb (GtkWidget *widget,
          gpointer   data)
@@ -51,6 +87,7 @@ main (int argc, char **argv)
   GtkWidget *window;
   GtkWidget *vbox;
   GtkWidget *label;
+  GtkWidget *stats;
   GtkWidget *scale;
   GtkWidget *da;
   GtkEventController *controller;
@@ -77,6 +114,11 @@ main (int argc, char **argv)
   scale = gtk_scale_new (GTK_ORIENTATION_HORIZONTAL, adjustment);
   gtk_box_append (GTK_BOX (vbox), scale);
 
+  stats = gtk_label_new ("");
+  gtk_widget_set_halign (stats, GTK_ALIGN_CENTER);
+  gtk_box_append (GTK_BOX (vbox), stats);
+  g_timeout_add_seconds (1, update_stats, stats);
+
   controller = gtk_event_controller_motion_new ();
   g_signal_connect (controller, "motion",
                     G_CALLBACK (motion_cb), da);
@@ -0,0 +1,172 @@
+/* testlazytemplate.c
+ *
+ * Opens a window whose template has many stack pages and reports
+ * how long it takes until the first frame, with the hidden pages
+ * marked lazy="yes", or built right away with --eager.
+ *
+ * Usage: testlazytemplate [--eager] [--quit]
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "config.h"
+#include <gtk/gtk.h>
+
+#define N_PAGES 40
+#define N_ROWS 30
+
+static gboolean eager;
+static gboolean quit;
+static gint64 start_time;
+
+typedef struct
+{
+  GtkWindowClass parent_class;
+} PagesWindowClass;
+
+typedef struct
+{
+  GtkWindow parent_instance;
+} PagesWindow;
+
+G_DEFINE_TYPE (PagesWindow, pages_window, GTK_TYPE_WINDOW);
+
+static void
+pages_window_init (PagesWindow *self)
+{
+  gtk_widget_init_template (GTK_WIDGET (self));
+}
+
+static GBytes *
+create_template (void)
+{
+  GString *s;
+  int i, j;
+
+  s = g_string_new ("<interface>\n"
+                    "  <template class='PagesWindow' parent='GtkWindow'>\n"
+                    "    <property name='default-width'>600</property>\n"
+                    "    <property name='default-height'>400</property>\n"
+                    "    <child>\n"
+                    "      <object class='GtkStack' id='stack'>\n");
+
+  for (i = 0; i < N_PAGES; i++)
+    {
+      g_string_append_printf (s,
+                              "        <child>\n"
+                              "          <object class='GtkStackPage'>\n"
+                              "            <property name='name'>page%d</property>\n"
+                              "            <property name='child'>\n"
+                              "              <object class='GtkBox'%s>\n"
+                              "                <property name='orientation'>vertical</property>\n",
+                              i, i > 0 && !eager ? " lazy='yes'" : "");
+
+      for (j = 0; j < N_ROWS; j++)
+        g_string_append_printf (s,
+                                "                <child>\n"
+                                "                  <object class='GtkBox'>\n"
+                                "                    <child>\n"
+                                "                      <object class='GtkLabel'>\n"
+                                "                        <property name='label'>Setting %d</property>\n"
+                                "                      </object>\n"
+                                "                    </child>\n"
+                                "                    <child>\n"
+                                "                      <object class='GtkEntry'/>\n"
+                                "                    </child>\n"
+                                "                  </object>\n"
+                                "                </child>\n",
+                                j);
+
+      g_string_append (s,
+                       "              </object>\n"
+                       "            </property>\n"
+                       "          </object>\n"
+                       "        </child>\n");
+    }
+
+  g_string_append (s,
+                   "      </object>\n"
+                   "    </child>\n"
+                   "  </template>\n"
+                   "</interface>\n");
+
+  return g_string_free_to_bytes (s);
+}
+
+static void
+pages_window_class_init (PagesWindowClass *klass)
+{
+  GBytes *template = create_template ();
+
+  gtk_widget_class_set_template (GTK_WIDGET_CLASS (klass), template);
+  g_bytes_unref (template);
+}
+
+static gboolean
+first_frame (GtkWidget     *widget,
+             GdkFrameClock *clock,
+             gpointer       data)
+{
+  g_print ("%s: first frame after %.1f ms\n",
+           eager ? "eager" : "lazy",
+           (g_get_monotonic_time () - start_time) / 1000.0);
+
+  if (quit)
+    gtk_window_destroy (GTK_WINDOW (widget));
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+quit_cb (GtkWidget *widget,
+         gpointer   data)
+{
+  gboolean *done = data;
+
+  *done = TRUE;
+
+  g_main_context_wakeup (NULL);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GtkWidget *window;
+  gboolean done = FALSE;
+  int i;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (g_str_equal (argv[i], "--eager"))
+        eager = TRUE;
+      else if (g_str_equal (argv[i], "--quit"))
+        quit = TRUE;
+    }
+
+  gtk_init ();
+
+  /* Don't count creating the template */
+  g_type_class_unref (g_type_class_ref (pages_window_get_type ()));
+
+  start_time = g_get_monotonic_time ();
+
+  window = g_object_new (pages_window_get_type (), NULL);
+  g_signal_connect (window, "destroy", G_CALLBACK (quit_cb), &done);
+  gtk_widget_add_tick_callback (window, first_frame, NULL, NULL);
+  gtk_widget_show (window);
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  return 0;
+}
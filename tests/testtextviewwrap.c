@@ -0,0 +1,177 @@
+/* testtextviewwrap.c
+ *
+ * Loads a big file (or generates a big log) into a wrapping
+ * GtkTextView and reports how long it takes until all lines
+ * are validated, i.e. until the scrollbar stops changing.
+ *
+ * Usage: testtextviewwrap [FILE]
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "config.h"
+#include <gtk/gtk.h>
+
+#define N_LINES 200000
+
+/* How long "upper" has to stay the same before we call it done */
+#define SETTLE_TIME (G_USEC_PER_SEC / 2)
+
+static gint64 start_time;
+static gint64 last_change;
+static double last_upper;
+static guint n_changes;
+static GtkWidget *label;
+
+static char *
+create_log (gsize *length)
+{
+  const char *words[] = {
+    "connection", "established", "to", "server", "timeout", "while",
+    "waiting", "for", "reply", "retrying", "request", "failed", "with",
+    "status", "ok", "payload", "size", "bytes", "cache", "miss", "hit",
+  };
+  GString *s;
+  guint i, j, n;
+
+  s = g_string_new (NULL);
+
+  for (i = 0; i < N_LINES; i++)
+    {
+      g_string_append_printf (s, "%02u:%02u:%02u.%03u [%5d] ",
+                              (i / 3600000) % 24, (i / 60000) % 60,
+                              (i / 1000) % 60, i % 1000, g_random_int_range (1, 65536));
+
+      /* Mostly short lines, and some that wrap a few times */
+      n = g_random_int_range (0, 10) == 0 ? g_random_int_range (40, 120)
+                                          : g_random_int_range (4, 16);
+      for (j = 0; j < n; j++)
+        {
+          g_string_append (s, words[g_random_int_range (0, G_N_ELEMENTS (words))]);
+          g_string_append_c (s, j + 1 < n ? ' ' : '\n');
+        }
+    }
+
+  *length = s->len;
+
+  return g_string_free (s, FALSE);
+}
+
+static void
+upper_changed (GtkAdjustment *adjustment)
+{
+  last_upper = gtk_adjustment_get_upper (adjustment);
+  last_change = g_get_monotonic_time ();
+  n_changes++;
+}
+
+static gboolean
+check_settled (GtkWidget     *widget,
+               GdkFrameClock *clock,
+               gpointer       data)
+{
+  gint64 now = g_get_monotonic_time ();
+  char *text;
+
+  if (n_changes == 0 || now - last_change < SETTLE_TIME)
+    {
+      text = g_strdup_printf ("Validating… %.1f s, height %.0f px",
+                              (now - start_time) / (double) G_USEC_PER_SEC, last_upper);
+      gtk_label_set_label (GTK_LABEL (label), text);
+      g_free (text);
+
+      return G_SOURCE_CONTINUE;
+    }
+
+  text = g_strdup_printf ("Validated in %.3f s, height %.0f px, %u updates",
+                          (last_change - start_time) / (double) G_USEC_PER_SEC,
+                          last_upper, n_changes);
+  gtk_label_set_label (GTK_LABEL (label), text);
+  g_print ("%s\n", text);
+  g_free (text);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+quit_cb (GtkWidget *widget,
+         gpointer   data)
+{
+  gboolean *done = data;
+
+  *done = TRUE;
+
+  g_main_context_wakeup (NULL);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GtkWidget *window, *box, *sw, *tv;
+  GtkTextBuffer *buffer;
+  GtkAdjustment *vadjustment;
+  GError *error = NULL;
+  gboolean done = FALSE;
+  char *contents;
+  gsize length;
+
+  gtk_init ();
+
+  if (argc > 1)
+    {
+      if (!g_file_get_contents (argv[1], &contents, &length, &error))
+        {
+          g_printerr ("%s\n", error->message);
+          return 1;
+        }
+    }
+  else
+    contents = create_log (&length);
+
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 800, 600);
+  g_signal_connect (window, "destroy", G_CALLBACK (quit_cb), &done);
+
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  gtk_window_set_child (GTK_WINDOW (window), box);
+
+  sw = gtk_scrolled_window_new ();
+  gtk_widget_set_vexpand (sw, TRUE);
+  gtk_box_append (GTK_BOX (box), sw);
+
+  tv = gtk_text_view_new ();
+  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (tv), GTK_WRAP_WORD_CHAR);
+  gtk_text_view_set_monospace (GTK_TEXT_VIEW (tv), TRUE);
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw), tv);
+
+  label = gtk_label_new ("");
+  gtk_label_set_xalign (GTK_LABEL (label), 0);
+  gtk_box_append (GTK_BOX (box), label);
+
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (tv));
+  vadjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (tv));
+  g_signal_connect (vadjustment, "notify::upper", G_CALLBACK (upper_changed), NULL);
+
+  start_time = g_get_monotonic_time ();
+  gtk_text_buffer_set_text (buffer, contents, (int) length);
+  g_free (contents);
+
+  gtk_widget_add_tick_callback (window, check_settled, NULL, NULL);
+
+  gtk_widget_show (window);
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  return 0;
+}
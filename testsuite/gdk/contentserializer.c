@@ -169,6 +169,65 @@ test_content_text_plain (void)
   g_value_unset (&value);
 }
 
+static char *
+create_large_text (gsize        size,
+                   const char  *pattern)
+{
+  GString *str;
+  gsize len = strlen (pattern);
+
+  str = g_string_sized_new (size + len);
+  while (str->len < size)
+    g_string_append_len (str, pattern, len);
+
+  return g_string_free (str, FALSE);
+}
+
+static void
+test_content_text_plain_utf8_large (void)
+{
+  GValue value = G_VALUE_INIT;
+
+  /* Multibyte characters end up on both sides of chunk boundaries */
+  g_value_init (&value, G_TYPE_STRING);
+  g_value_take_string (&value, create_large_text (1024 * 1024, "ABC\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80"));
+  test_content_roundtrip (&value, "text/plain;charset=utf-8", compare_string_values);
+  g_value_unset (&value);
+}
+
+static void
+test_content_text_plain_large (void)
+{
+  GValue value = G_VALUE_INIT;
+
+  g_value_init (&value, G_TYPE_STRING);
+  g_value_take_string (&value, create_large_text (1024 * 1024, "ABCDEF12345\n"));
+  test_content_roundtrip (&value, "text/plain", compare_string_values);
+  g_value_unset (&value);
+}
+
+static void
+test_content_text_performance (void)
+{
+  GValue value = G_VALUE_INIT;
+  gsize size = 256 * 1024 * 1024;
+  double elapsed;
+
+  if (!g_test_perf ())
+    return;
+
+  g_value_init (&value, G_TYPE_STRING);
+  g_value_take_string (&value, create_large_text (size, "The quick brown fox jumps over the lazy d\xc3\xb6g\n"));
+
+  g_test_timer_start ();
+  test_content_roundtrip (&value, "text/plain;charset=utf-8", compare_string_values);
+  elapsed = g_test_timer_elapsed ();
+
+  g_test_minimized_result (elapsed, "roundtrip of %zu MB of text: %.3fs", size / (1024 * 1024), elapsed);
+
+  g_value_unset (&value);
+}
+
 static void
 test_content_color (void)
 {
@@ -405,6 +464,9 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/content/text_plain_utf8", test_content_text_plain_utf8);
   g_test_add_func ("/content/text_plain", test_content_text_plain);
+  g_test_add_func ("/content/text_plain_utf8_large", test_content_text_plain_utf8_large);
+  g_test_add_func ("/content/text_plain_large", test_content_text_plain_large);
+  g_test_add_func ("/content/text_performance", test_content_text_performance);
   g_test_add_func ("/content/color", test_content_color);
   g_test_add_func ("/content/file", test_content_file);
   g_test_add_func ("/content/files", test_content_files);
@@ -0,0 +1,136 @@
+#include <gtk/gtk.h>
+
+#define N_FRAMES 10
+
+static guint64
+histogram_total (GdkFrameClock      *clock,
+                 GdkFrameClockPhase  phase)
+{
+  const guint *histogram;
+  gsize i, n_buckets;
+  guint64 total = 0;
+
+  histogram = gdk_frame_clock_get_phase_histogram (clock, phase, &n_buckets);
+  g_assert_nonnull (histogram);
+  g_assert_cmpuint (n_buckets, >, 0);
+
+  for (i = 0; i < n_buckets; i++)
+    total += histogram[i];
+
+  return total;
+}
+
+static gboolean
+tick_cb (GtkWidget     *widget,
+         GdkFrameClock *clock,
+         gpointer       data)
+{
+  guint *n_frames = data;
+
+  (*n_frames)++;
+  g_main_context_wakeup (NULL);
+
+  return *n_frames < N_FRAMES ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+static gboolean
+timeout_cb (gpointer data)
+{
+  gboolean *timed_out = data;
+
+  *timed_out = TRUE;
+  g_main_context_wakeup (NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+static GdkFrameClock *
+run_frames (GtkWidget *window)
+{
+  gboolean timed_out = FALSE;
+  guint n_frames = 0;
+  guint timeout_id;
+
+  gtk_widget_add_tick_callback (window, tick_cb, &n_frames, NULL);
+  timeout_id = g_timeout_add_seconds (10, timeout_cb, &timed_out);
+
+  while (n_frames < N_FRAMES && !timed_out)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_false (timed_out);
+  g_source_remove (timeout_id);
+
+  return gtk_widget_get_frame_clock (window);
+}
+
+static void
+test_phase_histogram (void)
+{
+  GtkWidget *window;
+  GdkFrameClock *clock;
+  gint64 median, max;
+
+  window = gtk_window_new ();
+  gtk_window_present (GTK_WINDOW (window));
+  clock = run_frames (window);
+
+  gdk_frame_clock_reset_phase_histograms (clock);
+  g_assert_cmpuint (histogram_total (clock, GDK_FRAME_CLOCK_PHASE_UPDATE), ==, 0);
+  g_assert_cmpint (gdk_frame_clock_get_phase_percentile (clock, GDK_FRAME_CLOCK_PHASE_UPDATE, 50), ==, 0);
+
+  run_frames (window);
+
+  /* every frame ran the update phase for the tick callback */
+  g_assert_cmpuint (histogram_total (clock, GDK_FRAME_CLOCK_PHASE_UPDATE), >=, N_FRAMES);
+
+  median = gdk_frame_clock_get_phase_percentile (clock, GDK_FRAME_CLOCK_PHASE_UPDATE, 50);
+  max = gdk_frame_clock_get_phase_percentile (clock, GDK_FRAME_CLOCK_PHASE_UPDATE, 100);
+  g_assert_cmpint (median, >, 0);
+  g_assert_cmpint (median, <=, max);
+  /* percentiles are bucket boundaries, which are powers of 2 */
+  g_assert_cmpint (median & (median - 1), ==, 0);
+  g_assert_cmpint (max & (max - 1), ==, 0);
+
+  gdk_frame_clock_reset_phase_histograms (clock);
+  g_assert_cmpuint (histogram_total (clock, GDK_FRAME_CLOCK_PHASE_UPDATE), ==, 0);
+  g_assert_cmpuint (histogram_total (clock, GDK_FRAME_CLOCK_PHASE_PAINT), ==, 0);
+  g_assert_cmpint (gdk_frame_clock_get_phase_percentile (clock, GDK_FRAME_CLOCK_PHASE_UPDATE, 100), ==, 0);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+static void
+test_adaptive_scheduling (void)
+{
+  GtkWidget *window;
+  GdkFrameClock *clock;
+
+  window = gtk_window_new ();
+  gtk_window_present (GTK_WINDOW (window));
+  clock = gtk_widget_get_frame_clock (window);
+
+  g_assert_false (gdk_frame_clock_get_adaptive_scheduling (clock));
+  gdk_frame_clock_set_adaptive_scheduling (clock, TRUE);
+  g_assert_true (gdk_frame_clock_get_adaptive_scheduling (clock));
+
+  /* frames keep coming with the delay applied */
+  run_frames (window);
+
+  gdk_frame_clock_set_adaptive_scheduling (clock, FALSE);
+  g_assert_false (gdk_frame_clock_get_adaptive_scheduling (clock));
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+int
+main (int argc, char *argv[])
+{
+  (g_test_init) (&argc, &argv, NULL);
+
+  gtk_init ();
+
+  g_test_add_func ("/frameclock/phase-histogram", test_phase_histogram);
+  g_test_add_func ("/frameclock/adaptive-scheduling", test_adaptive_scheduling);
+
+  return g_test_run ();
+}
@@ -1,8 +1,12 @@
+#include <fcntl.h>
 #include <locale.h>
+#include <math.h>
 #include <gdk/gdk.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
 
 /* maximum bytes per pixel */
-#define MAX_BPP 4
+#define MAX_BPP 8
 
 typedef enum {
   BLUE,
@@ -33,6 +37,12 @@ typedef struct _TestData {
 } TestData;
 
 #define RGBA(a, b, c, d) { 0x ## a, 0x ## b, 0x ## c, 0x ## d }
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define U16(x) (0x ## x) & 0xFF, (0x ## x) >> 8
+#else
+#define U16(x) (0x ## x) >> 8, (0x ## x) & 0xFF
+#endif
+#define RGBA16(a, b, c, d) { U16(a), U16(b), U16(c), U16(d) }
 
 static MemoryData tests[GDK_MEMORY_N_FORMATS] = {
   { 4, FALSE, { RGBA(FF,00,00,FF), RGBA(00,FF,00,FF), RGBA(00,00,FF,FF), RGBA(00,00,00,00), RGBA(66,22,44,AA) } },
@@ -44,6 +54,8 @@ static MemoryData tests[GDK_MEMORY_N_FORMATS] = {
   { 4, FALSE, { RGBA(FF,FF,00,00), RGBA(FF,00,FF,00), RGBA(FF,00,00,FF), RGBA(00,00,00,00), RGBA(AA,99,33,66) } },
   { 3, TRUE,  { RGBA(00,00,FF,00), RGBA(00,FF,00,00), RGBA(FF,00,00,00), RGBA(00,00,00,00), RGBA(44,22,66,00) } },
   { 3, TRUE,  { RGBA(FF,00,00,00), RGBA(00,FF,00,00), RGBA(00,00,FF,00), RGBA(00,00,00,00), RGBA(66,22,44,00) } },
+  { 8, FALSE, { RGBA16(0000,0000,FFFF,FFFF), RGBA16(0000,FFFF,0000,FFFF), RGBA16(FFFF,0000,0000,FFFF), RGBA16(0000,0000,0000,0000), RGBA16(4444,2222,6666,AAAA) } },
+  { 8, FALSE, { RGBA16(0000,0000,3C00,3C00), RGBA16(0000,3C00,0000,3C00), RGBA16(3C00,0000,0000,3C00), RGBA16(0000,0000,0000,0000), RGBA16(3444,3044,3666,3955) } },
 };
 
 static void
@@ -173,6 +185,400 @@ test_download_4x4_with_stride (gconstpointer data)
   g_object_unref (test);
 }
 
+typedef enum {
+  UNORM8,
+  UNORM16,
+  FLOAT16
+} ChannelType;
+
+/* Position of alpha, red, green and blue in each format,
+ * alpha is -1 if the format is opaque */
+static const struct {
+  gsize bytes_per_pixel;
+  ChannelType type;
+  int a, r, g, b;
+  gboolean premultiplied;
+} layouts[GDK_MEMORY_N_FORMATS] = {
+  { 4, UNORM8,   3, 2, 1, 0, TRUE },
+  { 4, UNORM8,   0, 1, 2, 3, TRUE },
+  { 4, UNORM8,   3, 0, 1, 2, TRUE },
+  { 4, UNORM8,   3, 2, 1, 0, FALSE },
+  { 4, UNORM8,   0, 1, 2, 3, FALSE },
+  { 4, UNORM8,   3, 0, 1, 2, FALSE },
+  { 4, UNORM8,   0, 3, 2, 1, FALSE },
+  { 3, UNORM8,  -1, 0, 1, 2, FALSE },
+  { 3, UNORM8,  -1, 2, 1, 0, FALSE },
+  { 8, UNORM16,  3, 0, 1, 2, TRUE },
+  { 8, FLOAT16,  3, 0, 1, 2, TRUE },
+};
+
+static guchar
+premultiply (guint c,
+             guint a)
+{
+  guint t = c * a + 0x80;
+
+  return ((t >> 8) + t) >> 8;
+}
+
+static float
+half_to_float (guint16 h)
+{
+  int e = (h >> 10) & 0x1F;
+  int m = h & 0x3FF;
+  float f;
+
+  if (e == 0)
+    f = ldexpf (m, -24);
+  else
+    f = ldexpf (m | 0x400, e - 25);
+
+  return h & 0x8000 ? -f : f;
+}
+
+static guint
+read_channel (const guchar    *src,
+              GdkMemoryFormat  format,
+              int              channel)
+{
+  const guint16 *src16 = (const guint16 *) src;
+  float f;
+
+  switch (layouts[format].type)
+    {
+    case UNORM8:
+      return src[channel];
+
+    case UNORM16:
+      return (src16[channel] * 255 + 32767) / 65535;
+
+    case FLOAT16:
+      f = half_to_float (src16[channel]);
+      if (!(f > 0.f))
+        return 0;
+      if (f >= 1.f)
+        return 255;
+      return f * 255.f + 0.5f;
+
+    default:
+      g_assert_not_reached ();
+      return 0;
+    }
+}
+
+/* Converts one pixel the obvious way, to check the optimized code against */
+static void
+convert_pixel (guchar          *dest,
+               const guchar    *src,
+               GdkMemoryFormat  src_format)
+{
+  guint a, r, g, b;
+
+  r = read_channel (src, src_format, layouts[src_format].r);
+  g = read_channel (src, src_format, layouts[src_format].g);
+  b = read_channel (src, src_format, layouts[src_format].b);
+  if (layouts[src_format].a < 0)
+    {
+      a = 0xFF;
+    }
+  else
+    {
+      a = read_channel (src, src_format, layouts[src_format].a);
+      if (!layouts[src_format].premultiplied)
+        {
+          r = premultiply (r, a);
+          g = premultiply (g, a);
+          b = premultiply (b, a);
+        }
+    }
+
+  dest[layouts[GDK_MEMORY_DEFAULT].a] = a;
+  dest[layouts[GDK_MEMORY_DEFAULT].r] = r;
+  dest[layouts[GDK_MEMORY_DEFAULT].g] = g;
+  dest[layouts[GDK_MEMORY_DEFAULT].b] = b;
+}
+
+/* Download random data in all kinds of sizes and strides, so that
+ * both vectorized code and the code handling the rest of a row
+ * gets tested with all values.
+ */
+static void
+test_download_random (gconstpointer data)
+{
+  GdkMemoryFormat format = GPOINTER_TO_UINT (data);
+  gsize bpp = layouts[format].bytes_per_pixel;
+  static const gsize widths[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 257 };
+  gsize i, x, y;
+
+  for (i = 0; i < G_N_ELEMENTS (widths); i++)
+    {
+      gsize width = widths[i];
+      gsize height = 1 + i % 4;
+      gsize stride = width * bpp + g_test_rand_int_range (0, 8) * (layouts[format].type == UNORM8 ? 1 : 2);
+      GdkTexture *texture;
+      guchar *src, *dest, expected[4];
+      GBytes *bytes;
+
+      src = g_malloc (stride * height);
+      for (x = 0; x < stride * height; x++)
+        src[x] = g_test_rand_int_range (0, 256);
+      if (layouts[format].type == FLOAT16)
+        {
+          /* Infinity and NaN are not handled consistently */
+          guint16 *src16 = (guint16 *) src;
+          for (x = 0; x < stride * height / 2; x++)
+            if ((src16[x] & 0x7C00) == 0x7C00)
+              src16[x] &= ~0x4000;
+        }
+
+      bytes = g_bytes_new_take (src, stride * height);
+      texture = gdk_memory_texture_new (width, height, format, bytes, stride);
+
+      dest = g_malloc (width * height * 4);
+      gdk_texture_download (texture, dest, width * 4);
+
+      for (y = 0; y < height; y++)
+        {
+          for (x = 0; x < width; x++)
+            {
+              convert_pixel (expected, &src[y * stride + x * bpp], format);
+              g_assert_cmpmem (&dest[(y * width + x) * 4], 4, expected, 4);
+            }
+        }
+
+      g_free (dest);
+      g_object_unref (texture);
+      g_bytes_unref (bytes);
+    }
+}
+
+static void
+test_download_exhaustive (gconstpointer data)
+{
+  GdkMemoryFormat format = GPOINTER_TO_UINT (data);
+  gsize bpp = layouts[format].bytes_per_pixel;
+  GdkTexture *texture;
+  guchar *src, *dest, expected[4];
+  GBytes *bytes;
+  guint c, a, i;
+
+  src = g_malloc (256 * 256 * bpp);
+  if (layouts[format].type == UNORM8)
+    {
+      /* every color value with every alpha value, in all channels */
+      for (a = 0; a < 256; a++)
+        for (c = 0; c < 256; c++)
+          for (i = 0; i < bpp; i++)
+            src[(a * 256 + c) * bpp + i] = (int) i == layouts[format].a ? a : c + 85 * i;
+    }
+  else
+    {
+      guint16 *src16 = (guint16 *) src;
+
+      /* every 16bit value in all channels */
+      for (i = 0; i < 256 * 256; i++)
+        {
+          guint16 value = i;
+
+          /* Infinity and NaN are not handled consistently */
+          if (layouts[format].type == FLOAT16 && (value & 0x7C00) == 0x7C00)
+            value = 0;
+
+          for (c = 0; c < 4; c++)
+            src16[4 * i + c] = value;
+        }
+    }
+
+  bytes = g_bytes_new_take (src, 256 * 256 * bpp);
+  texture = gdk_memory_texture_new (256, 256, format, bytes, 256 * bpp);
+
+  dest = g_malloc (256 * 256 * 4);
+  gdk_texture_download (texture, dest, 256 * 4);
+
+  for (i = 0; i < 256 * 256; i++)
+    {
+      convert_pixel (expected, &src[i * bpp], format);
+      g_assert_cmpmem (&dest[i * 4], 4, expected, 4);
+    }
+
+  g_free (dest);
+  g_object_unref (texture);
+  g_bytes_unref (bytes);
+}
+
+static void
+test_download_performance (gconstpointer data)
+{
+  GdkMemoryFormat format = GPOINTER_TO_UINT (data);
+  gsize bpp = layouts[format].bytes_per_pixel;
+  const int width = 3840, height = 2160, runs = 20;
+  GdkTexture *texture;
+  guchar *src, *dest;
+  GBytes *bytes;
+  gint64 start, usecs;
+  guint i;
+
+  if (!g_test_perf ())
+    return;
+
+  src = g_malloc (width * height * bpp);
+  for (i = 0; i < width * height * bpp; i++)
+    src[i] = g_test_rand_int_range (0, 256);
+
+  bytes = g_bytes_new_take (src, width * height * bpp);
+  texture = gdk_memory_texture_new (width, height, format, bytes, width * bpp);
+  dest = g_malloc (width * height * 4);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < runs; i++)
+    gdk_texture_download (texture, dest, width * 4);
+  usecs = g_get_monotonic_time () - start;
+
+  g_test_maximized_result ((double) width * height * runs / usecs,
+                           "%.1f Mpixels/s", (double) width * height * runs / usecs);
+
+  g_free (dest);
+  g_object_unref (texture);
+  g_bytes_unref (bytes);
+}
+
+static char *
+write_texture_file (GdkMemoryFormat   format,
+                    Color             color,
+                    gsize             offset,
+                    gsize             stride,
+                    int              *out_fd)
+{
+  GError *error = NULL;
+  char *filename;
+  guchar *data;
+  gsize size;
+  int fd, x, y;
+
+  fd = g_file_open_tmp ("memorytexture-XXXXXX", &filename, &error);
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+
+  size = offset + 4 * stride;
+  data = g_malloc0 (size);
+  for (y = 0; y < 4; y++)
+    for (x = 0; x < 4; x++)
+      memcpy (&data[offset + y * stride + x * tests[format].bytes_per_pixel],
+              &tests[format].data[color],
+              tests[format].bytes_per_pixel);
+
+  g_file_set_contents (filename, (const char *) data, size, &error);
+  g_assert_no_error (error);
+  g_free (data);
+
+  *out_fd = g_open (filename, O_RDONLY, 0);
+  g_assert_cmpint (*out_fd, >=, 0);
+
+  return filename;
+}
+
+static void
+test_mapped_file (void)
+{
+  GdkTexture *expected, *test;
+  GMappedFile *mapped_file;
+  GError *error = NULL;
+  char *filename;
+  int fd;
+
+  filename = write_texture_file (GDK_MEMORY_R8G8B8A8_PREMULTIPLIED, GREEN, 16, 20, &fd);
+
+  mapped_file = g_mapped_file_new (filename, FALSE, &error);
+  g_assert_no_error (error);
+
+  expected = create_texture (GDK_MEMORY_DEFAULT, GREEN, 4, 4, 16);
+  test = gdk_memory_texture_new_from_mapped_file (mapped_file, 16, 4, 4,
+                                                  GDK_MEMORY_R8G8B8A8_PREMULTIPLIED, 20);
+  g_mapped_file_unref (mapped_file);
+
+  compare_textures (expected, test, FALSE);
+
+  g_object_unref (expected);
+  g_object_unref (test);
+
+  g_close (fd, NULL);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+static void
+test_fd (void)
+{
+  GdkTexture *expected, *test;
+  GError *error = NULL;
+  char *filename;
+  int fd;
+
+  filename = write_texture_file (GDK_MEMORY_DEFAULT, RED, 8, 16, &fd);
+
+  expected = create_texture (GDK_MEMORY_DEFAULT, RED, 4, 4, 16);
+  test = gdk_memory_texture_new_from_fd (fd, 8, 4, 4, GDK_MEMORY_DEFAULT, 16, &error);
+  g_assert_no_error (error);
+
+  /* The texture must not depend on the fd */
+  g_close (fd, NULL);
+
+  compare_textures (expected, test, FALSE);
+
+  g_object_unref (expected);
+  g_object_unref (test);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+static void
+test_fd_too_small (void)
+{
+  GdkTexture *test;
+  GError *error = NULL;
+  char *filename;
+  int fd;
+
+  filename = write_texture_file (GDK_MEMORY_DEFAULT, RED, 0, 16, &fd);
+
+  test = gdk_memory_texture_new_from_fd (fd, 0, 4, 5, GDK_MEMORY_DEFAULT, 16, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_assert_null (test);
+  g_clear_error (&error);
+
+  g_close (fd, NULL);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+static void
+test_fd_bad_stride (void)
+{
+  GdkTexture *test;
+  GError *error = NULL;
+  char *filename;
+  int fd;
+
+  filename = write_texture_file (GDK_MEMORY_DEFAULT, RED, 0, 16, &fd);
+
+  /* The stride is too small for the width */
+  test = gdk_memory_texture_new_from_fd (fd, 0, 4, 4, GDK_MEMORY_DEFAULT, 8, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_assert_null (test);
+  g_clear_error (&error);
+
+  /* The size computation would overflow */
+  test = gdk_memory_texture_new_from_fd (fd, 0, 4, 4, GDK_MEMORY_DEFAULT, G_MAXSIZE / 2, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_assert_null (test);
+  g_clear_error (&error);
+
+  g_close (fd, NULL);
+  g_unlink (filename);
+  g_free (filename);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -226,5 +632,30 @@ main (int argc, char *argv[])
         }
     }
 
+  for (format = 0; format < GDK_MEMORY_N_FORMATS; format++)
+    {
+      char *test_name;
+
+      test_name = g_strdup_printf ("/memorytexture/download_random/%s",
+                                   g_enum_get_value (enum_class, format)->value_nick);
+      g_test_add_data_func (test_name, GUINT_TO_POINTER (format), test_download_random);
+      g_free (test_name);
+
+      test_name = g_strdup_printf ("/memorytexture/download_exhaustive/%s",
+                                   g_enum_get_value (enum_class, format)->value_nick);
+      g_test_add_data_func (test_name, GUINT_TO_POINTER (format), test_download_exhaustive);
+      g_free (test_name);
+
+      test_name = g_strdup_printf ("/memorytexture/download_performance/%s",
+                                   g_enum_get_value (enum_class, format)->value_nick);
+      g_test_add_data_func (test_name, GUINT_TO_POINTER (format), test_download_performance);
+      g_free (test_name);
+    }
+
+  g_test_add_func ("/memorytexture/mapped-file", test_mapped_file);
+  g_test_add_func ("/memorytexture/fd", test_fd);
+  g_test_add_func ("/memorytexture/fd-too-small", test_fd_too_small);
+  g_test_add_func ("/memorytexture/fd-bad-stride", test_fd_bad_stride);
+
   return g_test_run ();
 }
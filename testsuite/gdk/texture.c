@@ -1,4 +1,5 @@
 #include <gtk.h>
+#include <glib/gstdio.h>
 
 static gboolean
 compare_pixels (int     width,
@@ -106,6 +107,272 @@ test_texture_save_to_png (void)
   g_object_unref (texture2);
 }
 
+static void
+load_done (GObject      *source,
+           GAsyncResult *result,
+           gpointer      data)
+{
+  GAsyncResult **out = data;
+
+  *out = g_object_ref (result);
+}
+
+static GdkTexture *
+load_texture_sync (GFile         *file,
+                   int            width,
+                   int            height,
+                   GCancellable  *cancellable,
+                   GError       **error)
+{
+  GAsyncResult *result = NULL;
+  GdkTexture *texture;
+
+  gdk_texture_new_from_file_async (file, width, height,
+                                   G_PRIORITY_DEFAULT, cancellable,
+                                   load_done, &result);
+
+  while (result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  texture = gdk_texture_new_from_file_finish (result, error);
+  g_object_unref (result);
+
+  return texture;
+}
+
+static GFile *
+create_image_file (const char *dir,
+                   const char *basename,
+                   const char *type,
+                   int         width,
+                   int         height)
+{
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  char *path;
+  GFile *file;
+  int x, y;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+  for (y = 0; y < height; y++)
+    {
+      guchar *row = gdk_pixbuf_get_pixels (pixbuf) + y * gdk_pixbuf_get_rowstride (pixbuf);
+      for (x = 0; x < width; x++)
+        {
+          row[3 * x + 0] = x * 255 / width;
+          row[3 * x + 1] = y * 255 / height;
+          row[3 * x + 2] = (x ^ y) & 0xff;
+        }
+    }
+
+  path = g_build_filename (dir, basename, NULL);
+  gdk_pixbuf_save (pixbuf, path, type, &error, NULL);
+  g_assert_no_error (error);
+
+  file = g_file_new_for_path (path);
+
+  g_free (path);
+  g_object_unref (pixbuf);
+
+  return file;
+}
+
+static void
+test_texture_from_file_async (void)
+{
+  GdkTexture *texture;
+  GError *error = NULL;
+  GFile *file;
+
+  file = g_file_new_for_uri ("resource:///org/gtk/libgtk/icons/16x16/places/user-trash.png");
+  texture = load_texture_sync (file, -1, -1, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (texture);
+  g_assert_true (GDK_IS_MEMORY_TEXTURE (texture));
+  g_assert_cmpint (gdk_texture_get_width (texture), ==, 16);
+  g_assert_cmpint (gdk_texture_get_height (texture), ==, 16);
+  g_object_unref (texture);
+
+  /* Larger than the image: no upscaling */
+  texture = load_texture_sync (file, 64, 64, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_texture_get_width (texture), ==, 16);
+  g_assert_cmpint (gdk_texture_get_height (texture), ==, 16);
+  g_object_unref (texture);
+
+  g_object_unref (file);
+}
+
+static void
+test_texture_from_file_async_at_size (void)
+{
+  GdkTexture *texture;
+  GError *error = NULL;
+  GFile *file;
+  char *dir;
+
+  dir = g_dir_make_tmp ("gdk-texture-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  file = create_image_file (dir, "image.png", "png", 200, 100);
+
+  texture = load_texture_sync (file, 50, 50, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_texture_get_width (texture), ==, 50);
+  g_assert_cmpint (gdk_texture_get_height (texture), ==, 25);
+  g_object_unref (texture);
+
+  texture = load_texture_sync (file, -1, 20, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_texture_get_width (texture), ==, 40);
+  g_assert_cmpint (gdk_texture_get_height (texture), ==, 20);
+  g_object_unref (texture);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  g_rmdir (dir);
+  g_free (dir);
+}
+
+static void
+test_texture_from_file_async_cancel (void)
+{
+  GCancellable *cancellable;
+  GdkTexture *texture;
+  GError *error = NULL;
+  GFile *file;
+
+  file = g_file_new_for_uri ("resource:///org/gtk/libgtk/icons/16x16/places/user-trash.png");
+  cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+
+  texture = load_texture_sync (file, -1, -1, cancellable, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_null (texture);
+  g_clear_error (&error);
+
+  g_object_unref (cancellable);
+  g_object_unref (file);
+}
+
+static void
+test_texture_from_file_async_error (void)
+{
+  GdkTexture *texture;
+  GError *error = NULL;
+  GFile *file;
+
+  file = g_file_new_for_path ("/this/file/does/not/exist.png");
+
+  texture = load_texture_sync (file, -1, -1, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+  g_assert_null (texture);
+  g_clear_error (&error);
+
+  g_object_unref (file);
+}
+
+#define N_BENCHMARK_IMAGES 64
+
+static void
+count_done (GObject      *source,
+            GAsyncResult *result,
+            gpointer      data)
+{
+  guint *n_pending = data;
+  GdkTexture *texture;
+
+  /* Files that aren't images are skipped */
+  texture = gdk_texture_new_from_file_finish (result, NULL);
+  g_clear_object (&texture);
+
+  (*n_pending)--;
+}
+
+/* Loads all images in a directory, once synchronously at full size and
+ * once through the async loader at thumbnail size. Set
+ * GDK_TEXTURE_BENCHMARK_DIR to use a directory of real photos, otherwise
+ * a set of JPEGs is generated.
+ */
+static void
+test_texture_load_performance (void)
+{
+  const char *benchmark_dir;
+  char *dir = NULL;
+  GPtrArray *files;
+  GError *error = NULL;
+  gint64 start, sync_usecs, async_usecs;
+  guint i, n_pending;
+
+  if (!g_test_perf ())
+    return;
+
+  files = g_ptr_array_new_with_free_func (g_object_unref);
+
+  benchmark_dir = g_getenv ("GDK_TEXTURE_BENCHMARK_DIR");
+  if (benchmark_dir)
+    {
+      GDir *d;
+      const char *name;
+
+      d = g_dir_open (benchmark_dir, 0, &error);
+      g_assert_no_error (error);
+      while ((name = g_dir_read_name (d)))
+        {
+          char *path = g_build_filename (benchmark_dir, name, NULL);
+          if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
+            g_ptr_array_add (files, g_file_new_for_path (path));
+          g_free (path);
+        }
+      g_dir_close (d);
+    }
+  else
+    {
+      dir = g_dir_make_tmp ("gdk-texture-XXXXXX", &error);
+      g_assert_no_error (error);
+
+      for (i = 0; i < N_BENCHMARK_IMAGES; i++)
+        {
+          char *name = g_strdup_printf ("image%u.jpeg", i);
+          g_ptr_array_add (files, create_image_file (dir, name, "jpeg", 2048, 1536));
+          g_free (name);
+        }
+    }
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < files->len; i++)
+    {
+      GdkTexture *texture = gdk_texture_new_from_file (g_ptr_array_index (files, i), NULL);
+      g_clear_object (&texture);
+    }
+  sync_usecs = g_get_monotonic_time () - start;
+
+  start = g_get_monotonic_time ();
+  n_pending = files->len;
+  for (i = 0; i < files->len; i++)
+    gdk_texture_new_from_file_async (g_ptr_array_index (files, i), 256, 256,
+                                     G_PRIORITY_DEFAULT, NULL,
+                                     count_done, &n_pending);
+  while (n_pending > 0)
+    g_main_context_iteration (NULL, TRUE);
+  async_usecs = g_get_monotonic_time () - start;
+
+  g_test_message ("%u images: sync full size %.1fms, async 256x256 %.1fms",
+                  files->len, sync_usecs / 1000.0, async_usecs / 1000.0);
+  g_test_minimized_result (async_usecs / 1000000.0,
+                           "async load: %.3fs", async_usecs / 1000000.0);
+
+  if (dir)
+    {
+      for (i = 0; i < files->len; i++)
+        g_file_delete (g_ptr_array_index (files, i), NULL, NULL);
+      g_rmdir (dir);
+      g_free (dir);
+    }
+
+  g_ptr_array_unref (files);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -115,6 +382,11 @@ main (int argc, char *argv[])
   g_test_add_func ("/texture/from-pixbuf", test_texture_from_pixbuf);
   g_test_add_func ("/texture/from-resource", test_texture_from_resource);
   g_test_add_func ("/texture/save-to-png", test_texture_save_to_png);
+  g_test_add_func ("/texture/from-file-async", test_texture_from_file_async);
+  g_test_add_func ("/texture/from-file-async-at-size", test_texture_from_file_async_at_size);
+  g_test_add_func ("/texture/from-file-async-cancel", test_texture_from_file_async_cancel);
+  g_test_add_func ("/texture/from-file-async-error", test_texture_from_file_async_error);
+  g_test_add_func ("/texture/load-performance", test_texture_load_performance);
 
   return g_test_run ();
 }
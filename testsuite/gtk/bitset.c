@@ -558,6 +558,139 @@ test_splice_overflow (void)
   gtk_bitset_unref (set);
 }
 
+static void
+test_nth (void)
+{
+  GtkBitsetIter iter;
+  GtkBitset *set;
+  guint i, n, value;
+  gboolean loop;
+
+  for (i = 0; i < G_N_ELEMENTS (bitsets); i++)
+    {
+      set = bitsets[i].create();
+
+      g_assert_cmpint (gtk_bitset_get_size (set), ==, bitsets[i].n_elements);
+
+      n = 0;
+      for (loop = gtk_bitset_iter_init_first (&iter, set, &value);
+           loop;
+           loop = gtk_bitset_iter_next (&iter, &value))
+        {
+          /* only check a few values in the large sets */
+          if (n < 1000 || n % 997 == 0)
+            {
+              g_assert_cmpint (gtk_bitset_get_nth (set, n), ==, value);
+              g_assert_cmpint (gtk_bitset_get_size_in_range (set, 0, value), ==, n + 1);
+            }
+          n++;
+        }
+      g_assert_cmpint (n, ==, bitsets[i].n_elements);
+      g_assert_cmpint (gtk_bitset_get_nth (set, n), ==, 0);
+
+      gtk_bitset_unref (set);
+    }
+}
+
+static void
+test_nth_changes (void)
+{
+  GtkBitset *set, *copy;
+  guint i, value, n;
+
+  set = create_powers_of_10_ranges ();
+  g_assert_cmpint (gtk_bitset_get_nth (set, 41), ==, LARGE_VALUE + 5);
+
+  /* changing the set must not leave stale results behind */
+  for (i = 0; i < 1000; i++)
+    {
+      value = g_test_rand_int_range (0, 4 * 65536);
+      n = g_test_rand_int_range (0, 70000);
+
+      switch (g_test_rand_int_range (0, 4))
+        {
+        case 0:
+          gtk_bitset_add (set, value);
+          break;
+        case 1:
+          gtk_bitset_remove (set, value);
+          break;
+        case 2:
+          gtk_bitset_add_range (set, value, n);
+          break;
+        case 3:
+          gtk_bitset_remove_range (set, value, n);
+          break;
+        default:
+          g_assert_not_reached ();
+        }
+
+      n = gtk_bitset_get_size_in_range (set, 0, value);
+      if (gtk_bitset_contains (set, value))
+        g_assert_cmpint (gtk_bitset_get_nth (set, n - 1), ==, value);
+      else if (n > 0)
+        g_assert_cmpint (gtk_bitset_get_nth (set, n - 1), <, value);
+
+      g_assert_cmpint (gtk_bitset_get_size_in_range (set, 0, G_MAXUINT), ==, gtk_bitset_get_size (set));
+    }
+
+  copy = gtk_bitset_copy (set);
+  g_assert_cmpint (gtk_bitset_get_size (copy), ==, gtk_bitset_get_size (set));
+  gtk_bitset_union (copy, set);
+  gtk_bitset_splice (copy, 0, 1, 0);
+  n = gtk_bitset_get_size (copy);
+  if (n > 0)
+    g_assert_cmpint (gtk_bitset_get_nth (copy, n - 1), ==, gtk_bitset_get_maximum (copy));
+  gtk_bitset_remove_all (copy);
+  g_assert_cmpint (gtk_bitset_get_size (copy), ==, 0);
+  g_assert_cmpint (gtk_bitset_get_nth (copy, 0), ==, 0);
+
+  gtk_bitset_unref (copy);
+  gtk_bitset_unref (set);
+}
+
+static void
+test_nth_performance (void)
+{
+  GtkBitset *set;
+  guint i, n, value;
+  guint64 sum;
+  gint64 start;
+  double usecs;
+
+  if (!g_test_perf ())
+    return;
+
+  /* a large sparse set: every third value of 100 million */
+  set = gtk_bitset_new_empty ();
+  for (i = 0; i < 100 * 1000 * 1000; i += 3)
+    gtk_bitset_add (set, i);
+  n = gtk_bitset_get_size (set);
+
+  sum = 0;
+  start = g_get_monotonic_time ();
+  for (i = 0; i < 100000; i++)
+    {
+      value = gtk_bitset_get_nth (set, g_test_rand_int_range (0, n));
+      sum += value;
+    }
+  usecs = (g_get_monotonic_time () - start) / 100000.0;
+  g_test_minimized_result (usecs, "get_nth(): %.3fus per call", usecs);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < 100000; i++)
+    {
+      value = g_test_rand_int_range (0, 100 * 1000 * 1000);
+      sum += gtk_bitset_get_size_in_range (set, value / 2, value);
+    }
+  usecs = (g_get_monotonic_time () - start) / 100000.0;
+  g_test_minimized_result (usecs, "get_size_in_range(): %.3fus per call", usecs);
+
+  g_test_message ("checksum %" G_GUINT64_FORMAT, sum);
+
+  gtk_bitset_unref (set);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -578,6 +711,9 @@ main (int argc, char *argv[])
   g_test_add_func ("/bitset/rectangle", test_rectangle);
   g_test_add_func ("/bitset/iter", test_iter);
   g_test_add_func ("/bitset/splice-overflow", test_splice_overflow);
+  g_test_add_func ("/bitset/nth", test_nth);
+  g_test_add_func ("/bitset/nth-changes", test_nth_changes);
+  g_test_add_func ("/bitset/nth-performance", test_nth_performance);
 
   return g_test_run ();
 }
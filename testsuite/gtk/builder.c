@@ -2275,6 +2275,201 @@ test_template (void)
   g_assert_true (GTK_IS_LABEL (my_gtk_grid->priv->label));
 }
 
+#define MY_LAZY_STACK_TEMPLATE "\
+<interface>\n\
+ <template class=\"MyLazyStack\" parent=\"GtkBox\">\n\
+   <child>\n\
+     <object class=\"GtkStack\" id=\"stack\">\n\
+       <child>\n\
+         <object class=\"GtkStackPage\">\n\
+           <property name=\"name\">first</property>\n\
+           <property name=\"child\">\n\
+             <object class=\"GtkLabel\" id=\"first_label\"/>\n\
+           </property>\n\
+         </object>\n\
+       </child>\n\
+       <child>\n\
+         <object class=\"GtkStackPage\">\n\
+           <property name=\"name\">second</property>\n\
+           <property name=\"child\">\n\
+             <object class=\"GtkBox\" id=\"second_page\" lazy=\"yes\">\n\
+               <child>\n\
+                 <object class=\"GtkLabel\" id=\"second_label\">\n\
+                   <property name=\"label\">&lt;Second&gt;</property>\n\
+                   <property name=\"mnemonic-widget\">first_label</property>\n\
+                 </object>\n\
+               </child>\n\
+               <child>\n\
+                 <object class=\"GtkSpinButton\" id=\"second_spin\">\n\
+                   <property name=\"adjustment\">adjustment</property>\n\
+                 </object>\n\
+               </child>\n\
+             </object>\n\
+           </property>\n\
+         </object>\n\
+       </child>\n\
+     </object>\n\
+   </child>\n\
+ </template>\n\
+ <object class=\"GtkAdjustment\" id=\"adjustment\">\n\
+   <property name=\"upper\">100</property>\n\
+   <property name=\"value\">42</property>\n\
+ </object>\n\
+</interface>\n"
+
+#define MY_TYPE_LAZY_STACK             (my_lazy_stack_get_type ())
+
+typedef struct
+{
+  GtkBoxClass parent_class;
+} MyLazyStackClass;
+
+typedef struct
+{
+  GtkBox parent_instance;
+  GtkStack *stack;
+  GtkLabel *first_label;
+  GtkBox *second_page;
+  GtkLabel *second_label;
+  GtkSpinButton *second_spin;
+} MyLazyStack;
+
+G_DEFINE_TYPE (MyLazyStack, my_lazy_stack, GTK_TYPE_BOX);
+
+static void
+my_lazy_stack_init (MyLazyStack *self)
+{
+  gtk_widget_init_template (GTK_WIDGET (self));
+}
+
+static void
+my_lazy_stack_class_init (MyLazyStackClass *klass)
+{
+  GBytes *template = g_bytes_new_static (MY_LAZY_STACK_TEMPLATE, strlen (MY_LAZY_STACK_TEMPLATE));
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  gtk_widget_class_set_template (widget_class, template);
+  gtk_widget_class_bind_template_child (widget_class, MyLazyStack, stack);
+  gtk_widget_class_bind_template_child (widget_class, MyLazyStack, first_label);
+  gtk_widget_class_bind_template_child (widget_class, MyLazyStack, second_page);
+  gtk_widget_class_bind_template_child (widget_class, MyLazyStack, second_label);
+  gtk_widget_class_bind_template_child (widget_class, MyLazyStack, second_spin);
+}
+
+static void
+test_template_lazy (void)
+{
+  MyLazyStack *self;
+  GtkWidget *placeholder;
+  GObject *child;
+
+  /* Never built */
+  self = g_object_ref_sink (g_object_new (MY_TYPE_LAZY_STACK, NULL));
+  g_assert_true (GTK_IS_LABEL (self->first_label));
+  g_assert_null (self->second_page);
+  g_assert_null (self->second_label);
+  placeholder = gtk_stack_get_child_by_name (self->stack, "second");
+  g_assert_cmpstr (G_OBJECT_TYPE_NAME (placeholder), ==, "GtkLazyWidget");
+  g_assert_null (gtk_widget_get_first_child (placeholder));
+  g_object_unref (self);
+
+  /* Built on request */
+  self = g_object_ref_sink (g_object_new (MY_TYPE_LAZY_STACK, NULL));
+  g_assert_null (self->second_label);
+
+  child = gtk_widget_get_template_child (GTK_WIDGET (self), MY_TYPE_LAZY_STACK, "second_label");
+  g_assert_true (GTK_IS_LABEL (child));
+  g_assert_true (self->second_label == GTK_LABEL (child));
+  g_assert_true (GTK_IS_BOX (self->second_page));
+  g_assert_true (gtk_widget_get_parent (GTK_WIDGET (self->second_label)) == GTK_WIDGET (self->second_page));
+  /* The placeholder stays in the tree as the parent of the lazy object */
+  placeholder = gtk_stack_get_child_by_name (self->stack, "second");
+  g_assert_cmpstr (G_OBJECT_TYPE_NAME (placeholder), ==, "GtkLazyWidget");
+  g_assert_true (placeholder != GTK_WIDGET (self->second_page));
+  g_assert_true (gtk_stack_page_get_child (gtk_stack_get_page (self->stack, placeholder)) == placeholder);
+  g_assert_true (gtk_widget_get_parent (GTK_WIDGET (self->second_page)) == placeholder);
+  g_assert_true (gtk_widget_get_first_child (placeholder) == GTK_WIDGET (self->second_page));
+  g_assert_cmpstr (gtk_label_get_label (self->second_label), ==, "<Second>");
+  g_assert_true (gtk_label_get_mnemonic_widget (self->second_label) == GTK_WIDGET (self->first_label));
+  /* Objects in the template that are not template children work, too */
+  g_assert_cmpfloat (gtk_spin_button_get_value (self->second_spin), ==, 42);
+  g_assert_true (gtk_widget_get_template_child (GTK_WIDGET (self), MY_TYPE_LAZY_STACK, "second_page") ==
+                 G_OBJECT (self->second_page));
+  g_object_unref (self);
+}
+
+static void
+test_template_lazy_map (void)
+{
+  GtkWidget *window;
+  MyLazyStack *self;
+
+  window = gtk_window_new ();
+  self = g_object_new (MY_TYPE_LAZY_STACK, NULL);
+  gtk_window_set_child (GTK_WINDOW (window), GTK_WIDGET (self));
+  gtk_widget_show (window);
+
+  g_assert_null (self->second_label);
+
+  gtk_stack_set_visible_child_name (self->stack, "second");
+  g_assert_true (GTK_IS_LABEL (self->second_label));
+  g_assert_true (gtk_widget_get_mapped (GTK_WIDGET (self->second_label)));
+  /* The visible child is the placeholder, not the lazy object */
+  g_assert_cmpstr (G_OBJECT_TYPE_NAME (gtk_stack_get_visible_child (self->stack)), ==, "GtkLazyWidget");
+  g_assert_true (gtk_widget_get_parent (GTK_WIDGET (self->second_page)) ==
+                 gtk_stack_get_visible_child (self->stack));
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+static void
+test_template_lazy_invalid (void)
+{
+  const char *templates[] = {
+    "<interface>"
+    "  <template class='GtkGrid'>"
+    "    <child>"
+    "      <object class='GtkLabel' lazy='yes'>"
+    "        <layout>"
+    "          <property name='column'>1</property>"
+    "        </layout>"
+    "      </object>"
+    "    </child>"
+    "  </template>"
+    "</interface>",
+    "<interface>"
+    "  <template class='GtkGrid'>"
+    "    <child>"
+    "      <object class='GtkLabel' lazy='yes'>"
+    "        <property name='visible'>0</property>"
+    "      </object>"
+    "    </child>"
+    "  </template>"
+    "</interface>",
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (templates); i++)
+    {
+      GtkBuilder *builder;
+      GtkWidget *grid;
+      GError *error = NULL;
+      gboolean ret;
+
+      builder = gtk_builder_new ();
+      grid = g_object_ref_sink (gtk_grid_new ());
+
+      ret = gtk_builder_extend_with_template (builder, G_OBJECT (grid), GTK_TYPE_GRID,
+                                              templates[i], -1, &error);
+      g_assert_false (ret);
+      g_assert_error (error, GTK_BUILDER_ERROR, GTK_BUILDER_ERROR_INVALID_TAG);
+
+      g_error_free (error);
+      g_object_unref (grid);
+      g_object_unref (builder);
+    }
+}
+
 _BUILDER_TEST_EXPORT void
 on_cellrenderertoggle1_toggled (GtkCellRendererToggle *cell)
 {
@@ -2524,6 +2719,9 @@ main (int argc, char **argv)
   g_test_add_func ("/Builder/LevelBar", test_level_bar);
   g_test_add_func ("/Builder/Expose Object", test_expose_object);
   g_test_add_func ("/Builder/Template", test_template);
+  g_test_add_func ("/Builder/Template/Lazy", test_template_lazy);
+  g_test_add_func ("/Builder/Template/Lazy Map", test_template_lazy_map);
+  g_test_add_func ("/Builder/Template/Lazy Invalid", test_template_lazy_invalid);
   g_test_add_func ("/Builder/No IDs", test_no_ids);
   g_test_add_func ("/Builder/Property Bindings", test_property_bindings);
   g_test_add_func ("/Builder/anaconda-signal", test_anaconda_signal);
@@ -0,0 +1,246 @@
+#include <gtk/gtk.h>
+#include "gtk/gtkbuilderprivate.h"
+
+#include <string.h>
+
+static const char ui[] =
+  "<interface>"
+  "  <object class=\"GtkBox\" id=\"box\">"
+  "    <property name=\"orientation\">vertical</property>"
+  "    <property name=\"spacing\">6</property>"
+  "    <property name=\"homogeneous\">yes</property>"
+  "    <child>"
+  "      <object class=\"GtkLabel\" id=\"label\">"
+  "        <property name=\"label\" translatable=\"yes\">Hello</property>"
+  "        <property name=\"xalign\">0.25</property>"
+  "        <property name=\"justify\">GTK_JUSTIFY_CENTER</property>"
+  "        <property name=\"max-width-chars\">42</property>"
+  "        <property name=\"selectable\">True</property>"
+  "        <property name=\"visible\" bind-source=\"box\" bind-property=\"homogeneous\">False</property>"
+  "      </object>"
+  "    </child>"
+  "    <child>"
+  "      <object class=\"GtkScale\" id=\"scale\">"
+  "        <property name=\"digits\">3</property>"
+  "        <property name=\"adjustment\">"
+  "          <object class=\"GtkAdjustment\">"
+  "            <property name=\"upper\">1e10</property>"
+  "            <property name=\"value\">-12.5</property>"
+  "          </object>"
+  "        </property>"
+  "      </object>"
+  "    </child>"
+  "  </object>"
+  "</interface>";
+
+static void
+check_objects (GtkBuilder *builder)
+{
+  GObject *box, *label, *scale;
+  GtkAdjustment *adjustment;
+
+  box = gtk_builder_get_object (builder, "box");
+  label = gtk_builder_get_object (builder, "label");
+  scale = gtk_builder_get_object (builder, "scale");
+
+  g_assert_cmpint (gtk_orientable_get_orientation (GTK_ORIENTABLE (box)), ==, GTK_ORIENTATION_VERTICAL);
+  g_assert_cmpint (gtk_box_get_spacing (GTK_BOX (box)), ==, 6);
+  g_assert_true (gtk_box_get_homogeneous (GTK_BOX (box)));
+
+  g_assert_cmpstr (gtk_label_get_label (GTK_LABEL (label)), ==, "Hello");
+  g_assert_cmpfloat (gtk_label_get_xalign (GTK_LABEL (label)), ==, 0.25);
+  g_assert_cmpint (gtk_label_get_justify (GTK_LABEL (label)), ==, GTK_JUSTIFY_CENTER);
+  g_assert_cmpint (gtk_label_get_max_width_chars (GTK_LABEL (label)), ==, 42);
+  g_assert_true (gtk_label_get_selectable (GTK_LABEL (label)));
+  g_assert_true (gtk_widget_get_visible (GTK_WIDGET (label)));
+
+  g_assert_cmpint (gtk_scale_get_digits (GTK_SCALE (scale)), ==, 3);
+  adjustment = gtk_range_get_adjustment (GTK_RANGE (scale));
+  g_assert_cmpfloat (gtk_adjustment_get_upper (adjustment), ==, 1e10);
+  g_assert_cmpfloat (gtk_adjustment_get_value (adjustment), ==, -12.5);
+}
+
+static void
+test_compile_values (void)
+{
+  GtkBuilder *builder;
+  GBytes *bytes;
+  const char *data;
+  gsize size;
+  GError *error = NULL;
+
+  builder = gtk_builder_new ();
+  bytes = _gtk_buildable_parser_compile (builder, ui, -1, &error);
+  g_assert_no_error (error);
+  g_object_unref (builder);
+
+  data = g_bytes_get_data (bytes, &size);
+  g_assert_true (_gtk_buildable_parser_is_precompiled (data, size));
+  g_assert_cmpint (data[3], ==, 1);
+
+  builder = gtk_builder_new ();
+  gtk_builder_add_from_string (builder, data, size, &error);
+  g_assert_no_error (error);
+  check_objects (builder);
+  g_object_unref (builder);
+
+  builder = gtk_builder_new ();
+  gtk_builder_add_from_string (builder, ui, -1, &error);
+  g_assert_no_error (error);
+  check_objects (builder);
+  g_object_unref (builder);
+
+  g_bytes_unref (bytes);
+}
+
+/* Changes the compiled value of max-width-chars from 42 to 43,
+ * so we can tell whether the value or the text gets used.
+ */
+static void
+patch_compiled_value (char  *data,
+                      gsize  size)
+{
+  /* RECORD_TYPE_VALUE, G_TYPE_INT, high bits, low bits */
+  const char record[] = { 3, G_TYPE_INT >> G_TYPE_FUNDAMENTAL_SHIFT, 0, 42 };
+  guint n_found = 0;
+  gsize i;
+
+  for (i = 0; i + sizeof (record) <= size; i++)
+    {
+      if (memcmp (data + i, record, sizeof (record)) == 0)
+        {
+          data[i + 3] = 43;
+          n_found++;
+        }
+    }
+
+  g_assert_cmpuint (n_found, ==, 1);
+}
+
+static void
+test_compile_uses_values (void)
+{
+  GtkBuilder *builder;
+  GBytes *bytes;
+  GObject *label;
+  char *data;
+  gsize size;
+  GError *error = NULL;
+
+  builder = gtk_builder_new ();
+  bytes = _gtk_buildable_parser_compile (builder, ui, -1, &error);
+  g_assert_no_error (error);
+  g_object_unref (builder);
+
+  size = g_bytes_get_size (bytes);
+  data = g_malloc (size);
+  memcpy (data, g_bytes_get_data (bytes, NULL), size);
+  g_bytes_unref (bytes);
+
+  patch_compiled_value (data, size);
+
+  builder = gtk_builder_new ();
+  gtk_builder_add_from_string (builder, data, size, &error);
+  g_assert_no_error (error);
+  label = gtk_builder_get_object (builder, "label");
+  g_assert_cmpint (gtk_label_get_max_width_chars (GTK_LABEL (label)), ==, 43);
+  g_object_unref (builder);
+
+  g_free (data);
+}
+
+static double
+time_loading (const char *data,
+              gssize      size)
+{
+  GtkBuilder *builder;
+  GTimer *timer;
+  GError *error = NULL;
+  double elapsed;
+  int i;
+
+  timer = g_timer_new ();
+  for (i = 0; i < 1000; i++)
+    {
+      builder = gtk_builder_new ();
+      gtk_builder_add_from_string (builder, data, size, &error);
+      g_assert_no_error (error);
+      g_object_unref (builder);
+    }
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  return elapsed;
+}
+
+static void
+test_compile_performance (void)
+{
+  GtkBuilder *builder;
+  GBytes *bytes;
+  const char *data;
+  gsize size;
+  double text_time, compiled_time;
+  GError *error = NULL;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run in perf mode");
+      return;
+    }
+
+  builder = gtk_builder_new ();
+  bytes = _gtk_buildable_parser_compile (builder, ui, -1, &error);
+  g_assert_no_error (error);
+  g_object_unref (builder);
+
+  data = g_bytes_get_data (bytes, &size);
+
+  text_time = time_loading (ui, -1);
+  compiled_time = time_loading (data, size);
+
+  g_test_minimized_result (compiled_time, "loading 1000 times: text %.3f ms, compiled %.3f ms",
+                           1000 * text_time, 1000 * compiled_time);
+
+  g_bytes_unref (bytes);
+}
+
+static void
+test_compile_partial (void)
+{
+  GtkBuilder *builder;
+  GBytes *bytes;
+  const char *data;
+  gsize size;
+  const char *objects[] = { "scale", NULL };
+  GError *error = NULL;
+
+  builder = gtk_builder_new ();
+  bytes = _gtk_buildable_parser_compile (builder, ui, -1, &error);
+  g_assert_no_error (error);
+  g_object_unref (builder);
+
+  data = g_bytes_get_data (bytes, &size);
+
+  builder = gtk_builder_new ();
+  gtk_builder_add_objects_from_string (builder, data, size, objects, &error);
+  g_assert_no_error (error);
+  g_assert_null (gtk_builder_get_object (builder, "label"));
+  g_assert_cmpint (gtk_scale_get_digits (GTK_SCALE (gtk_builder_get_object (builder, "scale"))), ==, 3);
+  g_object_unref (builder);
+
+  g_bytes_unref (bytes);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/builder/compile/values", test_compile_values);
+  g_test_add_func ("/builder/compile/uses-values", test_compile_uses_values);
+  g_test_add_func ("/builder/compile/partial", test_compile_partial);
+  g_test_add_func ("/builder/compile/performance", test_compile_performance);
+
+  return g_test_run ();
+}
@@ -0,0 +1,566 @@
+/*
+ * Copyright (C) 2021, The GTK Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <locale.h>
+#include <string.h>
+
+#include <gtk/gtk.h>
+
+static GQuark number_quark;
+static GQuark changes_quark;
+static GQuark count_quark;
+
+static guint
+get (GListModel *model,
+     guint       position)
+{
+  GObject *object = g_list_model_get_item (model, position);
+  guint number;
+  g_assert_nonnull (object);
+  number = GPOINTER_TO_UINT (g_object_get_qdata (object, number_quark));
+  g_object_unref (object);
+  return number;
+}
+
+static char *
+model_to_string (GListModel *model)
+{
+  GString *string = g_string_new (NULL);
+  guint i;
+
+  for (i = 0; i < g_list_model_get_n_items (model); i++)
+    {
+      if (i > 0)
+        g_string_append (string, " ");
+      g_string_append_printf (string, "%u", get (model, i));
+    }
+
+  return g_string_free (string, FALSE);
+}
+
+static GObject *
+make_object (guint number)
+{
+  GObject *object;
+
+  /* 0 cannot be differentiated from NULL, so don't use it */
+  g_assert_cmpint (number, !=, 0);
+
+  object = g_object_new (G_TYPE_OBJECT, NULL);
+  g_object_set_qdata (object, number_quark, GUINT_TO_POINTER (number));
+
+  return object;
+}
+
+static void
+splice (GListStore *store,
+        guint       pos,
+        guint       removed,
+        guint      *numbers,
+        guint       added)
+{
+  GObject **objects = g_newa (GObject *, added);
+  guint i;
+
+  for (i = 0; i < added; i++)
+    objects[i] = make_object (numbers[i]);
+
+  g_list_store_splice (store, pos, removed, (gpointer *) objects, added);
+
+  for (i = 0; i < added; i++)
+    g_object_unref (objects[i]);
+}
+
+static void
+add (GListStore *store,
+     guint       number)
+{
+  GObject *object = make_object (number);
+  g_list_store_append (store, object);
+  g_object_unref (object);
+}
+
+static void
+insert (GListStore *store,
+        guint position,
+        guint number)
+{
+  GObject *object = make_object (number);
+  g_list_store_insert (store, position, object);
+  g_object_unref (object);
+}
+
+#define assert_model(model, expected) G_STMT_START{ \
+  char *s = model_to_string (G_LIST_MODEL (model)); \
+  if (!g_str_equal (s, expected)) \
+     g_assertion_message_cmpstr (G_LOG_DOMAIN, __FILE__, __LINE__, G_STRFUNC, \
+         #model " == " #expected, s, "==", expected); \
+  g_free (s); \
+}G_STMT_END
+
+#define assert_changes(model, expected) G_STMT_START{ \
+  GString *changes = g_object_get_qdata (G_OBJECT (model), changes_quark); \
+  if (!g_str_equal (changes->str, expected)) \
+     g_assertion_message_cmpstr (G_LOG_DOMAIN, __FILE__, __LINE__, G_STRFUNC, \
+         #model " == " #expected, changes->str, "==", expected); \
+  g_string_set_size (changes, 0); \
+}G_STMT_END
+
+#define assert_emissions(model, expected) G_STMT_START{ \
+  guint *count = g_object_get_qdata (G_OBJECT (model), count_quark); \
+  g_assert_cmpuint (*count, ==, expected); \
+  *count = 0; \
+}G_STMT_END
+
+static GListStore *
+new_empty_store (void)
+{
+  return g_list_store_new (G_TYPE_OBJECT);
+}
+
+static GListStore *
+new_store (guint start,
+           guint end,
+           guint step)
+{
+  GListStore *store = new_empty_store ();
+  guint i;
+
+  for (i = start; i <= end; i += step)
+    add (store, i);
+
+  return store;
+}
+
+static void
+items_changed (GListModel *model,
+               guint       position,
+               guint       removed,
+               guint       added,
+               GString    *changes)
+{
+  g_assert_true (removed != 0 || added != 0);
+
+  if (changes->len)
+    g_string_append (changes, ", ");
+
+  if (removed == 1 && added == 0)
+    {
+      g_string_append_printf (changes, "-%u", position);
+    }
+  else if (removed == 0 && added == 1)
+    {
+      g_string_append_printf (changes, "+%u", position);
+    }
+  else
+    {
+      g_string_append_printf (changes, "%u", position);
+      if (removed > 0)
+        g_string_append_printf (changes, "-%u", removed);
+      if (added > 0)
+        g_string_append_printf (changes, "+%u", added);
+    }
+}
+
+static void
+free_changes (gpointer data)
+{
+  GString *changes = data;
+
+  /* all changes must have been checked via assert_changes() before */
+  g_assert_cmpstr (changes->str, ==, "");
+
+  g_string_free (changes, TRUE);
+}
+
+static void
+count_emission (GListModel *model,
+                guint       position,
+                guint       removed,
+                guint       added,
+                guint      *count)
+{
+  (*count)++;
+}
+
+/* Counts the items-changed emissions of one stage of a pipeline */
+static void
+count_emissions (gpointer model)
+{
+  guint *count = g_new0 (guint, 1);
+
+  g_object_set_qdata_full (G_OBJECT (model), count_quark, count, g_free);
+  g_signal_connect (model, "items-changed", G_CALLBACK (count_emission), count);
+}
+
+static GtkCoalesceListModel *
+new_model (GListStore *store)
+{
+  GtkCoalesceListModel *result;
+  GString *changes;
+
+  if (store)
+    g_object_ref (store);
+  result = gtk_coalesce_list_model_new (G_LIST_MODEL (store));
+
+  changes = g_string_new ("");
+  g_object_set_qdata_full (G_OBJECT(result), changes_quark, changes, free_changes);
+  g_signal_connect (result, "items-changed", G_CALLBACK (items_changed), changes);
+
+  return result;
+}
+
+static void
+run_main_loop (void)
+{
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+test_create_empty (void)
+{
+  GtkCoalesceListModel *coalesce;
+
+  coalesce = new_model (NULL);
+  assert_model (coalesce, "");
+  assert_changes (coalesce, "");
+  g_assert_false (gtk_coalesce_list_model_get_pending (coalesce));
+
+  g_object_unref (coalesce);
+}
+
+static void
+test_create (void)
+{
+  GtkCoalesceListModel *coalesce;
+  GListStore *store;
+
+  store = new_store (1, 5, 2);
+  coalesce = new_model (store);
+  assert_model (coalesce, "1 3 5");
+  assert_changes (coalesce, "");
+
+  g_object_unref (store);
+  assert_model (coalesce, "1 3 5");
+  assert_changes (coalesce, "");
+
+  g_object_unref (coalesce);
+}
+
+static void
+test_set_model (void)
+{
+  GtkCoalesceListModel *coalesce;
+  GListStore *store;
+
+  coalesce = new_model (NULL);
+  assert_model (coalesce, "");
+  assert_changes (coalesce, "");
+
+  store = new_store (1, 7, 2);
+  gtk_coalesce_list_model_set_model (coalesce, G_LIST_MODEL (store));
+  assert_model (coalesce, "1 3 5 7");
+  assert_changes (coalesce, "0+4");
+
+  /* pending changes get dropped with the model */
+  add (store, 9);
+  g_assert_true (gtk_coalesce_list_model_get_pending (coalesce));
+  gtk_coalesce_list_model_set_model (coalesce, NULL);
+  g_assert_false (gtk_coalesce_list_model_get_pending (coalesce));
+  assert_model (coalesce, "");
+  assert_changes (coalesce, "0-4");
+
+  g_object_unref (store);
+  g_object_unref (coalesce);
+}
+
+static void
+test_stale_until_flush (void)
+{
+  GtkCoalesceListModel *coalesce;
+  GListStore *store;
+
+  store = new_store (1, 5, 1);
+  coalesce = new_model (store);
+
+  add (store, 6);
+  add (store, 7);
+  assert_model (coalesce, "1 2 3 4 5");
+  assert_changes (coalesce, "");
+  g_assert_true (gtk_coalesce_list_model_get_pending (coalesce));
+
+  gtk_coalesce_list_model_flush (coalesce);
+  assert_model (coalesce, "1 2 3 4 5 6 7");
+  assert_changes (coalesce, "5+2");
+  g_assert_false (gtk_coalesce_list_model_get_pending (coalesce));
+
+  /* flushing without changes does nothing */
+  gtk_coalesce_list_model_flush (coalesce);
+  assert_changes (coalesce, "");
+
+  g_object_unref (store);
+  g_object_unref (coalesce);
+}
+
+static void
+test_merge (void)
+{
+  GtkCoalesceListModel *coalesce;
+  GListStore *store;
+
+  store = new_store (1, 10, 1);
+  coalesce = new_model (store);
+
+  g_list_store_remove (store, 1);
+  insert (store, 5, 99);
+  gtk_coalesce_list_model_flush (coalesce);
+  assert_model (coalesce, "1 3 4 5 6 99 7 8 9 10");
+  assert_changes (coalesce, "1-5+5");
+
+  g_list_store_remove (store, 9);
+  g_list_store_remove (store, 8);
+  gtk_coalesce_list_model_flush (coalesce);
+  assert_model (coalesce, "1 3 4 5 6 99 7 8");
+  assert_changes (coalesce, "8-2");
+
+  splice (store, 2, 2, (guint[]) { 11, 12, 13 }, 3);
+  g_list_store_remove (store, 3);
+  gtk_coalesce_list_model_flush (coalesce);
+  assert_model (coalesce, "1 3 11 13 6 99 7 8");
+  assert_changes (coalesce, "2-2+2");
+
+  g_list_store_remove_all (store);
+  add (store, 1);
+  gtk_coalesce_list_model_flush (coalesce);
+  assert_model (coalesce, "1");
+  assert_changes (coalesce, "0-8+1");
+
+  g_object_unref (store);
+  g_object_unref (coalesce);
+}
+
+static void
+test_main_loop (void)
+{
+  GtkCoalesceListModel *coalesce;
+  GListStore *store;
+  guint i;
+
+  store = new_empty_store ();
+  coalesce = new_model (store);
+
+  for (i = 1; i <= 10; i++)
+    add (store, i);
+  assert_model (coalesce, "");
+
+  run_main_loop ();
+  assert_model (coalesce, "1 2 3 4 5 6 7 8 9 10");
+  assert_changes (coalesce, "0+10");
+  g_assert_false (gtk_coalesce_list_model_get_pending (coalesce));
+
+  g_object_unref (store);
+  g_object_unref (coalesce);
+}
+
+static gboolean
+is_odd (gpointer item,
+        gpointer data)
+{
+  guint *n_calls = data;
+
+  (*n_calls)++;
+
+  return GPOINTER_TO_UINT (g_object_get_qdata (item, number_quark)) % 2;
+}
+
+static int
+compare_reverse (gconstpointer a,
+                 gconstpointer b,
+                 gpointer      data)
+{
+  guint *n_calls = data;
+  guint na = GPOINTER_TO_UINT (g_object_get_qdata ((GObject *) a, number_quark));
+  guint nb = GPOINTER_TO_UINT (g_object_get_qdata ((GObject *) b, number_quark));
+
+  (*n_calls)++;
+
+  if (na < nb)
+    return GTK_ORDERING_LARGER;
+  else if (na > nb)
+    return GTK_ORDERING_SMALLER;
+  else
+    return GTK_ORDERING_EQUAL;
+}
+
+/* Models a directory listing delivering files in batches and
+ * counts how often each stage of the pipeline is touched.
+ */
+static void
+test_pipeline (void)
+{
+  GtkCoalesceListModel *coalesce;
+  GtkFilterListModel *filter;
+  GtkSortListModel *sort;
+  GtkMultiSelection *selection;
+  GListStore *store;
+  guint n_filter_calls = 0, n_sort_calls = 0;
+  guint batch, i;
+
+  store = new_empty_store ();
+  coalesce = new_model (store);
+  filter = gtk_filter_list_model_new (g_object_ref (G_LIST_MODEL (coalesce)),
+                                      GTK_FILTER (gtk_custom_filter_new (is_odd, &n_filter_calls, NULL)));
+  sort = gtk_sort_list_model_new (g_object_ref (G_LIST_MODEL (filter)),
+                                  GTK_SORTER (gtk_custom_sorter_new (compare_reverse, &n_sort_calls, NULL)));
+  selection = gtk_multi_selection_new (g_object_ref (G_LIST_MODEL (sort)));
+
+  count_emissions (store);
+  count_emissions (coalesce);
+  count_emissions (filter);
+  count_emissions (sort);
+  count_emissions (selection);
+
+  for (batch = 0; batch < 20; batch++)
+    {
+      GObject *objects[100];
+
+      for (i = 0; i < 100; i++)
+        objects[i] = make_object (batch * 100 + i + 1);
+      g_list_store_splice (store, g_list_model_get_n_items (G_LIST_MODEL (store)), 0, (gpointer *) objects, 100);
+      for (i = 0; i < 100; i++)
+        g_object_unref (objects[i]);
+    }
+
+  assert_emissions (store, 20);
+  assert_emissions (coalesce, 0);
+  assert_emissions (filter, 0);
+  assert_emissions (sort, 0);
+  assert_emissions (selection, 0);
+  g_assert_cmpuint (n_filter_calls, ==, 0);
+
+  run_main_loop ();
+
+  assert_emissions (store, 0);
+  assert_emissions (coalesce, 1);
+  assert_emissions (filter, 1);
+  assert_emissions (sort, 1);
+  assert_emissions (selection, 1);
+  assert_changes (coalesce, "0+2000");
+  g_assert_cmpuint (n_filter_calls, ==, 2000);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (selection)), ==, 1000);
+  g_assert_cmpuint (get (G_LIST_MODEL (selection), 0), ==, 1999);
+  g_test_message ("%u sort comparisons", n_sort_calls);
+
+  g_object_unref (selection);
+  g_object_unref (sort);
+  g_object_unref (filter);
+  g_object_unref (store);
+  g_object_unref (coalesce);
+}
+
+static void
+mirror_changes (GListModel *model,
+                guint       position,
+                guint       removed,
+                guint       added,
+                GListStore *mirror)
+{
+  gpointer *items = g_newa (gpointer, added);
+  guint i;
+
+  for (i = 0; i < added; i++)
+    items[i] = g_list_model_get_item (model, position + i);
+
+  g_list_store_splice (mirror, position, removed, items, added);
+
+  for (i = 0; i < added; i++)
+    g_object_unref (items[i]);
+}
+
+static void
+test_random (void)
+{
+  GtkCoalesceListModel *coalesce;
+  GListStore *store, *mirror;
+  guint i, j;
+
+  store = new_store (1, 50, 1);
+  coalesce = new_model (store);
+  mirror = new_store (1, 50, 1);
+  g_signal_connect (coalesce, "items-changed", G_CALLBACK (mirror_changes), mirror);
+
+  for (i = 0; i < 100; i++)
+    {
+      guint n_changes = g_test_rand_int_range (1, 10);
+
+      for (j = 0; j < n_changes; j++)
+        {
+          guint n_items = g_list_model_get_n_items (G_LIST_MODEL (store));
+          guint position = g_test_rand_int_range (0, n_items + 1);
+          guint removed = g_test_rand_int_range (0, n_items - position + 1);
+          guint added = g_test_rand_int_range (0, 5);
+          guint numbers[5];
+          guint k;
+
+          for (k = 0; k < added; k++)
+            numbers[k] = g_test_rand_int_range (1, 1000);
+
+          splice (store, position, removed, numbers, added);
+        }
+
+      gtk_coalesce_list_model_flush (coalesce);
+      {
+        GString *changes = g_object_get_qdata (G_OBJECT (coalesce), changes_quark);
+        char *expected = model_to_string (G_LIST_MODEL (store));
+
+        g_assert_null (strstr (changes->str, ","));
+        g_string_set_size (changes, 0);
+        assert_model (coalesce, expected);
+        assert_model (mirror, expected);
+        g_free (expected);
+      }
+    }
+
+  g_object_unref (mirror);
+  g_object_unref (store);
+  g_object_unref (coalesce);
+}
+
+int
+main (int argc, char *argv[])
+{
+  (g_test_init) (&argc, &argv, NULL);
+  setlocale (LC_ALL, "C");
+
+  number_quark = g_quark_from_static_string ("Hell and fire was spawned to be released.");
+  changes_quark = g_quark_from_static_string ("What did I see? Can I believe what I saw?");
+  count_quark = g_quark_from_static_string ("How many times do I have to tell you?");
+
+  g_test_add_func ("/coalescelistmodel/create_empty", test_create_empty);
+  g_test_add_func ("/coalescelistmodel/create", test_create);
+  g_test_add_func ("/coalescelistmodel/set-model", test_set_model);
+  g_test_add_func ("/coalescelistmodel/stale-until-flush", test_stale_until_flush);
+#if GLIB_CHECK_VERSION (2, 58, 0) /* g_list_store_splice() is broken before 2.58 */
+  g_test_add_func ("/coalescelistmodel/merge", test_merge);
+  g_test_add_func ("/coalescelistmodel/random", test_random);
+#endif
+  g_test_add_func ("/coalescelistmodel/main-loop", test_main_loop);
+  g_test_add_func ("/coalescelistmodel/pipeline", test_pipeline);
+
+  return g_test_run ();
+}
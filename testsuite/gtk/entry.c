@@ -306,6 +306,64 @@ test_delete (void)
   g_object_unref (entry);
 }
 
+static guint
+long_edit_position (guint i,
+                    guint n)
+{
+  /* Type at the end first, then in the middle */
+  return i < n / 2 ? i : i / 2;
+}
+
+static void
+test_buffer_long (void)
+{
+  GtkEntryBuffer *buffer;
+  GString *expected;
+  GTimer *timer;
+  guint i, n;
+
+  /* Every other character takes two bytes, which keeps us
+   * below GTK_ENTRY_BUFFER_MAX_SIZE
+   */
+  n = g_test_perf () ? 40000 : 4000;
+
+  buffer = gtk_entry_buffer_new (NULL, 0);
+
+  timer = g_timer_new ();
+  for (i = 0; i < n; i++)
+    gtk_entry_buffer_insert_text (buffer, long_edit_position (i, n), i % 2 ? "ä" : "a", 1);
+  g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                           "typing %u characters: %.3f ms", n, 1000 * g_timer_elapsed (timer, NULL));
+
+  g_timer_start (timer);
+  for (i = 0; i < n / 4; i++)
+    gtk_entry_buffer_delete_text (buffer, n / 2 - i - 1, 1);
+  g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                           "deleting %u characters: %.3f ms", n / 4, 1000 * g_timer_elapsed (timer, NULL));
+  g_timer_destroy (timer);
+
+  expected = g_string_new (NULL);
+  for (i = 0; i < n; i++)
+    {
+      const char *p = g_utf8_offset_to_pointer (expected->str, long_edit_position (i, n));
+
+      g_string_insert (expected, p - expected->str, i % 2 ? "ä" : "a");
+    }
+  for (i = 0; i < n / 4; i++)
+    {
+      const char *p = g_utf8_offset_to_pointer (expected->str, n / 2 - i - 1);
+
+      g_string_erase (expected, p - expected->str, g_utf8_next_char (p) - p);
+    }
+
+  g_assert_cmpuint (gtk_entry_buffer_get_length (buffer), ==, n - n / 4);
+  g_assert_cmpuint (gtk_entry_buffer_get_bytes (buffer), ==, expected->len);
+  g_assert_cmpstr (gtk_entry_buffer_get_text (buffer), ==, expected->str);
+
+  g_string_free (expected, TRUE);
+  g_object_unref (buffer);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -314,6 +372,7 @@ main (int   argc,
 
   g_test_add_func ("/entry/delete", test_delete);
   g_test_add_func ("/entry/insert", test_insert);
+  g_test_add_func ("/entry/buffer-long", test_buffer_long);
 
   return g_test_run();
 }
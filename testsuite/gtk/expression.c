@@ -779,6 +779,223 @@ test_value (void)
   g_value_unset (&value);
 }
 
+static guint
+count_notify_handlers (gpointer object)
+{
+  guint signal_id = g_signal_lookup ("notify", G_OBJECT_TYPE (object));
+  guint n;
+
+  n = g_signal_handlers_block_matched (object, G_SIGNAL_MATCH_ID, signal_id, 0, NULL, NULL, NULL);
+  g_signal_handlers_unblock_matched (object, G_SIGNAL_MATCH_ID, signal_id, 0, NULL, NULL, NULL);
+
+  return n;
+}
+
+/* Test that watches of the same property share a notify handler */
+static void
+test_shared_notify (void)
+{
+  GtkExpressionWatch *watches[10];
+  GtkExpression *expr, *expr2;
+  GtkStringFilter *filter;
+  guint counter = 0;
+  guint i;
+
+  filter = gtk_string_filter_new (NULL);
+  expr = gtk_property_expression_new (GTK_TYPE_STRING_FILTER, NULL, "search");
+  expr2 = gtk_property_expression_new (GTK_TYPE_STRING_FILTER, NULL, "search");
+
+  for (i = 0; i < G_N_ELEMENTS (watches); i++)
+    watches[i] = gtk_expression_watch (i % 2 ? expr : expr2, filter, inc_counter, &counter, NULL);
+  g_assert_cmpint (count_notify_handlers (filter), ==, 1);
+
+  gtk_string_filter_set_search (filter, "Hello World");
+  g_assert_cmpint (counter, ==, G_N_ELEMENTS (watches));
+  counter = 0;
+
+  for (i = 0; i < G_N_ELEMENTS (watches) / 2; i++)
+    gtk_expression_watch_unwatch (watches[i]);
+  g_assert_cmpint (count_notify_handlers (filter), ==, 1);
+
+  gtk_string_filter_set_search (filter, "Goodbye");
+  g_assert_cmpint (counter, ==, G_N_ELEMENTS (watches) / 2);
+  counter = 0;
+
+  for (; i < G_N_ELEMENTS (watches); i++)
+    gtk_expression_watch_unwatch (watches[i]);
+  g_assert_cmpint (count_notify_handlers (filter), ==, 0);
+
+  gtk_string_filter_set_search (filter, "Hello again");
+  g_assert_cmpint (counter, ==, 0);
+
+  gtk_expression_unref (expr);
+  gtk_expression_unref (expr2);
+  g_object_unref (filter);
+}
+
+static void
+unwatch_cb (gpointer data)
+{
+  GtkExpressionWatch **watch = data;
+
+  g_clear_pointer (watch, gtk_expression_watch_unwatch);
+}
+
+/* Test that unwatching from inside a notification is fine */
+static void
+test_unwatch_in_notify (void)
+{
+  GtkExpressionWatch *watch1, *watch2;
+  GtkExpression *expr;
+  GtkStringFilter *filter;
+
+  filter = gtk_string_filter_new (NULL);
+  expr = gtk_property_expression_new (GTK_TYPE_STRING_FILTER, NULL, "search");
+
+  watch1 = gtk_expression_watch (expr, filter, unwatch_cb, &watch1, NULL);
+  watch2 = gtk_expression_watch (expr, filter, unwatch_cb, &watch2, NULL);
+
+  gtk_string_filter_set_search (filter, "Hello World");
+  g_assert_null (watch1);
+  g_assert_null (watch2);
+  g_assert_cmpint (count_notify_handlers (filter), ==, 0);
+
+  gtk_expression_unref (expr);
+  g_object_unref (filter);
+}
+
+static char *
+count_evaluations (gpointer    this,
+                   const char *search1,
+                   const char *search2,
+                   gpointer    data)
+{
+  guint *counter = data;
+
+  *counter += 1;
+
+  return g_strconcat (search1, search2, NULL);
+}
+
+/* Test that a watch depending on the same property twice
+ * gets notified only once per change
+ */
+static void
+test_batch_notify (void)
+{
+  GtkExpression *expr, *params[2];
+  GtkStringFilter *filter, *target;
+  guint counter = 0, evaluations = 0;
+  GtkExpressionWatch *watch;
+
+  filter = gtk_string_filter_new (NULL);
+  target = gtk_string_filter_new (NULL);
+  params[0] = gtk_property_expression_new (GTK_TYPE_STRING_FILTER, NULL, "search");
+  params[1] = gtk_property_expression_new (GTK_TYPE_STRING_FILTER, NULL, "search");
+  expr = gtk_cclosure_expression_new (G_TYPE_STRING,
+                                      NULL,
+                                      2, params,
+                                      G_CALLBACK (count_evaluations),
+                                      &evaluations, NULL);
+
+  watch = gtk_expression_watch (expr, filter, inc_counter, &counter, NULL);
+  gtk_expression_bind (gtk_expression_ref (expr), target, "search", filter);
+  g_assert_cmpint (evaluations, ==, 1);
+  evaluations = 0;
+
+  gtk_string_filter_set_search (filter, "ab");
+  g_assert_cmpint (counter, ==, 1);
+  g_assert_cmpint (evaluations, ==, 1);
+  g_assert_cmpstr (gtk_string_filter_get_search (target), ==, "abab");
+
+  gtk_expression_watch_unwatch (watch);
+  gtk_expression_unref (expr);
+  g_object_unref (target);
+  g_object_unref (filter);
+}
+
+#define N_COLUMNS 20
+#define N_VISIBLE_ROWS 50
+#define N_ITEMS 1000
+
+/* Simulates scrolling a column view where every cell binds
+ * an expression on the row's item.
+ */
+static void
+test_scroll_performance (void)
+{
+  GtkStringFilter *items[N_ITEMS];
+  GtkStringFilter *cells[N_VISIBLE_ROWS][N_COLUMNS];
+  GtkExpressionWatch *watches[N_VISIBLE_ROWS][N_COLUMNS];
+  GtkExpression *expr, *params[2];
+  guint evaluations = 0;
+  guint i, row, col, handlers;
+  gint64 start;
+  double msecs;
+
+  if (!g_test_perf ())
+    return;
+
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      char *s = g_strdup_printf ("%u", i);
+      items[i] = gtk_string_filter_new (NULL);
+      gtk_string_filter_set_search (items[i], s);
+      g_free (s);
+    }
+
+  params[0] = gtk_property_expression_new (GTK_TYPE_STRING_FILTER, NULL, "search");
+  params[1] = gtk_property_expression_new (GTK_TYPE_STRING_FILTER, NULL, "search");
+  expr = gtk_cclosure_expression_new (G_TYPE_STRING,
+                                      NULL,
+                                      2, params,
+                                      G_CALLBACK (count_evaluations),
+                                      &evaluations, NULL);
+
+  for (row = 0; row < N_VISIBLE_ROWS; row++)
+    for (col = 0; col < N_COLUMNS; col++)
+      {
+        cells[row][col] = gtk_string_filter_new (NULL);
+        watches[row][col] = gtk_expression_bind (gtk_expression_ref (expr), cells[row][col], "search", items[row]);
+      }
+
+  handlers = 0;
+  for (row = 0; row < N_VISIBLE_ROWS; row++)
+    handlers += count_notify_handlers (items[row]);
+  g_test_message ("%u notify handlers for %u cells", handlers, N_VISIBLE_ROWS * N_COLUMNS);
+  g_assert_cmpint (handlers, ==, N_VISIBLE_ROWS);
+
+  evaluations = 0;
+  start = g_get_monotonic_time ();
+
+  /* scroll through all items, one row at a time */
+  for (i = N_VISIBLE_ROWS; i < N_ITEMS; i++)
+    {
+      row = i % N_VISIBLE_ROWS;
+      for (col = 0; col < N_COLUMNS; col++)
+        {
+          gtk_expression_watch_unwatch (watches[row][col]);
+          watches[row][col] = gtk_expression_bind (gtk_expression_ref (expr), cells[row][col], "search", items[i]);
+        }
+    }
+
+  /* and change the visible items */
+  for (i = N_ITEMS - N_VISIBLE_ROWS; i < N_ITEMS; i++)
+    gtk_string_filter_set_search (items[i], "changed");
+
+  msecs = (g_get_monotonic_time () - start) / 1000.0;
+  g_test_minimized_result (msecs, "scrolling: %.2fms", msecs);
+  g_test_message ("%u evaluations", evaluations);
+  g_assert_cmpint (evaluations, ==, (N_ITEMS - N_VISIBLE_ROWS) * N_COLUMNS + N_VISIBLE_ROWS * N_COLUMNS);
+
+  for (row = 0; row < N_VISIBLE_ROWS; row++)
+    for (col = 0; col < N_COLUMNS; col++)
+      g_object_unref (cells[row][col]);
+  for (i = 0; i < N_ITEMS; i++)
+    g_object_unref (items[i]);
+  gtk_expression_unref (expr);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -804,6 +1021,10 @@ main (int argc, char *argv[])
   g_test_add_func ("/expression/binds", test_binds);
   g_test_add_func ("/expression/bind-object", test_bind_object);
   g_test_add_func ("/expression/value", test_value);
+  g_test_add_func ("/expression/shared-notify", test_shared_notify);
+  g_test_add_func ("/expression/unwatch-in-notify", test_unwatch_in_notify);
+  g_test_add_func ("/expression/batch-notify", test_batch_notify);
+  g_test_add_func ("/expression/scroll-performance", test_scroll_performance);
 
   return g_test_run ();
 }
@@ -1,6 +1,12 @@
 #include <gtk/gtk.h>
 
 #include <string.h>
+#include <glib/gstdio.h>
+#ifdef G_OS_WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
 
 #define SCALABLE_IMAGE_SIZE (128)
 
@@ -789,6 +795,193 @@ test_nonsquare_symbolic (void)
   g_object_unref (info);
 }
 
+static guint
+count_cached_textures (void)
+{
+  char *path;
+  GDir *dir;
+  guint n = 0;
+
+  path = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "icon-textures", NULL);
+  dir = g_dir_open (path, 0, NULL);
+  if (dir)
+    {
+      while (g_dir_read_name (dir))
+        n++;
+      g_dir_close (dir);
+    }
+  g_free (path);
+
+  return n;
+}
+
+static void
+load_cached_icon (const char *path,
+                  int         size,
+                  int         expected_width,
+                  int         expected_height)
+{
+  GtkIconTheme *icon_theme;
+  GtkIconPaintable *info;
+  GFile *file;
+  GIcon *icon;
+  GtkSnapshot *snapshot;
+  GskRenderNode *node;
+  graphene_rect_t bounds;
+
+  /* use a new theme every time, so we don't hit its in-memory cache */
+  icon_theme = gtk_icon_theme_new ();
+  file = g_file_new_for_path (path);
+  icon = g_file_icon_new (file);
+  info = gtk_icon_theme_lookup_by_gicon (icon_theme, icon,
+                                         size, 1, GTK_TEXT_DIR_NONE, 0);
+  g_assert_nonnull (info);
+
+  snapshot = gtk_snapshot_new ();
+  gdk_paintable_snapshot (GDK_PAINTABLE (info), snapshot, size, size);
+  node = gtk_snapshot_free_to_node (snapshot);
+
+  gsk_render_node_get_bounds (node, &bounds);
+  g_assert_cmpint (bounds.size.width, ==, expected_width);
+  g_assert_cmpint (bounds.size.height, ==, expected_height);
+
+  gsk_render_node_unref (node);
+  g_object_unref (info);
+  g_object_unref (icon);
+  g_object_unref (file);
+  g_object_unref (icon_theme);
+}
+
+static char *
+get_cached_texture_path (const char *path,
+                         int         size,
+                         int         scale,
+                         gboolean    symbolic)
+{
+  char *key, *checksum, *cache_path;
+
+  key = g_strdup_printf ("%s\n%d\n%d\n%d", path, size, scale, symbolic);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, key, -1);
+  cache_path = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "icon-textures", checksum, NULL);
+  g_free (checksum);
+  g_free (key);
+
+  return cache_path;
+}
+
+/* Turns the cached 12x18 texture into an 18x12 one, so a
+ * load that returns 18x12 must have come from the cache.
+ */
+static void
+transpose_cached_texture (const char *path)
+{
+  char *cache_path, *contents;
+  GError *error = NULL;
+  guint32 width, height, stride, has_alpha;
+  gsize length;
+
+  cache_path = get_cached_texture_path (path, 18, 1, TRUE);
+  g_file_get_contents (cache_path, &contents, &length, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (length, >=, 28);
+
+  memcpy (&width, contents + 12, sizeof (guint32));
+  memcpy (&height, contents + 16, sizeof (guint32));
+  memcpy (&stride, contents + 20, sizeof (guint32));
+  memcpy (&has_alpha, contents + 24, sizeof (guint32));
+  g_assert_cmpuint (width, ==, 12);
+  g_assert_cmpuint (height, ==, 18);
+  g_assert_cmpuint (has_alpha, ==, 1);
+  g_assert_cmpuint (stride, ==, 12 * 4);
+
+  stride = 18 * 4;
+  memcpy (contents + 12, &height, sizeof (guint32));
+  memcpy (contents + 16, &width, sizeof (guint32));
+  memcpy (contents + 20, &stride, sizeof (guint32));
+
+  g_file_set_contents (cache_path, contents, length, &error);
+  g_assert_no_error (error);
+
+  g_free (contents);
+  g_free (cache_path);
+}
+
+static void
+test_texture_cache (void)
+{
+  char *src, *dir, *path, *contents, *swapped;
+  struct utimbuf times;
+  GError *error = NULL;
+  GStatBuf st;
+  gsize length;
+  guint n;
+
+  dir = g_dir_make_tmp ("icontheme-XXXXXX", &error);
+  g_assert_no_error (error);
+  path = g_build_filename (dir, "cached-symbolic.svg", NULL);
+
+  src = g_build_filename (g_test_get_dir (G_TEST_DIST), "icons", "scalable", "nonsquare-symbolic.svg", NULL);
+  g_file_get_contents (src, &contents, &length, &error);
+  g_assert_no_error (error);
+  g_file_set_contents (path, contents, length, &error);
+  g_assert_no_error (error);
+  g_free (contents);
+  g_free (src);
+
+  n = count_cached_textures ();
+
+  /* the first load renders the icon and stores it */
+  load_cached_icon (path, 18, 12, 18);
+  g_assert_cmpuint (count_cached_textures (), ==, n + 1);
+
+  /* the second load is served from the cache */
+  transpose_cached_texture (path);
+  load_cached_icon (path, 18, 18, 12);
+  g_assert_cmpuint (count_cached_textures (), ==, n + 1);
+
+  /* changing the icon file invalidates the entry, and it gets replaced */
+  src = g_build_filename (g_test_get_dir (G_TEST_DIST), "icons", "scalable", "everything-symbolic.svg", NULL);
+  g_file_get_contents (src, &contents, &length, &error);
+  g_assert_no_error (error);
+  g_file_set_contents (path, contents, length, &error);
+  g_assert_no_error (error);
+  g_free (contents);
+  g_free (src);
+
+  load_cached_icon (path, 18, 18, 18);
+  g_assert_cmpuint (count_cached_textures (), ==, n + 1);
+
+  /* and so does replacing it with a file of the same size and
+   * the same mtime in seconds */
+  src = g_build_filename (g_test_get_dir (G_TEST_DIST), "icons", "scalable", "nonsquare-symbolic.svg", NULL);
+  g_file_get_contents (src, &contents, &length, &error);
+  g_assert_no_error (error);
+  g_file_set_contents (path, contents, length, &error);
+  g_assert_no_error (error);
+  g_free (src);
+
+  load_cached_icon (path, 18, 12, 18);
+
+  g_assert_cmpint (g_stat (path, &st), ==, 0);
+  swapped = strstr (contents, "width=\"12px\" height=\"18px\"");
+  g_assert_nonnull (swapped);
+  memcpy (swapped, "width=\"18px\" height=\"12px\"", strlen ("width=\"18px\" height=\"12px\""));
+  g_file_set_contents (path, contents, length, &error);
+  g_assert_no_error (error);
+  g_free (contents);
+  times.actime = st.st_atime;
+  times.modtime = st.st_mtime;
+  g_assert_cmpint (g_utime (path, &times), ==, 0);
+
+  load_cached_icon (path, 18, 18, 12);
+  g_assert_cmpuint (count_cached_textures (), ==, n + 1);
+
+  g_remove (path);
+  g_rmdir (dir);
+  g_free (path);
+  g_free (dir);
+}
+
 static void
 require_env (const char *var)
 {
@@ -799,8 +992,15 @@ require_env (const char *var)
 int
 main (int argc, char *argv[])
 {
+  char *cache_dir;
+
   require_env ("G_TEST_SRCDIR");
 
+  /* Keep the icon texture cache out of the real cache directory */
+  cache_dir = g_dir_make_tmp ("icontheme-cache-XXXXXX", NULL);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+  g_free (cache_dir);
+
   gtk_test_init (&argc, &argv);
 
   g_test_add_func ("/icontheme/basics", test_basics);
@@ -815,6 +1015,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/icontheme/list", test_list);
   g_test_add_func ("/icontheme/inherit", test_inherit);
   g_test_add_func ("/icontheme/nonsquare-symbolic", test_nonsquare_symbolic);
+  g_test_add_func ("/icontheme/texture-cache", test_texture_cache);
 
   return g_test_run();
 }
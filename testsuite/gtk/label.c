@@ -218,6 +218,79 @@ test_label_underline (void)
   gtk_window_destroy (GTK_WINDOW (window));
 }
 
+static const char *wrap_text =
+  "The quick brown fox jumps over the lazy dog, while "
+  "a wrapping label is measured at many widths, like it "
+  "happens when resizing a window full of them.";
+
+static int
+measure_fresh (const char    *text,
+               PangoWrapMode  wrap_mode,
+               int            width,
+               int           *baseline)
+{
+  GtkWidget *label;
+  int height;
+
+  label = gtk_label_new (text);
+  gtk_label_set_wrap (GTK_LABEL (label), TRUE);
+  gtk_label_set_wrap_mode (GTK_LABEL (label), wrap_mode);
+  g_object_ref_sink (label);
+
+  gtk_widget_measure (label, GTK_ORIENTATION_VERTICAL, width, &height, NULL, baseline, NULL);
+
+  g_object_unref (label);
+
+  return height;
+}
+
+static void
+check_heights (GtkWidget  *label,
+               const char *text,
+               int         from,
+               int         to)
+{
+  int step = from < to ? 7 : -7;
+  int width;
+
+  for (width = from; step > 0 ? width <= to : width >= to; width += step)
+    {
+      int height, baseline, expected_baseline;
+
+      gtk_widget_measure (label, GTK_ORIENTATION_VERTICAL, width, &height, NULL, &baseline, NULL);
+      g_assert_cmpint (height, ==, measure_fresh (text,
+                                                  gtk_label_get_wrap_mode (GTK_LABEL (label)),
+                                                  width, &expected_baseline));
+      g_assert_cmpint (baseline, ==, expected_baseline);
+    }
+}
+
+static void
+test_label_wrap_measure (void)
+{
+  GtkWidget *label;
+
+  label = gtk_label_new (wrap_text);
+  gtk_label_set_wrap (GTK_LABEL (label), TRUE);
+  g_object_ref_sink (label);
+
+  /* Shrink and grow, like a window being resized */
+  check_heights (label, wrap_text, 600, 20);
+  check_heights (label, wrap_text, 20, 600);
+
+  /* Changing how lines are broken must not use old results */
+  gtk_label_set_wrap_mode (GTK_LABEL (label), PANGO_WRAP_CHAR);
+  check_heights (label, wrap_text, 600, 20);
+  gtk_label_set_wrap_mode (GTK_LABEL (label), PANGO_WRAP_WORD);
+  check_heights (label, wrap_text, 20, 600);
+
+  /* Changing the text must not use old results */
+  gtk_label_set_label (GTK_LABEL (label), "short");
+  check_heights (label, "short", 600, 20);
+
+  g_object_unref (label);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -225,6 +298,7 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/label/markup-parse", test_label_markup);
   g_test_add_func ("/label/underline-parse", test_label_underline);
+  g_test_add_func ("/label/wrap-measure", test_label_wrap_measure);
 
   return g_test_run ();
 }
@@ -722,6 +722,117 @@ test_empty_filter (void)
   g_object_unref (selection);
 }
 
+static gpointer
+count_map (gpointer item,
+           gpointer data)
+{
+  guint *n_calls = data;
+
+  (*n_calls)++;
+
+  return item;
+}
+
+/* Test that selecting lots of items doesn't need
+ * to look at all of them.
+ */
+static void
+test_select_all_large (void)
+{
+  GtkStringList *stringlist;
+  GtkMapListModel *map;
+  GtkSelectionModel *selection;
+  GtkSelectionFilterModel *filter;
+  GtkBitset *selected, *mask;
+  GString *text;
+  GBytes *bytes;
+  guint i, n_items, n_calls;
+  gboolean ret;
+
+  n_items = 100000;
+  text = g_string_new (NULL);
+  for (i = 0; i < n_items; i++)
+    g_string_append_printf (text, "%u\n", i);
+  bytes = g_string_free_to_bytes (text);
+  stringlist = gtk_string_list_new_from_bytes (bytes);
+  g_bytes_unref (bytes);
+
+  n_calls = 0;
+  map = gtk_map_list_model_new (G_LIST_MODEL (stringlist), count_map, &n_calls, NULL);
+  selection = GTK_SELECTION_MODEL (gtk_multi_selection_new (G_LIST_MODEL (map)));
+  filter = gtk_selection_filter_model_new (selection);
+
+  ret = gtk_selection_model_select_all (selection);
+  g_assert_true (ret);
+  g_assert_cmpuint (n_calls, <, 1000);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (filter)), ==, n_items);
+
+  /* invert the selection */
+  n_calls = 0;
+  selected = gtk_bitset_new_range (0, 10);
+  mask = gtk_bitset_new_range (0, n_items);
+  ret = gtk_selection_model_set_selection (selection, selected, mask);
+  g_assert_true (ret);
+  g_assert_cmpuint (n_calls, <, 1000);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (filter)), ==, 10);
+  gtk_bitset_unref (selected);
+  gtk_bitset_unref (mask);
+
+  /* items are only looked up when they are requested */
+  n_calls = 0;
+  ret = gtk_selection_model_select_all (selection);
+  g_assert_true (ret);
+  g_assert_cmpuint (n_calls, <, 1000);
+
+  n_calls = 0;
+  g_object_unref (g_list_model_get_item (G_LIST_MODEL (selection), n_items / 2));
+  g_assert_cmpuint (n_calls, ==, 1);
+  g_assert_true (gtk_selection_model_is_selected (selection, n_items / 2));
+
+  g_object_unref (filter);
+  g_object_unref (selection);
+}
+
+static void
+test_select_all_readd (void)
+{
+  GListStore *store;
+  GtkSelectionModel *selection;
+  GObject *items[2000];
+  gboolean ret;
+  guint i;
+
+  store = g_list_store_new (G_TYPE_OBJECT);
+  for (i = 0; i < G_N_ELEMENTS (items); i++)
+    {
+      items[i] = g_object_new (G_TYPE_OBJECT, NULL);
+      g_list_store_append (store, items[i]);
+      g_object_unref (items[i]);
+    }
+
+  selection = GTK_SELECTION_MODEL (gtk_multi_selection_new (g_object_ref (G_LIST_MODEL (store))));
+  ret = gtk_selection_model_select_all (selection);
+  g_assert_true (ret);
+
+  /* large selections are looked up when idle */
+  while (g_main_context_iteration (NULL, FALSE));
+
+  /* reverse the order, like a re-sort would */
+  for (i = 0; i < G_N_ELEMENTS (items) / 2; i++)
+    {
+      GObject *tmp = items[i];
+      items[i] = items[G_N_ELEMENTS (items) - 1 - i];
+      items[G_N_ELEMENTS (items) - 1 - i] = tmp;
+    }
+  g_list_store_splice (store, 0, G_N_ELEMENTS (items), (gpointer *) items, G_N_ELEMENTS (items));
+
+  for (i = 0; i < G_N_ELEMENTS (items); i++)
+    g_assert_true (gtk_selection_model_is_selected (selection, i));
+
+  g_object_unref (selection);
+  g_object_unref (store);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -746,6 +857,10 @@ main (int argc, char *argv[])
   g_test_add_func ("/multiselection/set-model", test_set_model);
   g_test_add_func ("/multiselection/empty", test_empty);
   g_test_add_func ("/multiselection/selection-filter/empty", test_empty_filter);
+  g_test_add_func ("/multiselection/select-all-large", test_select_all_large);
+#if GLIB_CHECK_VERSION (2, 58, 0) /* g_list_store_splice() is broken before 2.58 */
+  g_test_add_func ("/multiselection/select-all-readd", test_select_all_readd);
+#endif
 
   return g_test_run ();
 }
@@ -242,6 +242,155 @@ test_take (void)
   g_object_unref (list);
 }
 
+static void
+test_bytes (void)
+{
+  GtkStringList *list;
+  GBytes *bytes;
+
+  bytes = g_bytes_new_static ("a\nb\r\n\nc\n", 8);
+  list = gtk_string_list_new_from_bytes (bytes);
+  g_bytes_unref (bytes);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, 4);
+  g_assert_cmpstr (gtk_string_list_get_string (list, 0), ==, "a");
+  g_assert_cmpstr (gtk_string_list_get_string (list, 1), ==, "b");
+  g_assert_cmpstr (gtk_string_list_get_string (list, 2), ==, "");
+  g_assert_cmpstr (gtk_string_list_get_string (list, 3), ==, "c");
+  g_object_unref (list);
+
+  list = new_model ((const char *[]){ "a", "b", "c", NULL });
+
+  bytes = g_bytes_new_static ("x\ny", 3);
+  gtk_string_list_splice_bytes (list, 1, 1, bytes);
+  g_bytes_unref (bytes);
+  assert_model (list, "a x y c");
+  assert_changes (list, "1-1+2");
+
+  bytes = g_bytes_new_static ("", 0);
+  gtk_string_list_splice_bytes (list, 0, 2, bytes);
+  g_bytes_unref (bytes);
+  assert_model (list, "y c");
+  assert_changes (list, "0-2");
+
+  bytes = g_bytes_new_static ("\n", 1);
+  gtk_string_list_splice_bytes (list, 2, 0, bytes);
+  g_bytes_unref (bytes);
+  g_assert_cmpstr (gtk_string_list_get_string (list, 2), ==, "");
+  assert_changes (list, "+2");
+
+  g_object_unref (list);
+}
+
+static void
+test_bytes_large (void)
+{
+  GtkStringList *list;
+  GString *text;
+  GBytes *bytes;
+  GTimer *timer;
+  char *last;
+  guint i, n;
+
+  n = g_test_perf () ? 1000000 : 10000;
+
+  text = g_string_new (NULL);
+  for (i = 0; i < n; i++)
+    g_string_append_printf (text, "item %u\n", i);
+  bytes = g_string_free_to_bytes (text);
+
+  timer = g_timer_new ();
+  list = gtk_string_list_new_from_bytes (bytes);
+  g_test_minimized_result (g_timer_elapsed (timer, NULL), "loading %u strings: %.3f ms", n, 1000 * g_timer_elapsed (timer, NULL));
+  g_timer_destroy (timer);
+  g_bytes_unref (bytes);
+
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, n);
+  last = g_strdup_printf ("item %u", n - 1);
+  g_assert_cmpstr (gtk_string_list_get_string (list, n - 1), ==, last);
+  g_free (last);
+
+  g_object_unref (list);
+}
+
+static void
+test_item_cache (void)
+{
+  GtkStringList *list;
+  GtkStringObject *a, *b;
+  guint i;
+
+  list = new_model ((const char *[]){ "a", "b", "c", NULL });
+
+  /* items are reused as long as somebody holds them */
+  a = g_list_model_get_item (G_LIST_MODEL (list), 1);
+  b = g_list_model_get_item (G_LIST_MODEL (list), 1);
+  g_assert_true (a == b);
+  g_assert_cmpstr (gtk_string_object_get_string (a), ==, "b");
+  g_object_unref (b);
+
+  /* and survive the removal from the list */
+  gtk_string_list_remove (list, 1);
+  assert_changes (list, "-1");
+  g_assert_cmpstr (gtk_string_object_get_string (a), ==, "b");
+  b = g_list_model_get_item (G_LIST_MODEL (list), 1);
+  g_assert_true (a != b);
+  g_assert_cmpstr (gtk_string_object_get_string (b), ==, "c");
+  g_object_unref (a);
+
+  /* and the list going away */
+  g_object_unref (list);
+  g_assert_cmpstr (gtk_string_object_get_string (b), ==, "c");
+  g_object_unref (b);
+
+  /* and the list reusing its memory */
+  list = gtk_string_list_new ((const char *[]){ "a", NULL });
+  a = g_list_model_get_item (G_LIST_MODEL (list), 0);
+  for (i = 0; i < 100000; i++)
+    {
+      gtk_string_list_append (list, "a rather long string that is going to waste memory");
+      gtk_string_list_remove (list, 1);
+    }
+  b = g_list_model_get_item (G_LIST_MODEL (list), 0);
+  g_assert_true (a == b);
+  g_object_unref (b);
+  g_object_unref (a);
+
+  g_object_unref (list);
+}
+
+static void
+test_stable_strings (void)
+{
+  GtkStringList *list;
+  GBytes *bytes;
+  const char *keep;
+  guint i;
+
+  list = gtk_string_list_new ((const char *[]){ "keep", NULL });
+  keep = gtk_string_list_get_string (list, 0);
+
+  /* strings don't move while other items come and go */
+  for (i = 0; i < 100000; i++)
+    gtk_string_list_append (list, "a rather long string that is going to waste memory");
+  gtk_string_list_splice (list, 1, 100000, NULL);
+  g_assert_true (gtk_string_list_get_string (list, 0) == keep);
+
+  bytes = g_bytes_new_static ("a\nb\nc\n", 6);
+  gtk_string_list_splice_bytes (list, 1, 0, bytes);
+  gtk_string_list_splice_bytes (list, 1, 3, bytes);
+  gtk_string_list_splice (list, 1, 3, NULL);
+  g_bytes_unref (bytes);
+  g_assert_true (gtk_string_list_get_string (list, 0) == keep);
+  g_assert_cmpstr (keep, ==, "keep");
+
+  /* replacing a string with itself */
+  gtk_string_list_splice (list, 0, 1, (const char *[]){ keep, NULL });
+  g_assert_cmpstr (gtk_string_list_get_string (list, 0), ==, "keep");
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, 1);
+
+  g_object_unref (list);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -257,6 +406,10 @@ main (int argc, char *argv[])
   g_test_add_func ("/stringlist/splice", test_splice);
   g_test_add_func ("/stringlist/add_remove", test_add_remove);
   g_test_add_func ("/stringlist/take", test_take);
+  g_test_add_func ("/stringlist/bytes", test_bytes);
+  g_test_add_func ("/stringlist/bytes/large", test_bytes_large);
+  g_test_add_func ("/stringlist/item-cache", test_item_cache);
+  g_test_add_func ("/stringlist/stable-strings", test_stable_strings);
 
   return g_test_run ();
 }
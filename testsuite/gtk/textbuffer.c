@@ -1749,6 +1749,264 @@ test_undo3 (void)
   g_object_unref (buffer);
 }
 
+static void
+check_loaded (GtkTextBuffer *buffer,
+              const char    *str,
+              int            len)
+{
+  GtkTextBuffer *expected;
+  GtkTextIter start, end, iter, expected_iter;
+  char *text, *expected_text;
+
+  expected = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (expected, str, len);
+
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==, gtk_text_buffer_get_char_count (expected));
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, gtk_text_buffer_get_line_count (expected));
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+  gtk_text_buffer_get_bounds (expected, &start, &end);
+  expected_text = gtk_text_buffer_get_text (expected, &start, &end, TRUE);
+  g_assert_cmpstr (text, ==, expected_text);
+  g_free (text);
+  g_free (expected_text);
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  gtk_text_buffer_get_start_iter (expected, &expected_iter);
+  do
+    {
+      g_assert_cmpint (gtk_text_iter_get_bytes_in_line (&iter), ==, gtk_text_iter_get_bytes_in_line (&expected_iter));
+      gtk_text_iter_forward_line (&expected_iter);
+    }
+  while (gtk_text_iter_forward_line (&iter));
+
+  g_object_unref (expected);
+}
+
+static void
+count_signal (gpointer data)
+{
+  int *count = data;
+
+  (*count)++;
+}
+
+static void
+test_load_bytes (void)
+{
+  const char *strings[] = {
+    "",
+    "Hello",
+    "Hello\n",
+    "Hello\r\n",
+    "Hello\r",
+    "\n\n\n",
+    "\r\r\n\n",
+    "Hello\nBar\nFoo",
+    "Hello\nBar\nFoo\n",
+    "a\xe2\x80\xa9" "b\xe2\x80\xa9",
+    "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d\nhello\n\xd9\x85\xd8\xb1\xd8\xad\xd8\xa8\xd8\xa7\n",
+  };
+  GtkTextBuffer *buffer;
+  GString *s;
+  GBytes *bytes;
+  int changed = 0, inserted = 0;
+  guint i;
+
+  buffer = gtk_text_buffer_new (NULL);
+  g_signal_connect_swapped (buffer, "changed", G_CALLBACK (count_signal), &changed);
+  g_signal_connect_swapped (buffer, "insert-text", G_CALLBACK (count_signal), &inserted);
+
+  for (i = 0; i < G_N_ELEMENTS (strings); i++)
+    {
+      bytes = g_bytes_new_static (strings[i], strlen (strings[i]));
+      changed = 0;
+      gtk_text_buffer_load_bytes (buffer, bytes);
+      g_assert_cmpint (changed, <=, 2); /* deleting the old text, and loading */
+      g_bytes_unref (bytes);
+
+      check_loaded (buffer, strings[i], -1);
+      run_tests (buffer);
+    }
+
+  /* Enough lines for a few levels of nodes */
+  s = g_string_new (NULL);
+  for (i = 0; i < 20000; i++)
+    {
+      g_string_append_printf (s, "line %u", i);
+      g_string_append (s, i % 7 == 0 ? "\r\n" : i % 5 == 0 ? "\r" : "\n");
+    }
+  bytes = g_string_free_to_bytes (s);
+  gtk_text_buffer_load_bytes (buffer, bytes);
+  check_loaded (buffer, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+  g_bytes_unref (bytes);
+
+  g_assert_cmpint (inserted, ==, 0);
+  g_assert_false (gtk_text_buffer_get_can_undo (buffer));
+
+  g_object_unref (buffer);
+}
+
+static void
+test_load_bytes_invalid (void)
+{
+  const char invalid[] = "a\xffz\nb\xe2\x80";
+  GtkTextBuffer *buffer;
+  GBytes *bytes;
+  char *valid;
+
+  buffer = gtk_text_buffer_new (NULL);
+
+  bytes = g_bytes_new_static (invalid, sizeof (invalid) - 1);
+  gtk_text_buffer_load_bytes (buffer, bytes);
+  g_bytes_unref (bytes);
+
+  valid = g_utf8_make_valid (invalid, -1);
+  check_buffer_contents (buffer, valid);
+  g_free (valid);
+
+  g_object_unref (buffer);
+}
+
+static void
+test_load_bytes_marks (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextMark *mark;
+  GtkTextIter iter;
+  GBytes *bytes;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, "some\nold\ntext", -1);
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 6);
+  mark = gtk_text_buffer_create_mark (buffer, "mark", &iter, FALSE);
+  gtk_text_buffer_place_cursor (buffer, &iter);
+
+  bytes = g_bytes_new_static ("new\ntext\n", 9);
+  gtk_text_buffer_load_bytes (buffer, bytes);
+  g_bytes_unref (bytes);
+
+  check_buffer_contents (buffer, "new\ntext\n");
+
+  gtk_text_buffer_get_iter_at_mark (buffer, &iter, mark);
+  g_assert_true (gtk_text_iter_is_start (&iter));
+  gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+  g_assert_true (gtk_text_iter_is_start (&iter));
+
+  /* Still a regular buffer */
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  gtk_text_buffer_insert (buffer, &iter, "more", -1);
+  check_buffer_contents (buffer, "new\ntext\nmore");
+
+  g_object_unref (buffer);
+}
+
+static void
+load_progress (goffset  current,
+               goffset  total,
+               gpointer data)
+{
+  goffset *last = data;
+
+  g_assert_cmpint (current, >, *last);
+  g_assert_cmpint (current, <=, total);
+  *last = current;
+}
+
+static void
+load_done (GObject      *source,
+           GAsyncResult *result,
+           gpointer      data)
+{
+  GAsyncResult **out = data;
+
+  *out = g_object_ref (result);
+  g_main_context_wakeup (NULL);
+}
+
+static void
+test_load_stream (void)
+{
+  /* Matches the chunk size used for reading */
+  const gsize chunk = 1024 * 1024;
+  GtkTextBuffer *buffer;
+  GAsyncResult *result = NULL;
+  GInputStream *stream;
+  GError *error = NULL;
+  goffset progress = 0;
+  GBytes *bytes;
+  char *text;
+  gsize i, len;
+
+  /* Put a "\r\n", a paragraph separator and a multibyte character
+   * across chunk boundaries.
+   */
+  len = 4 * chunk + 17;
+  text = g_malloc (len);
+  for (i = 0; i < len; i++)
+    text[i] = i % 80 == 79 ? '\n' : 'a' + i % 26;
+  memcpy (text + chunk - 1, "\r\n", 2);
+  memcpy (text + 2 * chunk - 2, "\xe2\x80\xa9", 3);
+  memcpy (text + 3 * chunk - 1, "\xc3\xa9", 2);
+  bytes = g_bytes_new_take (text, len);
+
+  buffer = gtk_text_buffer_new (NULL);
+  stream = g_memory_input_stream_new_from_bytes (bytes);
+
+  gtk_text_buffer_load_stream_async (buffer, stream, G_PRIORITY_DEFAULT, NULL,
+                                     load_progress, &progress,
+                                     load_done, &result);
+  while (result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_true (gtk_text_buffer_load_stream_finish (buffer, result, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (progress, <=, len);
+
+  check_loaded (buffer, g_bytes_get_data (bytes, NULL), (int) len);
+
+  g_object_unref (result);
+  g_object_unref (stream);
+  g_bytes_unref (bytes);
+  g_object_unref (buffer);
+}
+
+static void
+test_load_stream_cancel (void)
+{
+  GtkTextBuffer *buffer;
+  GAsyncResult *result = NULL;
+  GCancellable *cancellable;
+  GInputStream *stream;
+  GError *error = NULL;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, "unchanged", -1);
+
+  stream = g_memory_input_stream_new_from_data ("new text", -1, NULL);
+  cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+
+  gtk_text_buffer_load_stream_async (buffer, stream, G_PRIORITY_DEFAULT, cancellable,
+                                     NULL, NULL,
+                                     load_done, &result);
+  while (result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_false (gtk_text_buffer_load_stream_finish (buffer, result, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&error);
+
+  check_buffer_contents (buffer, "unchanged");
+
+  g_object_unref (result);
+  g_object_unref (cancellable);
+  g_object_unref (stream);
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -1772,6 +2030,11 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Undo 1", test_undo1);
   g_test_add_func ("/TextBuffer/Undo 2", test_undo2);
   g_test_add_func ("/TextBuffer/Undo 3", test_undo3);
+  g_test_add_func ("/TextBuffer/Load bytes", test_load_bytes);
+  g_test_add_func ("/TextBuffer/Load invalid bytes", test_load_bytes_invalid);
+  g_test_add_func ("/TextBuffer/Load bytes marks", test_load_bytes_marks);
+  g_test_add_func ("/TextBuffer/Load stream", test_load_stream);
+  g_test_add_func ("/TextBuffer/Load stream cancel", test_load_stream_cancel);
 
   return g_test_run();
 }
@@ -604,6 +604,192 @@ test14 (void)
   g_free (fill);
 }
 
+static void
+text_insert (Text       *text,
+             guint       position,
+             const char *str)
+{
+  do_insert (text, position, position + g_utf8_strlen (str, -1), str, strlen (str));
+  gtk_text_history_text_inserted (text->history, position, str, -1);
+}
+
+static void
+text_delete (Text  *text,
+             guint  begin,
+             guint  end)
+{
+  char *str = g_strndup (text->buf->str + begin, end - begin);
+
+  do_delete (text, begin, end, str, end - begin);
+  gtk_text_history_text_deleted (text->history, begin, end, str, end - begin);
+
+  g_free (str);
+}
+
+static char *
+make_chunk (guint    n,
+            gboolean random)
+{
+  GString *str = g_string_new (NULL);
+
+  while (str->len < 8192)
+    {
+      if (random)
+        g_string_append_c (str, g_test_rand_int_range (32, 127));
+      else
+        g_string_append_printf (str, "%u: the quick brown fox jumps over the lazy dog\n", n);
+    }
+
+  return g_string_free (str, FALSE);
+}
+
+static void
+test15 (void)
+{
+  Text *text = text_new ();
+  GPtrArray *states = g_ptr_array_new_with_free_func (g_free);
+  guint i;
+
+  /* Enough large inserts that the old ones get compressed */
+  g_ptr_array_add (states, g_strdup (""));
+  for (i = 0; i < 40; i++)
+    {
+      char *chunk = make_chunk (i, FALSE);
+
+      text_insert (text, text->buf->len, chunk);
+      g_ptr_array_add (states, g_strdup (text->buf->str));
+      g_free (chunk);
+    }
+
+  /* Undo into the compressed part and branch off from there */
+  for (i = 40; i > 20; i--)
+    {
+      gtk_text_history_undo (text->history);
+      g_assert_cmpstr (text->buf->str, ==, g_ptr_array_index (states, i - 1));
+    }
+
+  text_insert (text, text->buf->len, "more");
+  g_assert_false (text->can_redo);
+  gtk_text_history_undo (text->history);
+  g_assert_cmpstr (text->buf->str, ==, g_ptr_array_index (states, 20));
+
+  for (i = 20; i > 0; i--)
+    {
+      g_assert_true (text->can_undo);
+      gtk_text_history_undo (text->history);
+      g_assert_cmpstr (text->buf->str, ==, g_ptr_array_index (states, i - 1));
+    }
+  g_assert_false (text->can_undo);
+
+  for (i = 1; i <= 20; i++)
+    {
+      g_assert_true (text->can_redo);
+      gtk_text_history_redo (text->history);
+      g_assert_cmpstr (text->buf->str, ==, g_ptr_array_index (states, i));
+    }
+
+  gtk_text_history_redo (text->history);
+  g_assert_true (g_str_has_prefix (text->buf->str, g_ptr_array_index (states, 20)));
+  g_assert_true (g_str_has_suffix (text->buf->str, "more"));
+  g_assert_false (text->can_redo);
+
+  g_ptr_array_unref (states);
+  text_free (text);
+}
+
+static void
+test16 (void)
+{
+  Text *text = text_new ();
+  GPtrArray *states = g_ptr_array_new_with_free_func (g_free);
+  char *big;
+  guint i, n_undo;
+
+  gtk_text_history_set_max_undo_bytes (text->history, 64 * 1024);
+
+  g_ptr_array_add (states, g_strdup (""));
+  for (i = 0; i < 20; i++)
+    {
+      char *chunk = make_chunk (i, TRUE);
+
+      text_insert (text, text->buf->len, chunk);
+      g_ptr_array_add (states, g_strdup (text->buf->str));
+      g_free (chunk);
+    }
+
+  /* The oldest changes have been dropped to stay within budget */
+  for (n_undo = 0; text->can_undo; n_undo++)
+    gtk_text_history_undo (text->history);
+
+  g_assert_cmpuint (n_undo, >, 0);
+  g_assert_cmpuint (n_undo, <, 20);
+  g_assert_cmpstr (text->buf->str, ==, g_ptr_array_index (states, 20 - n_undo));
+
+  /* A single change larger than the budget can still be undone */
+  big = g_strnfill (128 * 1024, 'x');
+  text_insert (text, 0, big);
+  g_assert_true (text->can_undo);
+  gtk_text_history_undo (text->history);
+  g_assert_cmpstr (text->buf->str, ==, g_ptr_array_index (states, 20 - n_undo));
+  g_assert_false (text->can_undo);
+
+  g_free (big);
+  g_ptr_array_unref (states);
+  text_free (text);
+}
+
+static void
+test17 (void)
+{
+  Text *text = text_new ();
+  guint i;
+
+  text_insert (text, 0, "hello world, this is a test");
+  gtk_text_history_begin_irreversible_action (text->history);
+  gtk_text_history_end_irreversible_action (text->history);
+
+  /* Deleting piecewise within a user action, forwards and backwards */
+  gtk_text_history_begin_user_action (text->history);
+  for (i = 0; i < 6; i++)
+    text_delete (text, 0, 1);
+  for (i = 0; i < 5; i++)
+    text_delete (text, text->buf->len - 1, text->buf->len);
+  gtk_text_history_end_user_action (text->history);
+  g_assert_cmpstr (text->buf->str, ==, "world, this is a");
+
+  gtk_text_history_undo (text->history);
+  g_assert_cmpstr (text->buf->str, ==, "hello world, this is a test");
+  g_assert_false (text->can_undo);
+
+  gtk_text_history_redo (text->history);
+  g_assert_cmpstr (text->buf->str, ==, "world, this is a");
+  gtk_text_history_undo (text->history);
+  g_assert_cmpstr (text->buf->str, ==, "hello world, this is a test");
+
+  text_free (text);
+
+  /* Deleting backwards past the size of inline strings */
+  text = text_new ();
+  text_insert (text, 0, "the quick brown fox jumps over the lazy dog");
+  gtk_text_history_begin_irreversible_action (text->history);
+  gtk_text_history_end_irreversible_action (text->history);
+
+  gtk_text_history_begin_user_action (text->history);
+  for (i = 0; i < 30; i++)
+    text_delete (text, text->buf->len - 1, text->buf->len);
+  gtk_text_history_end_user_action (text->history);
+  g_assert_cmpstr (text->buf->str, ==, "the quick bro");
+
+  gtk_text_history_undo (text->history);
+  g_assert_cmpstr (text->buf->str, ==, "the quick brown fox jumps over the lazy dog");
+  gtk_text_history_redo (text->history);
+  g_assert_cmpstr (text->buf->str, ==, "the quick bro");
+  gtk_text_history_undo (text->history);
+  g_assert_cmpstr (text->buf->str, ==, "the quick brown fox jumps over the lazy dog");
+
+  text_free (text);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -624,6 +810,9 @@ main (int   argc,
   g_test_add_func ("/Gtk/TextHistory/test12", test12);
   g_test_add_func ("/Gtk/TextHistory/test13", test13);
   g_test_add_func ("/Gtk/TextHistory/test14", test14);
+  g_test_add_func ("/Gtk/TextHistory/test15", test15);
+  g_test_add_func ("/Gtk/TextHistory/test16", test16);
+  g_test_add_func ("/Gtk/TextHistory/test17", test17);
 
   return g_test_run ();
 }
@@ -279,6 +279,103 @@ test_search_caseless (void)
   check_found_backward ("aa \303\200", "aa", flags, 0, 2, "aa");
 }
 
+static int
+count_matches (GtkTextBuffer      *buffer,
+               const char         *needle,
+               GtkTextSearchFlags  flags,
+               const GtkTextIter  *limit)
+{
+  GtkTextIter iter, s, e;
+  int n = 0;
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  while (gtk_text_iter_forward_search (&iter, needle, flags, &s, &e, limit))
+    {
+      char *text;
+
+      if (flags & GTK_TEXT_SEARCH_TEXT_ONLY)
+        text = gtk_text_iter_get_text (&s, &e);
+      else
+        text = gtk_text_iter_get_slice (&s, &e);
+      if (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE)
+        g_assert_cmpint (g_ascii_strcasecmp (text, needle), ==, 0);
+      else
+        g_assert_cmpstr (text, ==, needle);
+      g_free (text);
+
+      iter = e;
+      n++;
+    }
+
+  return n;
+}
+
+static void
+test_search_all (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter iter, limit, s_iter, e_iter;
+  GdkPaintable *paintable;
+  GString *s;
+  int i;
+
+  /* Enough lines for the search to go through many btree nodes */
+  s = g_string_new (NULL);
+  for (i = 0; i < 5000; i++)
+    g_string_append_printf (s, "line %d: some Foo and some foo%s",
+                            i, i % 3 == 0 ? "\r\n" : "\n");
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, s->str, s->len);
+  g_string_free (s, TRUE);
+
+  g_assert_cmpint (count_matches (buffer, "foo", 0, NULL), ==, 5000);
+  g_assert_cmpint (count_matches (buffer, "foo", GTK_TEXT_SEARCH_CASE_INSENSITIVE, NULL), ==, 10000);
+  g_assert_cmpint (count_matches (buffer, "some", 0, NULL), ==, 10000);
+  g_assert_cmpint (count_matches (buffer, "foo\r", 0, NULL), ==, 1667);
+  g_assert_cmpint (count_matches (buffer, "foo\nline", 0, NULL), ==, 3332);
+  g_assert_cmpint (count_matches (buffer, "1:", 0, NULL), ==, 500);
+  g_assert_cmpint (count_matches (buffer, "bar", 0, NULL), ==, 0);
+
+  /* Matches must end before the limit */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &limit, 2500, 31);
+  g_assert_cmpint (count_matches (buffer, "foo", 0, &limit), ==, 2500);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &limit, 2500, 32);
+  g_assert_cmpint (count_matches (buffer, "foo", 0, &limit), ==, 2501);
+
+  /* A limit on the line the search starts on */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 100, 20);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &limit, 100, 27);
+  g_assert_false (gtk_text_iter_forward_search (&iter, "foo", 0, NULL, NULL, &limit));
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &limit, 100, 31);
+  g_assert_true (gtk_text_iter_forward_search (&iter, "foo", 0, &s_iter, &e_iter, &limit));
+  g_assert_cmpint (gtk_text_iter_get_line (&s_iter), ==, 100);
+  g_assert_cmpint (gtk_text_iter_get_line_offset (&s_iter), ==, 28);
+  g_assert_true (gtk_text_iter_equal (&e_iter, &limit));
+
+  /* The searched text follows changes to the buffer */
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, 4000);
+  gtk_text_buffer_insert (buffer, &iter, "bar\nbar bar\n", -1);
+  g_assert_cmpint (count_matches (buffer, "bar", 0, NULL), ==, 3);
+  g_assert_cmpint (count_matches (buffer, "foo", 0, NULL), ==, 5000);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, 10);
+  gtk_text_buffer_get_iter_at_line (buffer, &limit, 20);
+  gtk_text_buffer_delete (buffer, &iter, &limit);
+  g_assert_cmpint (count_matches (buffer, "foo", 0, NULL), ==, 4990);
+
+  /* Paintables are U+FFFC, unless searching text only */
+  paintable = gdk_paintable_new_empty (10, 10);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 3000, 29);
+  gtk_text_buffer_insert_paintable (buffer, &iter, paintable);
+  g_object_unref (paintable);
+  g_assert_cmpint (count_matches (buffer, "e f", 0, NULL), ==, 4989);
+  g_assert_cmpint (count_matches (buffer, "e f", GTK_TEXT_SEARCH_TEXT_ONLY, NULL), ==, 4990);
+  g_assert_cmpint (count_matches (buffer, "e \357\277\274f", 0, NULL), ==, 1);
+
+  g_object_unref (buffer);
+}
+
 static void
 test_forward_to_tag_toggle (void)
 {
@@ -795,6 +892,7 @@ main (int argc, char** argv)
   g_test_add_func ("/TextIter/Search Full Buffer", test_search_full_buffer);
   g_test_add_func ("/TextIter/Search", test_search);
   g_test_add_func ("/TextIter/Search Caseless", test_search_caseless);
+  g_test_add_func ("/TextIter/Search All", test_search_all);
   g_test_add_func ("/TextIter/Forward To Tag Toggle", test_forward_to_tag_toggle);
   g_test_add_func ("/TextIter/Forward To Line End", test_forward_to_line_end);
   g_test_add_func ("/TextIter/Word Boundaries", test_word_boundaries);
@@ -0,0 +1,128 @@
+/*  Copyright 2021 Red Hat, Inc.
+ *
+ * GTK+ is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * GLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GTK+; see the file COPYING.  If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <glib/gi18n.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include "gtkbuilderprivate.h"
+#include "gtk-builder-tool.h"
+
+static gboolean
+compile_file (const char *filename,
+              const char *output)
+{
+  GtkBuilder *builder;
+  GError *error = NULL;
+  char *buffer;
+  gsize length;
+  GBytes *bytes;
+  const char *data;
+  gsize size;
+
+  if (!g_file_get_contents (filename, &buffer, &length, &error))
+    {
+      g_printerr (_("Can’t load “%s”: %s\n"), filename, error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  builder = gtk_builder_new ();
+  bytes = _gtk_buildable_parser_compile (builder, buffer, length, &error);
+  g_object_unref (builder);
+  g_free (buffer);
+
+  if (bytes == NULL)
+    {
+      g_printerr (_("Can’t parse “%s”: %s\n"), filename, error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  data = g_bytes_get_data (bytes, &size);
+
+  if (output)
+    {
+      if (!g_file_set_contents (output, data, size, &error))
+        {
+          g_printerr (_("Failed to write %s: “%s”\n"), output, error->message);
+          g_error_free (error);
+          g_bytes_unref (bytes);
+          return FALSE;
+        }
+    }
+  else if (fwrite (data, 1, size, stdout) != size)
+    {
+      g_printerr (_("Failed to write to stdout\n"));
+      g_bytes_unref (bytes);
+      return FALSE;
+    }
+
+  g_bytes_unref (bytes);
+
+  return TRUE;
+}
+
+void
+do_compile (int          *argc,
+            const char ***argv)
+{
+  char *output = NULL;
+  char **filenames = NULL;
+  GOptionContext *ctx;
+  const GOptionEntry entries[] = {
+    { "output", 0, 0, G_OPTION_ARG_FILENAME, &output, NULL, NULL },
+    { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL, NULL },
+    { NULL, }
+  };
+  GError *error = NULL;
+
+  ctx = g_option_context_new (NULL);
+  g_option_context_set_help_enabled (ctx, FALSE);
+  g_option_context_add_main_entries (ctx, entries, NULL);
+
+  if (!g_option_context_parse (ctx, argc, (char ***)argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      exit (1);
+    }
+
+  g_option_context_free (ctx);
+
+  if (filenames == NULL)
+    {
+      g_printerr (_("No .ui file specified\n"));
+      exit (1);
+    }
+
+  if (g_strv_length (filenames) > 1)
+    {
+      g_printerr (_("Can only compile a single .ui file\n"));
+      exit (1);
+    }
+
+  if (!compile_file (filenames[0], output))
+    exit (1);
+
+  g_strfreev (filenames);
+  g_free (output);
+}
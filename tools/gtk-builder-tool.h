@@ -6,5 +6,6 @@ void do_simplify  (int *argc, const char ***argv);
 void do_validate  (int *argc, const char ***argv);
 void do_enumerate (int *argc, const char ***argv);
 void do_preview   (int *argc, const char ***argv);
+void do_compile   (int *argc, const char ***argv);
 
 #endif